@@ -0,0 +1,119 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include "../persistence/TarIndex.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct ArchiveMountBenchmarkConfig {
+    size_t memberCount;
+    size_t memberBytes;
+};
+
+struct ArchiveMountBenchmarkResult {
+    size_t memberCount;
+    std::uint64_t archiveBytes;
+    double scanSeconds;      // TarIndex::scan alone
+    double coldMountSeconds; // mountArchive without an index: scan, tree, index written
+    double warmMountSeconds; // mountArchive reading the persisted index
+    double firstReadMicros;  // mapping and touching one member after the warm mount
+};
+
+class ArchiveMountBenchmark {
+  private:
+    static constexpr size_t MEMBERS_PER_DIRECTORY = 1000;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "archive_mount_benchmark";
+
+    static std::string header(const std::string& name, std::uint64_t size) {
+        std::string block(512, '\0');
+        name.copy(&block[0], 100);
+        std::snprintf(&block[100], 8, "%07o", 0644);
+        std::snprintf(&block[124], 12, "%011llo", static_cast<unsigned long long>(size));
+        block[156] = '0';
+        block.replace(257, 8, "ustar\0" "00", 8);
+        block.replace(148, 8, 8, ' ');
+        unsigned sum = 0;
+        for (char c : block) {
+            sum += static_cast<unsigned char>(c);
+        }
+        std::snprintf(&block[148], 7, "%06o", sum);
+        return block;
+    }
+
+    // Member data is skipped over rather than written, so multi-GB archives are sparse
+    // files that cost little disk space.
+    static std::uint64_t createArchive(const std::string& path,
+                                       const ArchiveMountBenchmarkConfig& config) {
+        std::filesystem::remove(path);
+        std::filesystem::remove(TarIndex::indexPath(path));
+        std::uint64_t padded = (config.memberBytes + 511) / 512 * 512;
+        std::uint64_t offset = 0;
+        {
+            std::ofstream out(path, std::ios::binary);
+            for (size_t i = 0; i < config.memberCount; ++i) {
+                out.seekp(static_cast<std::streamoff>(offset));
+                out << header("d" + std::to_string(i / MEMBERS_PER_DIRECTORY) + "/f" +
+                                  std::to_string(i),
+                              config.memberBytes);
+                offset += 512 + padded;
+            }
+            out.seekp(static_cast<std::streamoff>(offset));
+            out << std::string(1024, '\0');
+        }
+        return offset + 1024;
+    }
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // Time of a bare header scan against a first mount, which adds building the tree and
+    // writing the index, and against a repeated mount served by that index.
+    static std::vector<ArchiveMountBenchmarkResult> run(
+        const std::vector<ArchiveMountBenchmarkConfig>& configs = {{100000, 16 << 10},
+                                                                   {20000, 256 << 10}}) {
+        std::filesystem::create_directories(WORK_DIR);
+        std::string archive = (WORK_DIR / "archive.tar").string();
+        std::vector<ArchiveMountBenchmarkResult> results;
+        for (const auto& config : configs) {
+            ArchiveMountBenchmarkResult result{config.memberCount, 0, 0, 0, 0, 0};
+            result.archiveBytes = createArchive(archive, config);
+            result.scanSeconds = seconds([&]() { TarIndex::scan(archive); });
+            {
+                VFSExplorer explorer;
+                result.coldMountSeconds =
+                    seconds([&]() { explorer.mountArchive(archive, "/archive"); });
+            }
+            {
+                VFSExplorer explorer;
+                result.warmMountSeconds =
+                    seconds([&]() { explorer.mountArchive(archive, "/archive"); });
+                auto* file = static_cast<VFSFile*>(explorer.searchByIndex("f0").front());
+                result.firstReadMicros = seconds([&]() {
+                                             MappedFile mapped = file->mapReadOnly();
+                                             volatile char last = mapped.data()[mapped.size() - 1];
+                                             (void)last;
+                                         }) *
+                                         1e6;
+            }
+
+            std::cout << config.memberCount << " members, " << result.archiveBytes / (1 << 20)
+                      << " MiB: header scan " << result.scanSeconds << " s, cold mount "
+                      << result.coldMountSeconds << " s, warm mount " << result.warmMountSeconds
+                      << " s, first read " << result.firstReadMicros << " us" << std::endl;
+            results.push_back(result);
+        }
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+};
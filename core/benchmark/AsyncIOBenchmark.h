@@ -0,0 +1,95 @@
+#pragma once
+#include "../io/AsyncFileIO.h"
+#include "../utils/PageCache.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct AsyncIOResult {
+    AsyncBackend backend;
+    unsigned queueDepth;
+    bool coldCache;
+    double filesPerSecond;
+    double megabytesPerSecond;
+};
+
+class AsyncIOBenchmark {
+  private:
+    static inline const std::filesystem::path CORPUS_DIR =
+        std::filesystem::temp_directory_path() / "async_io_benchmark";
+
+    static std::vector<std::string> createCorpus(size_t fileCount, size_t fileSize) {
+        std::filesystem::create_directories(CORPUS_DIR);
+        std::vector<char> block(fileSize);
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < fileCount; ++i) {
+            for (auto& byte : block) {
+                byte = static_cast<char>(std::rand());
+            }
+            std::string path = (CORPUS_DIR / ("file_" + std::to_string(i) + ".bin")).string();
+            std::ofstream(path, std::ios::binary)
+                .write(block.data(), static_cast<std::streamsize>(block.size()));
+            paths.push_back(path);
+        }
+        return paths;
+    }
+
+    // One stat and one whole-file read per path, all submitted up front.
+    static AsyncIOResult measure(AsyncBackend backend, unsigned queueDepth, bool coldCache,
+                                 const std::vector<std::string>& paths, size_t fileSize) {
+        if (coldCache) {
+            PageCache::evict(paths);
+        }
+
+        AsyncFileIO io(queueDepth, backend);
+        std::atomic<std::uint64_t> bytes{0};
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& path : paths) {
+            io.stat(path, [](AsyncStatResult) {});
+            io.read(path, 0, fileSize,
+                    [&bytes](AsyncReadResult result) { bytes += result.data.size(); });
+        }
+        io.waitIdle();
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        AsyncIOResult result{io.backend(), queueDepth, coldCache, 0, 0};
+        if (seconds > 0) {
+            result.filesPerSecond = paths.size() / seconds;
+            result.megabytesPerSecond = bytes / 1e6 / seconds;
+        }
+
+        std::cout << (result.backend == AsyncBackend::IoUring ? "io_uring" : "thread pool")
+                  << " depth " << queueDepth << (coldCache ? " cold: " : " warm: ")
+                  << result.filesPerSecond << " files/s, " << result.megabytesPerSecond
+                  << " MB/s" << std::endl;
+        return result;
+    }
+
+  public:
+    // Sweeps queue depths 1..256 for every available backend, with the page cache
+    // dropped before each cold run and primed before each warm run.
+    static std::vector<AsyncIOResult> run(size_t fileCount = 2000, size_t fileSize = 16 * 1024) {
+        std::vector<AsyncIOResult> results;
+        std::vector<std::string> paths = createCorpus(fileCount, fileSize);
+
+        std::vector<AsyncBackend> backends = {AsyncBackend::ThreadPool};
+        if (AsyncFileIO(1).backend() == AsyncBackend::IoUring) {
+            backends.insert(backends.begin(), AsyncBackend::IoUring);
+        }
+
+        for (AsyncBackend backend : backends) {
+            for (unsigned depth = 1; depth <= 256; depth *= 2) {
+                results.push_back(measure(backend, depth, true, paths, fileSize));
+                results.push_back(measure(backend, depth, false, paths, fileSize));
+            }
+        }
+
+        std::filesystem::remove_all(CORPUS_DIR);
+        return results;
+    }
+};
@@ -7,6 +7,20 @@
 struct BenchmarkResult {
     long long searchByTraversalTime;
     long long searchByIndexTime;
+    long long searchByParallelTraversalTime;
+};
+
+struct NameFilterStats {
+    size_t filterCount;
+    size_t memoryBytes;
+    double falsePositiveRate;
+    double prunedFraction;
+};
+
+struct ScalingPoint {
+    size_t threadCount;
+    long long searchTime;
+    double speedup;
 };
 
 class BenchmarkService {
@@ -36,6 +50,84 @@ class BenchmarkService {
         }
     }
 
+    static std::vector<std::string> pickFileNames(int fileCount, int iterations) {
+        std::vector<std::string> fileNames;
+        fileNames.reserve(iterations);
+        for (int i = 0; i < iterations; ++i) {
+            size_t randIndex = std::rand() % fileCount;
+            fileNames.push_back(VIRTUAL_FILE_PREFIX + std::to_string(randIndex));
+        }
+        return fileNames;
+    }
+
+    template <typename Search>
+    static long long averageTime(const std::vector<std::string>& fileNames, Search search) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& fileName : fileNames) {
+            auto v = search(fileName);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() /
+               static_cast<long long>(fileNames.size());
+    }
+
+    // Returns true when some descendant of `node` is called `name`.
+    static bool auditFilters(const VFSNode* node, const std::string& name, size_t& negatives,
+                             size_t& falsePositives) {
+        if (!node->isDirectory()) {
+            return false;
+        }
+
+        auto* dir = static_cast<const VFSDirectory*>(node);
+        bool contains = false;
+        for (const auto& child : dir->getChildren()) {
+            bool childContains = auditFilters(child.get(), name, negatives, falsePositives);
+            contains = contains || childContains || child->getName() == name;
+        }
+
+        if (dir->getNameSummary().filter && !contains) {
+            ++negatives;
+            if (SubtreeNameFilters::mayContain(dir, name)) {
+                ++falsePositives;
+            }
+        }
+        return contains;
+    }
+
+    static size_t countPruned(const VFSNode* node, const std::string& name) {
+        if (!node->isDirectory()) {
+            return 0;
+        }
+
+        auto* dir = static_cast<const VFSDirectory*>(node);
+        if (!SubtreeNameFilters::mayContain(dir, name)) {
+            return dir->getDescendantCount();
+        }
+
+        size_t pruned = 0;
+        for (const auto& child : dir->getChildren()) {
+            pruned += countPruned(child.get(), name);
+        }
+        return pruned;
+    }
+
+    static size_t filterMemory(const VFSNode* node, size_t& filterCount) {
+        if (!node->isDirectory()) {
+            return 0;
+        }
+
+        auto* dir = static_cast<const VFSDirectory*>(node);
+        size_t bytes = 0;
+        if (dir->getNameSummary().filter) {
+            ++filterCount;
+            bytes += dir->getNameSummary().filter->memoryUsage();
+        }
+        for (const auto& child : dir->getChildren()) {
+            bytes += filterMemory(child.get(), filterCount);
+        }
+        return bytes;
+    }
+
   public:
     static void generateDataset(VFSExplorer& explorer, int fileCount) {
         std::srand(std::time(nullptr));
@@ -77,31 +169,68 @@ class BenchmarkService {
 
         generateDataset(explorer, filecount);
 
-        std::vector<std::string> fileNames;
-        fileNames.reserve(iterations);
-        for (int i = 0; i < iterations; ++i) {
-            size_t randIndex = std::rand() % filecount;
-            fileNames.push_back(VIRTUAL_FILE_PREFIX + std::to_string(randIndex));
-        }
-
-        auto start = std::chrono::high_resolution_clock::now();
-        for (int i = 0; i < iterations; ++i) {
-            auto v = explorer.searchByTraversal(fileNames[i]);
-        }
-        auto end = std::chrono::high_resolution_clock::now();
-        result.searchByTraversalTime =
-            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / iterations;
+        std::vector<std::string> fileNames = pickFileNames(filecount, iterations);
 
-        start = std::chrono::high_resolution_clock::now();
-        for (int i = 0; i < iterations; ++i) {
-            auto v = explorer.searchByIndex(fileNames[i]);
-        }
-        end = std::chrono::high_resolution_clock::now();
-        result.searchByIndexTime =
-            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / iterations;
+        result.searchByTraversalTime = averageTime(
+            fileNames, [&](const std::string& name) { return explorer.searchByTraversal(name); });
+        result.searchByIndexTime = averageTime(
+            fileNames, [&](const std::string& name) { return explorer.searchByIndex(name); });
+        result.searchByParallelTraversalTime =
+            averageTime(fileNames, [&](const std::string& name) {
+                return explorer.searchByParallelTraversal(name);
+            });
 
         removeTempFile();
 
         return result;
     }
+
+    // Expects a tree produced by generateDataset with the same file count.
+    static NameFilterStats runNameFilterReport(VFSExplorer& explorer, int filecount,
+                                               int iterations) {
+        SubtreeNameFilters::refresh(explorer.getRoot());
+        std::vector<std::string> fileNames = pickFileNames(filecount, iterations);
+        const VFSDirectory* root = explorer.getRoot();
+
+        size_t negatives = 0;
+        size_t falsePositives = 0;
+        size_t pruned = 0;
+        for (const auto& name : fileNames) {
+            auditFilters(root, name, negatives, falsePositives);
+            pruned += countPruned(root, name);
+        }
+
+        NameFilterStats stats{};
+        stats.memoryBytes = filterMemory(root, stats.filterCount);
+        stats.falsePositiveRate =
+            negatives ? static_cast<double>(falsePositives) / negatives : 0.0;
+        stats.prunedFraction =
+            static_cast<double>(pruned) / (root->getDescendantCount() * fileNames.size());
+
+        std::cout << "Bloom filters: " << stats.filterCount << ", memory " << stats.memoryBytes
+                  << " bytes, false positive rate " << stats.falsePositiveRate
+                  << ", pruned nodes " << stats.prunedFraction * 100 << "%" << std::endl;
+        return stats;
+    }
+
+    // Expects a tree produced by generateDataset with the same file count.
+    static std::vector<ScalingPoint> runParallelScaling(VFSExplorer& explorer, int filecount,
+                                                        int iterations,
+                                                        const std::vector<size_t>& threadCounts) {
+        std::vector<std::string> fileNames = pickFileNames(filecount, iterations);
+        long long baseline = averageTime(
+            fileNames, [&](const std::string& name) { return explorer.searchByTraversal(name); });
+
+        std::vector<ScalingPoint> points;
+        std::cout << "threads | avg ns | speedup vs sequential (" << baseline << " ns)" << std::endl;
+        for (size_t threads : threadCounts) {
+            long long time = averageTime(fileNames, [&](const std::string& name) {
+                return explorer.searchByParallelTraversal(name, threads);
+            });
+            double speedup = time > 0 ? static_cast<double>(baseline) / time : 0.0;
+            points.push_back({threads, time, speedup});
+            std::cout << threads << " | " << time << " | " << speedup << "x" << std::endl;
+        }
+        return points;
+    }
 };
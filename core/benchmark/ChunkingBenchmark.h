@@ -0,0 +1,196 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include "../persistence/PackStore.h"
+#include "../utils/ContentChunker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct ChunkingBenchmarkResult {
+    std::string corpus;
+    size_t files;
+    std::uint64_t logicalBytes;
+    double wholeFileDedupRatio; // logical bytes over stored bytes with createStoredFile
+    double chunkDedupRatio;     // the same with createChunkedFile
+    double averageChunkBytes;
+    double readAmplification; // chunk bytes touched per byte asked for by 4 KiB readAt
+};
+
+class ChunkingBenchmark {
+  private:
+    static constexpr size_t READ_BYTES = 4096;
+    static constexpr size_t READS_PER_FILE = 16;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "chunking_benchmark";
+
+    static std::string sourceLike(std::mt19937_64& random, size_t bytes) {
+        static const char* const WORDS[] = {"int", "value", "return", "if", "for", "auto",
+                                            "std::string", "const", "size_t", "node",
+                                            "explorer", "path", "(", ")", "{", "}", ";"};
+        std::string text;
+        while (text.size() < bytes) {
+            text.append(4 * (random() % 4), ' ');
+            for (size_t word = random() % 10 + 1; word > 0; --word) {
+                text += WORDS[random() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+                text += ' ';
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    // A few line-sized inserts, deletions and replacements at random places.
+    static std::string edit(std::mt19937_64& random, std::string text, size_t edits) {
+        for (size_t i = 0; i < edits && !text.empty(); ++i) {
+            size_t at = text.find('\n', random() % text.size());
+            at = at == std::string::npos ? text.size() : at + 1;
+            std::string line = "    // revision " + std::to_string(random() % 100000) + "\n";
+            switch (random() % 3) {
+            case 0:
+                text.insert(at, line);
+                break;
+            case 1:
+                text.erase(at, std::min<size_t>(line.size(), text.size() - at));
+                break;
+            default:
+                text.replace(at, std::min<size_t>(line.size(), text.size() - at), line);
+                break;
+            }
+        }
+        return text;
+    }
+
+    static std::uint64_t storedBytes(const std::vector<std::string>& contents, bool chunked,
+                                     const std::string& directory) {
+        PackStoreOptions options;
+        options.backgroundCompaction = false;
+        PackStore store(directory, options);
+        VFSExplorer explorer;
+        explorer.setPackStore(&store);
+        for (size_t i = 0; i < contents.size(); ++i) {
+            std::string name = "f" + std::to_string(i);
+            if (chunked) {
+                explorer.createChunkedFile("/", name, contents[i]);
+            } else {
+                explorer.createStoredFile("/", name, contents[i]);
+            }
+        }
+        return store.getStats().liveBytes;
+    }
+
+    static ChunkingBenchmarkResult measure(const std::string& corpus,
+                                           const std::vector<std::string>& contents) {
+        ChunkingBenchmarkResult result{corpus, contents.size(), 0, 0, 0, 0, 0};
+        for (const auto& content : contents) {
+            result.logicalBytes += content.size();
+        }
+        std::filesystem::remove_all(WORK_DIR);
+        double logical = static_cast<double>(result.logicalBytes);
+        result.wholeFileDedupRatio =
+            logical / storedBytes(contents, false, (WORK_DIR / "whole").string());
+        result.chunkDedupRatio =
+            logical / storedBytes(contents, true, (WORK_DIR / "chunked").string());
+
+        // Read amplification from the chunk boundaries alone: a read maps every chunk it
+        // overlaps.
+        ContentChunker chunker;
+        std::mt19937_64 random(7);
+        size_t chunks = 0;
+        double touched = 0;
+        double requested = 0;
+        for (const auto& content : contents) {
+            std::vector<std::uint64_t> ends;
+            std::uint64_t end = 0;
+            chunker.split(content, [&](std::string_view chunk) {
+                end += chunk.size();
+                ends.push_back(end);
+            });
+            chunks += ends.size();
+            for (size_t read = 0; read < READS_PER_FILE && !content.empty(); ++read) {
+                std::uint64_t at = random() % content.size();
+                std::uint64_t last = std::min<std::uint64_t>(at + READ_BYTES, content.size());
+                auto firstChunk = std::upper_bound(ends.begin(), ends.end(), at);
+                auto lastChunk = std::upper_bound(ends.begin(), ends.end(), last - 1);
+                std::uint64_t start = firstChunk == ends.begin() ? 0 : *(firstChunk - 1);
+                touched += static_cast<double>(*lastChunk - start);
+                requested += static_cast<double>(last - at);
+            }
+        }
+        result.averageChunkBytes = chunks ? logical / chunks : 0;
+        result.readAmplification = requested > 0 ? touched / requested : 0;
+        std::filesystem::remove_all(WORK_DIR);
+
+        std::cout << corpus << ": " << result.files << " files, "
+                  << result.logicalBytes / 1024 << " KiB; dedup whole-file "
+                  << result.wholeFileDedupRatio << "x, chunked " << result.chunkDedupRatio
+                  << "x; average chunk " << result.averageChunkBytes
+                  << " B; read amplification " << result.readAmplification << std::endl;
+        return result;
+    }
+
+  public:
+    // Chunking throughput over random bytes, in GB/s.
+    static double chunkingThroughput(size_t bytes = 256 << 20) {
+        std::mt19937_64 random(1);
+        std::string data(bytes, '\0');
+        for (size_t i = 0; i + 8 <= bytes; i += 8) {
+            std::uint64_t word = random();
+            std::memcpy(&data[i], &word, sizeof(word));
+        }
+        ContentChunker chunker;
+        size_t chunks = 0;
+        auto start = std::chrono::steady_clock::now();
+        chunker.split(data, [&](std::string_view) { ++chunks; });
+        auto end = std::chrono::steady_clock::now();
+        double gbPerSecond = bytes / std::chrono::duration<double>(end - start).count() / 1e9;
+        std::cout << "Chunking: " << gbPerSecond << " GB/s, average chunk "
+                  << bytes / std::max<size_t>(chunks, 1) << " B" << std::endl;
+        return gbPerSecond;
+    }
+
+    // Dedup ratio of whole-file against chunked storage on versions of source-like files,
+    // each a few line edits away from the previous one, and on the resource files with
+    // edited versions of the text ones.
+    static std::vector<ChunkingBenchmarkResult> run(
+        const std::string& resourceDir = "resources/files", size_t baseFiles = 20,
+        size_t versions = 10) {
+        chunkingThroughput();
+        std::vector<ChunkingBenchmarkResult> results;
+        std::mt19937_64 random(42);
+
+        std::vector<std::string> synthetic;
+        for (size_t i = 0; i < baseFiles; ++i) {
+            std::string text = sourceLike(random, 32 * 1024 + random() % (96 * 1024));
+            for (size_t version = 0; version < versions; ++version) {
+                synthetic.push_back(text);
+                text = edit(random, text, 3);
+            }
+        }
+        results.push_back(measure("synthetic versions", synthetic));
+
+        std::vector<std::string> resources;
+        if (std::filesystem::is_directory(resourceDir)) {
+            for (const auto& entry : std::filesystem::directory_iterator(resourceDir)) {
+                std::ifstream input(entry.path(), std::ios::binary);
+                std::string content((std::istreambuf_iterator<char>(input)),
+                                    std::istreambuf_iterator<char>());
+                std::string extension = entry.path().extension().string();
+                bool text = extension == ".java" || extension == ".cpp" ||
+                            extension == ".pro" || extension == ".txt";
+                resources.push_back(content);
+                for (size_t version = 1; text && version < versions; ++version) {
+                    content = edit(random, content, 1);
+                    resources.push_back(content);
+                }
+            }
+            results.push_back(measure("resources", resources));
+        }
+        return results;
+    }
+};
@@ -0,0 +1,172 @@
+#pragma once
+#include "../persistence/CompressedRecord.h"
+#include "../persistence/PackStore.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct CompressionBenchmarkResult {
+    std::string corpus;
+    size_t files;
+    std::uint64_t logicalBytes;
+    double ratio;          // logical bytes over bytes stored in the pack
+    double compressMBps;   // CompressedRecord::encode
+    double decompressMBps; // whole records decoded on the calling thread
+    double mapMBps;        // PackStore::map, every byte read; large records decode in parallel
+};
+
+class CompressionBenchmark {
+  private:
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "compression_benchmark";
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    // Log-like lines: repeated words and field names with varying numbers.
+    static std::string textLike(std::mt19937_64& random, size_t bytes) {
+        static const char* const WORDS[] = {"GET", "POST", "/api/files", "/api/search", "200",
+                                            "404", "user", "session", "explorer", "node",
+                                            "size", "bytes", "ms", "ok", "error"};
+        std::string text;
+        while (text.size() < bytes) {
+            text += "2024-05-" + std::to_string(10 + random() % 20) + " id=" +
+                    std::to_string(random() % 100000);
+            for (size_t word = random() % 8 + 2; word > 0; --word) {
+                text += ' ';
+                text += WORDS[random() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+            }
+            text += '\n';
+        }
+        text.resize(bytes);
+        return text;
+    }
+
+    // Fixed-size records of small counters, flags and a little noise, as in tables and
+    // object files.
+    static std::string binaryLike(std::mt19937_64& random, size_t bytes) {
+        std::string data(bytes, '\0');
+        std::uint32_t counter = 0;
+        for (size_t i = 0; i + 16 <= bytes; i += 16) {
+            counter += static_cast<std::uint32_t>(random() % 4);
+            std::uint32_t fields[4] = {counter, static_cast<std::uint32_t>(random() % 3),
+                                       0x7f000001u, static_cast<std::uint32_t>(random())};
+            std::memcpy(&data[i], fields, sizeof(fields));
+        }
+        return data;
+    }
+
+    static std::string randomBytes(std::mt19937_64& random, size_t bytes) {
+        std::string data(bytes, '\0');
+        for (size_t i = 0; i + 8 <= bytes; i += 8) {
+            std::uint64_t word = random();
+            std::memcpy(&data[i], &word, sizeof(word));
+        }
+        return data;
+    }
+
+    static CompressionBenchmarkResult measure(const std::string& corpus,
+                                              const std::vector<std::string>& contents) {
+        CompressionBenchmarkResult result{corpus, contents.size(), 0, 0, 0, 0, 0};
+        for (const auto& content : contents) {
+            result.logicalBytes += content.size();
+        }
+        double megabytes = static_cast<double>(result.logicalBytes) / 1e6;
+        PackStoreOptions defaults;
+
+        std::vector<std::string> records(contents.size());
+        result.compressMBps = megabytes / seconds([&]() {
+            for (size_t i = 0; i < contents.size(); ++i) {
+                records[i] = CompressedRecord::encode(contents[i], defaults.compressionBlockSize);
+            }
+        });
+        std::vector<char> decoded;
+        result.decompressMBps = megabytes / seconds([&]() {
+            for (size_t i = 0; i < records.size(); ++i) {
+                if (records[i].empty()) {
+                    decoded.assign(contents[i].begin(), contents[i].end());
+                    continue;
+                }
+                CompressedRecord record(records[i].data(), records[i].size());
+                decoded.resize(static_cast<size_t>(record.rawLength()));
+                record.decodeAll(decoded.data());
+            }
+        });
+
+        std::filesystem::remove_all(WORK_DIR);
+        {
+            PackStoreOptions options;
+            options.compression = true;
+            options.backgroundCompaction = false;
+            PackStore store(WORK_DIR.string(), options);
+            std::vector<ContentKey> keys;
+            for (const auto& content : contents) {
+                keys.push_back(store.put(content));
+            }
+            PackStoreStats stats = store.getStats();
+            result.ratio = static_cast<double>(stats.liveBytes) /
+                           static_cast<double>(stats.liveBytes - stats.bytesSaved);
+            size_t checksum = 0;
+            result.mapMBps = megabytes / seconds([&]() {
+                for (const auto& key : keys) {
+                    MappedFile mapped = store.map(key);
+                    for (char c : mapped.view()) {
+                        checksum += static_cast<unsigned char>(c);
+                    }
+                }
+            });
+            volatile size_t sink = checksum;
+            (void)sink;
+        }
+        std::filesystem::remove_all(WORK_DIR);
+
+        std::cout << corpus << ": " << result.files << " files, "
+                  << result.logicalBytes / 1024 << " KiB; ratio " << result.ratio
+                  << "x; compress " << result.compressMBps << " MB/s, decompress "
+                  << result.decompressMBps << " MB/s, pack map " << result.mapMBps << " MB/s"
+                  << std::endl;
+        return result;
+    }
+
+  public:
+    // Compression ratio and throughput of the pack store's block compression on the
+    // resource files and on synthetic text, binary and random corpora. Decoding is
+    // measured from memory, so it excludes page faults on the pack.
+    static std::vector<CompressionBenchmarkResult> run(
+        const std::string& resourceDir = "resources/files", size_t syntheticFiles = 16,
+        size_t syntheticBytes = 4 << 20) {
+        std::vector<CompressionBenchmarkResult> results;
+        if (std::filesystem::is_directory(resourceDir)) {
+            std::vector<std::string> resources;
+            for (const auto& entry : std::filesystem::directory_iterator(resourceDir)) {
+                std::ifstream input(entry.path(), std::ios::binary);
+                resources.emplace_back(std::istreambuf_iterator<char>(input),
+                                       std::istreambuf_iterator<char>());
+            }
+            results.push_back(measure("resources", resources));
+        }
+        std::mt19937_64 random(42);
+        std::vector<std::string> text;
+        std::vector<std::string> binary;
+        std::vector<std::string> noise;
+        for (size_t i = 0; i < syntheticFiles; ++i) {
+            text.push_back(textLike(random, syntheticBytes));
+            binary.push_back(binaryLike(random, syntheticBytes));
+            noise.push_back(randomBytes(random, syntheticBytes));
+        }
+        results.push_back(measure("synthetic text", text));
+        results.push_back(measure("synthetic binary", binary));
+        results.push_back(measure("random bytes", noise));
+        return results;
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include "../search/ContentIndexer.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+struct ContentSearchBenchmarkResult {
+    size_t filesIndexed;
+    std::uintmax_t bytesIndexed;
+    double megabytesPerSecond;
+    double termQueryMicros;
+    double phraseQueryMicros;
+};
+
+class ContentSearchBenchmark {
+  private:
+    static inline const std::filesystem::path CORPUS_DIR =
+        std::filesystem::temp_directory_path() / "content_benchmark_corpus";
+    static constexpr const char* CORPUS_FILE_PREFIX = "doc_";
+    static constexpr int VOCABULARY_SIZE = 20000;
+
+    static std::string word(int index) { return "w" + std::to_string(index); }
+
+    static std::vector<std::string> generateCorpus(int fileCount, int wordsPerFile) {
+        std::filesystem::create_directories(CORPUS_DIR);
+        std::vector<std::string> paths;
+        for (int i = 0; i < fileCount; ++i) {
+            auto path = CORPUS_DIR / (CORPUS_FILE_PREFIX + std::to_string(i) + ".txt");
+            std::ofstream file(path);
+            for (int j = 0; j < wordsPerFile; ++j) {
+                file << word(std::rand() % VOCABULARY_SIZE) << ((j % 12 == 11) ? '\n' : ' ');
+            }
+            paths.push_back(path.string());
+        }
+        return paths;
+    }
+
+    static void removeCorpus() {
+        std::error_code ec;
+        std::filesystem::remove_all(CORPUS_DIR, ec);
+    }
+
+    template <typename Query>
+    static double averageMicros(int iterations, Query query) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            auto v = query(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+    }
+
+  public:
+    // Indexes every file mounted in `explorer` plus a synthetic text corpus.
+    static ContentSearchBenchmarkResult run(const VFSExplorer& explorer, int fileCount = 200,
+                                            int wordsPerFile = 5000, int queries = 100,
+                                            size_t threadCount = ThreadPool::defaultThreadCount()) {
+        std::vector<std::string> paths = generateCorpus(fileCount, wordsPerFile);
+        std::vector<std::string> mounted = explorer.collectPhysicalPaths();
+        paths.insert(paths.end(), mounted.begin(), mounted.end());
+
+        ContentIndexer indexer(threadCount);
+        auto start = std::chrono::steady_clock::now();
+        indexer.indexFiles(paths);
+        indexer.waitIdle();
+        auto end = std::chrono::steady_clock::now();
+
+        ContentSearchBenchmarkResult result{};
+        ContentIndexStats stats = indexer.getStats();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        result.filesIndexed = stats.documents;
+        result.bytesIndexed = stats.bytesIndexed;
+        result.megabytesPerSecond = seconds > 0 ? stats.bytesIndexed / 1e6 / seconds : 0.0;
+
+        result.termQueryMicros = averageMicros(queries, [&](int) {
+            return indexer.findTerm(word(std::rand() % VOCABULARY_SIZE));
+        });
+        result.phraseQueryMicros = averageMicros(queries, [&](int) {
+            return indexer.findPhrase(word(std::rand() % VOCABULARY_SIZE) + " " +
+                                      word(std::rand() % VOCABULARY_SIZE));
+        });
+
+        std::cout << "Content index: " << result.filesIndexed << " files, "
+                  << result.megabytesPerSecond << " MB/s, term query " << result.termQueryMicros
+                  << " us, phrase query " << result.phraseQueryMicros << " us, postings "
+                  << stats.postingBytes << " bytes" << std::endl;
+
+        removeCorpus();
+        return result;
+    }
+};
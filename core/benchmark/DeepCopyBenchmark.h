@@ -0,0 +1,76 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+struct DeepCopyBenchmarkResult {
+    size_t fileCount;
+    size_t fileBytes;
+    double streamCopySeconds; // every host file copied with ifstream/ofstream
+    double serialDeepCopySeconds;
+    double parallelDeepCopySeconds;
+    DeepCopyStats parallelStats;
+};
+
+class DeepCopyBenchmark {
+  private:
+    static constexpr size_t FILES_PER_DIRECTORY = 100;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "deep_copy_benchmark";
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // Deep copies of one mounted subtree: a userspace stream copy of every file, then
+    // deepCopyNode on one thread and on `threadCount`. Page-cache warm; no syncing.
+    static DeepCopyBenchmarkResult run(size_t fileCount = 2000, size_t fileBytes = 64 * 1024,
+                                       size_t threadCount = 8) {
+        std::filesystem::remove_all(WORK_DIR);
+        auto source = WORK_DIR / "source";
+        std::string content(fileBytes, 'c');
+        for (size_t i = 0; i < fileCount; ++i) {
+            auto dir = source / ("d" + std::to_string(i / FILES_PER_DIRECTORY));
+            if (i % FILES_PER_DIRECTORY == 0) {
+                std::filesystem::create_directories(dir);
+            }
+            std::ofstream(dir / ("f" + std::to_string(i) + ".bin"), std::ios::binary) << content;
+        }
+        DeepCopyBenchmarkResult result{fileCount, fileBytes, 0, 0, 0, {}};
+
+        VFSExplorer explorer;
+        explorer.mountHostDirectory(source.string(), "/source");
+        std::vector<std::string> paths = explorer.collectPhysicalPaths();
+        result.streamCopySeconds = seconds([&]() {
+            for (const auto& path : paths) {
+                std::ifstream in(path, std::ios::binary);
+                std::ofstream(path + ".stream", std::ios::binary) << in.rdbuf();
+            }
+        });
+
+        VFSNode* mounted = explorer.getRoot()->getChild("source");
+        result.serialDeepCopySeconds =
+            explorer.deepCopyNode(mounted, "/", false, "serial", 1).seconds;
+        result.parallelStats = explorer.deepCopyNode(mounted, "/", false, "parallel", threadCount);
+        result.parallelDeepCopySeconds = result.parallelStats.seconds;
+        std::filesystem::remove_all(WORK_DIR);
+
+        const DeepCopyStats& stats = result.parallelStats;
+        std::cout << fileCount << " files of " << fileBytes / 1024 << " KiB: stream copy "
+                  << result.streamCopySeconds << " s, deep copy " << result.serialDeepCopySeconds
+                  << " s on 1 thread, " << result.parallelDeepCopySeconds << " s on "
+                  << threadCount << " (" << stats.reflinked << " reflinked, "
+                  << stats.kernelCopied << " in-kernel, " << stats.userspaceCopied
+                  << " userspace, " << stats.userspaceBytes << " B through userspace)"
+                  << std::endl;
+        return result;
+    }
+};
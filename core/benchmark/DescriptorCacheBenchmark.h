@@ -0,0 +1,75 @@
+#pragma once
+#include "../io/FileDescriptorCache.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct DescriptorCacheResult {
+    size_t hotFiles;
+    size_t reads;
+    double uncachedMicrosPerRead;
+    double cachedMicrosPerRead;
+    DescriptorCacheStats stats;
+};
+
+class DescriptorCacheBenchmark {
+  private:
+    static constexpr size_t READ_SIZE = 4096;
+    static constexpr const char* RESOURCE_DIR = "core/resources/files";
+
+    template <typename Reader>
+    static double microsPerRead(const std::vector<std::string>& files, size_t rounds,
+                                Reader reader) {
+        std::vector<char> buffer(READ_SIZE);
+        size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; ++round) {
+            for (const auto& file : files) {
+                sink += reader(file, buffer.data());
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        volatile size_t keep = sink;
+        (void)keep;
+        return std::chrono::duration<double, std::micro>(end - start).count() /
+               (rounds * files.size());
+    }
+
+  public:
+    // Re-reads the first block of every resource file, opening it each time versus
+    // going through the descriptor cache.
+    static DescriptorCacheResult run(size_t rounds = 2000,
+                                     const std::string& resourceDir = RESOURCE_DIR) {
+        std::vector<std::string> files;
+        for (const auto& entry : std::filesystem::directory_iterator(resourceDir)) {
+            if (entry.is_regular_file()) {
+                files.push_back(std::filesystem::absolute(entry.path()).string());
+            }
+        }
+
+        FileDescriptorCache cache(files.size());
+        DescriptorCacheResult result{files.size(), rounds * files.size(), 0, 0, {}};
+        result.uncachedMicrosPerRead =
+            microsPerRead(files, rounds, [](const std::string& path, char* buffer) {
+                std::ifstream input(path, std::ios::binary);
+                input.read(buffer, READ_SIZE);
+                return static_cast<size_t>(input.gcount());
+            });
+        result.cachedMicrosPerRead =
+            microsPerRead(files, rounds, [&cache](const std::string& path, char* buffer) {
+                return cache.readAt(path, 0, buffer, READ_SIZE);
+            });
+        result.stats = cache.getStats();
+
+        std::cout << "Descriptor cache over " << files.size() << " hot files: open per read "
+                  << result.uncachedMicrosPerRead << " us, cached "
+                  << result.cachedMicrosPerRead << " us; open() calls avoided "
+                  << result.stats.opensAvoided << " of " << result.reads
+                  << ", estimated open latency saved "
+                  << result.stats.estimatedNanosSaved / 1e6 << " ms" << std::endl;
+        return result;
+    }
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include "../search/BulkIndexBuilder.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct IndexBuildBenchmarkResult {
+    size_t nameCount;
+    size_t threadCount;
+    double incrementalSeconds;
+    double bulkSeconds;
+    double speedup;
+};
+
+class IndexBuildBenchmark {
+  private:
+    static constexpr size_t FANOUT = 100;
+    static constexpr size_t DISTINCT_FILE_NAMES = 250000;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "index_build_benchmark";
+
+    // Three levels of FANOUT-wide directories. File names repeat every
+    // DISTINCT_FILE_NAMES files, so most names are shared by a few nodes, as in real trees.
+    static void buildTree(VFSExplorer& explorer, size_t nodeCount,
+                          const std::string& physicalPath) {
+        size_t written = 0;
+        for (size_t top = 0; written < nodeCount; ++top) {
+            std::string topName = "t" + std::to_string(top);
+            explorer.createDirectory("/", topName);
+            ++written;
+            for (size_t mid = 0; mid < FANOUT && written < nodeCount; ++mid) {
+                std::string midPath = "/" + topName + "/m" + std::to_string(mid);
+                explorer.createDirectory("/" + topName, "m" + std::to_string(mid));
+                ++written;
+                for (size_t file = 0; file < FANOUT && written < nodeCount; ++file) {
+                    std::string name = "f" + std::to_string(written % DISTINCT_FILE_NAMES);
+                    explorer.addFile(midPath, name, physicalPath, VFSFile::TrustedPath{});
+                    ++written;
+                }
+            }
+        }
+    }
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // Indexing an existing tree one put()/insert() at a time versus the bulk builder, for
+    // each tree size. Both start from the collected node list, so only indexing is timed.
+    static std::vector<IndexBuildBenchmarkResult> run(
+        const std::vector<size_t>& nameCounts = {1000000, 10000000},
+        size_t threadCount = ParallelTraversal::defaultThreadCount()) {
+        std::filesystem::create_directories(WORK_DIR);
+        std::string physicalPath = std::filesystem::absolute(WORK_DIR / "payload.txt").string();
+        std::ofstream(physicalPath) << "index build benchmark payload\n";
+
+        std::vector<IndexBuildBenchmarkResult> results;
+        for (size_t requested : nameCounts) {
+            VFSExplorer explorer;
+            buildTree(explorer, requested, physicalPath);
+            VFSDirectory* root = explorer.getRoot();
+            std::vector<VFSNode*> nodes = ParallelTraversal::collect(
+                root, threadCount, [root](const VFSNode* node) { return node != root; });
+
+            IndexBuildBenchmarkResult result{nodes.size(), threadCount, 0, 0, 0};
+            {
+                FileHashMap map;
+                FileNameTrie trie;
+                result.incrementalSeconds = seconds([&]() {
+                    for (VFSNode* node : nodes) {
+                        map.put(node->getName(), node);
+                        trie.insert(node->getName());
+                    }
+                });
+            }
+            {
+                FileHashMap map;
+                FileNameTrie trie;
+                result.bulkSeconds = seconds(
+                    [&]() { BulkIndexBuilder::build(nodes, map, trie, threadCount); });
+            }
+            result.speedup = result.incrementalSeconds / result.bulkSeconds;
+
+            std::cout << result.nameCount << " names, " << threadCount << " threads: "
+                      << result.incrementalSeconds << " s incremental, " << result.bulkSeconds
+                      << " s bulk (" << result.speedup << "x)" << std::endl;
+            results.push_back(result);
+        }
+
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include "../persistence/Journal.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct JournalBenchmarkResult {
+    JournalSync sync;
+    size_t mutations;
+    double plainMicrosPerMutation;
+    double journaledMicrosPerMutation;
+    double overheadMicrosPerMutation;
+    JournalStats stats;
+};
+
+class JournalBenchmark {
+  private:
+    static constexpr size_t FANOUT = 100;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "journal_benchmark";
+
+    static const char* policyName(JournalSync sync) {
+        switch (sync) {
+        case JournalSync::Never:
+            return "never";
+        case JournalSync::Periodic:
+            return "periodic";
+        case JournalSync::EveryCommit:
+            return "every commit";
+        }
+        return "";
+    }
+
+    // Alternating mkdir/addFile over FANOUT-wide directories, the same mix a script load
+    // produces.
+    static double microsPerMutation(VFSExplorer& explorer, size_t mutations,
+                                    const std::string& physicalPath) {
+        auto start = std::chrono::steady_clock::now();
+        std::string dirPath;
+        for (size_t i = 0; i < mutations; ++i) {
+            if (i % FANOUT == 0) {
+                std::string name = "d" + std::to_string(i / FANOUT);
+                explorer.createDirectory("/", name);
+                dirPath = "/" + name;
+            } else {
+                explorer.addFile(dirPath, "f" + std::to_string(i), physicalPath);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / mutations;
+    }
+
+  public:
+    // Per-mutation cost with and without a journal for each sync policy. EveryCommit
+    // waits for an fsync per mutation from a single thread, so it runs a shorter series.
+    static std::vector<JournalBenchmarkResult> run(size_t mutations = 200000,
+                                                   size_t everyCommitMutations = 2000) {
+        std::filesystem::remove_all(WORK_DIR);
+        std::filesystem::create_directories(WORK_DIR);
+        std::string physicalPath = (WORK_DIR / "payload.txt").string();
+        std::ofstream(physicalPath) << "journal benchmark payload\n";
+
+        std::vector<JournalBenchmarkResult> results;
+        for (JournalSync sync :
+             {JournalSync::Never, JournalSync::Periodic, JournalSync::EveryCommit}) {
+            size_t count = sync == JournalSync::EveryCommit ? everyCommitMutations : mutations;
+            JournalBenchmarkResult result{sync, count, 0, 0, 0, {}};
+            {
+                VFSExplorer plain;
+                result.plainMicrosPerMutation = microsPerMutation(plain, count, physicalPath);
+            }
+            {
+                std::string logDir = (WORK_DIR / policyName(sync)).string();
+                JournalOptions options;
+                options.sync = sync;
+                VFSExplorer journaled;
+                Journal journal(logDir, options);
+                journaled.setMutationLog(&journal);
+                result.journaledMicrosPerMutation =
+                    microsPerMutation(journaled, count, physicalPath);
+                journaled.setMutationLog(nullptr);
+                journal.sync();
+                result.stats = journal.getStats();
+            }
+            result.overheadMicrosPerMutation =
+                result.journaledMicrosPerMutation - result.plainMicrosPerMutation;
+
+            std::cout << "sync " << policyName(sync) << ": " << count << " mutations, "
+                      << result.plainMicrosPerMutation << " us plain, "
+                      << result.journaledMicrosPerMutation << " us journaled (+"
+                      << result.overheadMicrosPerMutation << " us), "
+                      << result.stats.groupCommits << " groups, " << result.stats.syncs
+                      << " fsyncs" << std::endl;
+            results.push_back(result);
+        }
+
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+
+    // Records straight into the journal from several threads with EveryCommit: each
+    // fsync covers every record queued while the previous one ran.
+    static double groupCommitRecordsPerSync(size_t threads = 8, size_t recordsPerThread = 200) {
+        std::filesystem::remove_all(WORK_DIR);
+        JournalOptions options;
+        options.sync = JournalSync::EveryCommit;
+        JournalStats stats;
+        {
+            Journal journal((WORK_DIR / "group").string(), options);
+            std::vector<std::thread> workers;
+            for (size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&journal, t, recordsPerThread]() {
+                    std::string name = "thread" + std::to_string(t);
+                    for (size_t i = 0; i < recordsPerThread; ++i) {
+                        journal.record(MutationOp::CreateDirectory, {"/", name});
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            stats = journal.getStats();
+        }
+        std::filesystem::remove_all(WORK_DIR);
+        double perSync =
+            static_cast<double>(stats.records) / std::max<std::uint64_t>(1, stats.syncs);
+        std::cout << threads << " threads: " << stats.records << " records in " << stats.syncs
+                  << " fsyncs (" << perSync << " per fsync)" << std::endl;
+        return perSync;
+    }
+};
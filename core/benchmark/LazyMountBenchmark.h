@@ -0,0 +1,86 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct LazyMountBenchmarkResult {
+    size_t fileCount;
+    double eagerSeconds;
+    size_t eagerNodes;
+    double lazySeconds;
+    size_t lazyNodes;
+    double firstLookupSeconds; // first access to one leaf directory through the lazy mount
+};
+
+class LazyMountBenchmark {
+  private:
+    static constexpr size_t FILES_PER_DIRECTORY = 1000;
+    static constexpr size_t DIRECTORIES_PER_GROUP = 100;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "lazy_mount_benchmark";
+
+    // Same layout as MountBenchmark: group/dir/file.
+    static void createHostTree(const std::filesystem::path& host, size_t fileCount) {
+        std::filesystem::remove_all(host);
+        for (size_t written = 0, dir = 0; written < fileCount; ++dir) {
+            auto path = host / ("g" + std::to_string(dir / DIRECTORIES_PER_GROUP)) /
+                        ("d" + std::to_string(dir));
+            std::filesystem::create_directories(path);
+            for (size_t f = 0; f < FILES_PER_DIRECTORY && written < fileCount; ++f, ++written) {
+                std::ofstream(path / ("f" + std::to_string(f)));
+            }
+        }
+    }
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // Time to a usable mount and the nodes held afterwards, mountHostDirectory versus
+    // mountLazy, for each tree size. Node counts stand in for memory, which grows with
+    // them. The lazy side also times the first lookup of one file.
+    static std::vector<LazyMountBenchmarkResult> run(
+        const std::vector<size_t>& fileCounts = {10000, 100000, 1000000}) {
+        std::filesystem::path host = WORK_DIR / "host";
+        std::vector<LazyMountBenchmarkResult> results;
+        for (size_t fileCount : fileCounts) {
+            createHostTree(host, fileCount);
+            LazyMountBenchmarkResult result{fileCount, 0, 0, 0, 0, 0};
+            {
+                VFSExplorer explorer;
+                result.eagerSeconds =
+                    seconds([&]() { explorer.mountHostDirectory(host.string(), "/host"); });
+                result.eagerNodes = explorer.getRoot()->getDescendantCount();
+            }
+            {
+                VFSExplorer explorer;
+                VFSDirectory* mount = nullptr;
+                result.lazySeconds =
+                    seconds([&]() { mount = explorer.mountLazy(host.string(), "/host"); });
+                result.lazyNodes = explorer.getRoot()->getDescendantCount();
+                result.firstLookupSeconds = seconds([&]() {
+                    auto* group = static_cast<VFSDirectory*>(mount->getChild("g0"));
+                    auto* dir = static_cast<VFSDirectory*>(group->getChild("d0"));
+                    dir->getChild("f0");
+                });
+            }
+
+            std::cout << fileCount << " files: eager " << result.eagerSeconds << " s, "
+                      << result.eagerNodes << " nodes; lazy " << result.lazySeconds << " s, "
+                      << result.lazyNodes << " nodes, first lookup "
+                      << result.firstLookupSeconds << " s" << std::endl;
+            results.push_back(result);
+        }
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+struct MemoryFileBenchmarkResult {
+    size_t fileCount;
+    size_t fileBytes;
+    double diskCreatesPerSecond;   // createFile, then the content written to the host file
+    double memoryCreatesPerSecond; // createMemoryFile, then MemoryFile::write
+    size_t writeBytes;
+    double diskWriteMBPerSecond; // appends of WRITE_CHUNK bytes to one host file
+    double memoryWriteMBPerSecond;
+};
+
+class MemoryFileBenchmark {
+  private:
+    static constexpr size_t FILES_PER_DIRECTORY = 1000;
+    static constexpr size_t WRITE_CHUNK = 4096;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "memory_file_benchmark";
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    template <typename Create>
+    static double createsPerSecond(VFSExplorer& explorer, size_t count, Create create) {
+        return count / seconds([&]() {
+                   for (size_t i = 0; i < count; ++i) {
+                       std::string dir = "d" + std::to_string(i / FILES_PER_DIRECTORY);
+                       if (i % FILES_PER_DIRECTORY == 0) {
+                           explorer.createDirectory("/", dir);
+                       }
+                       create("/" + dir, "f" + std::to_string(i));
+                   }
+               });
+    }
+
+  public:
+    // Small-file creation with content, and streaming write throughput, of memory files
+    // against files on disk. Disk numbers do not include syncing.
+    static MemoryFileBenchmarkResult run(size_t fileCount = 20000, size_t fileBytes = 1024,
+                                         size_t writeBytes = 256 << 20) {
+        std::filesystem::remove_all(WORK_DIR);
+        std::filesystem::create_directories(WORK_DIR);
+        MemoryFileBenchmarkResult result{fileCount, fileBytes, 0, 0, writeBytes, 0, 0};
+        std::string content(fileBytes, 'm');
+        std::string chunk(WRITE_CHUNK, 'w');
+        double megabytes = writeBytes / double(1 << 20);
+        {
+            VFSExplorer explorer;
+            result.diskCreatesPerSecond = createsPerSecond(
+                explorer, fileCount, [&](const std::string& dir, const std::string& name) {
+                    std::string path = (WORK_DIR / name).string();
+                    explorer.createFile(dir, name, path);
+                    std::ofstream(path, std::ios::binary) << content;
+                });
+            std::string path = (WORK_DIR / "stream.bin").string();
+            result.diskWriteMBPerSecond = megabytes / seconds([&]() {
+                                              std::ofstream out(path, std::ios::binary);
+                                              for (size_t written = 0; written < writeBytes;
+                                                   written += WRITE_CHUNK) {
+                                                  out.write(chunk.data(), WRITE_CHUNK);
+                                              }
+                                          });
+        }
+        {
+            VFSExplorer explorer;
+            result.memoryCreatesPerSecond = createsPerSecond(
+                explorer, fileCount, [&](const std::string& dir, const std::string& name) {
+                    explorer.createMemoryFile(dir, name)->write(0, content);
+                });
+            MemoryFile* file = explorer.createMemoryFile("/", "stream.bin");
+            result.memoryWriteMBPerSecond =
+                megabytes / seconds([&]() {
+                    for (size_t written = 0; written < writeBytes; written += WRITE_CHUNK) {
+                        file->append(chunk);
+                    }
+                });
+        }
+        std::filesystem::remove_all(WORK_DIR);
+
+        std::cout << fileCount << " files of " << fileBytes << " B: disk "
+                  << result.diskCreatesPerSecond << "/s, memory " << result.memoryCreatesPerSecond
+                  << "/s; " << writeBytes / (1 << 20) << " MiB of appends: disk "
+                  << result.diskWriteMBPerSecond << " MB/s, memory "
+                  << result.memoryWriteMBPerSecond << " MB/s" << std::endl;
+        return result;
+    }
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct MountBenchmarkResult {
+    size_t fileCount;
+    size_t threadCount;
+    double perFileSeconds;
+    double mountSeconds;
+    double filesPerSecond;
+    double speedup;
+};
+
+class MountBenchmark {
+  private:
+    static constexpr size_t FILES_PER_DIRECTORY = 1000;
+    static constexpr size_t DIRECTORIES_PER_GROUP = 100;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "mount_benchmark";
+
+    // group/dir/file, FILES_PER_DIRECTORY empty files per leaf directory.
+    static void createHostTree(const std::filesystem::path& host, size_t fileCount) {
+        std::filesystem::remove_all(host);
+        for (size_t written = 0, dir = 0; written < fileCount; ++dir) {
+            auto path = host / ("g" + std::to_string(dir / DIRECTORIES_PER_GROUP)) /
+                        ("d" + std::to_string(dir));
+            std::filesystem::create_directories(path);
+            for (size_t f = 0; f < FILES_PER_DIRECTORY && written < fileCount; ++f, ++written) {
+                std::ofstream(path / ("f" + std::to_string(f)));
+            }
+        }
+    }
+
+    // What importing a tree took before: one createDirectory/addFile per host entry.
+    static void importPerFile(VFSExplorer& explorer, const std::filesystem::path& host) {
+        explorer.createDirectory("/", "host");
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(host)) {
+            std::string relative = entry.path().lexically_relative(host).string();
+            std::string parent = PathUtils::getParentPath("/host/" + relative);
+            std::string name = entry.path().filename().string();
+            if (entry.is_directory()) {
+                explorer.createDirectory(parent, name);
+            } else {
+                explorer.addFile(parent, name, entry.path().string());
+            }
+        }
+    }
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // Per-file import versus mountHostDirectory for each tree size. The host tree is read
+    // once before timing so both runs see a warm dentry cache.
+    static std::vector<MountBenchmarkResult> run(
+        const std::vector<size_t>& fileCounts = {1000000},
+        size_t threadCount = ThreadPool::defaultThreadCount()) {
+        std::filesystem::path host = WORK_DIR / "host";
+        std::vector<MountBenchmarkResult> results;
+        for (size_t fileCount : fileCounts) {
+            createHostTree(host, fileCount);
+            MountBenchmarkResult result{fileCount, threadCount, 0, 0, 0, 0};
+            {
+                VFSExplorer warmup;
+                warmup.mountHostDirectory(host.string(), "/host", threadCount);
+            }
+            {
+                VFSExplorer explorer;
+                result.perFileSeconds = seconds([&]() { importPerFile(explorer, host); });
+            }
+            {
+                VFSExplorer explorer;
+                MountStats stats;
+                result.mountSeconds = seconds([&]() {
+                    stats = explorer.mountHostDirectory(host.string(), "/host", threadCount);
+                });
+                result.filesPerSecond = stats.filesPerSecond;
+            }
+            result.speedup = result.perFileSeconds / result.mountSeconds;
+
+            std::cout << fileCount << " files, " << threadCount << " threads: "
+                      << result.perFileSeconds << " s per file, " << result.mountSeconds
+                      << " s mount (" << static_cast<size_t>(result.filesPerSecond)
+                      << " files/s, " << result.speedup << "x)" << std::endl;
+            results.push_back(result);
+        }
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+};
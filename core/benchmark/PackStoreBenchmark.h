@@ -0,0 +1,121 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include "../persistence/PackStore.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct PackStoreBenchmarkConfig {
+    size_t fileCount;
+    size_t fileBytes;
+};
+
+struct PackStoreBenchmarkResult {
+    size_t fileCount;
+    size_t fileBytes;
+    double hostCreatesPerSecond; // createFile plus writing the content to its host file
+    double packCreatesPerSecond; // createStoredFile
+    double hostReadsPerSecond;   // mapReadOnly of every file, each byte touched
+    double packReadsPerSecond;
+    PackStoreStats stats;
+};
+
+class PackStoreBenchmark {
+  private:
+    static constexpr size_t FILES_PER_DIRECTORY = 1000;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "pack_store_benchmark";
+
+    // Distinct content per file so nothing is deduplicated.
+    static std::string contentOf(size_t index, size_t bytes) {
+        std::string content = std::to_string(index) + ":";
+        content.resize(bytes, static_cast<char>('a' + index % 26));
+        return content;
+    }
+
+    template <typename Create>
+    static double perSecond(VFSExplorer& explorer, size_t count, Create create) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            std::string dir = "d" + std::to_string(i / FILES_PER_DIRECTORY);
+            if (i % FILES_PER_DIRECTORY == 0) {
+                explorer.createDirectory("/", dir);
+            }
+            create(dir, "f" + std::to_string(i), i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return count / std::chrono::duration<double>(end - start).count();
+    }
+
+    static double readsPerSecond(VFSExplorer& explorer, size_t count) {
+        std::vector<VFSFile*> files;
+        for (size_t i = 0; i < count; ++i) {
+            files.push_back(static_cast<VFSFile*>(
+                explorer.searchByIndex("f" + std::to_string(i)).front()));
+        }
+        auto start = std::chrono::steady_clock::now();
+        size_t checksum = 0;
+        for (VFSFile* file : files) {
+            MappedFile mapped = file->mapReadOnly();
+            for (char c : mapped.view()) {
+                checksum += static_cast<unsigned char>(c);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        volatile size_t sink = checksum;
+        (void)sink;
+        return count / std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // Small-file create and read throughput of stored files against one host file per
+    // node. Stored contents reach the OS on every create but are not synced, like the
+    // host files.
+    static std::vector<PackStoreBenchmarkResult> run(
+        const std::vector<PackStoreBenchmarkConfig>& configs = {{20000, 1 << 10},
+                                                                {20000, 16 << 10}}) {
+        std::vector<PackStoreBenchmarkResult> results;
+        for (const auto& config : configs) {
+            std::filesystem::remove_all(WORK_DIR);
+            std::filesystem::create_directories(WORK_DIR / "host");
+            PackStoreBenchmarkResult result{config.fileCount, config.fileBytes, 0, 0, 0, 0, {}};
+            {
+                VFSExplorer explorer;
+                result.hostCreatesPerSecond = perSecond(
+                    explorer, config.fileCount,
+                    [&](const std::string& dir, const std::string& name, size_t i) {
+                        std::string path = (WORK_DIR / "host" / name).string();
+                        std::ofstream(path, std::ios::binary)
+                            << contentOf(i, config.fileBytes);
+                        explorer.addFile("/" + dir, name, path);
+                    });
+                result.hostReadsPerSecond = readsPerSecond(explorer, config.fileCount);
+            }
+            {
+                PackStore store((WORK_DIR / "packs").string());
+                VFSExplorer explorer;
+                explorer.setPackStore(&store);
+                result.packCreatesPerSecond = perSecond(
+                    explorer, config.fileCount,
+                    [&](const std::string& dir, const std::string& name, size_t i) {
+                        explorer.createStoredFile("/" + dir, name,
+                                                  contentOf(i, config.fileBytes));
+                    });
+                result.packReadsPerSecond = readsPerSecond(explorer, config.fileCount);
+                result.stats = store.getStats();
+            }
+
+            std::cout << config.fileCount << " files of " << config.fileBytes
+                      << " B: create host " << result.hostCreatesPerSecond << "/s, pack "
+                      << result.packCreatesPerSecond << "/s; read host "
+                      << result.hostReadsPerSecond << "/s, pack " << result.packReadsPerSecond
+                      << "/s; " << result.stats.packs << " packs" << std::endl;
+            results.push_back(result);
+        }
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+};
@@ -0,0 +1,144 @@
+#pragma once
+#include "../io/MappedFile.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+struct ReadThroughputResult {
+    std::string corpus;
+    std::uintmax_t bytes;
+    double ifstreamMegabytesPerSecond;
+    double readMegabytesPerSecond;
+    double mmapMegabytesPerSecond;
+};
+
+class ReadThroughputBenchmark {
+  private:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+    static constexpr const char* RESOURCE_DIR = "core/resources/files";
+    static inline const std::string SYNTHETIC_FILE =
+        (std::filesystem::temp_directory_path() / "read_benchmark_large.bin").string();
+
+    // Touches every byte so that no strategy gets away without reading.
+    static std::uint64_t consume(const char* data, size_t length, std::uint64_t checksum) {
+        size_t i = 0;
+        for (; i + sizeof(std::uint64_t) <= length; i += sizeof(std::uint64_t)) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            checksum += word;
+        }
+        for (; i < length; ++i) {
+            checksum += static_cast<unsigned char>(data[i]);
+        }
+        return checksum;
+    }
+
+    static std::uint64_t readWithIfstream(const std::string& path) {
+        std::ifstream input(path, std::ios::binary);
+        std::vector<char> buffer(BUFFER_SIZE);
+        std::uint64_t checksum = 0;
+        while (input.read(buffer.data(), buffer.size()) || input.gcount() > 0) {
+            checksum = consume(buffer.data(), static_cast<size_t>(input.gcount()), checksum);
+        }
+        return checksum;
+    }
+
+    static std::uint64_t readWithSyscall(const std::string& path) {
+#if VFS_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return 0;
+        }
+        std::vector<char> buffer(BUFFER_SIZE);
+        std::uint64_t checksum = 0;
+        ssize_t count;
+        while ((count = ::read(fd, buffer.data(), buffer.size())) > 0) {
+            checksum = consume(buffer.data(), static_cast<size_t>(count), checksum);
+        }
+        ::close(fd);
+        return checksum;
+#else
+        return readWithIfstream(path);
+#endif
+    }
+
+    static std::uint64_t readWithMmap(const std::string& path) {
+        MappedFile file(path, AccessPattern::Sequential);
+        return consume(file.data(), file.size(), 0);
+    }
+
+    template <typename Reader>
+    static double megabytesPerSecond(const std::vector<std::string>& files, std::uintmax_t bytes,
+                                     int repetitions, Reader reader) {
+        std::uint64_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repetitions; ++i) {
+            for (const auto& file : files) {
+                sink += reader(file);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        volatile std::uint64_t keep = sink;
+        (void)keep;
+        return seconds > 0 ? bytes * repetitions / 1e6 / seconds : 0.0;
+    }
+
+    static ReadThroughputResult measure(const std::string& corpus,
+                                        const std::vector<std::string>& files, int repetitions) {
+        std::uintmax_t bytes = 0;
+        for (const auto& file : files) {
+            bytes += std::filesystem::file_size(file);
+        }
+
+        ReadThroughputResult result{corpus, bytes, 0, 0, 0};
+        result.ifstreamMegabytesPerSecond =
+            megabytesPerSecond(files, bytes, repetitions, readWithIfstream);
+        result.readMegabytesPerSecond =
+            megabytesPerSecond(files, bytes, repetitions, readWithSyscall);
+        result.mmapMegabytesPerSecond = megabytesPerSecond(files, bytes, repetitions, readWithMmap);
+
+        std::cout << corpus << " (" << bytes << " bytes): ifstream "
+                  << result.ifstreamMegabytesPerSecond << " MB/s, read() "
+                  << result.readMegabytesPerSecond << " MB/s, mmap "
+                  << result.mmapMegabytesPerSecond << " MB/s" << std::endl;
+        return result;
+    }
+
+    static void createSyntheticFile(size_t megabytes) {
+        std::ofstream file(SYNTHETIC_FILE, std::ios::binary);
+        std::vector<char> block(1024 * 1024);
+        for (size_t i = 0; i < block.size(); ++i) {
+            block[i] = static_cast<char>(std::rand());
+        }
+        for (size_t i = 0; i < megabytes; ++i) {
+            file.write(block.data(), static_cast<std::streamsize>(block.size()));
+        }
+    }
+
+  public:
+    // Warm-cache throughput of the three read paths on the resource files and on one
+    // large synthetic file.
+    static std::vector<ReadThroughputResult> run(size_t syntheticMegabytes = 256,
+                                                 int repetitions = 5,
+                                                 const std::string& resourceDir = RESOURCE_DIR) {
+        std::vector<ReadThroughputResult> results;
+
+        std::vector<std::string> resources;
+        for (const auto& entry : std::filesystem::directory_iterator(resourceDir)) {
+            if (entry.is_regular_file()) {
+                resources.push_back(entry.path().string());
+            }
+        }
+        results.push_back(measure("resources", resources, repetitions * 100));
+
+        createSyntheticFile(syntheticMegabytes);
+        results.push_back(measure("synthetic", {SYNTHETIC_FILE}, repetitions));
+        std::filesystem::remove(SYNTHETIC_FILE);
+
+        return results;
+    }
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include "../io/ReadaheadStream.h"
+#include "../utils/PageCache.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct ReadaheadResult {
+    std::string corpus;
+    bool coldCache;
+    std::uintmax_t bytes;
+    double ifstreamMegabytesPerSecond;
+    double readaheadMegabytesPerSecond;
+};
+
+class ReadaheadBenchmark {
+  private:
+    static constexpr size_t CONSUMER_READ = 4096;
+    static constexpr const char* RESOURCE_DIR = "core/resources/files";
+    static inline const std::string SYNTHETIC_FILE =
+        (std::filesystem::temp_directory_path() / "readahead_benchmark_large.bin").string();
+
+    // Small reads with some per-byte work, like a decoder consuming a media file; this
+    // is the time readahead can overlap with I/O.
+    static std::uint64_t consume(std::istream& input) {
+        std::vector<char> buffer(CONSUMER_READ);
+        std::uint64_t checksum = 0;
+        while (input.read(buffer.data(), buffer.size()) || input.gcount() > 0) {
+            for (std::streamsize i = 0; i < input.gcount(); ++i) {
+                checksum = checksum * 31 + static_cast<unsigned char>(buffer[i]);
+            }
+        }
+        return checksum;
+    }
+
+    template <typename Opener>
+    static double megabytesPerSecond(const std::vector<std::string>& files, std::uintmax_t bytes,
+                                     bool coldCache, Opener open) {
+        if (coldCache) {
+            PageCache::evict(files);
+        }
+        std::uint64_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& file : files) {
+            auto stream = open(file);
+            sink += consume(*stream);
+        }
+        auto end = std::chrono::steady_clock::now();
+        volatile std::uint64_t keep = sink;
+        (void)keep;
+        double seconds = std::chrono::duration<double>(end - start).count();
+        return seconds > 0 ? bytes / 1e6 / seconds : 0.0;
+    }
+
+    static ReadaheadResult measure(const std::string& corpus, const std::vector<std::string>& files,
+                                   bool coldCache) {
+        std::uintmax_t bytes = 0;
+        for (const auto& file : files) {
+            bytes += std::filesystem::file_size(file);
+        }
+
+        ReadaheadResult result{corpus, coldCache, bytes, 0, 0};
+        result.ifstreamMegabytesPerSecond =
+            megabytesPerSecond(files, bytes, coldCache, [](const std::string& path) {
+                return std::make_unique<std::ifstream>(path, std::ios::binary);
+            });
+        result.readaheadMegabytesPerSecond =
+            megabytesPerSecond(files, bytes, coldCache, [](const std::string& path) {
+                return std::make_unique<ReadaheadStream>(path);
+            });
+
+        std::cout << corpus << (coldCache ? " cold" : " warm") << " (" << bytes
+                  << " bytes): ifstream " << result.ifstreamMegabytesPerSecond
+                  << " MB/s, readahead " << result.readaheadMegabytesPerSecond << " MB/s"
+                  << std::endl;
+        return result;
+    }
+
+  public:
+    // Streams the .jpg and .pdf resources and one large synthetic file through both
+    // readers, on a cold and on a warm page cache.
+    static std::vector<ReadaheadResult> run(size_t syntheticMegabytes = 512,
+                                            const std::string& resourceDir = RESOURCE_DIR) {
+        std::vector<std::string> media;
+        for (const auto& entry : std::filesystem::directory_iterator(resourceDir)) {
+            auto extension = entry.path().extension();
+            if (entry.is_regular_file() && (extension == ".jpg" || extension == ".pdf")) {
+                media.push_back(entry.path().string());
+            }
+        }
+
+        {
+            std::ofstream file(SYNTHETIC_FILE, std::ios::binary);
+            std::vector<char> block(1024 * 1024);
+            for (auto& byte : block) {
+                byte = static_cast<char>(std::rand());
+            }
+            for (size_t i = 0; i < syntheticMegabytes; ++i) {
+                file.write(block.data(), static_cast<std::streamsize>(block.size()));
+            }
+        }
+
+        std::vector<ReadaheadResult> results;
+        for (bool coldCache : {true, false}) {
+            results.push_back(measure("media", media, coldCache));
+            results.push_back(measure("synthetic", {SYNTHETIC_FILE}, coldCache));
+        }
+        std::filesystem::remove(SYNTHETIC_FILE);
+        return results;
+    }
+};
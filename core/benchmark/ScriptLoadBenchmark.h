@@ -0,0 +1,107 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include "../utils/ScriptLoader.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct ScriptLoadBenchmarkResult {
+    size_t lineCount;
+    double loadSeconds;
+    double fastLoadSeconds;
+    double fastLinesPerSecond;
+    double speedup;
+};
+
+class ScriptLoadBenchmark {
+  private:
+    static constexpr size_t FANOUT = 100;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "script_load_benchmark";
+
+    // Same shape as SnapshotBenchmark's script: three levels of FANOUT-wide directories
+    // with files at the bottom.
+    static size_t writeScript(const std::string& scriptPath, const std::string& physicalPath,
+                              size_t lineCount) {
+        std::ofstream script(scriptPath);
+        size_t written = 0;
+        for (size_t top = 0; written < lineCount; ++top) {
+            std::string topPath = "/t" + std::to_string(top);
+            script << "mkdir " << topPath << '\n';
+            ++written;
+            for (size_t mid = 0; mid < FANOUT && written < lineCount; ++mid) {
+                std::string midPath = topPath + "/m" + std::to_string(mid);
+                script << "mkdir " << midPath << '\n';
+                ++written;
+                for (size_t file = 0; file < FANOUT && written < lineCount; ++file) {
+                    script << "mkfile " << midPath << "/f" << file << ' ' << physicalPath
+                           << '\n';
+                    ++written;
+                }
+            }
+        }
+        return written;
+    }
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // load() with its per-entry output silenced versus loadFast() for each script size.
+    // `withPlainLoad` = false skips load(), which takes minutes at 10M lines.
+    static std::vector<ScriptLoadBenchmarkResult> run(
+        const std::vector<size_t>& lineCounts = {1000000, 10000000}, bool withPlainLoad = true) {
+        std::filesystem::create_directories(WORK_DIR);
+        std::string physicalPath = (WORK_DIR / "payload.txt").string();
+        std::string scriptPath = (WORK_DIR / "script.txt").string();
+        std::ofstream(physicalPath) << "script load benchmark payload\n";
+
+        std::vector<ScriptLoadBenchmarkResult> results;
+        for (size_t requested : lineCounts) {
+            ScriptLoadBenchmarkResult result{};
+            result.lineCount = writeScript(scriptPath, physicalPath, requested);
+
+            if (withPlainLoad) {
+                VFSExplorer explorer;
+                std::ostream::iostate outState = std::cout.rdstate();
+                std::cout.setstate(std::ios::failbit);
+                result.loadSeconds =
+                    seconds([&]() { ScriptLoader::load(explorer, scriptPath.c_str()); });
+                std::cout.clear(outState);
+            }
+            {
+                VFSExplorer explorer;
+                ScriptLoadOptions options;
+                options.logSummary = false;
+                ScriptLoadStats stats;
+                result.fastLoadSeconds = seconds(
+                    [&]() { stats = ScriptLoader::loadFast(explorer, scriptPath, options); });
+                result.fastLinesPerSecond = stats.linesPerSecond;
+            }
+            result.speedup = withPlainLoad ? result.loadSeconds / result.fastLoadSeconds : 0;
+
+            std::cout << result.lineCount << " lines: ";
+            if (withPlainLoad) {
+                std::cout << result.loadSeconds << " s load, ";
+            }
+            std::cout << result.fastLoadSeconds << " s fast ("
+                      << static_cast<size_t>(result.fastLinesPerSecond) << " lines/s";
+            if (withPlainLoad) {
+                std::cout << ", " << result.speedup << "x";
+            }
+            std::cout << ")" << std::endl;
+            results.push_back(result);
+        }
+
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+};
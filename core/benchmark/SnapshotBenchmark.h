@@ -0,0 +1,123 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include "../persistence/VFSSnapshot.h"
+#include "../utils/ScriptLoader.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct SnapshotBenchmarkResult {
+    size_t nodeCount;
+    std::uint64_t snapshotBytes;
+    double scriptReplaySeconds;
+    double saveSeconds;
+    double loadSeconds;
+    double loadWithoutIndexesSeconds;
+    double loadWithIndexImageSeconds;
+    std::uint64_t indexImageBytes;
+};
+
+class SnapshotBenchmark {
+  private:
+    static constexpr size_t FANOUT = 100;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "snapshot_benchmark";
+
+    // Three levels of FANOUT-wide directories with files at the bottom, so no directory
+    // is wide enough to make the loader's linear child lookup dominate.
+    static size_t writeScript(const std::string& scriptPath, const std::string& physicalPath,
+                              size_t nodeCount) {
+        std::ofstream script(scriptPath);
+        size_t written = 0;
+        for (size_t top = 0; written < nodeCount; ++top) {
+            std::string topPath = "/t" + std::to_string(top);
+            script << "mkdir " << topPath << '\n';
+            ++written;
+            for (size_t mid = 0; mid < FANOUT && written < nodeCount; ++mid) {
+                std::string midPath = topPath + "/m" + std::to_string(mid);
+                script << "mkdir " << midPath << '\n';
+                ++written;
+                for (size_t file = 0; file < FANOUT && written < nodeCount; ++file) {
+                    script << "mkfile " << midPath << "/f" << file << ' ' << physicalPath
+                           << '\n';
+                    ++written;
+                }
+            }
+        }
+        return written;
+    }
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // Script replay versus snapshot save and load for each tree size, the load restoring
+    // the index sections, rebuilding the indexes, or mapping a separate index image. The
+    // loader's per-entry logging is silenced so that replay measures tree building only.
+    static std::vector<SnapshotBenchmarkResult> run(
+        const std::vector<size_t>& nodeCounts = {1000000, 10000000}) {
+        std::filesystem::create_directories(WORK_DIR);
+        std::string physicalPath = (WORK_DIR / "payload.txt").string();
+        std::string scriptPath = (WORK_DIR / "script.txt").string();
+        std::string snapshotPath = (WORK_DIR / "tree.snapshot").string();
+        std::string imagePath = (WORK_DIR / "tree.index").string();
+        std::ofstream(physicalPath) << "snapshot benchmark payload\n";
+
+        std::vector<SnapshotBenchmarkResult> results;
+        for (size_t requested : nodeCounts) {
+            SnapshotBenchmarkResult result{};
+            result.nodeCount = writeScript(scriptPath, physicalPath, requested);
+
+            auto explorer = std::make_unique<VFSExplorer>();
+            std::ostream::iostate outState = std::cout.rdstate();
+            std::cout.setstate(std::ios::failbit);
+            result.scriptReplaySeconds =
+                seconds([&]() { ScriptLoader::load(*explorer, scriptPath.c_str()); });
+            std::cout.clear(outState);
+
+            SnapshotOptions withImage;
+            withImage.indexImagePath = imagePath;
+            result.saveSeconds = seconds([&]() {
+                result.snapshotBytes = VFSSnapshot::save(*explorer, snapshotPath, withImage).bytes;
+            });
+            result.indexImageBytes = std::filesystem::file_size(imagePath);
+            explorer.reset();
+
+            {
+                VFSExplorer restored;
+                result.loadSeconds = seconds([&]() { VFSSnapshot::load(restored, snapshotPath); });
+            }
+            {
+                VFSExplorer restored;
+                SnapshotOptions options;
+                options.includeIndexes = false;
+                result.loadWithoutIndexesSeconds =
+                    seconds([&]() { VFSSnapshot::load(restored, snapshotPath, options); });
+            }
+            {
+                VFSExplorer restored;
+                result.loadWithIndexImageSeconds =
+                    seconds([&]() { VFSSnapshot::load(restored, snapshotPath, withImage); });
+            }
+
+            std::cout << result.nodeCount << " nodes: script replay " << result.scriptReplaySeconds
+                      << " s, save " << result.saveSeconds << " s (" << result.snapshotBytes
+                      << " bytes), load " << result.loadSeconds << " s, load rebuilding indexes "
+                      << result.loadWithoutIndexesSeconds << " s, load mapping the index image "
+                      << result.loadWithIndexImageSeconds << " s (" << result.indexImageBytes
+                      << " bytes)" << std::endl;
+            results.push_back(result);
+        }
+
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include "../domain/HostFileWatcher.h"
+#include "../domain/VFSExplorer.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct WatchBenchmarkResult {
+    size_t fileCount;
+    double meanVisibleMs;  // host write -> new size visible through the VFS
+    double p99VisibleMs;
+    size_t churnWrites;
+    double churnSeconds;
+    WatchStats stats;      // of the churn phase
+    double cpuMicrosPerWrite;
+};
+
+class WatchBenchmark {
+  private:
+    static constexpr size_t FILES_PER_DIRECTORY = 1000;
+    static constexpr size_t LATENCY_SAMPLES = 200;
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "watch_benchmark";
+
+    static std::vector<std::string> createHostTree(const std::filesystem::path& host,
+                                                   size_t fileCount) {
+        std::filesystem::remove_all(host);
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < fileCount; ++i) {
+            auto dir = host / ("d" + std::to_string(i / FILES_PER_DIRECTORY));
+            std::filesystem::create_directories(dir);
+            paths.push_back((dir / ("f" + std::to_string(i))).string());
+            std::ofstream(paths.back()) << 'x';
+        }
+        return paths;
+    }
+
+    static void append(const std::string& path) { std::ofstream(path, std::ios::app) << 'x'; }
+
+  public:
+    // Latency from a host write to the new size being visible, sampled one write at a
+    // time, then `churnSeconds` of back-to-back appends to random files to measure the
+    // watcher's CPU cost under load.
+    static std::vector<WatchBenchmarkResult> run(const std::vector<size_t>& fileCounts = {10000,
+                                                                                        100000},
+                                                 double churnSeconds = 2.0) {
+        std::filesystem::path host = WORK_DIR / "host";
+        std::vector<WatchBenchmarkResult> results;
+        for (size_t fileCount : fileCounts) {
+            std::vector<std::string> paths = createHostTree(host, fileCount);
+            WatchBenchmarkResult result{fileCount, 0, 0, 0, churnSeconds, {}, 0};
+            VFSExplorer explorer;
+            explorer.mountHostDirectory(host.string(), "/host");
+            std::mt19937_64 random(42);
+            {
+                HostFileWatcher watcher(explorer);
+                watcher.watch("/host");
+
+                std::vector<double> visibleMs;
+                for (size_t sample = 0; sample < LATENCY_SAMPLES; ++sample) {
+                    const std::string& path = paths[random() % paths.size()];
+                    VFSFile* file;
+                    size_t expected;
+                    {
+                        auto lock = watcher.lockTree();
+                        file = explorer.findByPhysicalPath(path).front();
+                        expected = file->getSize() + 1;
+                    }
+                    auto start = std::chrono::steady_clock::now();
+                    append(path);
+                    while (true) {
+                        auto lock = watcher.lockTree();
+                        if (file->getSize() == expected) {
+                            break;
+                        }
+                    }
+                    visibleMs.push_back(std::chrono::duration<double, std::milli>(
+                                            std::chrono::steady_clock::now() - start)
+                                            .count());
+                }
+                std::sort(visibleMs.begin(), visibleMs.end());
+                for (double ms : visibleMs) {
+                    result.meanVisibleMs += ms / visibleMs.size();
+                }
+                result.p99VisibleMs = visibleMs[visibleMs.size() * 99 / 100];
+
+                WatchStats before = watcher.getStats();
+                auto end = std::chrono::steady_clock::now() +
+                           std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(churnSeconds));
+                while (std::chrono::steady_clock::now() < end) {
+                    append(paths[random() % paths.size()]);
+                    ++result.churnWrites;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                WatchStats after = watcher.getStats();
+                result.stats = after;
+                result.stats.events -= before.events;
+                result.stats.batches -= before.batches;
+                result.stats.sizeUpdates -= before.sizeUpdates;
+                result.stats.cpuSeconds -= before.cpuSeconds;
+                result.cpuMicrosPerWrite = result.stats.cpuSeconds * 1e6 / result.churnWrites;
+            }
+
+            std::cout << fileCount << " files: visible after " << result.meanVisibleMs
+                      << " ms mean, " << result.p99VisibleMs << " ms p99; churn "
+                      << result.churnWrites << " writes, " << result.stats.events
+                      << " events in " << result.stats.batches << " batches, "
+                      << result.stats.sizeUpdates << " size updates, watcher CPU "
+                      << result.stats.cpuSeconds << " s (" << result.cpuMicrosPerWrite
+                      << " us/write)" << std::endl;
+            results.push_back(result);
+        }
+        std::filesystem::remove_all(WORK_DIR);
+        return results;
+    }
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "../domain/VFSExplorer.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+struct WriteBackBenchmarkResult {
+    size_t appendCount;
+    size_t appendBytes;
+    double reopenAppendsPerSecond; // an ofstream opened in append mode for every write
+    double ofstreamAppendsPerSecond; // one ofstream kept open
+    double streamAppendsPerSecond;   // VFSFile::openWriteStream
+    std::uint64_t streamHostWrites;
+};
+
+class WriteBackBenchmark {
+  private:
+    static inline const std::filesystem::path WORK_DIR =
+        std::filesystem::temp_directory_path() / "write_back_benchmark";
+
+    template <typename Action>
+    static double seconds(Action action) {
+        auto start = std::chrono::steady_clock::now();
+        action();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+  public:
+    // Many small appends to one file. The first two write the physical path directly,
+    // as callers did before write streams; the stream also keeps the cached sizes
+    // current. None of the numbers include syncing.
+    static WriteBackBenchmarkResult run(size_t appendCount = 200000, size_t appendBytes = 64) {
+        std::filesystem::remove_all(WORK_DIR);
+        std::filesystem::create_directories(WORK_DIR);
+        WriteBackBenchmarkResult result{appendCount, appendBytes, 0, 0, 0, 0};
+        std::string record(appendBytes - 1, 'r');
+        record += '\n';
+        std::string path = (WORK_DIR / "log.txt").string();
+
+        // Reopening is far slower; a tenth of the appends is enough to measure it.
+        size_t reopenCount = appendCount / 10;
+        std::ofstream(path, std::ios::binary);
+        result.reopenAppendsPerSecond = reopenCount / seconds([&]() {
+                                            for (size_t i = 0; i < reopenCount; ++i) {
+                                                std::ofstream(path, std::ios::binary |
+                                                                        std::ios::app)
+                                                    << record;
+                                            }
+                                        });
+
+        result.ofstreamAppendsPerSecond =
+            appendCount / seconds([&]() {
+                std::ofstream out(path, std::ios::binary | std::ios::trunc);
+                for (size_t i = 0; i < appendCount; ++i) {
+                    out.write(record.data(), static_cast<std::streamsize>(record.size()));
+                }
+            });
+
+        VFSExplorer explorer;
+        explorer.createFile("/", "log.txt", path);
+        auto* file = static_cast<VFSFile*>(explorer.getRoot()->getChild("log.txt"));
+        file->updateCachedSize(static_cast<std::int64_t>(file->getSize()));
+        result.streamAppendsPerSecond =
+            appendCount / seconds([&]() {
+                auto stream = file->openWriteStream(WriteMode::Truncate);
+                for (size_t i = 0; i < appendCount; ++i) {
+                    stream->write(record.data(), static_cast<std::streamsize>(record.size()));
+                }
+                stream->close();
+                result.streamHostWrites = stream->getStats().targetWrites;
+            });
+        if (explorer.getRoot()->getSize() != appendCount * appendBytes) {
+            throw std::runtime_error("Cached size does not match the appended bytes");
+        }
+        std::filesystem::remove_all(WORK_DIR);
+
+        std::cout << appendCount << " appends of " << appendBytes << " B: reopened ofstream "
+                  << result.reopenAppendsPerSecond << "/s, open ofstream "
+                  << result.ofstreamAppendsPerSecond << "/s, write stream "
+                  << result.streamAppendsPerSecond << "/s in " << result.streamHostWrites
+                  << " host writes" << std::endl;
+        return result;
+    }
+};
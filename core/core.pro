@@ -4,18 +4,81 @@ CONFIG += staticlib
 TARGET = core
 
 HEADERS += \
+    benchmark/ArchiveMountBenchmark.h \
+    benchmark/AsyncIOBenchmark.h \
     benchmark/BenchmarkService.h \
+    benchmark/ChunkingBenchmark.h \
+    benchmark/CompressionBenchmark.h \
+    benchmark/ContentSearchBenchmark.h \
+    benchmark/DeepCopyBenchmark.h \
+    benchmark/DescriptorCacheBenchmark.h \
+    benchmark/IndexBuildBenchmark.h \
+    benchmark/JournalBenchmark.h \
+    benchmark/LazyMountBenchmark.h \
+    benchmark/MemoryFileBenchmark.h \
+    benchmark/MountBenchmark.h \
+    benchmark/PackStoreBenchmark.h \
+    benchmark/ReadThroughputBenchmark.h \
+    benchmark/ReadaheadBenchmark.h \
+    benchmark/ScriptLoadBenchmark.h \
+    benchmark/SnapshotBenchmark.h \
+    benchmark/WatchBenchmark.h \
+    benchmark/WriteBackBenchmark.h \
+    domain/ArchiveMount.h \
+    domain/ChunkedFile.h \
+    domain/HostDirectoryReader.h \
+    domain/HostFileWatcher.h \
+    domain/HostListingPrefetcher.h \
+    domain/HostTreeScanner.h \
+    domain/IntervalLabeler.h \
+    domain/LazyListing.h \
+    domain/MemoryFile.h \
+    domain/MutationLog.h \
+    domain/OwnedContentFile.h \
+    domain/StoredFile.h \
     domain/VFSDirectory.h \
     domain/VFSExplorer.h \
     domain/VFSFile.h \
     domain/VFSNode.h \
+    io/AsyncFileIO.h \
+    io/BlockCache.h \
+    io/FileCopier.h \
+    io/FileDescriptorCache.h \
+    io/MappedFile.h \
+    io/ReadaheadStream.h \
+    io/WriteBackStream.h \
     model/VFSDirectory.h \
     model/VFSFile.h \
+    persistence/ArchiveIndexFormat.h \
+    persistence/CompressedRecord.h \
+    persistence/IndexImageFormat.h \
+    persistence/Journal.h \
+    persistence/JournalFormat.h \
+    persistence/PackFormat.h \
+    persistence/PackStore.h \
+    persistence/SnapshotFormat.h \
+    persistence/TarIndex.h \
+    persistence/VFSSnapshot.h \
+    search/BulkIndexBuilder.h \
+    search/ContentIndex.h \
+    search/ContentIndexer.h \
+    search/DuplicateFinder.h \
     search/FileHashMap.h \
     search/FileNameTrie.h \
+    search/MappedNameIndex.h \
+    search/ParallelTraversal.h \
+    search/SubtreeBloomFilter.h \
+    search/SubtreeNameFilters.h \
     search/Trie.h \
+    utils/ContentChunker.h \
+    utils/FileSync.h \
+    utils/Hash64.h \
+    utils/LzCodec.h \
+    utils/PageArena.h \
+    utils/PageCache.h \
     utils/PathUtils.h \
-    utils/ScriptLoader.h
+    utils/ScriptLoader.h \
+    utils/ThreadPool.h
 
 SUBDIRS += \
     resources/files/TextEditorApp.pro
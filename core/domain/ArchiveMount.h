@@ -0,0 +1,203 @@
+#pragma once
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../persistence/TarIndex.h"
+#include "VFSDirectory.h"
+#include "VFSFile.h"
+
+// A file stored inside an archive: its bytes are the range [offset, offset + size) of the
+// archive, which is its physical path. Reads map or read just that range, so nothing is
+// ever extracted.
+class ArchiveMemberFile : public VFSFile {
+  private:
+    std::uint64_t offset;
+    std::uint64_t size;
+
+    // `offset` and `length` of a read within the member, clipped to its end.
+    std::uint64_t clip(std::uint64_t at, size_t& length) const {
+        at = std::min(at, size);
+        length = static_cast<size_t>(std::min<std::uint64_t>(length, size - at));
+        return offset + at;
+    }
+
+  public:
+    ArchiveMemberFile(std::string name, std::string archivePath, std::uint64_t offset,
+                      std::uint64_t size, VFSNode* parent = nullptr)
+        : VFSFile(std::move(name), std::move(archivePath), TrustedPath{}, parent),
+          offset(offset), size(size) {
+        // Members never change size, so directory totals over them stay cached.
+        cachedSize = static_cast<std::int64_t>(size);
+    }
+
+    bool isArchiveMember() const override { return true; }
+
+    bool hasOwnHostFile() const override { return false; }
+
+    std::uint64_t getArchiveOffset() const { return offset; }
+
+    size_t getSize() const override { return static_cast<size_t>(size); }
+
+    MappedFile mapReadOnly(AccessPattern pattern = AccessPattern::Sequential) const override {
+        return MappedFile(getPhysicalPath(), offset, static_cast<size_t>(size), pattern);
+    }
+
+    std::unique_ptr<std::istream> openReadStream() const override {
+        return std::make_unique<MappedFileStream>(mapReadOnly());
+    }
+
+    std::unique_ptr<std::istream> openSequentialStream() const override {
+        return openReadStream();
+    }
+
+    // The archive's pages are already shared through the page cache, so the cached
+    // variants map the member as well rather than copying it into private blocks.
+    std::unique_ptr<std::istream> openReadStream(BlockCache&) const override {
+        return openReadStream();
+    }
+
+    MappedFile mapReadOnly(BlockCache&) const override { return mapReadOnly(); }
+
+    std::unique_ptr<std::istream> openReadStream(FileDescriptorCache&) const override {
+        return openReadStream();
+    }
+
+    size_t readAt(FileDescriptorCache& descriptors, std::uint64_t at, char* destination,
+                  size_t length) const override {
+        std::uint64_t position = clip(at, length);
+        return descriptors.readAt(getPhysicalPath(), position, destination, length);
+    }
+
+    void statAsync(AsyncFileIO& io, StatCallback callback) const override {
+        std::uint64_t memberSize = size;
+        io.stat(getPhysicalPath(), [callback = std::move(callback), memberSize](
+                                       AsyncStatResult result) {
+            result.size = memberSize;
+            callback(result);
+        });
+    }
+
+    std::future<AsyncStatResult> statAsync(AsyncFileIO& io) const override {
+        auto promise = std::make_shared<std::promise<AsyncStatResult>>();
+        std::future<AsyncStatResult> result = promise->get_future();
+        statAsync(io, [promise](AsyncStatResult stat) { promise->set_value(stat); });
+        return result;
+    }
+
+    void readAsync(AsyncFileIO& io, std::uint64_t at, size_t length,
+                   ReadCallback callback) const override {
+        std::uint64_t position = clip(at, length);
+        io.read(getPhysicalPath(), position, length, std::move(callback));
+    }
+
+    std::future<AsyncReadResult> readAsync(AsyncFileIO& io, std::uint64_t at,
+                                           size_t length) const override {
+        std::uint64_t position = clip(at, length);
+        return io.read(getPhysicalPath(), position, length);
+    }
+
+    std::unique_ptr<VFSNode> clone() const override {
+        return std::make_unique<ArchiveMemberFile>(getName(), getPhysicalPath(), offset, size);
+    }
+};
+
+// A directory inside a mounted archive. Nothing can be added to, removed from or renamed
+// in it; copies of it are ordinary directories whose files still read from the archive.
+class ArchiveDirectory : public VFSDirectory {
+  private:
+    std::string archivePath;
+
+  public:
+    ArchiveDirectory(std::string name, std::string archivePath, VFSNode* parent = nullptr)
+        : VFSDirectory(std::move(name), parent), archivePath(std::move(archivePath)) {}
+
+    bool isReadOnly() const override { return true; }
+
+    const std::string& getArchivePath() const { return archivePath; }
+};
+
+struct ArchiveMountStats {
+    size_t files;
+    size_t directories;
+    bool indexReused; // members came from the persisted index instead of a header scan
+    double seconds;
+};
+
+// Builds the subtree of a tar archive under a detached mount root.
+class ArchiveMount {
+  private:
+    struct Build {
+        const std::string& archivePath;
+        VFSDirectory* root;
+        std::unordered_map<std::string, VFSNode*> byPath;
+        std::vector<VFSNode*>& attached;
+        ArchiveMountStats& stats;
+    };
+
+    static std::string lastComponent(const std::string& path) {
+        size_t slash = path.rfind('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    // The directory at `path`, created along with its missing ancestors: archives need
+    // not list the directories of their files. nullptr if a file already has the name.
+    static VFSDirectory* directoryAt(Build& build, const std::string& path) {
+        if (path.empty()) {
+            return build.root;
+        }
+        auto found = build.byPath.find(path);
+        if (found != build.byPath.end()) {
+            return found->second->isDirectory() ? static_cast<VFSDirectory*>(found->second)
+                                                : nullptr;
+        }
+        size_t slash = path.rfind('/');
+        VFSDirectory* parent =
+            directoryAt(build, slash == std::string::npos ? "" : path.substr(0, slash));
+        if (!parent) {
+            return nullptr;
+        }
+        auto dir = std::make_unique<ArchiveDirectory>(lastComponent(path), build.archivePath);
+        VFSDirectory* raw = dir.get();
+        parent->add(std::move(dir));
+        build.byPath.emplace(path, raw);
+        build.attached.push_back(raw);
+        ++build.stats.directories;
+        return raw;
+    }
+
+  public:
+    // Adds the members of `archivePath` below `root`, appending every node created to
+    // `attached`. Members whose name is taken by a node of the other kind are left out.
+    static ArchiveMountStats build(const std::string& archivePath, VFSDirectory* root,
+                                   std::vector<VFSNode*>& attached) {
+        ArchiveMountStats stats{0, 0, false, 0};
+        std::vector<TarMember> members = TarIndex::load(archivePath, stats.indexReused);
+        Build build{archivePath, root, {}, attached, stats};
+        build.byPath.reserve(members.size());
+        attached.reserve(attached.size() + members.size());
+        for (const auto& member : members) {
+            if (member.directory) {
+                directoryAt(build, member.path);
+                continue;
+            }
+            size_t slash = member.path.rfind('/');
+            VFSDirectory* parent = directoryAt(
+                build, slash == std::string::npos ? "" : member.path.substr(0, slash));
+            if (!parent || build.byPath.count(member.path)) {
+                continue;
+            }
+            auto file = std::make_unique<ArchiveMemberFile>(lastComponent(member.path),
+                                                            archivePath, member.offset,
+                                                            member.size);
+            build.byPath.emplace(member.path, file.get());
+            attached.push_back(file.get());
+            parent->add(std::move(file));
+            ++stats.files;
+        }
+        return stats;
+    }
+};
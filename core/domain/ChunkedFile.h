@@ -0,0 +1,211 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "../persistence/PackStore.h"
+#include "../utils/ContentChunker.h"
+#include "OwnedContentFile.h"
+
+// std::istream over the chunks of a ChunkedFile. It holds a view of every chunk, so it
+// reads on without copying even after the file is deleted.
+class ChunkedFileStreambuf : public std::streambuf {
+  private:
+    std::vector<MappedFile> pieces;
+    std::vector<std::uint64_t> ends;
+    size_t current = 0;
+
+    std::uint64_t startOf(size_t piece) const { return piece == 0 ? 0 : ends[piece - 1]; }
+
+    void enter(size_t piece, std::uint64_t within) {
+        current = piece;
+        char* begin = const_cast<char*>(pieces[piece].data());
+        setg(begin, begin + within, begin + pieces[piece].size());
+    }
+
+  protected:
+    int_type underflow() override {
+        while (gptr() == egptr() && current + 1 < pieces.size()) {
+            enter(current + 1, 0);
+        }
+        return gptr() == egptr() ? traits_type::eof() : traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                     std::ios_base::openmode) override {
+        off_type size = ends.empty() ? 0 : static_cast<off_type>(ends.back());
+        off_type position = static_cast<off_type>(startOf(current)) + (gptr() - eback());
+        off_type base = direction == std::ios_base::beg   ? 0
+                        : direction == std::ios_base::cur ? position
+                                                          : size;
+        off_type target = base + offset;
+        if (target < 0 || target > size) {
+            return pos_type(off_type(-1));
+        }
+        if (!pieces.empty()) {
+            auto piece = static_cast<size_t>(
+                std::upper_bound(ends.begin(), ends.end(), static_cast<std::uint64_t>(target)) -
+                ends.begin());
+            piece = std::min(piece, pieces.size() - 1);
+            enter(piece, static_cast<std::uint64_t>(target) - startOf(piece));
+        }
+        return pos_type(target);
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override {
+        return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+
+  public:
+    ChunkedFileStreambuf(std::vector<MappedFile> pieces, std::vector<std::uint64_t> ends)
+        : pieces(std::move(pieces)), ends(std::move(ends)) {
+        if (!this->pieces.empty()) {
+            enter(0, 0);
+        }
+    }
+};
+
+class ChunkedFileStream : public std::istream {
+  private:
+    ChunkedFileStreambuf buffer;
+
+  public:
+    ChunkedFileStream(std::vector<MappedFile> pieces, std::vector<std::uint64_t> ends)
+        : std::istream(nullptr), buffer(std::move(pieces), std::move(ends)) {
+        rdbuf(&buffer);
+    }
+};
+
+// A stored file split into content-defined chunks (see ContentChunker), so files that
+// differ in a few places share the chunks they have in common. The node refers to a
+// recipe, itself stored content that lists the chunks (PackChunkRef[]), and holds one
+// reference on the recipe and on each chunk until the explorer deletes it.
+class ChunkedFile : public OwnedContentFile {
+  private:
+    PackStore* store;
+    ContentKey recipe;
+    std::vector<ContentKey> chunks;
+    std::vector<std::uint64_t> ends; // offset just past each chunk within the file
+
+    // Index of the chunk holding byte `at` of the file.
+    size_t chunkAt(std::uint64_t at) const {
+        return static_cast<size_t>(std::upper_bound(ends.begin(), ends.end(), at) -
+                                   ends.begin());
+    }
+
+    std::uint64_t startOf(size_t chunk) const { return chunk == 0 ? 0 : ends[chunk - 1]; }
+
+  protected:
+    // Copies bytes [at, at + length) of the file, touching only the chunks they span.
+    size_t copyRange(std::uint64_t at, char* destination, size_t length) const override {
+        std::uint64_t size = getSize();
+        if (at >= size) {
+            return 0;
+        }
+        length = static_cast<size_t>(std::min<std::uint64_t>(length, size - at));
+        size_t copied = 0;
+        for (size_t chunk = chunkAt(at); copied < length; ++chunk) {
+            std::uint64_t within = at + copied - startOf(chunk);
+            copied += store->read(chunks[chunk], within, destination + copied, length - copied);
+        }
+        return copied;
+    }
+
+    // Zero-copy for a single chunk; larger files are assembled into an owned buffer.
+    MappedFile mapContent() const override {
+        if (chunks.size() == 1) {
+            return store->map(chunks.front());
+        }
+        std::vector<char> content(getSize());
+        copyRange(0, content.data(), content.size());
+        return MappedFile(std::move(content));
+    }
+
+    std::unique_ptr<std::istream> streamContent() const override {
+        std::vector<MappedFile> pieces;
+        pieces.reserve(chunks.size());
+        for (const auto& chunk : chunks) {
+            pieces.push_back(store->map(chunk));
+        }
+        return std::make_unique<ChunkedFileStream>(std::move(pieces), ends);
+    }
+
+  public:
+    ChunkedFile(std::string name, PackStore& store, const ContentKey& recipe,
+                VFSNode* parent = nullptr)
+        : OwnedContentFile(std::move(name), store.getDirectory(), parent), store(&store),
+          recipe(recipe) {
+        MappedFile table = store.map(recipe);
+        if (table.size() % sizeof(PackChunkRef) != 0) {
+            throw std::runtime_error("Not a chunk recipe: " + recipe.toHex());
+        }
+        size_t count = table.size() / sizeof(PackChunkRef);
+        chunks.reserve(count);
+        ends.reserve(count);
+        std::uint64_t end = 0;
+        for (size_t i = 0; i < count; ++i) {
+            PackChunkRef ref;
+            std::memcpy(&ref, table.data() + i * sizeof(ref), sizeof(ref));
+            chunks.push_back({ref.keyHigh, ref.keyLow});
+            end += ref.length;
+            ends.push_back(end);
+        }
+        store.retain(recipe);
+        for (const auto& chunk : chunks) {
+            store.retain(chunk);
+        }
+        cachedSize = static_cast<std::int64_t>(end);
+    }
+
+    // Splits `content` into chunks and stores those not stored yet, then the recipe
+    // listing them. Returns the recipe's key; takes no references.
+    static ContentKey storeContent(PackStore& store, std::string_view content,
+                                   const ContentChunker& chunker) {
+        std::vector<PackChunkRef> refs;
+        chunker.split(content, [&](std::string_view chunk) {
+            ContentKey key = store.put(chunk);
+            refs.push_back({key.high, key.low, chunk.size()});
+        });
+        return store.put(std::string_view(reinterpret_cast<const char*>(refs.data()),
+                                          refs.size() * sizeof(PackChunkRef)));
+    }
+
+    // Declares the recipe and its chunks dead where nothing references them, for content
+    // storeContent() stored for a file that then could not be added.
+    static void discardStored(PackStore& store, const ContentKey& recipe) {
+        MappedFile table = store.map(recipe);
+        for (size_t i = 0; i < table.size() / sizeof(PackChunkRef); ++i) {
+            PackChunkRef ref;
+            std::memcpy(&ref, table.data() + i * sizeof(ref), sizeof(ref));
+            store.discard({ref.keyHigh, ref.keyLow});
+        }
+        store.discard(recipe);
+    }
+
+    void discardContent() override {
+        for (const auto& chunk : chunks) {
+            store->release(chunk);
+        }
+        store->release(recipe);
+    }
+
+    const ContentKey& getRecipeKey() const { return recipe; }
+
+    PackStore& getStore() const { return *store; }
+
+    size_t getChunkCount() const { return chunks.size(); }
+
+    const std::vector<std::uint64_t>& getChunkEnds() const { return ends; }
+
+    size_t getSize() const override {
+        return ends.empty() ? 0 : static_cast<size_t>(ends.back());
+    }
+
+    std::unique_ptr<VFSNode> clone() const override {
+        return std::make_unique<ChunkedFile>(getName(), *store, recipe);
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define VFS_HAS_GETDENTS 1
+#else
+#define VFS_HAS_GETDENTS 0
+#endif
+
+enum class HostEntryKind { Directory, File, Other };
+
+struct HostEntry {
+    std::string name;
+    HostEntryKind kind;
+};
+
+struct HostListing {
+    bool readable = false;
+    std::vector<HostEntry> entries;
+    std::filesystem::file_time_type modified{}; // taken before the entries were read
+};
+
+// Reads one host directory at a time. Symbolic links are reported as Other, never followed.
+class HostDirectoryReader {
+  private:
+    static constexpr size_t DIRENT_BUFFER_BYTES = 1 << 16;
+
+  public:
+    // Calls visit(name, kind) for every entry of `hostPath` except "." and "..";
+    // false if the directory cannot be read.
+    template <typename Visitor>
+    static bool read(const std::string& hostPath, Visitor visit) {
+#if VFS_HAS_GETDENTS
+        int fd = ::open(hostPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct LinuxDirent64 {
+            ino64_t d_ino;
+            off64_t d_off;
+            unsigned short d_reclen;
+            unsigned char d_type;
+            char d_name[1];
+        };
+        thread_local std::vector<char> buffer(DIRENT_BUFFER_BYTES);
+        while (true) {
+            long bytes = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+            if (bytes <= 0) {
+                ::close(fd);
+                return bytes == 0;
+            }
+            for (long offset = 0; offset < bytes;) {
+                auto* entry = reinterpret_cast<LinuxDirent64*>(buffer.data() + offset);
+                offset += entry->d_reclen;
+                const char* name = entry->d_name;
+                if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
+                    continue;
+                }
+                unsigned char type = entry->d_type;
+                if (type == DT_UNKNOWN) {
+                    struct stat info {};
+                    if (fstatat(fd, name, &info, AT_SYMLINK_NOFOLLOW) == 0) {
+                        type = S_ISDIR(info.st_mode)   ? DT_DIR
+                               : S_ISREG(info.st_mode) ? DT_REG
+                                                       : DT_UNKNOWN;
+                    }
+                }
+                visit(name, type == DT_DIR   ? HostEntryKind::Directory
+                            : type == DT_REG ? HostEntryKind::File
+                                             : HostEntryKind::Other);
+            }
+        }
+#else
+        std::error_code ec;
+        std::filesystem::directory_iterator it(hostPath, ec);
+        if (ec) {
+            return false;
+        }
+        for (; it != std::filesystem::directory_iterator(); it.increment(ec)) {
+            if (ec) {
+                return false;
+            }
+            auto status = it->symlink_status(ec);
+            std::string name = it->path().filename().string();
+            HostEntryKind kind = std::filesystem::is_directory(status) ? HostEntryKind::Directory
+                                 : std::filesystem::is_regular_file(status) ? HostEntryKind::File
+                                                                           : HostEntryKind::Other;
+            visit(name.c_str(), kind);
+        }
+        return true;
+#endif
+    }
+
+    // The directories and regular files of `hostPath`; false if it cannot be read.
+    static bool list(const std::string& hostPath, std::vector<HostEntry>& entries) {
+        return read(hostPath, [&entries](const char* name, HostEntryKind kind) {
+            if (kind != HostEntryKind::Other) {
+                entries.push_back({name, kind});
+            }
+        });
+    }
+
+    static HostListing readListing(const std::string& hostPath) {
+        HostListing listing;
+        std::error_code ec;
+        listing.modified = std::filesystem::last_write_time(hostPath, ec);
+        listing.readable = list(hostPath, listing.entries);
+        return listing;
+    }
+
+    // `path` made absolute and normalized, without a trailing separator.
+    static std::string normalize(const std::string& path) {
+        std::string result = std::filesystem::absolute(path).lexically_normal().string();
+        if (result.size() > 1 && result.back() == '/') {
+            result.pop_back();
+        }
+        return result;
+    }
+
+    static std::string childPath(const std::string& hostPath, const std::string& name) {
+        return hostPath == "/" ? hostPath + name : hostPath + "/" + name;
+    }
+};
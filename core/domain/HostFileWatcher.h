@@ -0,0 +1,358 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "HostDirectoryReader.h"
+#include "VFSDirectory.h"
+#include "VFSExplorer.h"
+#include "VFSFile.h"
+#include "VFSNode.h"
+
+#if defined(__linux__)
+#include <ctime>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define VFS_HAS_INOTIFY 1
+#else
+#define VFS_HAS_INOTIFY 0
+#endif
+
+struct WatchOptions {
+    // A batch is applied once no event arrived for quietPeriod, or maxDelay after its
+    // first event under constant churn.
+    std::chrono::milliseconds quietPeriod{2};
+    std::chrono::milliseconds maxDelay{50};
+};
+
+struct WatchStats {
+    size_t watchedDirectories;
+    size_t events;
+    size_t batches;
+    size_t sizeUpdates;
+    size_t removals;
+    size_t overflows;
+    double averageLatencyMs; // first event of a batch read -> batch applied
+    double maxLatencyMs;
+    double cpuSeconds;       // spent on the watcher thread
+};
+
+// Keeps the files of an explorer in step with their host files through inotify. Events
+// are read on a background thread and coalesced per path; each batch stats the paths
+// that back VFS files and then, under lockTree(), updates cached sizes (and the cached
+// totals of the directories above) or removes the files that disappeared. Nothing is
+// rescanned periodically; only a kernel queue overflow re-stats the watched files.
+//
+// While a watcher runs, every use of the explorer must hold lockTree(). Destroy the
+// watcher before the explorer.
+class HostFileWatcher {
+  private:
+    static constexpr size_t EVENT_BUFFER_BYTES = 64 * 1024;
+
+    using Clock = std::chrono::steady_clock;
+
+    VFSExplorer& explorer;
+    WatchOptions options;
+    std::mutex treeMutex;
+    std::vector<std::string> roots;
+
+    std::mutex watchMutex;
+    std::unordered_map<int, std::string> directoryByWatch;
+    std::unordered_map<std::string, int> watchByDirectory;
+
+    mutable std::mutex statsMutex;
+    WatchStats stats{};
+    double totalLatencyMs = 0;
+
+    int inotifyFd = -1;
+    int stopFd = -1;
+    std::thread thread;
+
+    static std::int64_t hostSize(const std::string& path) {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(path, ec)) {
+            return VFSNode::NO_CACHED_SIZE;
+        }
+        auto size = std::filesystem::file_size(path, ec);
+        return ec ? VFSNode::NO_CACHED_SIZE : static_cast<std::int64_t>(size);
+    }
+
+    // Files without a host file of their own are skipped: they never change.
+    template <typename Visit>
+    static void forEachFile(VFSNode* node, const Visit& visit) {
+        if (!node->isDirectory()) {
+            if (static_cast<VFSFile*>(node)->hasOwnHostFile()) {
+                visit(static_cast<VFSFile*>(node));
+            }
+            return;
+        }
+        for (const auto& child : static_cast<VFSDirectory*>(node)->getLoadedChildren()) {
+            forEachFile(child.get(), visit);
+        }
+    }
+
+    static void clearCachedSizes(VFSNode* node) {
+        if (!node->isDirectory()) {
+            if (static_cast<VFSFile*>(node)->hasOwnHostFile()) {
+                node->setCachedSize(VFSNode::NO_CACHED_SIZE);
+            }
+            return;
+        }
+        node->setCachedSize(VFSNode::NO_CACHED_SIZE);
+        for (const auto& child : static_cast<VFSDirectory*>(node)->getLoadedChildren()) {
+            clearCachedSizes(child.get());
+        }
+    }
+
+    bool isWatched(const std::string& hostDirectory) {
+        std::lock_guard<std::mutex> lock(watchMutex);
+        return watchByDirectory.count(hostDirectory) > 0;
+    }
+
+    // Applies the host state of `paths` to the files they back. Stats run without the
+    // tree lock; a file removed meanwhile is simply no longer found by its path.
+    void applyBatch(const std::unordered_set<std::string>& paths, bool overflowed,
+                    Clock::time_point firstEvent) {
+        std::vector<std::string> relevant;
+        {
+            std::lock_guard<std::mutex> lock(treeMutex);
+            if (overflowed) {
+                for (const auto& rootPath : roots) {
+                    VFSNode* rootNode = explorer.navigateToNode(rootPath);
+                    if (rootNode) {
+                        forEachFile(rootNode, [&](VFSFile* file) {
+                            relevant.push_back(file->getPhysicalPath());
+                        });
+                    }
+                }
+            }
+            for (const auto& path : paths) {
+                if (!explorer.physicalMap.get(path).empty()) {
+                    relevant.push_back(path);
+                }
+            }
+        }
+        std::sort(relevant.begin(), relevant.end());
+        relevant.erase(std::unique(relevant.begin(), relevant.end()), relevant.end());
+
+        std::vector<std::int64_t> sizes(relevant.size());
+        for (size_t i = 0; i < relevant.size(); ++i) {
+            sizes[i] = hostSize(relevant[i]);
+        }
+
+        size_t updates = 0;
+        size_t removals = 0;
+        {
+            std::lock_guard<std::mutex> lock(treeMutex);
+            for (size_t i = 0; i < relevant.size(); ++i) {
+                for (VFSNode* node : explorer.physicalMap.get(relevant[i])) {
+                    if (sizes[i] == VFSNode::NO_CACHED_SIZE) {
+                        explorer.deleteNode(node);
+                        ++removals;
+                    } else if (node->getCachedSize() != sizes[i]) {
+                        static_cast<VFSFile*>(node)->updateCachedSize(sizes[i]);
+                        ++updates;
+                    }
+                }
+            }
+        }
+
+        double latencyMs =
+            std::chrono::duration<double, std::milli>(Clock::now() - firstEvent).count();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        ++stats.batches;
+        stats.sizeUpdates += updates;
+        stats.removals += removals;
+        stats.overflows += overflowed ? 1 : 0;
+        totalLatencyMs += latencyMs;
+        stats.maxLatencyMs = std::max(stats.maxLatencyMs, latencyMs);
+    }
+
+#if VFS_HAS_INOTIFY
+    static constexpr std::uint32_t WATCH_MASK =
+        IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+    // Appends the paths named by the queued events to `dirty`; returns the event count.
+    size_t readEvents(std::unordered_set<std::string>& dirty, bool& overflowed) {
+        alignas(inotify_event) char buffer[EVENT_BUFFER_BYTES];
+        size_t count = 0;
+        while (true) {
+            ssize_t bytes = ::read(inotifyFd, buffer, sizeof(buffer));
+            if (bytes <= 0) {
+                return count;
+            }
+            std::lock_guard<std::mutex> lock(watchMutex);
+            for (ssize_t offset = 0; offset < bytes;) {
+                auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+                ++count;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    overflowed = true;
+                    continue;
+                }
+                auto directory = directoryByWatch.find(event->wd);
+                if (directory == directoryByWatch.end()) {
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    watchByDirectory.erase(directory->second);
+                    directoryByWatch.erase(directory);
+                } else if (event->len > 0) {
+                    dirty.insert(HostDirectoryReader::childPath(directory->second, event->name));
+                }
+            }
+        }
+    }
+
+    void run() {
+        std::unordered_set<std::string> dirty;
+        bool overflowed = false;
+        Clock::time_point firstEvent;
+        Clock::time_point lastEvent;
+        while (true) {
+            int timeoutMs = -1;
+            if (!dirty.empty() || overflowed) {
+                Clock::time_point deadline =
+                    std::min(lastEvent + options.quietPeriod, firstEvent + options.maxDelay);
+                Clock::time_point now = Clock::now();
+                if (now >= deadline) {
+                    applyBatch(dirty, overflowed, firstEvent);
+                    dirty.clear();
+                    overflowed = false;
+                    recordCpuTime();
+                    continue;
+                }
+                timeoutMs = static_cast<int>(
+                    std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+            }
+
+            pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+            if (::poll(fds, 2, timeoutMs) < 0) {
+                continue;
+            }
+            if (fds[1].revents & POLLIN) {
+                recordCpuTime();
+                return;
+            }
+            if (fds[0].revents & POLLIN) {
+                bool wasIdle = dirty.empty() && !overflowed;
+                size_t count = readEvents(dirty, overflowed);
+                lastEvent = Clock::now();
+                if (wasIdle) {
+                    firstEvent = lastEvent;
+                }
+                std::lock_guard<std::mutex> lock(statsMutex);
+                stats.events += count;
+            }
+        }
+    }
+
+    void recordCpuTime() {
+        timespec cpu{};
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.cpuSeconds = cpu.tv_sec + cpu.tv_nsec / 1e9;
+    }
+#endif
+
+  public:
+    explicit HostFileWatcher(VFSExplorer& explorer, WatchOptions options = {})
+        : explorer(explorer), options(options) {
+#if VFS_HAS_INOTIFY
+        inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        stopFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (inotifyFd < 0 || stopFd < 0) {
+            if (inotifyFd >= 0) {
+                ::close(inotifyFd);
+            }
+            if (stopFd >= 0) {
+                ::close(stopFd);
+            }
+            throw std::runtime_error("Cannot initialize inotify");
+        }
+        thread = std::thread([this]() { run(); });
+#else
+        throw std::runtime_error("Watching host files requires inotify");
+#endif
+    }
+
+    HostFileWatcher(const HostFileWatcher&) = delete;
+    HostFileWatcher& operator=(const HostFileWatcher&) = delete;
+
+    // Stops watching and drops every cached size, which nothing keeps current anymore.
+    ~HostFileWatcher() {
+#if VFS_HAS_INOTIFY
+        std::uint64_t one = 1;
+        if (::write(stopFd, &one, sizeof(one)) < 0) {
+            // The thread also stops once the descriptors are gone; nothing else to do.
+        }
+        thread.join();
+        ::close(inotifyFd);
+        ::close(stopFd);
+#endif
+        clearCachedSizes(explorer.getRoot());
+    }
+
+    // Watches the host directories of every file below `virtualPath` and caches their
+    // sizes. Lazy directories contribute what they have listed so far. Returns the
+    // number of host directories added.
+    size_t watch(const std::string& virtualPath = "/") {
+        std::lock_guard<std::mutex> lock(treeMutex);
+        VFSNode* start = explorer.navigateToNode(virtualPath);
+        if (!start) {
+            throw std::runtime_error("Node does not exist at path: " + virtualPath);
+        }
+        if (std::find(roots.begin(), roots.end(), virtualPath) == roots.end()) {
+            roots.push_back(virtualPath);
+        }
+
+        std::vector<VFSFile*> files;
+        forEachFile(start, [&](VFSFile* file) { files.push_back(file); });
+        size_t added = 0;
+        for (VFSFile* file : files) {
+            std::string directory =
+                std::filesystem::path(file->getPhysicalPath()).parent_path().string();
+            if (!isWatched(directory)) {
+#if VFS_HAS_INOTIFY
+                int wd = ::inotify_add_watch(inotifyFd, directory.c_str(), WATCH_MASK);
+                if (wd >= 0) {
+                    std::lock_guard<std::mutex> watchLock(watchMutex);
+                    directoryByWatch[wd] = directory;
+                    watchByDirectory[directory] = wd;
+                    ++added;
+                }
+#endif
+            }
+            // Cached only once the watch exists, so no change can slip in between.
+            std::int64_t size = hostSize(file->getPhysicalPath());
+            if (size != VFSNode::NO_CACHED_SIZE && isWatched(directory)) {
+                file->updateCachedSize(size);
+            }
+        }
+
+        std::lock_guard<std::mutex> statsLock(statsMutex);
+        stats.watchedDirectories += added;
+        return added;
+    }
+
+    // Hold while using the explorer from any thread as long as the watcher runs.
+    std::unique_lock<std::mutex> lockTree() { return std::unique_lock<std::mutex>(treeMutex); }
+
+    WatchStats getStats() const {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        WatchStats result = stats;
+        result.averageLatencyMs = stats.batches > 0 ? totalLatencyMs / stats.batches : 0;
+        return result;
+    }
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../utils/ThreadPool.h"
+#include "HostDirectoryReader.h"
+
+// Reads host directory listings ahead of use on a background thread, so that the lazy
+// directories likely to be opened next list from memory. Unclaimed listings are dropped
+// all at once when MAX_PENDING of them piled up.
+class HostListingPrefetcher {
+  private:
+    static constexpr size_t MAX_PENDING = 1024;
+
+    struct Prefetched {
+        HostListing listing;
+        std::chrono::steady_clock::time_point readAt;
+    };
+
+    std::mutex mutex;
+    std::condition_variable listingReady;
+    std::unordered_map<std::string, Prefetched> ready;
+    std::unordered_set<std::string> reading;
+    ThreadPool pool{1};
+
+  public:
+    void prefetch(const std::string& hostPath) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ready.count(hostPath) || reading.count(hostPath) ||
+                reading.size() >= MAX_PENDING) {
+                return;
+            }
+            if (ready.size() >= MAX_PENDING) {
+                ready.clear();
+            }
+            reading.insert(hostPath);
+        }
+        pool.submit([this, hostPath]() {
+            auto readAt = std::chrono::steady_clock::now();
+            HostListing listing = HostDirectoryReader::readListing(hostPath);
+            std::lock_guard<std::mutex> lock(mutex);
+            reading.erase(hostPath);
+            ready[hostPath] = {std::move(listing), readAt};
+            listingReady.notify_all();
+        });
+    }
+
+    // Hands over the prefetched listing of `hostPath`, waiting for it if it is still
+    // being read. False if there is none, or if it is older than `maxAge` (0 = any age).
+    bool take(const std::string& hostPath, std::chrono::milliseconds maxAge,
+              HostListing& listing) {
+        std::unique_lock<std::mutex> lock(mutex);
+        listingReady.wait(lock, [&]() { return !reading.count(hostPath); });
+        auto it = ready.find(hostPath);
+        if (it == ready.end()) {
+            return false;
+        }
+        Prefetched prefetched = std::move(it->second);
+        ready.erase(it);
+        if (maxAge.count() > 0 && std::chrono::steady_clock::now() - prefetched.readAt > maxAge) {
+            return false;
+        }
+        listing = std::move(prefetched.listing);
+        return true;
+    }
+};
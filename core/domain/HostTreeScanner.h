@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../utils/ThreadPool.h"
+#include "HostDirectoryReader.h"
+#include "VFSDirectory.h"
+#include "VFSFile.h"
+
+struct MountStats {
+    size_t directories;
+    size_t files;
+    size_t skipped; // unreadable directories and entries that are neither file nor directory
+    double seconds;
+    double filesPerSecond;
+};
+
+// Mirrors a host directory tree as a detached VFS subtree. Every directory is read by its
+// own pool task, which creates the child nodes without linking them; the subtree is
+// stitched together bottom-up once all reads finished, so each add() walks one parent
+// and no task ever touches another task's directory. Symbolic links are not followed.
+class HostTreeScanner {
+  private:
+    struct ScannedDirectory {
+        VFSDirectory* dir;
+        size_t depth;
+        std::vector<std::unique_ptr<VFSNode>> children;
+    };
+
+    struct Scan {
+        ThreadPool pool;
+        std::mutex mutex;
+        std::vector<ScannedDirectory> scanned;
+        size_t files = 0;
+        size_t skipped = 0;
+        bool rootReadable = true;
+
+        explicit Scan(size_t threadCount) : pool(threadCount) {}
+    };
+
+    static void scanDirectory(Scan& scan, VFSDirectory* dir, std::string hostPath,
+                              size_t depth) {
+        ScannedDirectory scanned{dir, depth, {}};
+        std::vector<std::pair<VFSDirectory*, std::string>> subdirectories;
+        size_t files = 0;
+        size_t skipped = 0;
+        std::string prefix = hostPath == "/" ? hostPath : hostPath + "/";
+
+        auto visit = [&](const char* name, HostEntryKind kind) {
+            if (kind == HostEntryKind::Directory) {
+                auto child = std::make_unique<VFSDirectory>(name);
+                subdirectories.push_back({child.get(), prefix + name});
+                scanned.children.push_back(std::move(child));
+            } else if (kind == HostEntryKind::File) {
+                scanned.children.push_back(
+                    std::make_unique<VFSFile>(name, prefix + name, VFSFile::TrustedPath{}));
+                ++files;
+            } else {
+                ++skipped;
+            }
+        };
+        bool readable = HostDirectoryReader::read(hostPath, visit);
+        if (!readable) {
+            ++skipped;
+        }
+
+        for (auto& subdirectory : subdirectories) {
+            scan.pool.submit([&scan, child = subdirectory.first,
+                              childPath = std::move(subdirectory.second), depth]() mutable {
+                scanDirectory(scan, child, std::move(childPath), depth + 1);
+            });
+        }
+        std::lock_guard<std::mutex> lock(scan.mutex);
+        scan.files += files;
+        scan.skipped += skipped;
+        scan.rootReadable = scan.rootReadable && (depth > 0 || readable);
+        scan.scanned.push_back(std::move(scanned));
+    }
+
+  public:
+    // Fills `mountRoot` with the contents of `hostPath` and appends every node created
+    // below it to `created`. `mountRoot` must still be detached.
+    static MountStats scan(const std::string& hostPath, VFSDirectory* mountRoot,
+                           std::vector<VFSNode*>& created,
+                           size_t threadCount = ThreadPool::defaultThreadCount()) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(hostPath, ec)) {
+            throw std::runtime_error("Host directory does not exist: " + hostPath);
+        }
+        std::string root = HostDirectoryReader::normalize(hostPath);
+
+        Scan scan(threadCount);
+        scan.pool.submit([&scan, mountRoot, root]() { scanDirectory(scan, mountRoot, root, 0); });
+        scan.pool.waitIdle();
+        if (!scan.rootReadable) {
+            throw std::runtime_error("Cannot read host directory: " + hostPath);
+        }
+
+        // Deepest directories first: every directory is complete before it joins its parent.
+        std::sort(scan.scanned.begin(), scan.scanned.end(),
+                  [](const ScannedDirectory& a, const ScannedDirectory& b) {
+                      return a.depth > b.depth;
+                  });
+        for (auto& scanned : scan.scanned) {
+            for (auto& child : scanned.children) {
+                created.push_back(child.get());
+                scanned.dir->add(std::move(child));
+            }
+        }
+        return {scan.scanned.size() - 1, scan.files, scan.skipped, 0, 0};
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "VFSDirectory.h"
+#include "VFSNode.h"
+
+// Gap-based pre/post interval labels. Every node owns [pre, post] and the labels of its
+// descendants lie strictly inside, so ancestry is a comparison of two pairs.
+class IntervalLabeler {
+  private:
+    static constexpr std::uint64_t LABEL_SPACE = std::uint64_t(1) << 62;
+    static constexpr std::uint64_t DIRECTORY_SHARE = 8;
+    static constexpr std::uint64_t RELABEL_DENSITY = 4;
+
+    static size_t collectSizes(const VFSNode* node, std::vector<size_t>& sizes) {
+        size_t index = sizes.size();
+        sizes.push_back(1);
+
+        if (node->isDirectory()) {
+            auto* dir = static_cast<const VFSDirectory*>(node);
+            for (const auto& child : dir->getLoadedChildren()) {
+                size_t childSize = collectSizes(child.get(), sizes);
+                sizes[index] += childSize;
+            }
+        }
+        return sizes[index];
+    }
+
+    // Spreads the subtree over [begin, end]. Half of the spare room is distributed among
+    // children in proportion to their sizes, the other half is left after the last child
+    // for future appends.
+    static void layout(VFSNode* node, std::uint64_t begin, std::uint64_t end,
+                       const std::vector<size_t>& sizes, size_t& cursor) {
+        size_t size = sizes[cursor++];
+        node->setLabels(begin, end);
+
+        if (!node->isDirectory() || size == 1) {
+            return;
+        }
+
+        std::uint64_t descendants = size - 1;
+        std::uint64_t spare = (end - begin - 1) - 2 * descendants;
+        std::uint64_t perNode = (spare - spare / 2) / descendants;
+        std::uint64_t next = begin + 1;
+
+        auto* dir = static_cast<VFSDirectory*>(node);
+        for (const auto& child : dir->getLoadedChildren()) {
+            std::uint64_t childSize = sizes[cursor];
+            std::uint64_t width = childSize * (2 + perNode);
+            layout(child.get(), next, next + width - 1, sizes, cursor);
+            next += width;
+        }
+    }
+
+    static void relabel(VFSNode* node) {
+        std::vector<size_t> sizes;
+        collectSizes(node, sizes);
+        size_t cursor = 0;
+        layout(node, node->getPreLabel(), node->getPostLabel(), sizes, cursor);
+    }
+
+    static bool hasRoomFor(const VFSNode* node, size_t subtreeSize) {
+        std::uint64_t interior = node->getPostLabel() - node->getPreLabel() - 1;
+        return interior / RELABEL_DENSITY >= 2 * static_cast<std::uint64_t>(subtreeSize - 1);
+    }
+
+  public:
+    static void labelRoot(VFSNode* root) {
+        root->setLabels(0, LABEL_SPACE);
+        relabel(root);
+    }
+
+    // `node` must already be the last child of its parent.
+    static void attach(VFSNode* node) {
+        auto* parent = static_cast<VFSDirectory*>(node->getParent());
+        if (!parent) {
+            labelRoot(node);
+            return;
+        }
+
+        const auto& siblings = parent->getLoadedChildren();
+        std::uint64_t low = siblings.size() >= 2 ? siblings[siblings.size() - 2]->getPostLabel()
+                                                 : parent->getPreLabel();
+        std::uint64_t available = parent->getPostLabel() - low - 1;
+
+        std::vector<size_t> sizes;
+        std::uint64_t required = 2 * collectSizes(node, sizes);
+
+        if (available >= required) {
+            std::uint64_t width = required;
+            if (node->isDirectory()) {
+                width += (available - required) / DIRECTORY_SHARE;
+            }
+            size_t cursor = 0;
+            layout(node, low + 1, low + width, sizes, cursor);
+            return;
+        }
+
+        for (VFSNode* ancestor = parent; ancestor; ancestor = ancestor->getParent()) {
+            std::vector<size_t> ancestorSizes;
+            collectSizes(ancestor, ancestorSizes);
+            if (hasRoomFor(ancestor, ancestorSizes.front())) {
+                size_t cursor = 0;
+                layout(ancestor, ancestor->getPreLabel(), ancestor->getPostLabel(), ancestorSizes,
+                       cursor);
+                return;
+            }
+        }
+
+        throw std::runtime_error("Interval label space exhausted");
+    }
+};
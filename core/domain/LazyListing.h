@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+class VFSDirectory;
+
+// Produces the children of directories whose listing is deferred until first use.
+class DirectoryLister {
+  public:
+    virtual ~DirectoryLister() = default;
+
+    // Called on every access to the children of a lazy directory, listed or not, so the
+    // lister can read the listing the first time and refresh it once it went stale.
+    virtual void childrenAccessed(VFSDirectory& dir) = 0;
+};
+
+struct LazyMountOptions {
+    size_t prefetchSiblings = 0; // following sibling directories read ahead on first listing
+    std::chrono::milliseconds revalidateAfter{0}; // 0 = a listing never goes stale
+};
+
+// State of a directory mirrored lazily from the host.
+struct LazyListing {
+    DirectoryLister* lister;
+    std::string hostPath;
+    LazyMountOptions options;
+    bool listed = false;
+    std::filesystem::file_time_type hostModified{};
+    std::chrono::steady_clock::time_point checkedAt{};
+    bool revalidating = false; // set while the lister rewrites the listing
+};
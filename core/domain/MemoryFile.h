@@ -0,0 +1,168 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../utils/PageArena.h"
+#include "OwnedContentFile.h"
+
+// A file that lives only in memory, in pages of a PageArena, for scratch data that need
+// not touch the disk. It has no physical path. Its size is always cached, and writes
+// update the cached totals of the directories above it. Like the tree, a file is not
+// safe to modify from several threads at once.
+class MemoryFile : public OwnedContentFile {
+  private:
+    PageArena* arena;
+    std::vector<char*> pages;
+    std::uint64_t size = 0;
+
+    size_t pageSize() const { return arena->getPageSize(); }
+
+    void reservePages(std::uint64_t bytes) {
+        size_t needed = static_cast<size_t>((bytes + pageSize() - 1) / pageSize());
+        while (pages.size() < needed) {
+            pages.push_back(arena->allocate());
+        }
+    }
+
+    void releasePagesBeyond(std::uint64_t bytes) {
+        size_t needed = static_cast<size_t>((bytes + pageSize() - 1) / pageSize());
+        while (pages.size() > needed) {
+            arena->release(pages.back());
+            pages.pop_back();
+        }
+    }
+
+    // Copies `length` bytes to [at, at + length); the pages must be there already.
+    void copyIn(std::uint64_t at, const char* data, size_t length) {
+        while (length > 0) {
+            auto within = static_cast<size_t>(at % pageSize());
+            size_t count = std::min(length, pageSize() - within);
+            std::memcpy(pages[static_cast<size_t>(at / pageSize())] + within, data, count);
+            at += count;
+            data += count;
+            length -= count;
+        }
+    }
+
+    void zeroFill(std::uint64_t at, std::uint64_t end) {
+        while (at < end) {
+            auto within = static_cast<size_t>(at % pageSize());
+            auto count = static_cast<size_t>(std::min<std::uint64_t>(end - at,
+                                                                     pageSize() - within));
+            std::memset(pages[static_cast<size_t>(at / pageSize())] + within, 0, count);
+            at += count;
+        }
+    }
+
+    void setSize(std::uint64_t newSize) {
+        size = newSize;
+        updateCachedSize(static_cast<std::int64_t>(newSize));
+    }
+
+    class Target : public WriteTarget {
+      private:
+        MemoryFile* file;
+
+      public:
+        explicit Target(MemoryFile& file) : file(&file) {}
+
+        std::uint64_t size() const override { return file->size; }
+
+        void writeAt(std::uint64_t offset, const char* data, size_t length) override {
+            file->write(offset, std::string_view(data, length));
+        }
+    };
+
+  protected:
+    MappedFile mapContent() const override {
+        std::vector<char> content(static_cast<size_t>(size));
+        copyRange(0, content.data(), content.size());
+        return MappedFile(std::move(content));
+    }
+
+    size_t copyRange(std::uint64_t at, char* destination, size_t length) const override {
+        return read(at, destination, length);
+    }
+
+  public:
+    MemoryFile(std::string name, PageArena& arena, VFSNode* parent = nullptr)
+        : OwnedContentFile(std::move(name), std::string(), parent), arena(&arena) {
+        cachedSize = 0;
+    }
+
+    ~MemoryFile() override { releasePagesBeyond(0); }
+
+    size_t getSize() const override { return static_cast<size_t>(size); }
+
+    size_t getPageCount() const { return pages.size(); }
+
+    // Copies up to `length` bytes at `at`; returns how many there were.
+    size_t read(std::uint64_t at, char* destination, size_t length) const {
+        if (at >= size) {
+            return 0;
+        }
+        length = static_cast<size_t>(std::min<std::uint64_t>(length, size - at));
+        for (size_t copied = 0; copied < length;) {
+            auto within = static_cast<size_t>((at + copied) % pageSize());
+            size_t count = std::min(length - copied, pageSize() - within);
+            std::memcpy(destination + copied,
+                        pages[static_cast<size_t>((at + copied) / pageSize())] + within, count);
+            copied += count;
+        }
+        return length;
+    }
+
+    // Writes `data` at `at`, growing the file if it ends beyond the current size; a gap
+    // between the old end and `at` reads as zeros.
+    void write(std::uint64_t at, std::string_view data) override {
+        std::uint64_t end = at + data.size();
+        if (end > size) {
+            reservePages(end);
+            zeroFill(size, std::min(at, end));
+        }
+        copyIn(at, data.data(), data.size());
+        if (end > size) {
+            setSize(end);
+        }
+    }
+
+    void append(std::string_view data) { write(size, data); }
+
+    // Shrinks the file, releasing the pages past its new end, or grows it with zeros.
+    void truncate(std::uint64_t newSize) {
+        if (newSize < size) {
+            releasePagesBeyond(newSize);
+        } else if (newSize > size) {
+            reservePages(newSize);
+            zeroFill(size, newSize);
+        }
+        if (newSize != size) {
+            setSize(newSize);
+        }
+    }
+
+    // Writes reach the pages when the stream flushes, like those to a host file.
+    std::unique_ptr<WriteBackStream>
+    openWriteStream(WriteMode mode = WriteMode::Update,
+                    size_t capacity = WriteBackStream::DEFAULT_CAPACITY) override {
+        if (mode == WriteMode::Truncate) {
+            truncate(0);
+        }
+        return std::make_unique<WriteBackStream>(std::make_unique<Target>(*this), mode, capacity);
+    }
+
+    std::unique_ptr<VFSNode> clone() const override {
+        auto copy = std::make_unique<MemoryFile>(getName(), *arena);
+        copy->reservePages(size);
+        for (size_t i = 0; i < pages.size(); ++i) {
+            std::memcpy(copy->pages[i], pages[i], pageSize());
+        }
+        copy->size = size;
+        copy->cachedSize = static_cast<std::int64_t>(size);
+        return copy;
+    }
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+
+enum class MutationOp : std::uint8_t {
+    CreateDirectory = 1,    // parentPath, name
+    AddFile = 2,            // parentPath, name, physicalPath
+    DeleteNode = 3,         // path
+    RenameNode = 4,         // path, newName
+    MoveNode = 5,           // path, newParentPath
+    CopyNode = 6,           // path, destParentPath, newName; flag = replace
+    CutNode = 7,            // path, destParentPath, newName; flag = replace
+    MountHostDirectory = 8, // hostPath, virtualPath
+    MountLazy = 9,          // hostPath, virtualPath, prefetchSiblings, revalidateAfter (ms)
+    MountArchive = 10,      // archivePath, virtualPath
+    AddStoredFile = 11,     // parentPath, name, content key (ContentKey::toHex)
+    AddChunkedFile = 12,    // parentPath, name, recipe key
+    CreateMemoryFile = 13,  // parentPath, name
+    DeepCopyNode = 14,      // path, destParentPath, newName, host copies ('\0'-separated,
+                            // in preorder); flag = replace
+};
+
+// Receives every successful VFSExplorer mutation, described by the arguments that
+// reproduce it when the same calls are replayed against the same tree.
+class MutationLog {
+  public:
+    virtual ~MutationLog() = default;
+
+    virtual void record(MutationOp op, std::initializer_list<std::string_view> args,
+                        bool flag = false) = 0;
+};
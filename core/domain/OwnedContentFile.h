@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "VFSFile.h"
+
+// Base of the files whose content the VFS owns instead of a host file of their own
+// (StoredFile, ChunkedFile, MemoryFile). Every read goes through mapContent and
+// copyRange, and the asynchronous calls complete before they return, on the calling
+// thread: there is no I/O to wait for.
+class OwnedContentFile : public VFSFile {
+  protected:
+    virtual MappedFile mapContent() const = 0;
+
+    // Copies up to `length` bytes at `at`; returns how many there were.
+    virtual size_t copyRange(std::uint64_t at, char* destination, size_t length) const = 0;
+
+    virtual std::unique_ptr<std::istream> streamContent() const {
+        return std::make_unique<MappedFileStream>(mapContent());
+    }
+
+  public:
+    OwnedContentFile(std::string name, std::string physicalPath, VFSNode* parent = nullptr)
+        : VFSFile(std::move(name), std::move(physicalPath), TrustedPath{}, parent) {}
+
+    bool hasOwnHostFile() const override { return false; }
+
+    MappedFile mapReadOnly(AccessPattern = AccessPattern::Sequential) const override {
+        return mapContent();
+    }
+
+    std::unique_ptr<std::istream> openReadStream() const override { return streamContent(); }
+
+    std::unique_ptr<std::istream> openSequentialStream() const override {
+        return streamContent();
+    }
+
+    // The content is in memory or in shared mappings already, so the cached variants
+    // read it directly.
+    std::unique_ptr<std::istream> openReadStream(BlockCache&) const override {
+        return streamContent();
+    }
+
+    MappedFile mapReadOnly(BlockCache&) const override { return mapContent(); }
+
+    std::unique_ptr<std::istream> openReadStream(FileDescriptorCache&) const override {
+        return streamContent();
+    }
+
+    size_t readAt(FileDescriptorCache&, std::uint64_t at, char* destination,
+                  size_t length) const override {
+        return copyRange(at, destination, length);
+    }
+
+    void statAsync(AsyncFileIO&, StatCallback callback) const override {
+        AsyncStatResult result{};
+        result.size = getSize();
+        callback(result);
+    }
+
+    std::future<AsyncStatResult> statAsync(AsyncFileIO& io) const override {
+        std::promise<AsyncStatResult> promise;
+        statAsync(io, [&promise](AsyncStatResult stat) { promise.set_value(stat); });
+        return promise.get_future();
+    }
+
+    void readAsync(AsyncFileIO& io, std::uint64_t at, size_t length,
+                   ReadCallback callback) const override {
+        callback(readAsync(io, at, length).get());
+    }
+
+    std::future<AsyncReadResult> readAsync(AsyncFileIO&, std::uint64_t at,
+                                           size_t length) const override {
+        std::promise<AsyncReadResult> promise;
+        AsyncReadResult result{};
+        if (at < getSize()) {
+            std::uint64_t available = getSize() - at;
+            result.data.resize(static_cast<size_t>(std::min<std::uint64_t>(length, available)));
+            result.data.resize(copyRange(at, result.data.data(), result.data.size()));
+        }
+        promise.set_value(std::move(result));
+        return promise.get_future();
+    }
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <string>
+
+#include "../persistence/PackStore.h"
+#include "OwnedContentFile.h"
+
+// A file whose content the VFS owns and keeps in a PackStore instead of a host file of
+// its own; its physical path is the store's directory. The content never changes. Each
+// node holds one reference on it from construction until the explorer deletes the node.
+class StoredFile : public OwnedContentFile {
+  private:
+    PackStore* store;
+    ContentKey key;
+    std::uint64_t size;
+
+  protected:
+    MappedFile mapContent() const override { return store->map(key); }
+
+    size_t copyRange(std::uint64_t at, char* destination, size_t length) const override {
+        return store->read(key, at, destination, length);
+    }
+
+  public:
+    StoredFile(std::string name, PackStore& store, const ContentKey& key,
+               VFSNode* parent = nullptr)
+        : OwnedContentFile(std::move(name), store.getDirectory(), parent), store(&store),
+          key(key), size(store.sizeOf(key)) {
+        store.retain(key);
+        cachedSize = static_cast<std::int64_t>(size);
+    }
+
+    void discardContent() override { store->release(key); }
+
+    const ContentKey& getContentKey() const { return key; }
+
+    PackStore& getStore() const { return *store; }
+
+    size_t getSize() const override { return static_cast<size_t>(size); }
+
+    std::unique_ptr<VFSNode> clone() const override {
+        return std::make_unique<StoredFile>(getName(), *store, key);
+    }
+};
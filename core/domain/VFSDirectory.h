@@ -1,4 +1,6 @@
 #pragma once
+#include "../search/SubtreeBloomFilter.h"
+#include "LazyListing.h"
 #include "VFSNode.h"
 #include <algorithm>
 #include <memory>
@@ -8,6 +10,46 @@ class VFSDirectory : public VFSNode {
 
 private:
     std::vector<std::unique_ptr<VFSNode>> children;
+    SubtreeNameSummary nameSummary;
+    std::unique_ptr<LazyListing> lazy;
+
+    static size_t subtreeCount(const VFSNode* node) {
+        if (!node->isDirectory()) {
+            return 1;
+        }
+        return 1 + static_cast<const VFSDirectory*>(node)->nameSummary.descendantCount;
+    }
+
+    static size_t subtreeUnlisted(const VFSNode* node) {
+        if (!node->isDirectory()) {
+            return 0;
+        }
+        return static_cast<const VFSDirectory*>(node)->nameSummary.unlistedDirectories;
+    }
+
+    void adjustCounts(const VFSNode* node, bool added) {
+        size_t count = subtreeCount(node);
+        size_t unlisted = subtreeUnlisted(node);
+        for (VFSNode* current = this; current; current = current->getParent()) {
+            auto& summary = static_cast<VFSDirectory*>(current)->nameSummary;
+            summary.descendantCount += added ? count : -count;
+            summary.unlistedDirectories += added ? unlisted : -unlisted;
+            current->setCachedSize(NO_CACHED_SIZE);
+        }
+    }
+
+    void adjustUnlisted(bool added) {
+        for (VFSNode* current = this; current; current = current->getParent()) {
+            auto& summary = static_cast<VFSDirectory*>(current)->nameSummary;
+            summary.unlistedDirectories += added ? 1 : -1;
+        }
+    }
+
+    void ensureListed() const {
+        if (lazy) {
+            lazy->lister->childrenAccessed(const_cast<VFSDirectory&>(*this));
+        }
+    }
 
 public:
     VFSDirectory(std::string name, VFSNode* parent = nullptr)
@@ -15,10 +57,24 @@ public:
 
     bool isDirectory() const override { return true; }
 
+    // Read-only directories (see ArchiveDirectory) refuse every change to their children.
+    virtual bool isReadOnly() const { return false; }
+
+    // Served from the cached total when there is one. Otherwise the total is summed up
+    // and cached if every child turned out to be cached as well.
     size_t getSize() const override {
+        ensureListed();
+        if (cachedSize != NO_CACHED_SIZE) {
+            return static_cast<size_t>(cachedSize);
+        }
         size_t total = 0;
+        bool complete = true;
         for (const auto& child : children) {
             total += child->getSize();
+            complete = complete && child->getCachedSize() != NO_CACHED_SIZE;
+        }
+        if (complete) {
+            cachedSize = static_cast<std::int64_t>(total);
         }
         return total;
     }
@@ -26,13 +82,43 @@ public:
     void add(std::unique_ptr<VFSNode> node) {
         if (node) {
             node->setParent(this);
+            adjustCounts(node.get(), true);
             children.push_back(std::move(node));
         }
     }
 
     bool remove(const std::string& name) {
+        ensureListed();
+        return removeLoadedChild(name);
+    }
+
+    VFSNode* getChild(const std::string& name) const {
+        ensureListed();
+        return getLoadedChild(name);
+    }
+
+    const std::vector<std::unique_ptr<VFSNode>>& getChildren() const {
+        ensureListed();
+        return children;
+    }
+
+    // The children present right now, without reading a lazy directory's listing. Used
+    // by the bookkeeping that has to see the tree as it is (labels, filters, indexes).
+    const std::vector<std::unique_ptr<VFSNode>>& getLoadedChildren() const { return children; }
+
+    VFSNode* getLoadedChild(const std::string& name) const {
+        for (const auto& child : children) {
+            if (child->getName() == name) {
+                return child.get();
+            }
+        }
+        return nullptr;
+    }
+
+    bool removeLoadedChild(const std::string& name) {
         for (auto it = children.begin(); it != children.end(); ++it) {
             if ((*it)->getName() == name) {
+                adjustCounts(it->get(), false);
                 children.erase(it);
                 return true;
             }
@@ -40,32 +126,64 @@ public:
         return false;
     }
 
-    VFSNode* getChild(const std::string& name) const {
-        for (const auto& child : children) {
-            if (child->getName() == name) {
-                return child.get();
-            }
+    // Defers the children to `lister`, which receives every later access to them.
+    void makeLazy(DirectoryLister* lister, std::string hostPath, LazyMountOptions options,
+                  bool listed = false) {
+        lazy = std::make_unique<LazyListing>(
+            LazyListing{lister, std::move(hostPath), options, listed, {}, {}, false});
+        if (!listed) {
+            adjustUnlisted(true);
         }
-        return nullptr;
     }
 
-    const std::vector<std::unique_ptr<VFSNode>>& getChildren() const { 
-        return children;
+    LazyListing* getLazyListing() const { return lazy.get(); }
+
+    bool isListed() const { return !lazy || lazy->listed; }
+
+    // Turns a listed lazy directory into a plain one that no longer follows its host
+    // directory, as a deep copy must not pick up later changes to the original.
+    void detachListing() {
+        if (lazy && lazy->listed) {
+            lazy.reset();
+        }
     }
 
+    // Called by the lister before it attaches the children it read.
+    void markListed() {
+        if (lazy && !lazy->listed) {
+            lazy->listed = true;
+            adjustUnlisted(false);
+        }
+    }
+
+    size_t getDescendantCount() const { return nameSummary.descendantCount; }
+
+    SubtreeNameSummary& getNameSummary() { return nameSummary; }
+
+    const SubtreeNameSummary& getNameSummary() const { return nameSummary; }
+
     std::unique_ptr<VFSNode> extractChild(const std::string& name) {
+        ensureListed();
         for (auto it = children.begin(); it != children.end(); ++it) {
             if ((*it)->getName() == name) {
                 std::unique_ptr<VFSNode> extractedNode = std::move(*it);
                 children.erase(it);
+                adjustCounts(extractedNode.get(), false);
                 return extractedNode;
             }
         }
         return nullptr;
     }
 
+    // A lazy directory is cloned with what it has loaded and stays lazy, so copying a
+    // mount does not read the parts of the host tree nobody opened.
     std::unique_ptr<VFSNode> clone() const override {
         auto newDir = std::make_unique<VFSDirectory>(this->getName());
+        if (lazy) {
+            newDir->makeLazy(lazy->lister, lazy->hostPath, lazy->options, lazy->listed);
+            newDir->lazy->hostModified = lazy->hostModified;
+            newDir->lazy->checkedAt = lazy->checkedAt;
+        }
         for (const auto& child : children) {
             newDir->add(child->clone());
         }
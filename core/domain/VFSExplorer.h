@@ -1,26 +1,279 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <iterator>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
+#include "../io/FileCopier.h"
+#include "../search/BulkIndexBuilder.h"
+#include "../search/ContentIndexer.h"
 #include "../search/FileHashMap.h"
 #include "../search/FileNameTrie.h"
+#include "../search/MappedNameIndex.h"
+#include "../search/ParallelTraversal.h"
+#include "../search/SubtreeNameFilters.h"
 #include "../utils/PathUtils.h"
+#include "ArchiveMount.h"
+#include "ChunkedFile.h"
+#include "HostListingPrefetcher.h"
+#include "HostTreeScanner.h"
+#include "IntervalLabeler.h"
+#include "MemoryFile.h"
+#include "MutationLog.h"
+#include "StoredFile.h"
 #include "VFSDirectory.h"
 #include "VFSFile.h"
 #include "VFSNode.h"
 
 //копирование файла, вырезать, вставить
 
-class VFSExplorer {
+enum class SearchMode { Index, Traversal, ParallelTraversal };
+
+class VFSExplorer : private DirectoryLister {
+    friend class HostFileWatcher;
+    friend class Journal;
+    friend class ScriptLoader;
+    friend class VFSSnapshot;
+
   private:
+    PageArena memoryPages; // declared first: memory files release their pages into it
     std::unique_ptr<VFSDirectory> root;
     FileHashMap searchMap;
+    FileHashMap physicalMap;
     FileNameTrie trie;
+    MutationLog* mutationLog = nullptr;
+    PackStore* packStore = nullptr;
+
+    // Names of the nodes restored from a snapshot, answered from the mapped image;
+    // searchMap and trie then only hold what changed since (see VFSSnapshot::load).
+    std::unique_ptr<MappedNameIndex> nameImage;
+    std::vector<VFSNode*> imageNodes;
+    std::unordered_map<std::string, size_t> imageNamesRemoved;
+
+    // Host directory mtimes have a coarse clock; a listing read this soon after a change
+    // may have missed another change in the same tick, so it is not trusted as current.
+    static constexpr std::chrono::seconds RACY_LISTING_WINDOW{1};
+    std::unique_ptr<HostListingPrefetcher> prefetcher;
+
+    // Const reads list lazy directories on first access, which changes the tree and the
+    // indexes, and searches rebuild scheduled name filters. Both happen under this lock,
+    // and index reads take it as well, so concurrent readers take turns for them.
+    mutable std::recursive_mutex readerMutex;
+
+    // Takes `node` out of the name image; false if it was never listed there.
+    bool leaveNameImage(VFSNode* node) {
+        std::uint32_t ordinal = node->getImageOrdinal();
+        if (ordinal == VFSNode::NO_IMAGE_ORDINAL) {
+            return false;
+        }
+        imageNodes[ordinal] = nullptr;
+        ++imageNamesRemoved[node->getName()];
+        node->setImageOrdinal(VFSNode::NO_IMAGE_ORDINAL);
+        return true;
+    }
+
+    std::vector<VFSNode*> indexedNodes(const std::string& name) const {
+        std::lock_guard<std::recursive_mutex> lock(readerMutex);
+        std::vector<VFSNode*> results = searchMap.get(name);
+        if (nameImage) {
+            auto [ordinals, count] = nameImage->find(name);
+            for (size_t i = 0; i < count; ++i) {
+                if (ordinals[i] < imageNodes.size() && imageNodes[ordinals[i]]) {
+                    results.push_back(imageNodes[ordinals[i]]);
+                }
+            }
+        }
+        return results;
+    }
+
+    void logMutation(MutationOp op, std::initializer_list<std::string_view> args,
+                     bool flag = false) {
+        if (mutationLog) {
+            mutationLog->record(op, args, flag);
+        }
+    }
+
+    void requireWritable(VFSDirectory* dir) const {
+        if (dir->isReadOnly()) {
+            throw std::runtime_error("Directory is read-only: " + findVirtualPath(dir));
+        }
+    }
+
+    // Archive members and stored files share one physical path with many others, so
+    // only files with a host file of their own are listed by physical path.
+    static bool hasOwnHostFile(const VFSNode* node) {
+        return !node->isDirectory() && static_cast<const VFSFile*>(node)->hasOwnHostFile();
+    }
+
+    // Lets the files below `node` give up content the VFS owns, once they are deleted.
+    static void discardSubtree(VFSNode* node) {
+        if (!node->isDirectory()) {
+            static_cast<VFSFile*>(node)->discardContent();
+            return;
+        }
+        for (const auto& child : static_cast<VFSDirectory*>(node)->getLoadedChildren()) {
+            discardSubtree(child.get());
+        }
+    }
+
+    void removeNodeAt(const std::string& fullPath) {
+        VFSDirectory* parentDir = getParentDirectory(fullPath);
+        requireWritable(parentDir);
+        VFSNode* nodeToDelete = parentDir->getChild(PathUtils::split(fullPath).back());
+        if (!nodeToDelete) {
+            throw std::runtime_error("Node does not exist at path: " + fullPath);
+        }
+        removeFromTrieAndMap(nodeToDelete);
+        SubtreeNameFilters::subtreeDetaching(nodeToDelete);
+        discardSubtree(nodeToDelete);
+        parentDir->remove(nodeToDelete->getName());
+    }
+
+    VFSDirectory* parentForNewFile(const std::string& parentPath, const std::string& name) const {
+        VFSDirectory* parentDir = navigateToDirectory(parentPath);
+        requireWritable(parentDir);
+        if (parentDir->getChild(name)) {
+            throw std::runtime_error("Directory or file with the same name already exists");
+        }
+        return parentDir;
+    }
+
+    VFSFile* attachFile(const std::string& parentPath, std::unique_ptr<VFSFile> newFile) {
+        VFSFile* result = newFile.get();
+        auto* parentDir = static_cast<VFSDirectory*>(result->getParent());
+        searchMap.put(result->getName(), result);
+        physicalMap.put(result->getPhysicalPath(), result);
+        trie.insert(result->getName());
+        attachNode(parentDir, std::move(newFile));
+        logMutation(MutationOp::AddFile, {parentPath, result->getName(), result->getPhysicalPath()});
+        return result;
+    }
+
+    PackStore& requirePackStore() const {
+        if (!packStore) {
+            throw std::runtime_error("No pack store attached");
+        }
+        return *packStore;
+    }
+
+    VFSFile* attachStoredFile(const std::string& parentPath, std::unique_ptr<VFSFile> newFile,
+                              MutationOp op, const ContentKey& key) {
+        VFSFile* result = newFile.get();
+        auto* parentDir = static_cast<VFSDirectory*>(result->getParent());
+        searchMap.put(result->getName(), result);
+        trie.insert(result->getName());
+        attachNode(parentDir, std::move(newFile));
+        if (mutationLog) {
+            // replay must find the content the record names
+            requirePackStore().flush();
+        }
+        logMutation(op, {parentPath, result->getName(), key.toHex()});
+        return result;
+    }
+
+    // Attaches a copy under `destDir`, replacing a node of the same name or, without
+    // `replace`, renaming the copy to "<name>_copyN".
+    VFSNode* placeCopy(std::unique_ptr<VFSNode> cloneNode, VFSDirectory* destDir, bool replace,
+                       const std::string& newName) {
+        std::string targetName = cloneNode->getName();
+
+        if (destDir->getChild(targetName) != nullptr) {
+            if (replace) {
+                VFSNode* replaced = destDir->getChild(targetName);
+                removeFromTrieAndMap(replaced);
+                SubtreeNameFilters::subtreeDetaching(replaced);
+                discardSubtree(replaced);
+                destDir->remove(targetName);
+            } else {
+                std::string originalName = targetName;
+                int counter = 1;
+                while (destDir->getChild(cloneNode->getName()) != nullptr) {
+                    cloneNode->rename(originalName + "_copy" + std::to_string(counter++));
+                }
+            }
+        }
+
+        if (!newName.empty()) {
+            cloneNode->rename(newName);
+        }
+
+        VFSNode* attached = attachNode(destDir, std::move(cloneNode));
+        SubtreeNameFilters::subtreeAssembled(attached);
+        addToTrieAndMap(attached);
+        return attached;
+    }
+
+    // Reads every lazy listing below `node`, so a deep copy sees the whole host tree.
+    static void listSubtree(const VFSNode* node) {
+        if (node->isDirectory()) {
+            for (const auto& child : static_cast<const VFSDirectory*>(node)->getChildren()) {
+                listSubtree(child.get());
+            }
+        }
+    }
+
+    // Files below `node` with a host file of their own, in preorder.
+    static void collectHostFiles(VFSNode* node, std::vector<VFSFile*>& files) {
+        if (hasOwnHostFile(node)) {
+            files.push_back(static_cast<VFSFile*>(node));
+        } else if (node->isDirectory()) {
+            for (const auto& child : static_cast<VFSDirectory*>(node)->getLoadedChildren()) {
+                collectHostFiles(child.get(), files);
+            }
+        }
+    }
+
+    static void detachListings(VFSNode* node) {
+        if (node->isDirectory()) {
+            auto* dir = static_cast<VFSDirectory*>(node);
+            dir->detachListing();
+            for (const auto& child : dir->getLoadedChildren()) {
+                detachListings(child.get());
+            }
+        }
+    }
+
+    // Copies `node` with its host files pointing at `hostCopies`, made beforehand in
+    // the order collectHostFiles visits them.
+    VFSNode* attachDeepCopy(const VFSNode* node, const std::string& destParentPath,
+                            bool replace, const std::string& newName,
+                            const std::vector<std::string>& hostCopies) {
+        VFSDirectory* destDir = navigateToDirectory(destParentPath);
+        requireWritable(destDir);
+        std::string sourcePath =
+            mutationLog ? findVirtualPath(const_cast<VFSNode*>(node)) : std::string();
+        listSubtree(node);
+        auto cloneNode = node->clone();
+        detachListings(cloneNode.get());
+        std::vector<VFSFile*> files;
+        collectHostFiles(cloneNode.get(), files);
+        if (files.size() != hostCopies.size()) {
+            throw std::runtime_error("Deep copy does not match its source: " + sourcePath);
+        }
+        for (size_t i = 0; i < files.size(); ++i) {
+            files[i]->relink(hostCopies[i]);
+        }
+        VFSNode* attached = placeCopy(std::move(cloneNode), destDir, replace, newName);
+
+        std::string copyList;
+        for (const auto& copy : hostCopies) {
+            copyList += copyList.empty() ? copy : '\0' + copy;
+        }
+        logMutation(MutationOp::DeepCopyNode, {sourcePath, destParentPath, newName, copyList},
+                    replace);
+        return attached;
+    }
 
     VFSDirectory* navigateToDirectory(const std::string& path) const {
         VFSNode* node = navigateToNode(path);
@@ -87,19 +340,83 @@ class VFSExplorer {
         return current;
     }
 
-    void searchRecursive(VFSNode* current, const std::string& targetName,
-                         std::vector<VFSNode*>& results) const {
-        if (!current)
+    void searchDepthFirst(VFSNode* start, const std::string& targetName,
+                          std::vector<VFSNode*>& results) const {
+        std::vector<VFSNode*> stack;
+        if (start) {
+            stack.push_back(start);
+        }
+
+        while (!stack.empty()) {
+            VFSNode* current = stack.back();
+            stack.pop_back();
+
+            if (current->getName() == targetName) {
+                results.push_back(current);
+            }
+
+            if (current->isDirectory()) {
+                auto* dir = static_cast<VFSDirectory*>(current);
+                if (!SubtreeNameFilters::mayContain(dir, targetName)) {
+                    continue;
+                }
+                const auto& children = dir->getLoadedChildren();
+                for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                    stack.push_back(it->get());
+                }
+            }
+        }
+    }
+
+    // Lists the lazy directories below `scope` and rebuilds scheduled name filters, so
+    // the traversal that follows only reads the tree.
+    void prepareTraversal(const VFSDirectory* scope) const {
+        std::lock_guard<std::recursive_mutex> lock(readerMutex);
+        listLazyDirectories(scope);
+        SubtreeNameFilters::refresh(root.get());
+    }
+
+    void addToTrieAndMap(VFSNode* node) {
+        if (!node)
             return;
 
-        if (current->getName() == targetName) {
-            results.push_back(current);
+        searchMap.put(node->getName(), node);
+        trie.insert(node->getName());
+        if (hasOwnHostFile(node)) {
+            physicalMap.put(static_cast<VFSFile*>(node)->getPhysicalPath(), node);
         }
 
-        if (current->isDirectory()) {
-            auto* dir = static_cast<VFSDirectory*>(current);
-            for (const auto& child : dir->getChildren()) {
-                searchRecursive(child.get(), targetName, results);
+        if (node->isDirectory()) {
+            auto* dir = static_cast<VFSDirectory*>(node);
+            for (const auto& child : dir->getLoadedChildren()) {
+                addToTrieAndMap(child.get());
+            }
+        }
+    }
+
+    VFSNode* attachNode(VFSDirectory* parentDir, std::unique_ptr<VFSNode> node) {
+        VFSNode* attached = node.get();
+        parentDir->add(std::move(node));
+        IntervalLabeler::attach(attached);
+        SubtreeNameFilters::subtreeAttached(attached);
+        return attached;
+    }
+
+    // Indexes nodes that were attached without their index updates, in one batch: a bulk
+    // rebuild when they make up at least half of the tree, plain inserts otherwise.
+    void indexAttached(const std::vector<VFSNode*>& attached) {
+        if (attached.size() * 2 >= root->getDescendantCount()) {
+            rebuildIndexes();
+        } else {
+            for (VFSNode* node : attached) {
+                searchMap.put(node->getName(), node);
+                trie.insert(node->getName());
+            }
+        }
+        physicalMap.reserve(attached.size());
+        for (VFSNode* node : attached) {
+            if (hasOwnHostFile(node)) {
+                physicalMap.put(static_cast<VFSFile*>(node)->getPhysicalPath(), node);
             }
         }
     }
@@ -108,24 +425,220 @@ class VFSExplorer {
         if (!node)
             return;
 
-        searchMap.remove(node->getName(), node);
-        trie.erase(node->getName());
+        if (!leaveNameImage(node)) {
+            searchMap.remove(node->getName(), node);
+            trie.erase(node->getName());
+        }
+        if (hasOwnHostFile(node)) {
+            physicalMap.remove(static_cast<VFSFile*>(node)->getPhysicalPath(), node);
+        }
 
         if (node->isDirectory()) {
             auto* dir = static_cast<VFSDirectory*>(node);
-            for (const auto& child : dir->getChildren()) {
+            for (const auto& child : dir->getLoadedChildren()) {
                 removeFromTrieAndMap(child.get());
             }
         }
     }
 
+    std::unique_ptr<VFSNode> hostChild(const LazyListing& parent, const HostEntry& entry) {
+        std::string path = HostDirectoryReader::childPath(parent.hostPath, entry.name);
+        if (entry.kind == HostEntryKind::File) {
+            return std::make_unique<VFSFile>(entry.name, path, VFSFile::TrustedPath{});
+        }
+        auto dir = std::make_unique<VFSDirectory>(entry.name);
+        dir->makeLazy(this, std::move(path), parent.options);
+        return dir;
+    }
+
+    // Whether `child` of a lazy directory came from its host listing rather than from a
+    // VFS operation, i.e. whether revalidation is allowed to take it away.
+    static bool mirrorsHost(const LazyListing& parent, const VFSNode* child) {
+        std::string path = HostDirectoryReader::childPath(parent.hostPath, child->getName());
+        if (!child->isDirectory()) {
+            return static_cast<const VFSFile*>(child)->getPhysicalPath() == path;
+        }
+        const LazyListing* lazy = static_cast<const VFSDirectory*>(child)->getLazyListing();
+        return lazy && lazy->hostPath == path;
+    }
+
+    void attachHostEntries(VFSDirectory& dir, const std::vector<HostEntry>& entries) {
+        const LazyListing& lazy = *dir.getLazyListing();
+        std::vector<VFSNode*> attached;
+        attached.reserve(entries.size());
+        for (const auto& entry : entries) {
+            attached.push_back(attachNode(&dir, hostChild(lazy, entry)));
+        }
+        indexAttached(attached);
+    }
+
+    void acceptListing(LazyListing& lazy, const HostListing& listing) {
+        bool racy = std::filesystem::file_time_type::clock::now() - listing.modified <
+                    RACY_LISTING_WINDOW;
+        lazy.hostModified = racy ? std::filesystem::file_time_type{} : listing.modified;
+        lazy.checkedAt = std::chrono::steady_clock::now();
+    }
+
+    // Queues the listings of the next unlisted sibling directories. Siblings are kept in
+    // label order, so `dir` is found by its label rather than by a scan.
+    void prefetchSiblings(const VFSDirectory& dir) {
+        size_t remaining = dir.getLazyListing()->options.prefetchSiblings;
+        auto* parent = static_cast<VFSDirectory*>(dir.getParent());
+        if (remaining == 0 || !parent || !prefetcher) {
+            return;
+        }
+        const auto& siblings = parent->getLoadedChildren();
+        auto it = std::upper_bound(siblings.begin(), siblings.end(), dir.getPreLabel(),
+                                   [](std::uint64_t label, const std::unique_ptr<VFSNode>& node) {
+                                       return label < node->getPreLabel();
+                                   });
+        for (; it != siblings.end() && remaining > 0; ++it) {
+            if ((*it)->isDirectory()) {
+                auto* sibling = static_cast<VFSDirectory*>(it->get());
+                if (!sibling->isListed()) {
+                    prefetcher->prefetch(sibling->getLazyListing()->hostPath);
+                    --remaining;
+                }
+            }
+        }
+    }
+
+    void listLazy(VFSDirectory& dir) {
+        LazyListing& lazy = *dir.getLazyListing();
+        dir.markListed();
+        HostListing listing;
+        bool prefetched =
+            prefetcher && prefetcher->take(lazy.hostPath, lazy.options.revalidateAfter, listing);
+        if (!prefetched) {
+            listing = HostDirectoryReader::readListing(lazy.hostPath);
+        }
+        acceptListing(lazy, listing);
+        attachHostEntries(dir, listing.entries);
+        prefetchSiblings(dir);
+    }
+
+    // Re-reads a listing whose host directory changed since it was read: entries that
+    // disappeared or changed kind are removed, new ones attached. Children created through
+    // the VFS are left alone, and win over a host entry of the same name.
+    void revalidateLazy(VFSDirectory& dir) {
+        LazyListing& lazy = *dir.getLazyListing();
+        lazy.checkedAt = std::chrono::steady_clock::now();
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(lazy.hostPath, ec);
+        if (!ec && modified == lazy.hostModified) {
+            return;
+        }
+
+        HostListing listing = HostDirectoryReader::readListing(lazy.hostPath);
+        acceptListing(lazy, listing);
+        std::unordered_map<std::string, HostEntryKind> fresh;
+        for (const auto& entry : listing.entries) {
+            fresh.emplace(entry.name, entry.kind);
+        }
+
+        std::vector<std::string> vanished;
+        std::unordered_set<std::string> present;
+        for (const auto& child : dir.getLoadedChildren()) {
+            auto entry = fresh.find(child->getName());
+            HostEntryKind kind =
+                child->isDirectory() ? HostEntryKind::Directory : HostEntryKind::File;
+            bool kept = entry != fresh.end() && entry->second == kind;
+            if (mirrorsHost(lazy, child.get()) && !kept) {
+                vanished.push_back(child->getName());
+            } else {
+                present.insert(child->getName());
+            }
+        }
+        std::vector<HostEntry> added;
+        for (const auto& entry : listing.entries) {
+            if (!present.count(entry.name)) {
+                added.push_back(entry);
+            }
+        }
+
+        // Only loaded children are touched, and the flag keeps accesses made on the way
+        // from starting a second pass over the same directory.
+        lazy.revalidating = true;
+        try {
+            for (const auto& name : vanished) {
+                VFSNode* child = dir.getLoadedChild(name);
+                removeFromTrieAndMap(child);
+                SubtreeNameFilters::subtreeDetaching(child);
+                dir.removeLoadedChild(name);
+            }
+            attachHostEntries(dir, added);
+        } catch (...) {
+            lazy.revalidating = false;
+            throw;
+        }
+        lazy.revalidating = false;
+    }
+
+    void childrenAccessed(VFSDirectory& dir) override {
+        std::lock_guard<std::recursive_mutex> lock(readerMutex);
+        LazyListing& lazy = *dir.getLazyListing();
+        if (!lazy.listed) {
+            listLazy(dir);
+        } else if (!lazy.revalidating && lazy.options.revalidateAfter.count() > 0 &&
+                   std::chrono::steady_clock::now() - lazy.checkedAt >=
+                       lazy.options.revalidateAfter) {
+            revalidateLazy(dir);
+        }
+    }
+
+    // Lists every lazy directory below `dir` on the calling thread, ahead of a traversal
+    // that reads the tree from several threads.
+    void listLazyDirectories(const VFSDirectory* dir) const {
+        if (dir->getNameSummary().unlistedDirectories == 0) {
+            return;
+        }
+        for (const auto& child : dir->getChildren()) {
+            if (child->isDirectory()) {
+                listLazyDirectories(static_cast<const VFSDirectory*>(child.get()));
+            }
+        }
+    }
+
 public:
-    VFSExplorer() : root(std::make_unique<VFSDirectory>("root", nullptr)), searchMap(), trie() {}
+    VFSExplorer()
+        : root(std::make_unique<VFSDirectory>("root", nullptr)), searchMap(), physicalMap(),
+          trie() {
+        IntervalLabeler::labelRoot(root.get());
+    }
 
     VFSDirectory* getRoot() const { return root.get(); }
 
+    // Successful mutations are reported to `log` from now on; nullptr detaches it.
+    void setMutationLog(MutationLog* log) { mutationLog = log; }
+
+    // Store for the contents of files created with createStoredFile; must outlive them.
+    void setPackStore(PackStore* store) { packStore = store; }
+
+    PackStore* getPackStore() const { return packStore; }
+
+    // Rebuilds the name map and trie from the tree in one bulk pass, dropping a mapped
+    // name image if one is attached. Returns the number of names indexed.
+    size_t rebuildIndexes(size_t threadCount = ParallelTraversal::defaultThreadCount()) {
+        for (VFSNode* node : imageNodes) {
+            if (node) {
+                node->setImageOrdinal(VFSNode::NO_IMAGE_ORDINAL);
+            }
+        }
+        nameImage.reset();
+        imageNodes.clear();
+        imageNamesRemoved.clear();
+
+        FileHashMap rebuiltMap;
+        FileNameTrie rebuiltTrie;
+        size_t count = BulkIndexBuilder::build(root.get(), rebuiltMap, rebuiltTrie, threadCount);
+        searchMap = std::move(rebuiltMap);
+        trie = std::move(rebuiltTrie);
+        return count;
+    }
+
     VFSDirectory* createDirectory(const std::string& parentPath, const std::string& name) {
         VFSDirectory* parentDir = navigateToDirectory(parentPath);
+        requireWritable(parentDir);
 
         if (parentDir->getChild(name)) {
             throw std::runtime_error("Directory or file with the same name already exists");
@@ -135,7 +648,8 @@ public:
         VFSDirectory* result = newDir.get();
         searchMap.put(name, result);
         trie.insert(name);
-        parentDir->add(std::move(newDir));
+        attachNode(parentDir, std::move(newDir));
+        logMutation(MutationOp::CreateDirectory, {parentPath, name});
         return result;
     }
 
@@ -160,17 +674,173 @@ public:
 
     VFSFile* addFile(const std::string& parentPath, const std::string& name,
                      const std::string& physicalPath) {
-        VFSDirectory* parentDir = navigateToDirectory(parentPath);
+        VFSDirectory* parentDir = parentForNewFile(parentPath, name);
+        return attachFile(parentPath, std::make_unique<VFSFile>(name, physicalPath, parentDir));
+    }
 
-        if (parentDir->getChild(name)) {
-            throw std::runtime_error("Directory or file with the same name already exists");
+    // Adds a file whose absolute physical path is already known, e.g. during journal
+    // replay, without requiring the host file to still exist.
+    VFSFile* addFile(const std::string& parentPath, const std::string& name,
+                     const std::string& absolutePath, VFSFile::TrustedPath tag) {
+        VFSDirectory* parentDir = parentForNewFile(parentPath, name);
+        return attachFile(parentPath,
+                          std::make_unique<VFSFile>(name, absolutePath, tag, parentDir));
+    }
+
+    // Adds an empty file that lives only in memory; fill it through MemoryFile::write.
+    // Journals and snapshots keep the file but not its content.
+    MemoryFile* createMemoryFile(const std::string& parentPath, const std::string& name) {
+        VFSDirectory* parentDir = parentForNewFile(parentPath, name);
+        auto newFile = std::make_unique<MemoryFile>(name, memoryPages, parentDir);
+        MemoryFile* result = newFile.get();
+        searchMap.put(name, result);
+        trie.insert(name);
+        attachNode(parentDir, std::move(newFile));
+        logMutation(MutationOp::CreateMemoryFile, {parentPath, name});
+        return result;
+    }
+
+    PageArenaStats getMemoryPageStats() { return memoryPages.getStats(); }
+
+    // Adds a file holding `content`, kept in the attached pack store rather than in a
+    // host file of its own. Identical contents are stored once.
+    VFSFile* createStoredFile(const std::string& parentPath, const std::string& name,
+                              std::string_view content) {
+        parentForNewFile(parentPath, name);
+        PackStore& store = requirePackStore();
+        ContentKey key = store.put(content);
+        try {
+            return addStoredFile(parentPath, name, key);
+        } catch (...) {
+            store.discard(key);
+            throw;
         }
+    }
+
+    // Adds a file for content that is already in the attached pack store.
+    VFSFile* addStoredFile(const std::string& parentPath, const std::string& name,
+                           const ContentKey& key) {
+        VFSDirectory* parentDir = parentForNewFile(parentPath, name);
+        return attachStoredFile(
+            parentPath, std::make_unique<StoredFile>(name, requirePackStore(), key, parentDir),
+            MutationOp::AddStoredFile, key);
+    }
+
+    // Like createStoredFile, but the content is split into content-defined chunks that
+    // are stored once, so near-duplicate files share most of their bytes.
+    VFSFile* createChunkedFile(const std::string& parentPath, const std::string& name,
+                               std::string_view content, ChunkerOptions options = {}) {
+        parentForNewFile(parentPath, name);
+        ContentChunker chunker(options);
+        PackStore& store = requirePackStore();
+        ContentKey recipe = ChunkedFile::storeContent(store, content, chunker);
+        try {
+            return addChunkedFile(parentPath, name, recipe);
+        } catch (...) {
+            ChunkedFile::discardStored(store, recipe);
+            throw;
+        }
+    }
 
-        std::unique_ptr<VFSFile> newFile = std::make_unique<VFSFile>(name, physicalPath, parentDir);
-        searchMap.put(name, newFile.get());
+    // Adds a chunked file whose recipe is already in the attached pack store.
+    VFSFile* addChunkedFile(const std::string& parentPath, const std::string& name,
+                            const ContentKey& recipe) {
+        VFSDirectory* parentDir = parentForNewFile(parentPath, name);
+        return attachStoredFile(
+            parentPath, std::make_unique<ChunkedFile>(name, requirePackStore(), recipe, parentDir),
+            MutationOp::AddChunkedFile, recipe);
+    }
+
+    // Imports the host directory `hostPath` with everything below it as a new directory
+    // at `virtualPath`. Directories are read in parallel and the names are indexed in
+    // one batch after the subtree is in place.
+    MountStats mountHostDirectory(const std::string& hostPath, const std::string& virtualPath,
+                                  size_t threadCount = ThreadPool::defaultThreadCount()) {
+        auto start = std::chrono::steady_clock::now();
+        std::string parentPath = PathUtils::getParentPath(virtualPath);
+        std::string name = PathUtils::getFileName(virtualPath);
+        if (name.empty()) {
+            throw std::runtime_error("Invalid mount path: " + virtualPath);
+        }
+        VFSDirectory* parentDir = parentForNewFile(parentPath, name);
+
+        auto mountRoot = std::make_unique<VFSDirectory>(name);
+        std::vector<VFSNode*> attached{mountRoot.get()};
+        MountStats stats = HostTreeScanner::scan(hostPath, mountRoot.get(), attached, threadCount);
+        VFSNode* mounted = attachNode(parentDir, std::move(mountRoot));
+        SubtreeNameFilters::subtreeAssembled(mounted);
+        indexAttached(attached);
+        logMutation(MutationOp::MountHostDirectory, {hostPath, virtualPath});
+
+        stats.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.filesPerSecond = stats.seconds > 0 ? stats.files / stats.seconds : 0;
+        return stats;
+    }
+
+    // Mounts the host directory `hostPath` at `virtualPath` without reading it. Each
+    // directory below is listed the first time its children are accessed, so mounting
+    // costs the same for any host tree; index searches and suggestions cover what has
+    // been listed so far. Listing runs under the explorer's reader lock, so threads may
+    // read a mount concurrently; with revalidateAfter set, though, a listing is rewritten
+    // in place and must not change under a traversal running on another thread.
+    VFSDirectory* mountLazy(const std::string& hostPath, const std::string& virtualPath,
+                            LazyMountOptions options = {}) {
+        std::string parentPath = PathUtils::getParentPath(virtualPath);
+        std::string name = PathUtils::getFileName(virtualPath);
+        if (name.empty()) {
+            throw std::runtime_error("Invalid mount path: " + virtualPath);
+        }
+        std::error_code ec;
+        if (!std::filesystem::is_directory(hostPath, ec)) {
+            throw std::runtime_error("Host directory does not exist: " + hostPath);
+        }
+        VFSDirectory* parentDir = parentForNewFile(parentPath, name);
+
+        auto mountRoot = std::make_unique<VFSDirectory>(name);
+        mountRoot->makeLazy(this, HostDirectoryReader::normalize(hostPath), options);
+        if (options.prefetchSiblings > 0 && !prefetcher) {
+            prefetcher = std::make_unique<HostListingPrefetcher>();
+        }
+        VFSDirectory* result = mountRoot.get();
+        searchMap.put(name, result);
         trie.insert(name);
-        parentDir->add(std::move(newFile));
-        return newFile.get();
+        attachNode(parentDir, std::move(mountRoot));
+        logMutation(MutationOp::MountLazy,
+                    {hostPath, virtualPath, std::to_string(options.prefetchSiblings),
+                     std::to_string(options.revalidateAfter.count())});
+        return result;
+    }
+
+    // Mounts the tar archive `archivePath` read-only at `virtualPath`. The member table
+    // comes from the index kept next to the archive, or from one pass over its headers
+    // when there is none yet; member contents are read from the archive on demand.
+    ArchiveMountStats mountArchive(const std::string& archivePath,
+                                   const std::string& virtualPath) {
+        auto start = std::chrono::steady_clock::now();
+        std::string parentPath = PathUtils::getParentPath(virtualPath);
+        std::string name = PathUtils::getFileName(virtualPath);
+        if (name.empty()) {
+            throw std::runtime_error("Invalid mount path: " + virtualPath);
+        }
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(archivePath, ec)) {
+            throw std::runtime_error("Archive does not exist: " + archivePath);
+        }
+        VFSDirectory* parentDir = parentForNewFile(parentPath, name);
+
+        std::string absolutePath = HostDirectoryReader::normalize(archivePath);
+        auto mountRoot = std::make_unique<ArchiveDirectory>(name, absolutePath);
+        std::vector<VFSNode*> attached{mountRoot.get()};
+        ArchiveMountStats stats = ArchiveMount::build(absolutePath, mountRoot.get(), attached);
+        VFSNode* mounted = attachNode(parentDir, std::move(mountRoot));
+        SubtreeNameFilters::subtreeAssembled(mounted);
+        indexAttached(attached);
+        logMutation(MutationOp::MountArchive, {archivePath, virtualPath});
+
+        stats.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
     }
 
     void deleteNode(VFSNode* node) {
@@ -182,26 +852,101 @@ public:
     }
 
     void deleteNode(const std::string& fullPath) {
-        VFSDirectory* parentDir = getParentDirectory(fullPath);
-        VFSNode* nodeToDelete = parentDir->getChild(PathUtils::split(fullPath).back());
-        if (!nodeToDelete) {
-            throw std::runtime_error("Node does not exist at path: " + fullPath);
-        }
-        removeFromTrieAndMap(nodeToDelete);
-        parentDir->remove(nodeToDelete->getName());
+        removeNodeAt(fullPath);
+        logMutation(MutationOp::DeleteNode, {fullPath});
     }
 
     std::vector<VFSNode*> searchByIndex(const std::string& name) const {
-        return searchMap.get(name);
+        return indexedNodes(name);
+    }
+
+    std::vector<VFSNode*> searchByIndex(const std::string& name, const std::string& scopePath) const {
+        VFSNode* scope = navigateToDirectory(scopePath);
+
+        std::vector<VFSNode*> results;
+        for (VFSNode* node : indexedNodes(name)) {
+            if (scope->isAncestorOf(node)) {
+                results.push_back(node);
+            }
+        }
+        return results;
     }
 
     std::vector<VFSNode*> searchByTraversal(const std::string& name) const {
         std::vector<VFSNode*> results;
-        searchRecursive(root.get(), name, results);
+        prepareTraversal(root.get());
+        searchDepthFirst(root.get(), name, results);
 
         return results;
     }
 
+    std::vector<VFSNode*> searchByTraversal(const std::string& name,
+                                            const std::string& scopePath) const {
+        VFSDirectory* scope = navigateToDirectory(scopePath);
+        std::vector<VFSNode*> results;
+        prepareTraversal(scope);
+        searchDepthFirst(scope, name, results);
+
+        if (!results.empty() && results.front() == scope) {
+            results.erase(results.begin());
+        }
+        return results;
+    }
+
+    std::vector<VFSNode*> searchByParallelTraversal(
+        const std::string& name,
+        size_t threadCount = ParallelTraversal::defaultThreadCount()) const {
+        prepareTraversal(root.get());
+        return ParallelTraversal::collect(
+            root.get(), threadCount,
+            [&name](const VFSNode* node) { return node->getName() == name; },
+            [&name](const VFSDirectory* dir) { return SubtreeNameFilters::mayContain(dir, name); });
+    }
+
+    std::vector<VFSNode*> search(const std::string& name, SearchMode mode) const {
+        switch (mode) {
+        case SearchMode::Traversal:
+            return searchByTraversal(name);
+        case SearchMode::ParallelTraversal:
+            return searchByParallelTraversal(name);
+        case SearchMode::Index:
+        default:
+            return searchByIndex(name);
+        }
+    }
+
+    std::vector<VFSFile*> findByPhysicalPath(const std::string& physicalPath) const {
+        std::lock_guard<std::recursive_mutex> lock(readerMutex);
+        std::vector<VFSFile*> files;
+        for (VFSNode* node : physicalMap.get(physicalPath)) {
+            files.push_back(static_cast<VFSFile*>(node));
+        }
+        return files;
+    }
+
+    std::vector<std::string> collectPhysicalPaths() const {
+        std::lock_guard<std::recursive_mutex> lock(readerMutex);
+        return physicalMap.keys();
+    }
+
+    // Single words are term queries, several words must appear as a phrase.
+    std::vector<VFSFile*> searchByContent(const ContentIndexer& indexer,
+                                          const std::string& query) const {
+        std::vector<std::string> terms = ContentIndex::tokenize(query);
+        std::vector<VFSFile*> results;
+        if (terms.empty()) {
+            return results;
+        }
+
+        std::vector<std::string> paths =
+            terms.size() > 1 ? indexer.findPhrase(query) : indexer.findTerm(terms.front());
+        for (const auto& path : paths) {
+            auto files = findByPhysicalPath(path);
+            results.insert(results.end(), files.begin(), files.end());
+        }
+        return results;
+    }
+
     bool renameNode(VFSNode* node, const std::string& newName) {
         if (!node) {
             throw std::runtime_error("Node is null");
@@ -214,6 +959,7 @@ public:
 
     bool renameNode(const std::string& fullPath, const std::string& newName) {
         VFSDirectory* parentDir = getParentDirectory(fullPath);
+        requireWritable(parentDir);
         VFSNode* nodeToRename = parentDir->getChild(PathUtils::split(fullPath).back());
         if (!nodeToRename) {
             throw std::runtime_error("Node does not exist at path: " + fullPath);
@@ -223,10 +969,15 @@ public:
             throw std::runtime_error("A node with the new name already exists in the directory");
         }
 
-        removeFromTrieAndMap(nodeToRename);
+        if (!leaveNameImage(nodeToRename)) {
+            searchMap.remove(nodeToRename->getName(), nodeToRename);
+            trie.erase(nodeToRename->getName());
+        }
         nodeToRename->rename(newName);
         trie.insert(newName);
         searchMap.put(newName, nodeToRename);
+        SubtreeNameFilters::nameReplaced(nodeToRename);
+        logMutation(MutationOp::RenameNode, {fullPath, newName});
 
         return true;
     }
@@ -248,26 +999,29 @@ public:
             throw std::runtime_error("Destination already contains a file/folder with this name");
         }
 
-        VFSNode* tmp = newParent;
-        while (tmp) {
-            if (tmp == node) {
-                throw std::runtime_error("Cannot move directory into its own child");
-            }
-            tmp = tmp->getParent();
+        if (node->isAncestorOf(newParent)) {
+            throw std::runtime_error("Cannot move directory into its own child");
         }
 
         auto* oldParent = static_cast<VFSDirectory*>(node->getParent());
         if (!oldParent) {
             throw std::runtime_error("Cannot move root directory or node without parent");
         }
+        requireWritable(oldParent);
+        requireWritable(newParent);
 
+        std::string oldPath = mutationLog ? findVirtualPath(node) : std::string();
+        SubtreeNameFilters::subtreeDetaching(node);
         std::unique_ptr<VFSNode> extractedChild = oldParent->extractChild(node->getName());
 
         if (!extractedChild) {
             throw std::runtime_error("Node not found in parent's list");
         }
         node->setParent(newParent);
-        newParent->add(std::move(extractedChild));
+        attachNode(newParent, std::move(extractedChild));
+        if (mutationLog) {
+            logMutation(MutationOp::MoveNode, {oldPath, findVirtualPath(newParent)});
+        }
     }
 
     std::string findVirtualPath(VFSNode* node) const {
@@ -295,7 +1049,27 @@ public:
     }
 
     std::vector<std::string> getSuggestions(const std::string& prefix) const {
-        return trie.autoComplete(prefix);
+        std::lock_guard<std::recursive_mutex> lock(readerMutex);
+        std::vector<std::string> suggestions = trie.autoComplete(prefix);
+        if (!nameImage) {
+            return suggestions;
+        }
+
+        std::vector<std::string> fromImage;
+        nameImage->forEachWithPrefix(prefix, [&](const std::string& name, size_t count) {
+            auto removed = imageNamesRemoved.find(name);
+            if (removed == imageNamesRemoved.end() || removed->second < count) {
+                fromImage.push_back(name);
+            }
+        });
+        auto trieOrder = [](const std::string& a, const std::string& b) {
+            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+        };
+        std::vector<std::string> merged;
+        merged.reserve(suggestions.size() + fromImage.size());
+        std::set_union(fromImage.begin(), fromImage.end(), suggestions.begin(),
+                       suggestions.end(), std::back_inserter(merged), trieOrder);
+        return merged;
     }
 
     bool copyNode(const VFSNode* node, const std::string& destParentPath, bool replace = false, std::string newName = "") {
@@ -306,30 +1080,85 @@ public:
             throw std::runtime_error("Destination path is not a directory");
         }
         auto* destDir = static_cast<VFSDirectory*>(destNode);
+        requireWritable(destDir);
 
-        auto cloneNode = node->clone();
-        std::string targetName = cloneNode->getName();
+        std::string sourcePath =
+            mutationLog ? findVirtualPath(const_cast<VFSNode*>(node)) : std::string();
+        placeCopy(node->clone(), destDir, replace, newName);
+        logMutation(MutationOp::CopyNode, {sourcePath, destParentPath, newName}, replace);
 
-        if (destDir->getChild(targetName) != nullptr) {
-            if (replace) {
-                destDir->remove(targetName);
-            } else {
-                std::string originalName = targetName;
-                int counter = 1;
-                while (destDir->getChild(cloneNode->getName()) != nullptr) {
-                    cloneNode->rename(originalName + "_copy" + std::to_string(counter++));
+        return true;
+    }
+
+    // Like copyNode, but the copy gets host files of its own: every host file below
+    // `node` is copied next to its original, several at once, by reflink or in-kernel
+    // copy where the filesystem allows. Stored, chunked and archive files share their
+    // immutable content as before; memory files are copied by clone anyway.
+    DeepCopyStats deepCopyNode(const VFSNode* node, const std::string& destParentPath,
+                               bool replace = false, std::string newName = "",
+                               size_t threadCount = ThreadPool::defaultThreadCount()) {
+        auto start = std::chrono::steady_clock::now();
+        if (!node) {
+            throw std::runtime_error("Node to copy is null");
+        }
+        requireWritable(navigateToDirectory(destParentPath));
+        listSubtree(node);
+        std::vector<VFSFile*> originals;
+        collectHostFiles(const_cast<VFSNode*>(node), originals);
+
+        DeepCopyStats stats{};
+        std::vector<std::string> copies(originals.size());
+        std::vector<FileCopyResult> results(originals.size());
+        auto copyOne = [&](size_t i) {
+            copies[i] = FileCopier::copyBeside(originals[i]->getPhysicalPath(), results[i]);
+        };
+        std::exception_ptr failure;
+        if (threadCount > 1 && originals.size() > 1) {
+            ThreadPool pool(std::min(threadCount, originals.size()));
+            std::vector<std::future<void>> pending;
+            pending.reserve(originals.size());
+            for (size_t i = 0; i < originals.size(); ++i) {
+                pending.push_back(pool.submit([&copyOne, i]() { copyOne(i); }));
+            }
+            for (auto& result : pending) {
+                try {
+                    result.get();
+                } catch (...) {
+                    failure = std::current_exception();
                 }
             }
+        } else {
+            try {
+                for (size_t i = 0; i < originals.size(); ++i) {
+                    copyOne(i);
+                }
+            } catch (...) {
+                failure = std::current_exception();
+            }
         }
-
-        if (!newName.empty()) {
-            cloneNode->rename(newName);
+        if (!failure) {
+            try {
+                attachDeepCopy(node, destParentPath, replace, newName, copies);
+            } catch (...) {
+                failure = std::current_exception();
+            }
+        }
+        if (failure) {
+            for (const auto& copy : copies) {
+                if (!copy.empty()) {
+                    std::error_code ec;
+                    std::filesystem::remove(copy, ec);
+                }
+            }
+            std::rethrow_exception(failure);
         }
 
-
-        destDir->add(std::move(cloneNode));
-        
-        return true;
+        for (const auto& result : results) {
+            stats.add(result);
+        }
+        stats.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
     }
 
     bool cutNode(VFSNode* node, const std::string& destParentPath, bool replace = false, std::string newName = "") {
@@ -340,29 +1169,14 @@ public:
             throw std::runtime_error("Destination path is not a directory");
         }
         auto* destDir = static_cast<VFSDirectory*>(destNode);
+        requireWritable(destDir);
 
         auto cloneNode = node->clone();
-        deleteNode(findVirtualPath(node));
-        std::string targetName = cloneNode->getName();
-
-        if (destDir->getChild(targetName) != nullptr) {
-            if (replace) {
-                destDir->remove(targetName);
-            } else {
-                std::string originalName = targetName;
-                int counter = 1;
-                while (destDir->getChild(cloneNode->getName()) != nullptr) {
-                    cloneNode->rename(originalName + "_copy" + std::to_string(counter++));
-                }
-            }
-        }
-
-        if (!newName.empty()) {
-            cloneNode->rename(newName);
-        }
+        std::string sourcePath = findVirtualPath(node);
+        removeNodeAt(sourcePath);
+        placeCopy(std::move(cloneNode), destDir, replace, newName);
+        logMutation(MutationOp::CutNode, {sourcePath, destParentPath, newName}, replace);
 
-        destDir->add(std::move(cloneNode));
-        
         return true;
     }
 };
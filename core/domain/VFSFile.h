@@ -1,4 +1,10 @@
 #pragma once
+#include "../io/AsyncFileIO.h"
+#include "../io/BlockCache.h"
+#include "../io/FileDescriptorCache.h"
+#include "../io/MappedFile.h"
+#include "../io/ReadaheadStream.h"
+#include "../io/WriteBackStream.h"
 #include "VFSNode.h"
 #include <filesystem>
 #include <fstream>
@@ -9,6 +15,10 @@ private:
     std::string physicalPath;
 
 public:
+    // Marks a physical path that is already absolute and known to exist, so restoring
+    // millions of files does not stat each one.
+    struct TrustedPath {};
+
     VFSFile(std::string name, std::string physicalPath, VFSNode* parent = nullptr)
         : VFSNode(std::move(name), parent) {
         if (!std::filesystem::exists(physicalPath)) {
@@ -17,23 +27,134 @@ public:
         this->physicalPath = std::filesystem::absolute(physicalPath).string();
     }
 
+    VFSFile(std::string name, std::string absolutePath, TrustedPath, VFSNode* parent = nullptr)
+        : VFSNode(std::move(name), parent), physicalPath(std::move(absolutePath)) {}
+
     bool isDirectory() const override { return false; }
 
     size_t getSize() const override {
+        if (cachedSize != NO_CACHED_SIZE) {
+            return static_cast<size_t>(cachedSize);
+        }
         std::error_code ec;
         auto size = std::filesystem::file_size(physicalPath, ec);
         return ec ? 0 : size;
     }
 
+    // Changes the cached size and every cached total above it. A cached directory implies
+    // cached directories below, so the walk stops at the first ancestor without one.
+    void updateCachedSize(std::int64_t size) {
+        std::int64_t previous = cachedSize;
+        cachedSize = size;
+        if (previous == NO_CACHED_SIZE) {
+            return;
+        }
+        for (VFSNode* node = getParent(); node; node = node->getParent()) {
+            if (node->getCachedSize() == NO_CACHED_SIZE) {
+                break;
+            }
+            node->setCachedSize(node->getCachedSize() + size - previous);
+        }
+    }
+
     std::string getPhysicalPath() const { 
         return physicalPath;
         }
 
-    std::unique_ptr<std::istream> openReadStream() const {
+    // Points a file that is not in a tree yet at another host file, e.g. a copy.
+    void relink(std::string absolutePath) { physicalPath = std::move(absolutePath); }
+
+    // True for files that are a byte range of their physical file (see ArchiveMount.h).
+    virtual bool isArchiveMember() const { return false; }
+
+    // False when the physical path is shared storage (an archive, a pack store) rather
+    // than a host file of the node's own. Such files never change behind the VFS's back.
+    virtual bool hasOwnHostFile() const { return true; }
+
+    // Called once the explorer deleted the file, for files whose content the VFS owns.
+    virtual void discardContent() {}
+
+    virtual std::unique_ptr<std::istream> openReadStream() const {
         return std::make_unique<std::ifstream>(physicalPath, std::ios::binary);
     }
 
+    // For streaming large files front to back; reads ahead on a background thread.
+    virtual std::unique_ptr<std::istream> openSequentialStream() const {
+        return std::make_unique<ReadaheadStream>(physicalPath);
+    }
+
+    // Zero-copy alternative to openReadStream; the returned handle owns the mapping.
+    virtual MappedFile mapReadOnly(AccessPattern pattern = AccessPattern::Sequential) const {
+        return MappedFile(physicalPath, pattern);
+    }
+
+    // Cached variants for hot files: repeated reads are served from the cache's blocks
+    // instead of the OS, and a changed mtime or size bypasses stale blocks.
+    virtual std::unique_ptr<std::istream> openReadStream(BlockCache& cache) const {
+        return std::make_unique<BlockCacheStream>(cache, physicalPath);
+    }
+
+    // Unlike the plain mapping this assembles the whole file into an owned buffer, so
+    // every call copies the file; stream large files through openReadStream(cache).
+    virtual MappedFile mapReadOnly(BlockCache& cache) const {
+        return MappedFile(cache.readAll(physicalPath));
+    }
+
+    // Reuses an open descriptor for hot files instead of opening the path again.
+    virtual std::unique_ptr<std::istream> openReadStream(FileDescriptorCache& descriptors) const {
+        return std::make_unique<DescriptorStream>(descriptors.acquire(physicalPath));
+    }
+
+    virtual size_t readAt(FileDescriptorCache& descriptors, std::uint64_t offset,
+                          char* destination, size_t length) const {
+        return descriptors.readAt(physicalPath, offset, destination, length);
+    }
+
+    // Batched alternatives for callers touching many files; results arrive on io's thread.
+    virtual void statAsync(AsyncFileIO& io, StatCallback callback) const {
+        io.stat(physicalPath, std::move(callback));
+    }
+
+    virtual std::future<AsyncStatResult> statAsync(AsyncFileIO& io) const {
+        return io.stat(physicalPath);
+    }
+
+    virtual void readAsync(AsyncFileIO& io, std::uint64_t offset, size_t length,
+                           ReadCallback callback) const {
+        io.read(physicalPath, offset, length, std::move(callback));
+    }
+
+    virtual std::future<AsyncReadResult> readAsync(AsyncFileIO& io, std::uint64_t offset,
+                                                   size_t length) const {
+        return io.read(physicalPath, offset, length);
+    }
+
+    // Buffered writes to the host file. Each flush applies the new size to the cached
+    // totals in one step, when the file's size is cached. Close the stream before the
+    // node is deleted.
+    virtual std::unique_ptr<WriteBackStream>
+    openWriteStream(WriteMode mode = WriteMode::Update,
+                    size_t capacity = WriteBackStream::DEFAULT_CAPACITY) {
+        if (!hasOwnHostFile()) {
+            throw std::runtime_error("File cannot be written: " + getName());
+        }
+        auto target = std::make_unique<HostFileTarget>(
+            physicalPath, mode, [this](const FileVersion& version) {
+                if (cachedSize != NO_CACHED_SIZE) {
+                    updateCachedSize(static_cast<std::int64_t>(version.size));
+                }
+            });
+        return std::make_unique<WriteBackStream>(std::move(target), mode, capacity);
+    }
+
+    // Writes `data` at `offset` at once; use openWriteStream for many small writes.
+    virtual void write(std::uint64_t offset, std::string_view data) {
+        auto stream = openWriteStream();
+        stream->write(offset, data);
+        stream->close();
+    }
+
     std::unique_ptr<VFSNode> clone() const override {
-        return std::make_unique<VFSFile>(this->getName(), this->getPhysicalPath());
+        return std::make_unique<VFSFile>(this->getName(), this->getPhysicalPath(), TrustedPath{});
     }
 };
\ No newline at end of file
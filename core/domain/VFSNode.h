@@ -1,5 +1,7 @@
 #pragma once
+#include <cstdint>
 #include <ctime>
+#include <memory>
 #include <string>
 
 class VFSNode {
@@ -7,23 +9,57 @@ protected:
   std::string name;
   std::time_t createdAt;
   VFSNode* parent;
+  std::uint64_t preLabel = 0;
+  std::uint64_t postLabel = 0;
+  std::uint32_t imageOrdinal = NO_IMAGE_ORDINAL;
+  mutable std::int64_t cachedSize = NO_CACHED_SIZE;
 
   public:
+    static constexpr std::uint32_t NO_IMAGE_ORDINAL = 0xFFFFFFFF;
+    static constexpr std::int64_t NO_CACHED_SIZE = -1;
+
     virtual ~VFSNode() = default;
 
     VFSNode(std::string name, VFSNode* parent = nullptr)
         : name(std::move(name)), parent(parent), createdAt(std::time(nullptr)) {}
 
-    std::string getName() const { return name; }
+    const std::string& getName() const { return name; }
 
     std::time_t getCreationTime() const { return createdAt; }
 
+    void setCreationTime(std::time_t time) { createdAt = time; }
+
     VFSNode* getParent() const { return parent; }
 
     void setParent(VFSNode* newParent) { parent = newParent; }
 
     void rename(const std::string& newName) { name = newName; }
 
+    std::uint64_t getPreLabel() const { return preLabel; }
+
+    std::uint64_t getPostLabel() const { return postLabel; }
+
+    void setLabels(std::uint64_t pre, std::uint64_t post) {
+        preLabel = pre;
+        postLabel = post;
+    }
+
+    // Index of the node in the mapped name index it is still listed in, if any.
+    std::uint32_t getImageOrdinal() const { return imageOrdinal; }
+
+    void setImageOrdinal(std::uint32_t ordinal) { imageOrdinal = ordinal; }
+
+    // Size kept current by a HostFileWatcher, or NO_CACHED_SIZE. A directory only caches
+    // its total while every file below has a cached size.
+    std::int64_t getCachedSize() const { return cachedSize; }
+
+    void setCachedSize(std::int64_t size) const { cachedSize = size; }
+
+    // Labels are assigned by IntervalLabeler: a descendant lies strictly inside its ancestor
+    bool isAncestorOf(const VFSNode* other) const {
+        return other && preLabel < other->preLabel && other->postLabel < postLabel;
+    }
+
     virtual bool isDirectory() const = 0;
     virtual size_t getSize() const = 0;
 
@@ -0,0 +1,550 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "../utils/ThreadPool.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define VFS_HAS_IO_URING 1
+#else
+#define VFS_HAS_IO_URING 0
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct AsyncStatResult {
+    int error;
+    std::uintmax_t size;
+    std::int64_t modifiedAt;
+};
+
+struct AsyncReadResult {
+    int error;
+    std::vector<char> data;
+};
+
+using StatCallback = std::function<void(AsyncStatResult)>;
+using ReadCallback = std::function<void(AsyncReadResult)>;
+
+enum class AsyncBackend { Auto, IoUring, ThreadPool };
+
+// Batched stat/open/read engine. With io_uring every request becomes a chain of
+// STATX or OPENAT -> READ -> CLOSE submissions driven by one ring thread; requests queued
+// while the thread waits in io_uring_enter are submitted together as the next batch.
+// Without io_uring the same API runs blocking syscalls on a thread pool.
+// Callbacks run on an engine thread and must not block. If the ring breaks, unfinished
+// requests fail with its errno, and later ones fail the same way on the calling thread.
+class AsyncFileIO {
+  private:
+    struct Operation {
+        enum class Kind { Stat, Read };
+        enum class Stage { Stat, Open, Read, Close };
+
+        Operation(Kind kind, Stage stage, std::string path)
+            : kind(kind), stage(stage), path(std::move(path)) {}
+
+        Kind kind;
+        Stage stage;
+        std::string path;
+        std::uint64_t offset = 0;
+        size_t length = 0;
+        int fd = -1;
+        AsyncStatResult statResult{};
+        AsyncReadResult readResult{};
+        StatCallback onStat;
+        ReadCallback onRead;
+#if VFS_HAS_IO_URING
+        struct statx statBuffer {};
+#endif
+    };
+
+    AsyncBackend activeBackend;
+    unsigned queueDepth;
+    std::unique_ptr<ThreadPool> pool;
+
+    std::mutex mutex;
+    std::condition_variable wakeRing;
+    std::condition_variable idle;
+    std::deque<Operation*> pending;
+    size_t outstanding = 0;
+    bool stopping = false;
+    int ringError = 0;
+    std::thread ringThread;
+
+#if VFS_HAS_IO_URING
+    int ringFd = -1;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned inFlight = 0;
+    std::unordered_set<Operation*> submitted;
+    std::vector<Operation*> abandoned;
+
+    static bool supportsRequiredOps(int fd) {
+        size_t probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+        std::vector<char> storage(probeSize, 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return false;
+        }
+        for (int op : {IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool setupRing() {
+        io_uring_params params{};
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+        if (ringFd < 0) {
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd, IORING_OFF_SQ_RING);
+        cqRing = singleMap ? sqRing
+                           : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqeMemory == MAP_FAILED ||
+            !supportsRequiredOps(ringFd)) {
+            teardownRing();
+            return false;
+        }
+
+        auto* sq = static_cast<char*>(sqRing);
+        auto* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        sqes = static_cast<io_uring_sqe*>(sqeMemory);
+        queueDepth = params.sq_entries;
+        return true;
+    }
+
+    void teardownRing() {
+        if (sqes && sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing && cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing && sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (ringFd >= 0) {
+            ::close(ringFd);
+        }
+        sqes = nullptr;
+        sqRing = cqRing = nullptr;
+        ringFd = -1;
+    }
+
+    // Fills the next SQE for the operation's current stage. Caller owns the SQ tail.
+    void prepare(Operation* op) {
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->user_data = reinterpret_cast<std::uint64_t>(op);
+
+        switch (op->stage) {
+        case Operation::Stage::Stat:
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<std::uint64_t>(op->path.c_str());
+            sqe->len = STATX_SIZE | STATX_MTIME;
+            sqe->off = reinterpret_cast<std::uint64_t>(&op->statBuffer);
+            break;
+        case Operation::Stage::Open:
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<std::uint64_t>(op->path.c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            break;
+        case Operation::Stage::Read:
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = op->fd;
+            sqe->addr = reinterpret_cast<std::uint64_t>(op->readResult.data.data());
+            sqe->len = static_cast<unsigned>(op->readResult.data.size());
+            sqe->off = op->offset;
+            break;
+        case Operation::Stage::Close:
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = op->fd;
+            break;
+        }
+
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++inFlight;
+        submitted.insert(op);
+    }
+
+    // Advances the operation after a completion; returns true when it is finished.
+    bool complete(Operation* op, int result) {
+        switch (op->stage) {
+        case Operation::Stage::Stat:
+            if (result < 0) {
+                op->statResult.error = -result;
+            } else {
+                op->statResult.size = op->statBuffer.stx_size;
+                op->statResult.modifiedAt = op->statBuffer.stx_mtime.tv_sec;
+            }
+            op->onStat(op->statResult);
+            return true;
+        case Operation::Stage::Open:
+            if (result < 0) {
+                op->readResult.error = -result;
+                op->onRead(std::move(op->readResult));
+                return true;
+            }
+            op->fd = result;
+            op->readResult.data.resize(op->length);
+            op->stage = Operation::Stage::Read;
+            return false;
+        case Operation::Stage::Read:
+            if (result < 0) {
+                op->readResult.error = -result;
+                op->readResult.data.clear();
+            } else {
+                op->readResult.data.resize(static_cast<size_t>(result));
+            }
+            op->onRead(std::move(op->readResult));
+            op->stage = Operation::Stage::Close;
+            return false;
+        case Operation::Stage::Close:
+            return true;
+        }
+        return true;
+    }
+
+    // io_uring_enter failed for good: every unfinished operation fails with `error`, and
+    // so does every later request. Operations the kernel may still hold are kept until the
+    // ring is torn down.
+    void abandonRing(int error, std::vector<Operation*>& followUps) {
+        std::vector<Operation*> failed(followUps.begin(), followUps.end());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ringError = error;
+            failed.insert(failed.end(), pending.begin(), pending.end());
+            pending.clear();
+        }
+        for (Operation* op : failed) {
+            fail(op, error);
+            if (op->fd >= 0) {
+                ::close(op->fd);
+            }
+            delete op;
+        }
+        for (Operation* op : submitted) {
+            fail(op, error);
+            abandoned.push_back(op);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        outstanding -= failed.size() + submitted.size();
+        submitted.clear();
+        if (outstanding == 0) {
+            idle.notify_all();
+        }
+    }
+
+    void ringLoop() {
+        std::vector<Operation*> followUps;
+        while (true) {
+            unsigned toSubmit = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeRing.wait(lock, [this, &followUps]() {
+                    return stopping || !pending.empty() || inFlight > 0 || !followUps.empty();
+                });
+                if (stopping && pending.empty() && inFlight == 0 && followUps.empty()) {
+                    return;
+                }
+                for (Operation* op : followUps) {
+                    prepare(op);
+                    ++toSubmit;
+                }
+                followUps.clear();
+                while (!pending.empty() && inFlight < queueDepth) {
+                    prepare(pending.front());
+                    pending.pop_front();
+                    ++toSubmit;
+                }
+            }
+
+            unsigned waitFor = inFlight > 0 ? 1 : 0;
+            int entered = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, waitFor,
+                                                   IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                abandonRing(errno, followUps);
+                return;
+            }
+
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            size_t finished = 0;
+            while (head != tail) {
+                io_uring_cqe* cqe = &cqes[head & *cqMask];
+                auto* op = reinterpret_cast<Operation*>(cqe->user_data);
+                int result = cqe->res;
+                ++head;
+                --inFlight;
+                submitted.erase(op);
+                if (complete(op, result)) {
+                    delete op;
+                    ++finished;
+                } else {
+                    followUps.push_back(op);
+                }
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+            if (finished > 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                outstanding -= finished;
+                if (outstanding == 0) {
+                    idle.notify_all();
+                }
+            }
+        }
+    }
+#endif
+
+    // Reports `error` to an operation whose callback has not run yet.
+    static void fail(Operation* op, int error) {
+        if (op->kind == Operation::Kind::Stat) {
+            op->onStat(AsyncStatResult{error, 0, 0});
+        } else if (op->stage != Operation::Stage::Close) {
+            op->onRead(AsyncReadResult{error, {}});
+        }
+    }
+
+    static AsyncStatResult blockingStat(const std::string& path) {
+        AsyncStatResult result{};
+#if defined(__unix__) || defined(__APPLE__)
+        struct stat info {};
+        if (::stat(path.c_str(), &info) != 0) {
+            result.error = errno;
+            return result;
+        }
+        result.size = static_cast<std::uintmax_t>(info.st_size);
+        result.modifiedAt = info.st_mtime;
+#else
+        std::error_code ec;
+        result.size = std::filesystem::file_size(path, ec);
+        auto writeTime = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            result.error = ec.value();
+            return result;
+        }
+        result.modifiedAt = std::chrono::duration_cast<std::chrono::seconds>(
+                                writeTime.time_since_epoch())
+                                .count();
+#endif
+        return result;
+    }
+
+    static AsyncReadResult blockingRead(const std::string& path, std::uint64_t offset,
+                                        size_t length) {
+        AsyncReadResult result{};
+        result.data.resize(length);
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            result.error = errno;
+            result.data.clear();
+            return result;
+        }
+        ssize_t count = ::pread(fd, result.data.data(), length, static_cast<off_t>(offset));
+        result.error = count < 0 ? errno : 0;
+        result.data.resize(count < 0 ? 0 : static_cast<size_t>(count));
+        ::close(fd);
+#else
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            result.error = ENOENT;
+            result.data.clear();
+            return result;
+        }
+        input.seekg(static_cast<std::streamoff>(offset));
+        input.read(result.data.data(), static_cast<std::streamsize>(length));
+        result.data.resize(static_cast<size_t>(input.gcount()));
+#endif
+        return result;
+    }
+
+    void enqueue(Operation* op) {
+        int error = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = ringError;
+            if (error == 0) {
+                ++outstanding;
+                if (activeBackend == AsyncBackend::IoUring) {
+                    pending.push_back(op);
+                }
+            }
+        }
+        if (error != 0) {
+            fail(op, error);
+            delete op;
+            return;
+        }
+
+        if (activeBackend == AsyncBackend::IoUring) {
+            wakeRing.notify_one();
+            return;
+        }
+
+        pool->submit([this, op]() {
+            if (op->kind == Operation::Kind::Stat) {
+                op->onStat(blockingStat(op->path));
+            } else {
+                op->onRead(blockingRead(op->path, op->offset, op->length));
+            }
+            delete op;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--outstanding == 0) {
+                idle.notify_all();
+            }
+        });
+    }
+
+  public:
+    static constexpr unsigned DEFAULT_QUEUE_DEPTH = 64;
+    static constexpr unsigned MAX_FALLBACK_THREADS = 64;
+
+    explicit AsyncFileIO(unsigned queueDepth = DEFAULT_QUEUE_DEPTH,
+                         AsyncBackend backend = AsyncBackend::Auto)
+        : activeBackend(AsyncBackend::ThreadPool), queueDepth(queueDepth == 0 ? 1 : queueDepth) {
+#if VFS_HAS_IO_URING
+        if (backend != AsyncBackend::ThreadPool && setupRing()) {
+            activeBackend = AsyncBackend::IoUring;
+            ringThread = std::thread([this]() { ringLoop(); });
+            return;
+        }
+#endif
+        if (backend == AsyncBackend::IoUring) {
+            throw std::runtime_error("io_uring is not available on this system");
+        }
+        pool = std::make_unique<ThreadPool>(std::min(this->queueDepth, MAX_FALLBACK_THREADS));
+    }
+
+    AsyncFileIO(const AsyncFileIO&) = delete;
+    AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+    ~AsyncFileIO() {
+        waitIdle();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeRing.notify_all();
+        if (ringThread.joinable()) {
+            ringThread.join();
+        }
+#if VFS_HAS_IO_URING
+        teardownRing();
+        for (Operation* op : abandoned) {
+            if (op->fd >= 0 && op->stage == Operation::Stage::Read) {
+                ::close(op->fd);
+            }
+            delete op;
+        }
+#endif
+    }
+
+    AsyncBackend backend() const { return activeBackend; }
+
+    unsigned getQueueDepth() const { return queueDepth; }
+
+    void stat(const std::string& path, StatCallback callback) {
+        auto* op = new Operation(Operation::Kind::Stat, Operation::Stage::Stat, path);
+        op->onStat = std::move(callback);
+        enqueue(op);
+    }
+
+    void read(const std::string& path, std::uint64_t offset, size_t length,
+              ReadCallback callback) {
+        auto* op = new Operation(Operation::Kind::Read, Operation::Stage::Open, path);
+        op->offset = offset;
+        op->length = length;
+        op->onRead = std::move(callback);
+        enqueue(op);
+    }
+
+    std::future<AsyncStatResult> stat(const std::string& path) {
+        auto promise = std::make_shared<std::promise<AsyncStatResult>>();
+        std::future<AsyncStatResult> future = promise->get_future();
+        stat(path, [promise](AsyncStatResult result) { promise->set_value(result); });
+        return future;
+    }
+
+    std::future<AsyncReadResult> read(const std::string& path, std::uint64_t offset,
+                                      size_t length) {
+        auto promise = std::make_shared<std::promise<AsyncReadResult>>();
+        std::future<AsyncReadResult> future = promise->get_future();
+        read(path, offset, length,
+             [promise](AsyncReadResult result) { promise->set_value(std::move(result)); });
+        return future;
+    }
+
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return outstanding == 0; });
+    }
+};
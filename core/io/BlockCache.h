@@ -0,0 +1,436 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../utils/Hash64.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct BlockCacheStats {
+    std::uint64_t hits;
+    std::uint64_t misses;
+    std::uint64_t evictions;
+    std::uint64_t ghostPromotions;
+    size_t cachedBytes;
+    size_t byteBudget;
+
+    double hitRatio() const {
+        std::uint64_t lookups = hits + misses;
+        return lookups ? static_cast<double>(hits) / lookups : 0.0;
+    }
+};
+
+// Version of a physical file the cached blocks belong to. A changed mtime or size makes
+// every old block unreachable; they age out through normal eviction.
+struct FileVersion {
+    std::int64_t modifiedAt;
+    std::uint64_t size;
+};
+
+// Memory-bounded cache of fixed-size file blocks keyed by physical path, file version and
+// block offset.
+// Each shard runs a 2Q variant: new blocks enter a FIFO probation queue and reach the main
+// LRU only when requested again, either while still on probation or shortly after being
+// evicted from it (remembered in a ghost list of keys). A one-off scan therefore cycles
+// through probation without flushing the hot set. Streams fetch each block once per pass,
+// and a read that starts where the previous read of a block stopped continues that pass,
+// so small sequential reads through one block count as a single reference.
+class BlockCache {
+  public:
+    using Block = std::vector<char>;
+    using BlockPtr = std::shared_ptr<const Block>;
+
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t DEFAULT_SHARDS = 16;
+
+  private:
+    // Share of each shard's budget given to the probation queue, and the ghost list
+    // length as a share of the blocks that fit in the shard (the 2Q paper's Kin and Kout).
+    static constexpr double PROBATION_SHARE = 0.25;
+    static constexpr double GHOST_SHARE = 0.5;
+    static constexpr std::uint64_t NO_RUN = UINT64_MAX;
+
+    struct BlockKey {
+        std::string path;
+        std::int64_t modifiedAt;
+        std::uint64_t fileSize;
+        std::uint64_t offset;
+
+        bool operator==(const BlockKey& other) const {
+            return offset == other.offset && modifiedAt == other.modifiedAt &&
+                   fileSize == other.fileSize && path == other.path;
+        }
+    };
+
+    struct BlockKeyHash {
+        size_t operator()(const BlockKey& key) const {
+            return static_cast<size_t>(Hash64::compute(
+                key.path, (static_cast<std::uint64_t>(key.modifiedAt) ^ key.fileSize) * 31 + key.offset));
+        }
+    };
+
+    enum class Queue { Probation, Main };
+
+    struct Entry {
+        BlockKey key;
+        BlockPtr block;
+        Queue queue;
+        std::uint64_t runEnd; // file offset where the last access to the block stopped
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> probation;
+        std::list<Entry> main;
+        std::unordered_map<BlockKey, std::list<Entry>::iterator, BlockKeyHash> entries;
+        std::list<BlockKey> ghosts;
+        std::unordered_map<BlockKey, std::list<BlockKey>::iterator, BlockKeyHash> ghostIndex;
+        size_t probationBytes = 0;
+        size_t mainBytes = 0;
+    };
+
+    size_t byteBudget;
+    size_t blockSize;
+    size_t shardBudget;
+    size_t ghostCapacity;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> evictions{0};
+    std::atomic<std::uint64_t> ghostPromotions{0};
+
+    Shard& shardFor(const BlockKey& key) {
+        return *shards[BlockKeyHash()(key) % shards.size()];
+    }
+
+    void rememberGhost(Shard& shard, BlockKey key) {
+        if (ghostCapacity == 0) {
+            return;
+        }
+        shard.ghosts.push_front(std::move(key));
+        shard.ghostIndex[shard.ghosts.front()] = shard.ghosts.begin();
+        if (shard.ghosts.size() > ghostCapacity) {
+            shard.ghostIndex.erase(shard.ghosts.back());
+            shard.ghosts.pop_back();
+        }
+    }
+
+    void evictOne(Shard& shard, bool fromProbation) {
+        std::list<Entry>& queue = fromProbation ? shard.probation : shard.main;
+        Entry& victim = queue.back();
+        (fromProbation ? shard.probationBytes : shard.mainBytes) -= victim.block->size();
+        shard.entries.erase(victim.key);
+        if (fromProbation) {
+            rememberGhost(shard, std::move(victim.key));
+        }
+        queue.pop_back();
+        ++evictions;
+    }
+
+    void reclaim(Shard& shard) {
+        size_t probationLimit = static_cast<size_t>(shardBudget * PROBATION_SHARE);
+        while (shard.probationBytes + shard.mainBytes > shardBudget) {
+            bool fromProbation =
+                !shard.probation.empty() &&
+                (shard.probationBytes > probationLimit || shard.main.empty());
+            evictOne(shard, fromProbation);
+        }
+    }
+
+    static Block loadBlock(const std::string& path, std::uint64_t offset, size_t length) {
+        Block block(length);
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        size_t filled = 0;
+        while (filled < length) {
+            ssize_t count = ::pread(fd, block.data() + filled, length - filled,
+                                    static_cast<off_t>(offset + filled));
+            if (count <= 0) {
+                break;
+            }
+            filled += static_cast<size_t>(count);
+        }
+        ::close(fd);
+        block.resize(filled);
+#else
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        input.seekg(static_cast<std::streamoff>(offset));
+        input.read(block.data(), static_cast<std::streamsize>(length));
+        block.resize(static_cast<size_t>(input.gcount()));
+#endif
+        return block;
+    }
+
+    // Looks the block up for an access to the file bytes [from, to). A hit on probation
+    // promotes the block unless `from` continues the previous access to it.
+    BlockPtr fetch(const std::string& path, const FileVersion& version,
+                   std::uint64_t blockIndex, std::uint64_t from, std::uint64_t to) {
+        BlockKey key{path, version.modifiedAt, version.size, blockIndex * blockSize};
+        Shard& shard = shardFor(key);
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto found = shard.entries.find(key);
+            if (found != shard.entries.end()) {
+                ++hits;
+                auto entry = found->second;
+                bool sameRun = entry->runEnd == from;
+                entry->runEnd = to;
+                if (entry->queue == Queue::Probation && sameRun) {
+                    return entry->block;
+                }
+                if (entry->queue == Queue::Probation) {
+                    shard.probationBytes -= entry->block->size();
+                    shard.mainBytes += entry->block->size();
+                    entry->queue = Queue::Main;
+                    shard.main.splice(shard.main.begin(), shard.probation, entry);
+                } else {
+                    shard.main.splice(shard.main.begin(), shard.main, entry);
+                }
+                return entry->block;
+            }
+        }
+
+        ++misses;
+        auto block = std::make_shared<const Block>(
+            loadBlock(path, key.offset, std::min<std::uint64_t>(
+                                            blockSize, version.size > key.offset
+                                                           ? version.size - key.offset
+                                                           : 0)));
+        if (block->size() > shardBudget) {
+            return block;
+        }
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.entries.find(key);
+        if (found != shard.entries.end()) {
+            return found->second->block;
+        }
+
+        auto ghost = shard.ghostIndex.find(key);
+        if (ghost != shard.ghostIndex.end()) {
+            ++ghostPromotions;
+            shard.ghosts.erase(ghost->second);
+            shard.ghostIndex.erase(ghost);
+            shard.main.push_front({key, block, Queue::Main, to});
+            shard.mainBytes += block->size();
+            shard.entries[key] = shard.main.begin();
+        } else {
+            shard.probation.push_front({key, block, Queue::Probation, to});
+            shard.probationBytes += block->size();
+            shard.entries[key] = shard.probation.begin();
+        }
+        reclaim(shard);
+        return block;
+    }
+
+  public:
+    explicit BlockCache(size_t byteBudget, size_t blockSize = DEFAULT_BLOCK_SIZE,
+                        size_t shardCount = DEFAULT_SHARDS)
+        : byteBudget(byteBudget), blockSize(blockSize == 0 ? DEFAULT_BLOCK_SIZE : blockSize) {
+        shardCount = std::max<size_t>(1, shardCount);
+        shardBudget = byteBudget / shardCount;
+        ghostCapacity = static_cast<size_t>(shardBudget / this->blockSize * GHOST_SHARE);
+        for (size_t i = 0; i < shardCount; ++i) {
+            shards.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    static FileVersion versionOf(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        struct stat info {};
+        if (::stat(path.c_str(), &info) != 0) {
+            throw std::runtime_error("Cannot stat file: " + path);
+        }
+#if defined(__linux__)
+        std::int64_t modifiedAt = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 +
+                                  info.st_mtim.tv_nsec;
+#else
+        std::int64_t modifiedAt = static_cast<std::int64_t>(info.st_mtime) * 1000000000;
+#endif
+        return {modifiedAt, static_cast<std::uint64_t>(info.st_size)};
+#else
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        auto writeTime = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            throw std::runtime_error("Cannot stat file: " + path);
+        }
+        return {writeTime.time_since_epoch().count(), size};
+#endif
+    }
+
+    size_t getBlockSize() const { return blockSize; }
+
+    // Returns the block starting at blockIndex * blockSize, reading it on a miss. The
+    // returned pointer stays valid after the block is evicted.
+    BlockPtr getBlock(const std::string& path, const FileVersion& version,
+                      std::uint64_t blockIndex) {
+        return fetch(path, version, blockIndex, NO_RUN, (blockIndex + 1) * blockSize);
+    }
+
+    // Copies up to length bytes starting at offset; returns the number of bytes copied.
+    size_t read(const std::string& path, const FileVersion& version, std::uint64_t offset,
+                char* destination, size_t length) {
+        size_t copied = 0;
+        while (copied < length && offset < version.size) {
+            std::uint64_t blockIndex = offset / blockSize;
+            std::uint64_t blockEnd = std::min(version.size, (blockIndex + 1) * blockSize);
+            size_t count = static_cast<size_t>(
+                std::min<std::uint64_t>(length - copied, blockEnd - offset));
+            BlockPtr block = fetch(path, version, blockIndex, offset, offset + count);
+            size_t within = static_cast<size_t>(offset - blockIndex * blockSize);
+            if (within >= block->size()) {
+                break;
+            }
+            count = std::min(count, block->size() - within);
+            std::memcpy(destination + copied, block->data() + within, count);
+            copied += count;
+            offset += count;
+        }
+        return copied;
+    }
+
+    std::vector<char> readAll(const std::string& path) {
+        FileVersion version = versionOf(path);
+        std::vector<char> content(static_cast<size_t>(version.size));
+        content.resize(read(path, version, 0, content.data(), content.size()));
+        return content;
+    }
+
+    void clear() {
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->probation.clear();
+            shard->main.clear();
+            shard->entries.clear();
+            shard->ghosts.clear();
+            shard->ghostIndex.clear();
+            shard->probationBytes = shard->mainBytes = 0;
+        }
+    }
+
+    BlockCacheStats getStats() {
+        BlockCacheStats stats{hits, misses, evictions, ghostPromotions, 0, byteBudget};
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            stats.cachedBytes += shard->probationBytes + shard->mainBytes;
+        }
+        return stats;
+    }
+};
+
+// Seekable read-only streambuf that serves a file out of a BlockCache, one block per
+// underflow. The file version is captured at construction.
+class BlockCacheStreambuf : public std::streambuf {
+  private:
+    BlockCache& cache;
+    std::string path;
+    FileVersion version;
+    BlockCache::BlockPtr current;
+    std::uint64_t base = 0; // file offset of eback()
+
+    // Makes position the next character to read; false at or past end of file. A seek
+    // within the current block stays on it rather than fetching the block again.
+    bool positionAt(std::uint64_t position) {
+        if (current && position >= base && position < base + current->size()) {
+            char* begin = const_cast<char*>(current->data());
+            setg(begin, begin + (position - base), begin + current->size());
+            return true;
+        }
+        current.reset();
+        base = position;
+        setg(nullptr, nullptr, nullptr);
+        if (position >= version.size) {
+            return false;
+        }
+        std::uint64_t blockIndex = position / cache.getBlockSize();
+        BlockCache::BlockPtr block = cache.getBlock(path, version, blockIndex);
+        size_t within = static_cast<size_t>(position - blockIndex * cache.getBlockSize());
+        if (within >= block->size()) {
+            return false;
+        }
+        current = std::move(block);
+        base = blockIndex * cache.getBlockSize();
+        char* begin = const_cast<char*>(current->data());
+        setg(begin, begin + within, begin + current->size());
+        return true;
+    }
+
+    std::uint64_t position() const { return base + (gptr() - eback()); }
+
+  protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (!positionAt(position())) {
+            return traits_type::eof();
+        }
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::streamsize showmanyc() override {
+        std::uint64_t at = position();
+        return at < version.size ? static_cast<std::streamsize>(version.size - at) : -1;
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                     std::ios_base::openmode which) override {
+        off_type origin = direction == std::ios_base::beg   ? 0
+                          : direction == std::ios_base::cur ? static_cast<off_type>(position())
+                                                            : static_cast<off_type>(version.size);
+        return seekpos(pos_type(origin + offset), which);
+    }
+
+    pos_type seekpos(pos_type target, std::ios_base::openmode which) override {
+        off_type absolute = static_cast<off_type>(target);
+        if (!(which & std::ios_base::in) || absolute < 0 ||
+            static_cast<std::uint64_t>(absolute) > version.size) {
+            return pos_type(off_type(-1));
+        }
+        positionAt(static_cast<std::uint64_t>(absolute));
+        return target;
+    }
+
+  public:
+    BlockCacheStreambuf(BlockCache& cache, std::string path)
+        : cache(cache), path(std::move(path)), version(BlockCache::versionOf(this->path)) {}
+};
+
+class BlockCacheStream : public std::istream {
+  private:
+    BlockCacheStreambuf buffer;
+
+  public:
+    BlockCacheStream(BlockCache& cache, const std::string& path)
+        : std::istream(nullptr), buffer(cache, path) {
+        rdbuf(&buffer);
+    }
+};
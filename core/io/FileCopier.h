@@ -0,0 +1,234 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VFS_HAS_POSIX_COPY 1
+#else
+#define VFS_HAS_POSIX_COPY 0
+#endif
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && defined(FICLONE)
+#define VFS_HAS_REFLINK 1
+#else
+#define VFS_HAS_REFLINK 0
+#endif
+
+#if defined(__linux__) && defined(SYS_copy_file_range)
+#define VFS_HAS_COPY_FILE_RANGE 1
+#else
+#define VFS_HAS_COPY_FILE_RANGE 0
+#endif
+
+enum class CopyMethod {
+    Reflink,    // the copy shares the source's extents until either is written
+    KernelCopy, // copy_file_range; the data never leaves the kernel
+    Userspace,  // read and written through a buffer
+};
+
+struct FileCopyResult {
+    CopyMethod method;
+    std::uint64_t bytes;
+    std::uint64_t userspaceBytes;
+};
+
+struct DeepCopyStats {
+    size_t files; // host files copied; other files share or clone their content
+    std::uint64_t bytes;
+    size_t reflinked;
+    size_t kernelCopied;
+    size_t userspaceCopied;
+    std::uint64_t userspaceBytes; // zero when every copy took a fast path
+    double seconds;
+
+    void add(const FileCopyResult& result) {
+        ++files;
+        bytes += result.bytes;
+        userspaceBytes += result.userspaceBytes;
+        switch (result.method) {
+        case CopyMethod::Reflink:
+            ++reflinked;
+            break;
+        case CopyMethod::KernelCopy:
+            ++kernelCopied;
+            break;
+        case CopyMethod::Userspace:
+            ++userspaceCopied;
+            break;
+        }
+    }
+};
+
+// Copies host files by the cheapest means the filesystem offers: a reflink, else an
+// in-kernel copy, else plain reads and writes. A copy never replaces an existing file.
+class FileCopier {
+  private:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+#if VFS_HAS_POSIX_COPY
+    // Copies from the current offsets of `in` and `out` up to the end of `in`.
+    static void copyUserspace(int in, int out, FileCopyResult& result) {
+        std::vector<char> buffer(BUFFER_SIZE);
+        while (true) {
+            ssize_t count = ::read(in, buffer.data(), buffer.size());
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0) {
+                throw std::runtime_error("Cannot read file for copying");
+            }
+            if (count == 0) {
+                return;
+            }
+            for (ssize_t written = 0; written < count;) {
+                ssize_t step = ::write(out, buffer.data() + written, count - written);
+                if (step < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (step < 0) {
+                    throw std::runtime_error("Cannot write file copy");
+                }
+                written += step;
+            }
+            result.userspaceBytes += static_cast<std::uint64_t>(count);
+        }
+    }
+
+    static FileCopyResult copyData(int in, int out, std::uint64_t size) {
+        FileCopyResult result{CopyMethod::Reflink, size, 0};
+#if VFS_HAS_REFLINK
+        if (::ioctl(out, FICLONE, in) == 0) {
+            return result;
+        }
+#endif
+        result.method = CopyMethod::KernelCopy;
+#if VFS_HAS_COPY_FILE_RANGE
+        std::uint64_t copied = 0;
+        while (true) {
+            auto count = static_cast<ssize_t>(::syscall(SYS_copy_file_range, in, nullptr, out,
+                                                        nullptr, BUFFER_SIZE * 64, 0u));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count == 0) {
+                return result;
+            }
+            if (count < 0) {
+                // Not supported here; the rest goes through userspace.
+                if (errno != ENOSYS && errno != EXDEV && errno != EINVAL &&
+                    errno != EOPNOTSUPP) {
+                    throw std::runtime_error("Cannot copy file data");
+                }
+                break;
+            }
+            copied += static_cast<std::uint64_t>(count);
+        }
+        if (copied == 0) {
+            result.method = CopyMethod::Userspace;
+        }
+#else
+        result.method = CopyMethod::Userspace;
+#endif
+        copyUserspace(in, out, result);
+        return result;
+    }
+
+    // Creates `to` exclusively; false if it already exists.
+    static bool copyTo(int in, const struct stat& info, const std::string& to,
+                       FileCopyResult& result) {
+        int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                         info.st_mode & 07777);
+        if (out < 0) {
+            if (errno == EEXIST) {
+                return false;
+            }
+            throw std::runtime_error("Cannot create file copy: " + to);
+        }
+        try {
+            result = copyData(in, out, static_cast<std::uint64_t>(info.st_size));
+        } catch (const std::exception&) {
+            ::close(out);
+            ::unlink(to.c_str());
+            throw;
+        }
+        ::close(out);
+        return true;
+    }
+#endif
+
+    template <typename NextTarget>
+    static std::string copyToFirstFree(const std::string& from, NextTarget next,
+                                       FileCopyResult& result) {
+#if VFS_HAS_POSIX_COPY
+        int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            throw std::runtime_error("Cannot open file for copying: " + from);
+        }
+        struct stat info {};
+        ::fstat(in, &info);
+        try {
+            for (std::string to = next(); !to.empty(); to = next()) {
+                if (copyTo(in, info, to, result)) {
+                    ::close(in);
+                    return to;
+                }
+            }
+        } catch (const std::exception&) {
+            ::close(in);
+            throw;
+        }
+        ::close(in);
+#else
+        for (std::string to = next(); !to.empty(); to = next()) {
+            std::error_code ec;
+            if (std::filesystem::copy_file(from, to, ec)) {
+                std::uint64_t size = std::filesystem::file_size(to);
+                result = {CopyMethod::Userspace, size, size};
+                return to;
+            }
+            if (ec != std::errc::file_exists) {
+                throw std::runtime_error("Cannot copy file: " + from);
+            }
+        }
+#endif
+        throw std::runtime_error("File copy already exists");
+    }
+
+  public:
+    static FileCopyResult copy(const std::string& from, const std::string& to) {
+        FileCopyResult result{};
+        bool tried = false;
+        copyToFirstFree(
+            from, [&]() { return tried ? std::string() : (tried = true, to); }, result);
+        return result;
+    }
+
+    // Copies `from` to the first free "<stem>_copyN<extension>" in its directory and
+    // returns the new path.
+    static std::string copyBeside(const std::string& from, FileCopyResult& result) {
+        std::filesystem::path source(from);
+        std::string stem = source.stem().string();
+        std::string extension = source.extension().string();
+        int counter = 0;
+        return copyToFirstFree(
+            from,
+            [&]() {
+                std::string name = stem + "_copy" + std::to_string(++counter) + extension;
+                return (source.parent_path() / name).string();
+            },
+            result);
+    }
+};
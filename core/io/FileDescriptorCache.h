@@ -0,0 +1,319 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VFS_HAS_PREAD 1
+#else
+#define VFS_HAS_PREAD 0
+#endif
+
+struct DescriptorCacheStats {
+    std::uint64_t opens;
+    std::uint64_t opensAvoided;
+    std::uint64_t evictions;
+    std::uint64_t invalidations;
+    // Average cost of the open() calls that did happen, charged to every avoided one.
+    double estimatedNanosSaved;
+};
+
+// Open descriptor shared by every reader of a physical file. Reads are positional, so
+// concurrent readers never disturb each other. The descriptor closes once the cache has
+// dropped it and the last reader released it.
+class CachedDescriptor {
+  private:
+    std::string path;
+#if VFS_HAS_PREAD
+    int fd;
+    dev_t device;
+    ino_t inode;
+#endif
+
+  public:
+    explicit CachedDescriptor(std::string path) : path(std::move(path)) {
+#if VFS_HAS_PREAD
+        fd = ::open(this->path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + this->path);
+        }
+        struct stat info {};
+        ::fstat(fd, &info);
+        device = info.st_dev;
+        inode = info.st_ino;
+#else
+        if (!std::ifstream(this->path, std::ios::binary)) {
+            throw std::runtime_error("Cannot open file: " + this->path);
+        }
+#endif
+    }
+
+    CachedDescriptor(const CachedDescriptor&) = delete;
+    CachedDescriptor& operator=(const CachedDescriptor&) = delete;
+
+    ~CachedDescriptor() {
+#if VFS_HAS_PREAD
+        ::close(fd);
+#endif
+    }
+
+    const std::string& getPath() const { return path; }
+
+    size_t readAt(std::uint64_t offset, char* destination, size_t length) const {
+#if VFS_HAS_PREAD
+        size_t filled = 0;
+        while (filled < length) {
+            ssize_t count = ::pread(fd, destination + filled, length - filled,
+                                    static_cast<off_t>(offset + filled));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                break;
+            }
+            filled += static_cast<size_t>(count);
+        }
+        return filled;
+#else
+        std::ifstream input(path, std::ios::binary);
+        input.seekg(static_cast<std::streamoff>(offset));
+        input.read(destination, static_cast<std::streamsize>(length));
+        return static_cast<size_t>(input.gcount());
+#endif
+    }
+
+    std::uint64_t size() const {
+#if VFS_HAS_PREAD
+        struct stat info {};
+        return ::fstat(fd, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+#else
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        return ec ? 0 : size;
+#endif
+    }
+
+    // False once the file was unlinked, or the path now names a different file (renamed
+    // away or replaced). The first check needs no path lookup, the second does.
+    bool stillValid(bool checkPath) const {
+#if VFS_HAS_PREAD
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || info.st_nlink == 0) {
+            return false;
+        }
+        if (!checkPath) {
+            return true;
+        }
+        struct stat current {};
+        return ::stat(path.c_str(), &current) == 0 && current.st_dev == device &&
+               current.st_ino == inode;
+#else
+        (void)checkPath;
+        return std::filesystem::exists(path);
+#endif
+    }
+};
+
+// Bounded LRU of open descriptors keyed by physical path, for hot files that are re-read
+// constantly. A hit skips open() entirely; entries are revalidated against the path at
+// most once per revalidation interval, and invalidate() drops one immediately.
+class FileDescriptorCache {
+  public:
+    using DescriptorPtr = std::shared_ptr<const CachedDescriptor>;
+
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+    static constexpr std::chrono::milliseconds DEFAULT_REVALIDATE_INTERVAL{1000};
+
+  private:
+    struct Entry {
+        DescriptorPtr descriptor;
+        std::chrono::steady_clock::time_point validatedAt;
+    };
+
+    size_t capacity;
+    std::chrono::steady_clock::duration revalidateInterval;
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+    std::mutex mutex;
+
+    std::atomic<std::uint64_t> opens{0};
+    std::atomic<std::uint64_t> opensAvoided{0};
+    std::atomic<std::uint64_t> evictions{0};
+    std::atomic<std::uint64_t> invalidations{0};
+    std::atomic<std::uint64_t> openNanos{0};
+
+    DescriptorPtr openTimed(const std::string& path) {
+        auto start = std::chrono::steady_clock::now();
+        auto descriptor = std::make_shared<const CachedDescriptor>(path);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        openNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        ++opens;
+        return descriptor;
+    }
+
+  public:
+    explicit FileDescriptorCache(
+        size_t capacity = DEFAULT_CAPACITY,
+        std::chrono::steady_clock::duration revalidateInterval = DEFAULT_REVALIDATE_INTERVAL)
+        : capacity(capacity == 0 ? 1 : capacity), revalidateInterval(revalidateInterval) {}
+
+    FileDescriptorCache(const FileDescriptorCache&) = delete;
+    FileDescriptorCache& operator=(const FileDescriptorCache&) = delete;
+
+    // The cached descriptor is taken under the lock but validated outside it, so hits on
+    // different files never wait for each other's fstat/stat. Whoever finds the interval
+    // expired claims the path check, and the other readers skip it meanwhile.
+    DescriptorPtr acquire(const std::string& path) {
+        auto now = std::chrono::steady_clock::now();
+        DescriptorPtr cached;
+        bool checkPath = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = entries.find(path);
+            if (found != entries.end()) {
+                Entry& entry = *found->second;
+                cached = entry.descriptor;
+                checkPath = now - entry.validatedAt >= revalidateInterval;
+                if (checkPath) {
+                    entry.validatedAt = now;
+                }
+                lru.splice(lru.begin(), lru, found->second);
+            }
+        }
+        if (cached) {
+            if (cached->stillValid(checkPath)) {
+                ++opensAvoided;
+                return cached;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = entries.find(path);
+            if (found != entries.end() && found->second->descriptor == cached) {
+                lru.erase(found->second);
+                entries.erase(found);
+                ++invalidations;
+            }
+        }
+
+        DescriptorPtr descriptor = openTimed(path);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(path);
+        if (found != entries.end()) {
+            lru.erase(found->second);
+            entries.erase(found);
+        }
+        lru.push_front({descriptor, now});
+        entries[path] = lru.begin();
+        while (lru.size() > capacity) {
+            entries.erase(lru.back().descriptor->getPath());
+            lru.pop_back();
+            ++evictions;
+        }
+        return descriptor;
+    }
+
+    size_t readAt(const std::string& path, std::uint64_t offset, char* destination,
+                  size_t length) {
+        return acquire(path)->readAt(offset, destination, length);
+    }
+
+    // Hook for callers that rename or delete the physical file themselves.
+    void invalidate(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(path);
+        if (found != entries.end()) {
+            lru.erase(found->second);
+            entries.erase(found);
+            ++invalidations;
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        lru.clear();
+        entries.clear();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lru.size();
+    }
+
+    DescriptorCacheStats getStats() const {
+        std::uint64_t opened = opens;
+        double averageOpen = opened ? static_cast<double>(openNanos) / opened : 0.0;
+        return {opened, opensAvoided, evictions, invalidations, averageOpen * opensAvoided};
+    }
+};
+
+// Buffered, seekable stream over a shared descriptor.
+class DescriptorStreambuf : public std::streambuf {
+  private:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    FileDescriptorCache::DescriptorPtr descriptor;
+    std::vector<char> buffer;
+    std::uint64_t base = 0; // file offset of eback()
+
+  protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        base += egptr() - eback();
+        size_t count = descriptor->readAt(base, buffer.data(), buffer.size());
+        setg(buffer.data(), buffer.data(), buffer.data() + count);
+        return count ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                     std::ios_base::openmode which) override {
+        off_type origin = direction == std::ios_base::beg ? 0
+                          : direction == std::ios_base::cur
+                              ? static_cast<off_type>(base + (gptr() - eback()))
+                              : static_cast<off_type>(descriptor->size());
+        return seekpos(pos_type(origin + offset), which);
+    }
+
+    pos_type seekpos(pos_type target, std::ios_base::openmode which) override {
+        off_type absolute = static_cast<off_type>(target);
+        if (!(which & std::ios_base::in) || absolute < 0) {
+            return pos_type(off_type(-1));
+        }
+        base = static_cast<std::uint64_t>(absolute);
+        setg(buffer.data(), buffer.data(), buffer.data());
+        return target;
+    }
+
+  public:
+    explicit DescriptorStreambuf(FileDescriptorCache::DescriptorPtr descriptor)
+        : descriptor(std::move(descriptor)), buffer(BUFFER_SIZE) {
+        setg(buffer.data(), buffer.data(), buffer.data());
+    }
+};
+
+class DescriptorStream : public std::istream {
+  private:
+    DescriptorStreambuf buffer;
+
+  public:
+    explicit DescriptorStream(FileDescriptorCache::DescriptorPtr descriptor)
+        : std::istream(nullptr), buffer(std::move(descriptor)) {
+        rdbuf(&buffer);
+    }
+};
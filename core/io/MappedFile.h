@@ -0,0 +1,223 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VFS_HAS_MMAP 1
+#else
+#define VFS_HAS_MMAP 0
+#endif
+
+enum class AccessPattern { Normal, Sequential, Random };
+
+// Read-only view of a whole file. Regular files are memory-mapped where the platform
+// allows it; special files (pipes, procfs entries reporting size 0, devices) and
+// platforms without mmap are read into an owned buffer instead. The view stays valid for
+// the lifetime of the handle.
+class MappedFile {
+  private:
+    const char* mapped;
+    size_t length;
+    size_t pageLead = 0; // bytes mapped before `mapped` to start on a page boundary
+    std::vector<char> buffer;
+    std::shared_ptr<const MappedFile> owner; // set for views into another handle's bytes
+
+    void release() {
+#if VFS_HAS_MMAP
+        if (mapped && length > 0 && !owner) {
+            munmap(const_cast<char*>(mapped - pageLead), length + pageLead);
+        }
+#endif
+        mapped = nullptr;
+        length = 0;
+        pageLead = 0;
+        buffer.clear();
+        owner.reset();
+    }
+
+    static std::vector<char> readAll(const std::string& path) {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        return std::vector<char>(std::istreambuf_iterator<char>(input),
+                                 std::istreambuf_iterator<char>());
+    }
+
+  public:
+    MappedFile() : mapped(nullptr), length(0) {}
+
+    explicit MappedFile(const std::string& path, AccessPattern pattern = AccessPattern::Normal)
+        : mapped(nullptr), length(0) {
+#if VFS_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        struct stat info {};
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                                 MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                mapped = static_cast<const char*>(address);
+                length = static_cast<size_t>(info.st_size);
+            }
+        }
+        ::close(fd);
+        if (mapped) {
+            advise(pattern);
+            return;
+        }
+#endif
+        buffer = readAll(path);
+    }
+
+    // View of the `size` bytes at `offset`, e.g. one member of an archive. The range must
+    // lie within the file.
+    MappedFile(const std::string& path, std::uint64_t offset, size_t size,
+               AccessPattern pattern = AccessPattern::Normal)
+        : mapped(nullptr), length(0) {
+        if (size == 0) {
+            return;
+        }
+#if VFS_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || offset + size > static_cast<std::uint64_t>(info.st_size)) {
+            ::close(fd);
+            throw std::runtime_error("Range outside of file: " + path);
+        }
+        std::uint64_t page = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+        std::uint64_t start = offset - offset % page;
+        void* address = mmap(nullptr, static_cast<size_t>(offset - start) + size, PROT_READ,
+                             MAP_PRIVATE, fd, static_cast<off_t>(start));
+        ::close(fd);
+        if (address != MAP_FAILED) {
+            pageLead = static_cast<size_t>(offset - start);
+            mapped = static_cast<const char*>(address) + pageLead;
+            length = size;
+            advise(pattern);
+            return;
+        }
+#endif
+        std::ifstream input(path, std::ios::binary);
+        buffer.resize(size);
+        if (!input.seekg(static_cast<std::streamoff>(offset)) ||
+            !input.read(buffer.data(), static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("Cannot read range of file: " + path);
+        }
+    }
+
+    // View of `size` bytes at `offset` within `whole`, which stays alive as long as any
+    // view of it does. Cheaper than a range mapping when many small views share one file.
+    MappedFile(std::shared_ptr<const MappedFile> whole, size_t offset, size_t size)
+        : mapped(whole->data() + offset), length(size), owner(std::move(whole)) {}
+
+    // Wraps content that was already read, e.g. assembled from a block cache.
+    explicit MappedFile(std::vector<char> content)
+        : mapped(nullptr), length(0), buffer(std::move(content)) {}
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : mapped(std::exchange(other.mapped, nullptr)), length(std::exchange(other.length, 0)),
+          pageLead(std::exchange(other.pageLead, 0)), buffer(std::move(other.buffer)),
+          owner(std::move(other.owner)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            release();
+            mapped = std::exchange(other.mapped, nullptr);
+            length = std::exchange(other.length, 0);
+            pageLead = std::exchange(other.pageLead, 0);
+            buffer = std::move(other.buffer);
+            owner = std::move(other.owner);
+        }
+        return *this;
+    }
+
+    ~MappedFile() { release(); }
+
+    // Kernel readahead hint for the mapped range; a no-op for buffered files.
+    void advise(AccessPattern pattern) const {
+#if VFS_HAS_MMAP
+        if (!mapped || owner) {
+            return;
+        }
+        int advice = POSIX_MADV_NORMAL;
+        if (pattern == AccessPattern::Sequential) {
+            advice = POSIX_MADV_SEQUENTIAL;
+        } else if (pattern == AccessPattern::Random) {
+            advice = POSIX_MADV_RANDOM;
+        }
+        posix_madvise(const_cast<char*>(mapped - pageLead), length + pageLead, advice);
+#else
+        (void)pattern;
+#endif
+    }
+
+    std::string_view view() const { return std::string_view(data(), size()); }
+
+    const char* data() const { return mapped ? mapped : buffer.data(); }
+
+    size_t size() const { return mapped ? length : buffer.size(); }
+
+    bool isMapped() const { return mapped != nullptr; }
+};
+
+// std::istream over the bytes of a MappedFile, which it owns.
+class MappedFileStreambuf : public std::streambuf {
+  private:
+    MappedFile file;
+
+  protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                     std::ios_base::openmode) override {
+        char* begin = eback();
+        off_type base = direction == std::ios_base::beg   ? 0
+                        : direction == std::ios_base::cur ? gptr() - begin
+                                                          : egptr() - begin;
+        off_type target = base + offset;
+        if (target < 0 || target > egptr() - begin) {
+            return pos_type(off_type(-1));
+        }
+        setg(begin, begin + target, egptr());
+        return pos_type(target);
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode mode) override {
+        return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+
+  public:
+    explicit MappedFileStreambuf(MappedFile mappedFile) : file(std::move(mappedFile)) {
+        char* begin = const_cast<char*>(file.data());
+        setg(begin, begin, begin + file.size());
+    }
+};
+
+class MappedFileStream : public std::istream {
+  private:
+    MappedFileStreambuf buffer;
+
+  public:
+    explicit MappedFileStream(MappedFile file) : std::istream(nullptr), buffer(std::move(file)) {
+        rdbuf(&buffer);
+    }
+};
@@ -0,0 +1,250 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReadaheadStats {
+    std::uint64_t chunksRead;
+    std::uint64_t bytesPrefetched;
+    std::uint64_t stalls;
+    std::uint64_t restarts;
+    size_t window;
+    size_t largestWindow;
+};
+
+// Streambuf for large sequential reads. A background thread keeps up to `window` bytes
+// read ahead of the consumer in a ring of reusable chunks. The window starts small, doubles
+// every time the consumer catches up and has to wait, and falls back to the minimum after
+// a seek, so random access does not trigger large speculative reads.
+class ReadaheadStreambuf : public std::streambuf {
+  public:
+    static constexpr size_t MIN_WINDOW = 128 * 1024;
+    static constexpr size_t MAX_WINDOW = 8 * 1024 * 1024;
+
+  private:
+    static constexpr size_t MIN_CHUNK = 64 * 1024;
+    static constexpr size_t MAX_CHUNK = 1024 * 1024;
+
+    struct Chunk {
+        std::uint64_t offset;
+        std::vector<char> data;
+    };
+
+    std::ifstream input; // used only by the prefetcher after construction
+    std::uint64_t fileSize;
+    size_t minWindow;
+    size_t maxWindow;
+
+    std::mutex mutex;
+    std::condition_variable chunkReady;
+    std::condition_variable spaceFree;
+    std::deque<Chunk> ready;
+    std::vector<std::vector<char>> spare;
+    size_t bytesAhead = 0;
+    size_t window;
+    std::uint64_t nextOffset = 0; // next byte the prefetcher reads
+    std::uint64_t generation = 0; // bumped on every seek to discard in-flight reads
+    bool reading = false;
+    bool stopping = false;
+    ReadaheadStats stats{};
+
+    Chunk current{0, {}};
+    std::thread prefetcher;
+
+    size_t chunkSize() const { return std::clamp(window / 4, MIN_CHUNK, MAX_CHUNK); }
+
+    void prefetchLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            spaceFree.wait(lock, [this]() {
+                return stopping || (nextOffset < fileSize && bytesAhead < window);
+            });
+            if (stopping) {
+                return;
+            }
+
+            std::uint64_t offset = nextOffset;
+            std::uint64_t startedIn = generation;
+            size_t length =
+                static_cast<size_t>(std::min<std::uint64_t>(chunkSize(), fileSize - offset));
+            std::vector<char> data;
+            if (!spare.empty()) {
+                data = std::move(spare.back());
+                spare.pop_back();
+            }
+            nextOffset += length;
+            reading = true;
+
+            lock.unlock();
+            data.resize(length);
+            input.clear();
+            input.seekg(static_cast<std::streamoff>(offset));
+            input.read(data.data(), static_cast<std::streamsize>(length));
+            data.resize(static_cast<size_t>(input.gcount()));
+            lock.lock();
+            reading = false;
+
+            if (generation != startedIn) {
+                chunkReady.notify_one();
+                spare.push_back(std::move(data));
+                continue;
+            }
+            if (data.size() < length) {
+                nextOffset = fileSize; // file shrank underneath us; stop at what is there
+            }
+            ++stats.chunksRead;
+            stats.bytesPrefetched += data.size();
+            bytesAhead += data.size();
+            ready.push_back({offset, std::move(data)});
+            chunkReady.notify_one();
+        }
+    }
+
+    std::uint64_t position() const { return current.offset + (gptr() - eback()); }
+
+    void restartAt(std::uint64_t offset) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+        ++stats.restarts;
+        for (auto& chunk : ready) {
+            spare.push_back(std::move(chunk.data));
+        }
+        ready.clear();
+        bytesAhead = 0;
+        window = minWindow;
+        nextOffset = std::min<std::uint64_t>(offset, fileSize);
+        spare.push_back(std::move(current.data));
+        current = Chunk{offset, {}};
+        setg(nullptr, nullptr, nullptr);
+        spaceFree.notify_one();
+    }
+
+  protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        std::uint64_t wanted = position();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (wanted >= fileSize) {
+            return traits_type::eof();
+        }
+        if (ready.empty()) {
+            ++stats.stalls;
+            window = std::min(window * 2, maxWindow);
+            stats.largestWindow = std::max(stats.largestWindow, window);
+            spaceFree.notify_one();
+            chunkReady.wait(lock, [this]() {
+                return !ready.empty() || (nextOffset >= fileSize && !reading);
+            });
+            if (ready.empty()) {
+                return traits_type::eof();
+            }
+        }
+
+        spare.push_back(std::move(current.data));
+        current = std::move(ready.front());
+        ready.pop_front();
+        bytesAhead -= current.data.size();
+        spaceFree.notify_one();
+        lock.unlock();
+
+        if (current.data.empty()) {
+            return traits_type::eof();
+        }
+        setg(current.data.data(), current.data.data(), current.data.data() + current.data.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::streamsize showmanyc() override {
+        std::uint64_t at = position();
+        return at < fileSize ? static_cast<std::streamsize>(fileSize - at) : -1;
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                     std::ios_base::openmode which) override {
+        off_type origin = direction == std::ios_base::beg   ? 0
+                          : direction == std::ios_base::cur ? static_cast<off_type>(position())
+                                                            : static_cast<off_type>(fileSize);
+        if (direction == std::ios_base::cur && offset == 0) {
+            return pos_type(origin); // tellg() must not disturb readahead
+        }
+        return seekpos(pos_type(origin + offset), which);
+    }
+
+    pos_type seekpos(pos_type target, std::ios_base::openmode which) override {
+        off_type absolute = static_cast<off_type>(target);
+        if (!(which & std::ios_base::in) || absolute < 0) {
+            return pos_type(off_type(-1));
+        }
+        std::uint64_t wanted = static_cast<std::uint64_t>(absolute);
+        // Seeks inside the chunk in hand, or to its end, keep the readahead going.
+        if (eback() && wanted >= current.offset &&
+            wanted <= current.offset + current.data.size()) {
+            setg(eback(), eback() + (wanted - current.offset), egptr());
+            return target;
+        }
+        restartAt(wanted);
+        return target;
+    }
+
+  public:
+    explicit ReadaheadStreambuf(const std::string& path, size_t minWindow = MIN_WINDOW,
+                                size_t maxWindow = MAX_WINDOW)
+        : input(path, std::ios::binary), minWindow(std::max(minWindow, MIN_CHUNK)),
+          maxWindow(std::max(maxWindow, minWindow)), window(this->minWindow) {
+        if (!input) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        input.seekg(0, std::ios::end);
+        fileSize = static_cast<std::uint64_t>(input.tellg());
+        input.seekg(0);
+        stats.largestWindow = window;
+        setg(nullptr, nullptr, nullptr);
+        prefetcher = std::thread([this]() { prefetchLoop(); });
+    }
+
+    ReadaheadStreambuf(const ReadaheadStreambuf&) = delete;
+    ReadaheadStreambuf& operator=(const ReadaheadStreambuf&) = delete;
+
+    ~ReadaheadStreambuf() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        spaceFree.notify_all();
+        prefetcher.join();
+    }
+
+    ReadaheadStats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ReadaheadStats snapshot = stats;
+        snapshot.window = window;
+        return snapshot;
+    }
+};
+
+class ReadaheadStream : public std::istream {
+  private:
+    ReadaheadStreambuf buffer;
+
+  public:
+    explicit ReadaheadStream(const std::string& path,
+                             size_t minWindow = ReadaheadStreambuf::MIN_WINDOW,
+                             size_t maxWindow = ReadaheadStreambuf::MAX_WINDOW)
+        : std::istream(nullptr), buffer(path, minWindow, maxWindow) {
+        rdbuf(&buffer);
+    }
+
+    ReadaheadStats getStats() { return buffer.getStats(); }
+};
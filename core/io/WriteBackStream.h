@@ -0,0 +1,400 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include "BlockCache.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VFS_HAS_PWRITE 1
+#else
+#include <filesystem>
+#include <fstream>
+#define VFS_HAS_PWRITE 0
+#endif
+
+enum class WriteMode {
+    Update,   // keep the content, start writing at offset 0
+    Truncate, // empty the file first
+    Append,   // keep the content, start writing at its end
+};
+
+struct WriteBackStats {
+    std::uint64_t writes;       // calls that handed data to the buffer
+    std::uint64_t bytesWritten;
+    std::uint64_t flushes;
+    std::uint64_t targetWrites; // writes issued to the target, one per coalesced extent
+};
+
+// Where a WriteBackStream's buffered data ends up.
+class WriteTarget {
+  public:
+    virtual ~WriteTarget() = default;
+
+    virtual std::uint64_t size() const = 0;
+
+    virtual void writeAt(std::uint64_t offset, const char* data, size_t length) = 0;
+
+    // Called once after each flush with every extent written.
+    virtual void commit() {}
+};
+
+// Pending writes as disjoint extents by offset. A write that overlaps or touches an
+// extent is merged into it, later bytes winning, so many small writes become a few
+// large ones. Appending to the last extent, the common case, is a string append.
+class WriteBackBuffer {
+  private:
+    std::map<std::uint64_t, std::string> extents;
+    size_t buffered = 0;
+    std::string spare; // storage of a drained extent, so refills do not fault in new memory
+
+  public:
+    size_t bufferedBytes() const { return buffered; }
+
+    bool empty() const { return extents.empty(); }
+
+    // End of the last extent, or 0 when nothing is buffered.
+    std::uint64_t end() const {
+        if (extents.empty()) {
+            return 0;
+        }
+        auto last = std::prev(extents.end());
+        return last->first + last->second.size();
+    }
+
+    void add(std::uint64_t offset, const char* data, size_t length) {
+        if (length == 0) {
+            return;
+        }
+        buffered += length;
+        if (!extents.empty() && end() == offset) {
+            std::prev(extents.end())->second.append(data, length);
+            return;
+        }
+        std::uint64_t start = offset;
+        std::uint64_t finish = offset + length;
+        auto first = extents.upper_bound(offset);
+        if (first != extents.begin()) {
+            auto previous = std::prev(first);
+            if (previous->first + previous->second.size() >= offset) {
+                first = previous;
+                start = previous->first;
+            }
+        }
+        auto last = first;
+        while (last != extents.end() && last->first <= finish) {
+            finish = std::max<std::uint64_t>(finish, last->first + last->second.size());
+            ++last;
+        }
+        std::string merged = std::move(spare);
+        merged.assign(static_cast<size_t>(finish - start), '\0');
+        for (auto it = first; it != last; ++it) {
+            std::memcpy(&merged[static_cast<size_t>(it->first - start)], it->second.data(),
+                        it->second.size());
+            buffered -= it->second.size();
+        }
+        std::memcpy(&merged[static_cast<size_t>(offset - start)], data, length);
+        buffered += merged.size() - length;
+        extents.erase(first, last);
+        extents.emplace(start, std::move(merged));
+    }
+
+    // Hands every extent to `visit(offset, data)` in offset order and empties the buffer.
+    template <typename Visit>
+    void drain(Visit visit) {
+        for (auto& [offset, data] : extents) {
+            visit(offset, std::string_view(data));
+            if (data.capacity() > spare.capacity()) {
+                spare = std::move(data);
+            }
+        }
+        spare.clear();
+        extents.clear();
+        buffered = 0;
+    }
+};
+
+// The host file at a physical path, written with positional writes.
+class HostFileTarget : public WriteTarget {
+  public:
+    using CommitCallback = std::function<void(const FileVersion&)>;
+
+  private:
+    std::string path;
+    CommitCallback onCommit;
+#if VFS_HAS_PWRITE
+    int fd;
+#else
+    std::fstream file;
+#endif
+
+  public:
+    HostFileTarget(std::string path, WriteMode mode, CommitCallback onCommit = {})
+        : path(std::move(path)), onCommit(std::move(onCommit)) {
+#if VFS_HAS_PWRITE
+        int flags = O_WRONLY | O_CLOEXEC | (mode == WriteMode::Truncate ? O_TRUNC : 0);
+        fd = ::open(this->path.c_str(), flags);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file for writing: " + this->path);
+        }
+#else
+        auto openMode = std::ios::in | std::ios::out | std::ios::binary;
+        file.open(this->path, mode == WriteMode::Truncate ? openMode | std::ios::trunc : openMode);
+        if (!file) {
+            throw std::runtime_error("Cannot open file for writing: " + this->path);
+        }
+#endif
+    }
+
+    HostFileTarget(const HostFileTarget&) = delete;
+    HostFileTarget& operator=(const HostFileTarget&) = delete;
+
+    ~HostFileTarget() override {
+#if VFS_HAS_PWRITE
+        ::close(fd);
+#endif
+    }
+
+    // Size and mtime of the file as they are now.
+    FileVersion version() const {
+#if VFS_HAS_PWRITE
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            throw std::runtime_error("Cannot stat file: " + path);
+        }
+#if defined(__linux__)
+        std::int64_t modifiedAt = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 +
+                                  info.st_mtim.tv_nsec;
+#else
+        std::int64_t modifiedAt = static_cast<std::int64_t>(info.st_mtime) * 1000000000;
+#endif
+        return {modifiedAt, static_cast<std::uint64_t>(info.st_size)};
+#else
+        return BlockCache::versionOf(path);
+#endif
+    }
+
+    std::uint64_t size() const override { return version().size; }
+
+    void writeAt(std::uint64_t offset, const char* data, size_t length) override {
+#if VFS_HAS_PWRITE
+        while (length > 0) {
+            ssize_t count = ::pwrite(fd, data, length, static_cast<off_t>(offset));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                throw std::runtime_error("Cannot write file: " + path);
+            }
+            offset += static_cast<std::uint64_t>(count);
+            data += count;
+            length -= static_cast<size_t>(count);
+        }
+#else
+        file.seekp(static_cast<std::streamoff>(offset));
+        if (!file.write(data, static_cast<std::streamsize>(length))) {
+            throw std::runtime_error("Cannot write file: " + path);
+        }
+#endif
+    }
+
+    void commit() override {
+#if !VFS_HAS_PWRITE
+        file.flush();
+#endif
+        if (onCommit) {
+            onCommit(version());
+        }
+    }
+};
+
+// Sequential bytes first go to a small put area, as in a file stream, and reach the
+// WriteBackBuffer in pieces of its size.
+class WriteBackStreambuf : public std::streambuf {
+  private:
+    static constexpr size_t PUT_AREA = 8192;
+
+    std::unique_ptr<WriteTarget> target;
+    WriteBackBuffer buffer;
+    size_t capacity;
+    std::uint64_t areaStart; // file offset of pbase()
+    bool dirty;              // a truncated file is committed even if nothing is written
+    WriteBackStats stats{};
+    char area[PUT_AREA];
+
+    size_t pending() const { return static_cast<size_t>(pptr() - pbase()); }
+
+    void add(std::uint64_t offset, const char* data, size_t length) {
+        buffer.add(offset, data, length);
+        ++stats.writes;
+        stats.bytesWritten += length;
+    }
+
+    // Moves the put area's bytes into the buffer, flushing it once it holds `capacity`.
+    void spill() {
+        if (pending() > 0) {
+            add(areaStart, pbase(), pending());
+            areaStart += pending();
+            setp(area, area + PUT_AREA);
+        }
+        if (buffer.bufferedBytes() >= capacity) {
+            drain();
+        }
+    }
+
+    void drain() {
+        if (buffer.empty() && !dirty) {
+            return;
+        }
+        buffer.drain([&](std::uint64_t offset, std::string_view data) {
+            target->writeAt(offset, data.data(), data.size());
+            ++stats.targetWrites;
+        });
+        ++stats.flushes;
+        dirty = false;
+        target->commit();
+    }
+
+  protected:
+    int_type overflow(int_type c) override {
+        spill();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        auto length = static_cast<size_t>(count);
+        if (length <= static_cast<size_t>(epptr() - pptr())) {
+            std::memcpy(pptr(), data, length);
+            pbump(static_cast<int>(length));
+            return count;
+        }
+        spill();
+        add(areaStart, data, length);
+        areaStart += length;
+        spill();
+        return count;
+    }
+
+    int sync() override {
+        try {
+            flushPending();
+        } catch (const std::exception&) {
+            return -1;
+        }
+        return 0;
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+                     std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::out)) {
+            return pos_type(off_type(-1));
+        }
+        spill();
+        std::int64_t base = 0;
+        if (direction == std::ios_base::cur) {
+            base = static_cast<std::int64_t>(areaStart);
+        } else if (direction == std::ios_base::end) {
+            base = static_cast<std::int64_t>(std::max(target->size(), buffer.end()));
+        }
+        if (base + offset < 0) {
+            return pos_type(off_type(-1));
+        }
+        areaStart = static_cast<std::uint64_t>(base + offset);
+        return pos_type(static_cast<off_type>(areaStart));
+    }
+
+    pos_type seekpos(pos_type offset, std::ios_base::openmode which) override {
+        return seekoff(off_type(offset), std::ios_base::beg, which);
+    }
+
+  public:
+    WriteBackStreambuf(std::unique_ptr<WriteTarget> target, WriteMode mode, size_t capacity)
+        : target(std::move(target)), capacity(capacity),
+          areaStart(mode == WriteMode::Append ? this->target->size() : 0),
+          dirty(mode == WriteMode::Truncate) {
+        setp(area, area + PUT_AREA);
+    }
+
+    void write(std::uint64_t offset, std::string_view data) {
+        spill();
+        add(offset, data.data(), data.size());
+        spill();
+    }
+
+    void flushPending() {
+        spill();
+        drain();
+    }
+
+    std::uint64_t tell() const { return areaStart + pending(); }
+
+    size_t bufferedBytes() const { return buffer.bufferedBytes() + pending(); }
+
+    WriteBackStats getStats() const { return stats; }
+};
+
+// Output stream that collects writes in a WriteBackBuffer and hands them to its target
+// once `capacity` bytes are pending, on flush() and on close. Data written is not
+// visible to readers of the target before then. Besides sequential << and write(),
+// write(offset, data) writes at any offset without moving the stream position.
+class WriteBackStream : public std::ostream {
+  private:
+    WriteBackStreambuf buffer;
+    bool closed = false;
+
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 256 * 1024;
+
+    WriteBackStream(std::unique_ptr<WriteTarget> target, WriteMode mode = WriteMode::Update,
+                    size_t capacity = DEFAULT_CAPACITY)
+        : std::ostream(nullptr), buffer(std::move(target), mode, capacity) {
+        rdbuf(&buffer);
+    }
+
+    ~WriteBackStream() override {
+        try {
+            close();
+        } catch (const std::exception&) {
+        }
+    }
+
+    using std::ostream::write;
+
+    void write(std::uint64_t offset, std::string_view data) {
+        if (closed) {
+            throw std::runtime_error("Write stream is closed");
+        }
+        buffer.write(offset, data);
+    }
+
+    // Writes what is pending; unlike flush(), failures throw. Later writes fail.
+    void close() {
+        if (closed) {
+            return;
+        }
+        closed = true;
+        rdbuf(nullptr);
+        buffer.flushPending();
+    }
+
+    size_t bufferedBytes() const { return buffer.bufferedBytes(); }
+
+    WriteBackStats getStats() const { return buffer.getStats(); }
+};
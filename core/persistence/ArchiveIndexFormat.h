@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+// On-disk layout of the member index kept next to a mounted archive, so that mounting it
+// again skips the header scan. All fields are little-endian.
+//
+//   ArchiveIndexHeader
+//   ArchiveIndexEntry[entryCount]
+//   pathBytes bytes of member paths
+struct ArchiveIndexFormat {
+    static constexpr char MAGIC[8] = {'V', 'F', 'S', 'T', 'A', 'R', 'I', 'X'};
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr const char* SUFFIX = ".vfsidx";
+    static constexpr std::uint32_t DIRECTORY_FLAG = 1;
+};
+
+struct ArchiveIndexHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t archiveSize;    // the index is only used while the archive still has
+    std::int64_t archiveModified; // this size and modification time
+    std::uint64_t entryCount;
+    std::uint64_t pathBytes;
+    std::uint64_t checksum; // Hash64 of everything after the header
+};
+
+struct ArchiveIndexEntry {
+    std::uint64_t pathOffset;
+    std::uint64_t dataOffset;
+    std::uint64_t size;
+    std::uint32_t pathLength;
+    std::uint32_t flags;
+};
+
+static_assert(sizeof(ArchiveIndexHeader) == 56, "archive index header layout");
+static_assert(sizeof(ArchiveIndexEntry) == 32, "archive index entry layout");
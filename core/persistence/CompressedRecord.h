@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../utils/LzCodec.h"
+#include "../utils/ThreadPool.h"
+#include "PackFormat.h"
+
+// Content of a compressed pack record (see PackFormat.h): independent blocks behind an
+// offset table, so any byte range decodes from the blocks it spans alone.
+class CompressedRecord {
+  private:
+    const char* data;
+    size_t size;
+    PackCompressedHeader header;
+
+    static size_t tableBytes(size_t blockCount) {
+        return sizeof(PackCompressedHeader) + (blockCount + 1) * sizeof(std::uint64_t);
+    }
+
+    std::uint64_t offsetOf(size_t block) const {
+        std::uint64_t offset;
+        std::memcpy(&offset,
+                    data + sizeof(PackCompressedHeader) + block * sizeof(std::uint64_t),
+                    sizeof(offset));
+        return offset;
+    }
+
+    size_t rawSizeOf(size_t block) const {
+        return static_cast<size_t>(std::min<std::uint64_t>(
+            header.blockSize, header.rawLength - std::uint64_t(block) * header.blockSize));
+    }
+
+    void decodeBlocks(size_t first, size_t last, char* destination) const {
+        for (size_t block = first; block < last; ++block) {
+            decodeBlock(block, destination + std::uint64_t(block) * header.blockSize);
+        }
+    }
+
+  public:
+    // Below this many blocks a whole-record decode stays on the calling thread.
+    static constexpr size_t PARALLEL_BLOCKS = 16;
+
+    // The record for `content`, or an empty string when compression would not make it
+    // smaller. Blocks that do not shrink are stored as they are.
+    static std::string encode(std::string_view content, std::uint32_t blockSize) {
+        if (blockSize == 0) {
+            throw std::runtime_error("Compression block size must not be zero");
+        }
+        size_t blockCount = (content.size() + blockSize - 1) / blockSize;
+        size_t start = tableBytes(blockCount);
+        if (content.size() <= start) {
+            return std::string();
+        }
+        std::string record(start, '\0');
+        PackCompressedHeader header{content.size(), blockSize,
+                                    static_cast<std::uint32_t>(blockCount)};
+        std::memcpy(&record[0], &header, sizeof(header));
+        std::vector<char> scratch(blockSize);
+        for (size_t block = 0; block <= blockCount; ++block) {
+            std::uint64_t offset = record.size();
+            std::memcpy(&record[sizeof(header) + block * sizeof(offset)], &offset,
+                        sizeof(offset));
+            if (block == blockCount) {
+                break;
+            }
+            std::string_view raw = content.substr(block * blockSize, blockSize);
+            size_t packed = LzCodec::compress(raw.data(), raw.size(), scratch.data(),
+                                              raw.size() - 1);
+            if (packed > 0) {
+                record.append(scratch.data(), packed);
+            } else {
+                record.append(raw.data(), raw.size());
+            }
+            if (record.size() >= content.size()) {
+                return std::string();
+            }
+        }
+        return record;
+    }
+
+    // Checks the header and offset table of `size` bytes at `data`, which must outlive
+    // the object.
+    CompressedRecord(const char* data, size_t size) : data(data), size(size) {
+        if (size < sizeof(header)) {
+            throw std::runtime_error("Corrupt compressed record");
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (header.blockSize == 0 ||
+            header.blockCount != header.rawLength / header.blockSize +
+                                     (header.rawLength % header.blockSize != 0) ||
+            size < tableBytes(header.blockCount) ||
+            offsetOf(0) != tableBytes(header.blockCount) ||
+            offsetOf(header.blockCount) != size) {
+            throw std::runtime_error("Corrupt compressed record");
+        }
+        for (size_t block = 0; block < header.blockCount; ++block) {
+            if (offsetOf(block + 1) <= offsetOf(block) ||
+                offsetOf(block + 1) - offsetOf(block) > rawSizeOf(block)) {
+                throw std::runtime_error("Corrupt compressed record");
+            }
+        }
+    }
+
+    std::uint64_t rawLength() const { return header.rawLength; }
+
+    size_t blockCount() const { return header.blockCount; }
+
+    // Decodes block `block` into its raw size at `destination`.
+    void decodeBlock(size_t block, char* destination) const {
+        const char* stored = data + offsetOf(block);
+        auto storedSize = static_cast<size_t>(offsetOf(block + 1) - offsetOf(block));
+        size_t rawSize = rawSizeOf(block);
+        if (storedSize == rawSize) {
+            std::memcpy(destination, stored, rawSize);
+        } else {
+            LzCodec::decompress(stored, storedSize, destination, rawSize);
+        }
+    }
+
+    // Copies up to `length` bytes at `at`, decoding only the blocks they span; returns
+    // how many there were.
+    size_t read(std::uint64_t at, char* destination, size_t length) const {
+        if (at >= header.rawLength) {
+            return 0;
+        }
+        length = static_cast<size_t>(std::min<std::uint64_t>(length, header.rawLength - at));
+        std::vector<char> scratch;
+        for (size_t copied = 0; copied < length;) {
+            std::uint64_t position = at + copied;
+            auto block = static_cast<size_t>(position / header.blockSize);
+            auto within = static_cast<size_t>(position % header.blockSize);
+            size_t count = std::min(length - copied, rawSizeOf(block) - within);
+            if (within == 0 && count == rawSizeOf(block)) {
+                decodeBlock(block, destination + copied);
+            } else {
+                scratch.resize(rawSizeOf(block));
+                decodeBlock(block, scratch.data());
+                std::memcpy(destination + copied, scratch.data() + within, count);
+            }
+            copied += count;
+        }
+        return length;
+    }
+
+    // Decodes the whole content into rawLength() bytes at `destination`, spread over
+    // `pool` for records of PARALLEL_BLOCKS blocks or more.
+    void decodeAll(char* destination, ThreadPool* pool = nullptr) const {
+        size_t blocks = header.blockCount;
+        if (!pool || pool->size() < 2 || blocks < PARALLEL_BLOCKS) {
+            decodeBlocks(0, blocks, destination);
+            return;
+        }
+        size_t parts = std::min(pool->size(), blocks);
+        std::vector<std::future<void>> pending;
+        pending.reserve(parts);
+        for (size_t part = 0; part < parts; ++part) {
+            size_t first = blocks * part / parts;
+            size_t last = blocks * (part + 1) / parts;
+            pending.push_back(pool->submit(
+                [this, first, last, destination]() { decodeBlocks(first, last, destination); }));
+        }
+        std::exception_ptr failure;
+        for (auto& part : pending) {
+            try {
+                part.get();
+            } catch (...) {
+                failure = std::current_exception();
+            }
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+};
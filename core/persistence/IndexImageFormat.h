@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+// On-disk layout of a name index image. The arrays follow the header in this order,
+// each starting on an 8-byte boundary and sized by the header counts, and refer to each
+// other only by indices and offsets, so a mapped image is queried where it lies.
+//
+//   IndexImageHeader
+//   IndexImageSlot[slotCount]          open-addressing table, linear probing
+//   uint32 values[valueCount]          snapshot preorder index of every named node
+//   IndexImageTrieNode[trieNodeCount]  breadth-first, children contiguous and ordered
+//   char strings[stringBytes]
+struct IndexImageFormat {
+    static constexpr char MAGIC[8] = {'V', 'F', 'S', 'I', 'N', 'D', 'X', '\0'};
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint64_t ALIGNMENT = 8;
+};
+
+struct IndexImageHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t treeVersion; // checksum of the snapshot nodes the image was built from
+    std::uint64_t nodeCount;
+    std::uint64_t slotCount; // a power of two
+    std::uint64_t valueCount;
+    std::uint64_t trieNodeCount;
+    std::uint64_t stringBytes;
+    std::uint64_t checksum; // Hash64 of everything after the header
+};
+
+struct IndexImageSlot {
+    std::uint64_t hash; // Hash64 of the name
+    std::uint64_t keyOffset;
+    std::uint64_t firstValue;
+    std::uint32_t keyLength;
+    std::uint32_t valueCount; // 0 marks an empty slot
+};
+
+struct IndexImageTrieNode {
+    std::uint32_t firstChild;
+    std::uint32_t childCount;
+    std::uint32_t count; // names ending here
+    char ch;
+    char padding[3];
+};
+
+static_assert(sizeof(IndexImageHeader) == 72, "index image header layout");
+static_assert(sizeof(IndexImageSlot) == 32, "index image slot layout");
+static_assert(sizeof(IndexImageTrieNode) == 16, "index image trie node layout");
@@ -0,0 +1,640 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../domain/MutationLog.h"
+#include "../domain/VFSExplorer.h"
+#include "../utils/FileSync.h"
+#include "../utils/Hash64.h"
+#include "JournalFormat.h"
+#include "VFSSnapshot.h"
+
+enum class JournalSync {
+    Never,       // records reach the OS, flushing to disk is left to it
+    Periodic,    // one fsync per group, at most syncInterval after the first record in it
+    EveryCommit, // record() returns once its record is on disk
+};
+
+struct JournalOptions {
+    JournalSync sync = JournalSync::Periodic;
+    std::chrono::milliseconds syncInterval{10};
+    std::uint64_t segmentBytes = 64ull << 20;
+};
+
+struct JournalStats {
+    std::uint64_t records;
+    std::uint64_t groupCommits;
+    std::uint64_t syncs;
+    std::uint64_t bytesWritten;
+    std::uint64_t segmentsCompacted;
+};
+
+struct JournalRecovery {
+    bool snapshotLoaded;
+    std::uint64_t snapshotSequence;
+    std::uint64_t replayed;
+    std::uint64_t lastSequence;
+    std::uint64_t truncatedBytes; // torn tail dropped when the journal was opened
+};
+
+// Append-only log of VFSExplorer mutations stored as numbered segment files in one
+// directory. Callers only encode the record into a shared buffer; a background thread
+// writes whatever accumulated as one group and fsyncs it once (group commit), so the
+// cost on the mutating thread stays at a few microseconds unless EveryCommit is asked for.
+//
+// Typical use:
+//   Journal journal(dir);
+//   journal.recover(explorer, snapshotPath); // snapshot + records after it
+//   explorer.setMutationLog(&journal);
+//   ...
+//   journal.checkpoint(explorer, snapshotPath); // old segments are dropped in the background
+class Journal : public MutationLog {
+  private:
+    static constexpr size_t FLUSH_BYTES = 1 << 20;
+
+    struct Segment {
+        std::string path;
+        std::uint64_t firstSequence;
+        std::uint64_t lastSequence; // firstSequence - 1 while empty
+    };
+
+    struct Record {
+        std::uint64_t sequence;
+        MutationOp op;
+        bool flag;
+        std::vector<std::string_view> args;
+    };
+
+    std::filesystem::path directory;
+    JournalOptions options;
+
+    mutable std::mutex mutex;
+    std::condition_variable workReady;
+    std::condition_variable groupDone;
+    std::string pending;
+    std::uint64_t pendingFirst = 0;
+    std::uint64_t nextSequence = 1;
+    std::uint64_t writtenSequence = 0;
+    std::uint64_t syncedSequence = 0;
+    std::uint64_t syncTarget = 0;
+    std::uint64_t compactThrough = 0;
+    bool rotateRequested = false;
+    bool stopping = false;
+    bool recorded = false;
+    std::exception_ptr failure;
+    std::vector<Segment> segments;
+    std::uint64_t truncatedBytes = 0;
+    JournalStats stats{};
+
+    // Owned by the writer thread.
+    std::FILE* current = nullptr;
+    std::uint64_t currentBytes = 0;
+    std::thread writer;
+
+    static std::string segmentName(std::uint64_t firstSequence) {
+        std::string digits = std::to_string(firstSequence);
+        return JournalFormat::SEGMENT_PREFIX + std::string(20 - digits.size(), '0') + digits +
+               JournalFormat::SEGMENT_SUFFIX;
+    }
+
+    static void appendLength(std::string& out, std::uint32_t value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static size_t expectedArgs(MutationOp op) {
+        switch (op) {
+        case MutationOp::DeleteNode:
+            return 1;
+        case MutationOp::CreateDirectory:
+        case MutationOp::CreateMemoryFile:
+        case MutationOp::RenameNode:
+        case MutationOp::MoveNode:
+        case MutationOp::MountHostDirectory:
+        case MutationOp::MountArchive:
+            return 2;
+        case MutationOp::AddFile:
+        case MutationOp::AddStoredFile:
+        case MutationOp::AddChunkedFile:
+        case MutationOp::CopyNode:
+        case MutationOp::CutNode:
+            return 3;
+        case MutationOp::MountLazy:
+        case MutationOp::DeepCopyNode:
+            return 4;
+        }
+        return 0;
+    }
+
+    // Calls `visit` for every intact record and returns the length of the valid prefix,
+    // or 0 when even the segment header is unusable.
+    static std::uint64_t readSegment(const std::string& path,
+                                     const std::function<void(const Record&)>& visit) {
+        std::ifstream in(path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        JournalSegmentHeader segmentHeader;
+        if (data.size() < sizeof(segmentHeader)) {
+            return 0;
+        }
+        std::memcpy(&segmentHeader, data.data(), sizeof(segmentHeader));
+        if (std::memcmp(segmentHeader.magic, JournalFormat::MAGIC, sizeof(segmentHeader.magic)) !=
+                0 ||
+            segmentHeader.version != JournalFormat::VERSION) {
+            return 0;
+        }
+
+        std::uint64_t offset = sizeof(segmentHeader);
+        std::uint64_t expected = segmentHeader.firstSequence;
+        while (data.size() - offset >= sizeof(JournalRecordHeader)) {
+            JournalRecordHeader header;
+            std::memcpy(&header, data.data() + offset, sizeof(header));
+            std::uint64_t end = offset + sizeof(header) + header.payloadLength;
+            if (header.payloadLength > data.size() - offset - sizeof(header) ||
+                header.sequence != expected ||
+                Hash64::compute(data.data() + offset + sizeof(header.checksum),
+                                end - offset - sizeof(header.checksum)) != header.checksum) {
+                break;
+            }
+
+            Record record{header.sequence, static_cast<MutationOp>(header.op), header.flag != 0,
+                          {}};
+            std::uint64_t cursor = offset + sizeof(header);
+            bool intact = true;
+            for (std::uint16_t i = 0; i < header.argCount && intact; ++i) {
+                std::uint32_t length;
+                if (end - cursor < sizeof(length)) {
+                    intact = false;
+                    break;
+                }
+                std::memcpy(&length, data.data() + cursor, sizeof(length));
+                cursor += sizeof(length);
+                if (length > end - cursor) {
+                    intact = false;
+                    break;
+                }
+                record.args.emplace_back(data.data() + cursor, length);
+                cursor += length;
+            }
+            if (!intact || cursor != end || record.args.size() != expectedArgs(record.op)) {
+                break;
+            }
+
+            visit(record);
+            offset = end;
+            ++expected;
+        }
+        return offset;
+    }
+
+    static void apply(VFSExplorer& explorer, const Record& record) {
+        const auto arg = [&](size_t i) { return std::string(record.args[i]); };
+        switch (record.op) {
+        case MutationOp::CreateDirectory:
+            explorer.createDirectory(arg(0), arg(1));
+            break;
+        case MutationOp::AddFile:
+            explorer.addFile(arg(0), arg(1), arg(2), VFSFile::TrustedPath{});
+            break;
+        case MutationOp::DeleteNode:
+            explorer.deleteNode(arg(0));
+            break;
+        case MutationOp::RenameNode:
+            explorer.renameNode(arg(0), arg(1));
+            break;
+        case MutationOp::MoveNode:
+            explorer.moveNode(explorer.navigateToNode(arg(0)), explorer.navigateToDirectory(arg(1)));
+            break;
+        case MutationOp::CopyNode:
+            explorer.copyNode(explorer.navigateToNode(arg(0)), arg(1), record.flag, arg(2));
+            break;
+        case MutationOp::CutNode:
+            explorer.cutNode(explorer.navigateToNode(arg(0)), arg(1), record.flag, arg(2));
+            break;
+        case MutationOp::MountHostDirectory:
+            explorer.mountHostDirectory(arg(0), arg(1));
+            break;
+        case MutationOp::MountLazy: {
+            LazyMountOptions options;
+            options.prefetchSiblings = std::stoull(arg(2));
+            options.revalidateAfter = std::chrono::milliseconds(std::stoll(arg(3)));
+            explorer.mountLazy(arg(0), arg(1), options);
+            break;
+        }
+        case MutationOp::MountArchive:
+            explorer.mountArchive(arg(0), arg(1));
+            break;
+        case MutationOp::AddStoredFile:
+            explorer.addStoredFile(arg(0), arg(1), ContentKey::fromHex(arg(2)));
+            break;
+        case MutationOp::AddChunkedFile:
+            explorer.addChunkedFile(arg(0), arg(1), ContentKey::fromHex(arg(2)));
+            break;
+        case MutationOp::CreateMemoryFile:
+            explorer.createMemoryFile(arg(0), arg(1));
+            break;
+        case MutationOp::DeepCopyNode: {
+            // The host files were copied when the record was written; replay links them.
+            std::vector<std::string> copies;
+            std::string_view list = record.args[3];
+            for (size_t start = 0; start < list.size();) {
+                size_t end = std::min(list.find('\0', start), list.size());
+                copies.emplace_back(list.substr(start, end - start));
+                start = end + 1;
+            }
+            explorer.attachDeepCopy(explorer.navigateToNode(arg(0)), arg(1), record.flag, arg(2),
+                                    copies);
+            break;
+        }
+        }
+    }
+
+    // Drops a torn tail left by a crash. Only the newest segment may have one; damage
+    // anywhere else means records were lost and the journal cannot be trusted.
+    void scanSegments() {
+        std::vector<std::filesystem::path> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind(JournalFormat::SEGMENT_PREFIX, 0) == 0 &&
+                entry.path().extension() == JournalFormat::SEGMENT_SUFFIX) {
+                paths.push_back(entry.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            std::string path = paths[i].string();
+            bool newest = i + 1 == paths.size();
+            std::uint64_t firstSequence = 0;
+            std::uint64_t lastSequence = 0;
+            std::uint64_t valid = readSegment(path, [&](const Record& record) {
+                if (firstSequence == 0) {
+                    firstSequence = record.sequence;
+                }
+                lastSequence = record.sequence;
+            });
+            std::uint64_t size = std::filesystem::file_size(path);
+
+            if (valid < size && !newest) {
+                throw std::runtime_error("Corrupt journal segment: " + path);
+            }
+            if (valid == 0 || firstSequence == 0) {
+                truncatedBytes += size;
+                std::filesystem::remove(path);
+                continue;
+            }
+            if (valid < size) {
+                truncatedBytes += size - valid;
+                std::filesystem::resize_file(path, valid);
+            }
+            if (!segments.empty() && firstSequence != segments.back().lastSequence + 1) {
+                throw std::runtime_error("Journal segments are not contiguous at: " + path);
+            }
+            segments.push_back({path, firstSequence, lastSequence});
+        }
+
+        if (!segments.empty()) {
+            nextSequence = segments.back().lastSequence + 1;
+        }
+        writtenSequence = syncedSequence = nextSequence - 1;
+    }
+
+    void openSegment(std::uint64_t firstSequence) {
+        std::string path = (directory / segmentName(firstSequence)).string();
+        current = std::fopen(path.c_str(), "wb");
+        if (!current) {
+            throw std::runtime_error("Cannot create journal segment: " + path);
+        }
+        JournalSegmentHeader header{};
+        std::memcpy(header.magic, JournalFormat::MAGIC, sizeof(header.magic));
+        header.version = JournalFormat::VERSION;
+        header.firstSequence = firstSequence;
+        std::fwrite(&header, sizeof(header), 1, current);
+        currentBytes = sizeof(header);
+        FileSync::directory(directory.string());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        segments.push_back({path, firstSequence, firstSequence - 1});
+    }
+
+    void closeSegment() {
+        if (current) {
+            FileSync::flush(current);
+            std::fclose(current);
+            current = nullptr;
+        }
+    }
+
+    void writeGroup(const std::string& group, std::uint64_t firstSequence,
+                    std::uint64_t recordCount, bool sync) {
+        if (!current) {
+            openSegment(firstSequence);
+        }
+        if (std::fwrite(group.data(), 1, group.size(), current) != group.size()) {
+            throw std::runtime_error("Cannot write journal segment");
+        }
+        currentBytes += group.size();
+        if (sync) {
+            FileSync::flush(current);
+        } else {
+            std::fflush(current);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        segments.back().lastSequence = firstSequence + recordCount - 1;
+    }
+
+    void removeCompacted(std::uint64_t through) {
+        std::vector<std::string> obsolete;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string openPath = current ? segments.back().path : std::string();
+            auto keep = std::stable_partition(
+                segments.begin(), segments.end(), [&](const Segment& segment) {
+                    return segment.path == openPath || segment.lastSequence > through;
+                });
+            for (auto it = keep; it != segments.end(); ++it) {
+                obsolete.push_back(it->path);
+            }
+            segments.erase(keep, segments.end());
+            stats.segmentsCompacted += obsolete.size();
+        }
+        for (const auto& path : obsolete) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+        if (!obsolete.empty()) {
+            FileSync::directory(directory.string());
+        }
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::uint64_t compacted = compactThrough;
+        while (true) {
+            const auto ready = [&]() {
+                return stopping || rotateRequested || compactThrough != compacted ||
+                       syncTarget > syncedSequence || pending.size() >= FLUSH_BYTES ||
+                       (options.sync == JournalSync::EveryCommit && !pending.empty());
+            };
+            if (options.sync == JournalSync::EveryCommit) {
+                workReady.wait(lock, ready);
+            } else {
+                workReady.wait_for(lock, options.syncInterval, ready);
+            }
+
+            std::string group;
+            group.swap(pending);
+            std::uint64_t first = pendingFirst;
+            std::uint64_t last = nextSequence - 1;
+            bool sync = options.sync != JournalSync::Never || syncTarget > syncedSequence;
+            bool flushWritten = group.empty() && sync && syncedSequence < writtenSequence;
+            bool rotate = rotateRequested;
+            rotateRequested = false;
+            std::uint64_t compactTarget = compactThrough;
+            bool exiting = stopping;
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                if (rotate) {
+                    closeSegment();
+                }
+                if (!group.empty()) {
+                    writeGroup(group, first, last - first + 1, sync);
+                    if (currentBytes >= options.segmentBytes) {
+                        closeSegment();
+                    }
+                } else if (flushWritten && current) {
+                    FileSync::flush(current);
+                }
+                if (compactTarget != compacted) {
+                    removeCompacted(compactTarget);
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            if (error) {
+                failure = error;
+            } else {
+                compacted = compactTarget;
+                if (sync && syncedSequence < last) {
+                    syncedSequence = last;
+                    ++stats.syncs;
+                }
+                if (!group.empty()) {
+                    writtenSequence = last;
+                    ++stats.groupCommits;
+                    stats.bytesWritten += group.size();
+                }
+            }
+            groupDone.notify_all();
+            if (exiting && pending.empty()) {
+                break;
+            }
+        }
+        lock.unlock();
+        closeSegment();
+    }
+
+    void throwIfFailed() const {
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+  public:
+    explicit Journal(const std::string& directory, JournalOptions options = {})
+        : directory(directory), options(options) {
+        std::filesystem::create_directories(this->directory);
+        scanSegments();
+        writer = std::thread(&Journal::writerLoop, this);
+    }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Everything recorded is written out; it is synced unless the policy is Never.
+    ~Journal() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workReady.notify_one();
+        writer.join();
+    }
+
+    void record(MutationOp op, std::initializer_list<std::string_view> args,
+                bool flag = false) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        throwIfFailed();
+
+        size_t start = pending.size();
+        pending.resize(start + sizeof(JournalRecordHeader));
+        for (std::string_view arg : args) {
+            appendLength(pending, static_cast<std::uint32_t>(arg.size()));
+            pending.append(arg.data(), arg.size());
+        }
+
+        JournalRecordHeader header{};
+        header.sequence = nextSequence++;
+        if (start == 0) {
+            pendingFirst = header.sequence;
+        }
+        header.payloadLength =
+            static_cast<std::uint32_t>(pending.size() - start - sizeof(JournalRecordHeader));
+        header.op = static_cast<std::uint8_t>(op);
+        header.flag = flag ? 1 : 0;
+        header.argCount = static_cast<std::uint16_t>(args.size());
+        std::memcpy(&pending[start], &header, sizeof(header));
+        header.checksum = Hash64::compute(pending.data() + start + sizeof(header.checksum),
+                                          pending.size() - start - sizeof(header.checksum));
+        std::memcpy(&pending[start], &header.checksum, sizeof(header.checksum));
+        ++stats.records;
+        recorded = true;
+
+        if (options.sync == JournalSync::EveryCommit) {
+            workReady.notify_one();
+            groupDone.wait(lock, [&]() { return syncedSequence >= header.sequence || failure; });
+            throwIfFailed();
+        } else if (pending.size() >= FLUSH_BYTES) {
+            workReady.notify_one();
+        }
+    }
+
+    // Blocks until every record so far is on disk, whatever the policy, and returns the
+    // sequence number of the last one.
+    std::uint64_t sync() {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::uint64_t target = nextSequence - 1;
+        syncTarget = std::max(syncTarget, target);
+        workReady.notify_one();
+        groupDone.wait(lock, [&]() { return syncedSequence >= target || failure; });
+        throwIfFailed();
+        return target;
+    }
+
+    // Loads the snapshot at `snapshotPath` if there is one and replays the records
+    // written after it. Must run before the journal is attached to the explorer. If a
+    // record fails to replay the explorer is left with the records before it applied.
+    JournalRecovery recover(VFSExplorer& explorer, const std::string& snapshotPath = "") {
+        std::vector<Segment> existing;
+        JournalRecovery result{};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (recorded) {
+                throw std::runtime_error("Journal recovery must run before recording");
+            }
+            existing = segments;
+            result.truncatedBytes = truncatedBytes;
+        }
+
+        if (!snapshotPath.empty() && std::filesystem::exists(snapshotPath)) {
+            result.snapshotSequence = VFSSnapshot::load(explorer, snapshotPath).journalSequence;
+            result.snapshotLoaded = true;
+        }
+
+        MutationLog* attached = explorer.mutationLog;
+        explorer.mutationLog = nullptr;
+        std::uint64_t expected = result.snapshotSequence + 1;
+        try {
+            for (const auto& segment : existing) {
+                if (segment.lastSequence < expected) {
+                    continue;
+                }
+                readSegment(segment.path, [&](const Record& record) {
+                    if (record.sequence < expected) {
+                        return;
+                    }
+                    if (record.sequence != expected) {
+                        throw std::runtime_error("Journal is missing records before sequence " +
+                                                 std::to_string(record.sequence));
+                    }
+                    try {
+                        apply(explorer, record);
+                    } catch (const std::exception& e) {
+                        throw std::runtime_error("Journal replay failed at sequence " +
+                                                 std::to_string(record.sequence) + ": " +
+                                                 e.what());
+                    }
+                    ++expected;
+                    ++result.replayed;
+                });
+            }
+        } catch (...) {
+            explorer.mutationLog = attached;
+            throw;
+        }
+        explorer.mutationLog = attached;
+        result.lastSequence = expected - 1;
+
+        // A snapshot newer than the surviving log must not have its sequence reused. The
+        // old segments go first: next to a segment that starts after the snapshot they
+        // would leave a gap, and the next open would reject the journal.
+        std::vector<std::string> obsolete;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (nextSequence <= result.lastSequence) {
+                for (const auto& segment : segments) {
+                    obsolete.push_back(segment.path);
+                }
+                segments.clear();
+                nextSequence = result.lastSequence + 1;
+                writtenSequence = syncedSequence = result.lastSequence;
+                rotateRequested = true;
+            }
+        }
+        for (const auto& path : obsolete) {
+            std::filesystem::remove(path);
+        }
+        if (!obsolete.empty()) {
+            FileSync::directory(directory.string());
+        }
+        return result;
+    }
+
+    // Snapshots the explorer, tagged with the last record it reflects, then starts a new
+    // segment and lets the writer thread delete the ones the snapshot made obsolete.
+    SnapshotInfo checkpoint(const VFSExplorer& explorer, const std::string& snapshotPath,
+                            SnapshotOptions snapshotOptions = {}) {
+        snapshotOptions.journalSequence = sync();
+        SnapshotInfo info = VFSSnapshot::save(explorer, snapshotPath, snapshotOptions);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            rotateRequested = true;
+            compactThrough = std::max(compactThrough, snapshotOptions.journalSequence);
+        }
+        workReady.notify_one();
+        return info;
+    }
+
+    std::uint64_t lastSequence() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return nextSequence - 1;
+    }
+
+    size_t segmentCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return segments.size();
+    }
+
+    JournalStats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+};
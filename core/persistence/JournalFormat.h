@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+// On-disk layout of a journal segment. A segment is a JournalSegmentHeader followed by
+// records; each record is a JournalRecordHeader followed by argCount arguments, each a
+// uint32 length and that many bytes. Sequence numbers are contiguous across segments.
+struct JournalFormat {
+    static constexpr char MAGIC[8] = {'V', 'F', 'S', 'J', 'R', 'N', 'L', '\0'};
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr const char* SEGMENT_PREFIX = "journal-";
+    static constexpr const char* SEGMENT_SUFFIX = ".log";
+};
+
+struct JournalSegmentHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t firstSequence;
+};
+
+struct JournalRecordHeader {
+    std::uint64_t checksum; // Hash64 of the rest of the record, header fields included
+    std::uint64_t sequence;
+    std::uint32_t payloadLength;
+    std::uint8_t op;
+    std::uint8_t flag;
+    std::uint16_t argCount;
+};
+
+static_assert(sizeof(JournalSegmentHeader) == 24, "journal segment header layout");
+static_assert(sizeof(JournalRecordHeader) == 24, "journal record header layout");
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+
+// On-disk layout of a pack file. A pack is a PackFileHeader followed by records, each a
+// PackRecordHeader and `length` bytes of content padded to ALIGNMENT. Records are only
+// appended; the pack being appended to carries OPEN_SUFFIX until it is sealed. A record
+// whose length has the COMPRESSED bit holds its content in compressed blocks: a
+// PackCompressedHeader, blockCount + 1 offsets of the blocks within the record, then the
+// blocks. A block is stored raw when compressing did not make it smaller. Such records
+// only appear in packs of COMPRESSED_VERSION, which readers predating compression do
+// not accept, rather than taking the records for a torn tail.
+struct PackFormat {
+    static constexpr char MAGIC[8] = {'V', 'F', 'S', 'P', 'A', 'C', 'K', '\0'};
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t COMPRESSED_VERSION = 2;
+    static constexpr const char* PREFIX = "pack-";
+    static constexpr const char* SUFFIX = ".pack";
+    static constexpr const char* OPEN_SUFFIX = ".open";
+    static constexpr std::uint64_t ALIGNMENT = 8;
+    static constexpr std::uint64_t COMPRESSED = 1ull << 63;
+};
+
+struct PackFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t packId;
+};
+
+struct PackRecordHeader {
+    std::uint64_t checksum; // Hash64 of the remaining header fields
+    std::uint64_t keyHigh;  // content key, see ContentKey
+    std::uint64_t keyLow;
+    std::uint64_t length;   // of the stored bytes, with the COMPRESSED bit
+};
+
+struct PackCompressedHeader {
+    std::uint64_t rawLength;
+    std::uint32_t blockSize; // of every block but the last, before compression
+    std::uint32_t blockCount;
+};
+
+// Content of a chunked file's recipe record: its chunks in file order.
+struct PackChunkRef {
+    std::uint64_t keyHigh;
+    std::uint64_t keyLow;
+    std::uint64_t length;
+};
+
+static_assert(sizeof(PackFileHeader) == 16, "pack file header layout");
+static_assert(sizeof(PackRecordHeader) == 32, "pack record header layout");
+static_assert(sizeof(PackCompressedHeader) == 16, "pack compressed header layout");
+static_assert(sizeof(PackChunkRef) == 24, "pack chunk reference layout");
@@ -0,0 +1,744 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../io/MappedFile.h"
+#include "../utils/FileSync.h"
+#include "../utils/Hash64.h"
+#include "../utils/ThreadPool.h"
+#include "CompressedRecord.h"
+#include "PackFormat.h"
+
+// 128-bit content address: two Hash64 digests of the content under different seeds.
+struct ContentKey {
+    static constexpr std::uint64_t HIGH_SEED = 0x9E3779B97F4A7C15ULL;
+
+    std::uint64_t high;
+    std::uint64_t low;
+
+    static ContentKey of(std::string_view content) {
+        return {Hash64::compute(content.data(), content.size(), HIGH_SEED),
+                Hash64::compute(content.data(), content.size())};
+    }
+
+    bool operator==(const ContentKey& other) const {
+        return high == other.high && low == other.low;
+    }
+
+    bool operator!=(const ContentKey& other) const { return !(*this == other); }
+
+    // 32 hex digits, the form used in journal records.
+    std::string toHex() const {
+        static constexpr char DIGITS[] = "0123456789abcdef";
+        std::string hex(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            hex[15 - i] = DIGITS[(high >> (4 * i)) & 0xF];
+            hex[31 - i] = DIGITS[(low >> (4 * i)) & 0xF];
+        }
+        return hex;
+    }
+
+    static ContentKey fromHex(const std::string& hex) {
+        if (hex.size() != 32 || hex.find_first_not_of("0123456789abcdef") != std::string::npos) {
+            throw std::runtime_error("Invalid content key: " + hex);
+        }
+        return {std::stoull(hex.substr(0, 16), nullptr, 16),
+                std::stoull(hex.substr(16), nullptr, 16)};
+    }
+};
+
+struct ContentKeyHash {
+    size_t operator()(const ContentKey& key) const { return static_cast<size_t>(key.low); }
+};
+
+struct PackStoreOptions {
+    std::uint64_t packBytes = 256ull << 20; // the open pack is sealed once it reaches this
+    double compactionThreshold = 0.5;       // dead share of a sealed pack that gets it rewritten
+    bool backgroundCompaction = true;       // rewrite such packs on a background thread
+    bool compression = false;               // store content in compressed blocks if it shrinks
+    std::uint32_t compressionBlockSize = 64 * 1024;
+};
+
+struct PackStoreStats {
+    std::uint64_t packs;
+    std::uint64_t records;
+    std::uint64_t liveBytes; // content of records that are not dead
+    std::uint64_t deadBytes; // record bytes that compaction has yet to reclaim
+    std::uint64_t dedupHits;
+    std::uint64_t bytesWritten;
+    std::uint64_t packsCompacted;
+    std::uint64_t bytesCompacted; // record bytes copied into new packs by compaction
+    std::uint64_t truncatedBytes; // torn tails dropped when the store was opened
+    std::uint64_t compressedRecords;
+    std::uint64_t bytesSaved; // by compression, over the live records
+};
+
+// Content-addressed storage for file data owned by the VFS: a few large append-only pack
+// files in one directory instead of one host file per node. Identical contents are stored
+// once, and reads are views into a shared mapping of the pack, without a copy.
+//
+// References are counted per session. retain() takes one and release() drops one;
+// content whose count drops to zero is dead, and its bytes are reclaimed once compaction
+// rewrites the pack: the live records move to a new pack and readers keep their views of
+// the old one. Records read back on open are unclaimed, neither live nor dead, until
+// dropUnclaimed() declares that every owner has retained its content again.
+//
+// With compression on, content is stored in compressed blocks when that makes it
+// smaller. Keys, sizes and reads stay those of the raw content; reads decode only the
+// blocks they touch, and map() returns a decoded copy instead of a view.
+class PackStore {
+  private:
+    struct Pack {
+        std::string path;
+        std::uint64_t bytes;     // header and records written so far
+        std::uint64_t deadBytes; // of records that are dead or superseded by another copy
+        std::shared_ptr<const MappedFile> mapping;
+    };
+
+    struct Entry {
+        std::uint32_t pack;
+        std::uint64_t offset; // of the content within the pack
+        std::uint64_t stored; // bytes in the pack
+        std::uint64_t length; // of the raw content
+        bool compressed;
+        std::uint64_t refs;
+        bool dead;
+    };
+
+    struct Record {
+        ContentKey key;
+        std::uint64_t offset;
+        std::uint64_t stored;
+        bool compressed;
+    };
+
+    std::filesystem::path directory;
+    PackStoreOptions options;
+
+    std::mutex mutex;
+    std::map<std::uint32_t, Pack> packs;
+    std::unordered_map<ContentKey, Entry, ContentKeyHash> entries;
+    std::uint32_t nextPackId = 1;
+    std::FILE* active = nullptr; // the open pack
+    std::uint32_t activeId = 0;
+    std::uint32_t activeVersion = PackFormat::VERSION;
+    bool activeUnsynced = false; // records appended since the open pack was last synced
+    bool compactionQueued = false;
+    PackStoreStats stats{};
+
+    std::mutex compactionMutex; // one compaction at a time
+    std::unique_ptr<ThreadPool> compactor;
+    std::once_flag decodersCreated;
+    std::unique_ptr<ThreadPool> decoders; // for maps of large compressed records
+
+    static std::uint64_t alignUp(std::uint64_t offset) {
+        return (offset + PackFormat::ALIGNMENT - 1) & ~(PackFormat::ALIGNMENT - 1);
+    }
+
+    static std::uint64_t recordBytes(std::uint64_t length) {
+        return sizeof(PackRecordHeader) + alignUp(length);
+    }
+
+    static std::uint64_t headerChecksum(const PackRecordHeader& header) {
+        return Hash64::compute(reinterpret_cast<const char*>(&header) + sizeof(header.checksum),
+                               sizeof(header) - sizeof(header.checksum));
+    }
+
+    std::string packPath(std::uint32_t id, bool open) const {
+        std::string digits = std::to_string(id);
+        std::string name = PackFormat::PREFIX + std::string(10 - digits.size(), '0') + digits +
+                           PackFormat::SUFFIX + (open ? PackFormat::OPEN_SUFFIX : "");
+        return (directory / name).string();
+    }
+
+    static void writeAll(std::FILE* file, const void* data, size_t length,
+                         const std::string& path) {
+        if (length > 0 && std::fwrite(data, 1, length, file) != length) {
+            throw std::runtime_error("Cannot write pack: " + path);
+        }
+    }
+
+    static void writeRecord(std::FILE* file, const ContentKey& key, const char* data,
+                            std::uint64_t length, bool compressed, const std::string& path) {
+        static constexpr char PADDING[PackFormat::ALIGNMENT] = {};
+        PackRecordHeader header{0, key.high, key.low,
+                                compressed ? length | PackFormat::COMPRESSED : length};
+        header.checksum = headerChecksum(header);
+        writeAll(file, &header, sizeof(header), path);
+        writeAll(file, data, static_cast<size_t>(length), path);
+        writeAll(file, PADDING, static_cast<size_t>(alignUp(length) - length), path);
+    }
+
+    static std::FILE* createPack(const std::string& path, std::uint32_t id,
+                                 std::uint32_t version) {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Cannot create pack: " + path);
+        }
+        PackFileHeader header{};
+        std::memcpy(header.magic, PackFormat::MAGIC, sizeof(header.magic));
+        header.version = version;
+        header.packId = id;
+        writeAll(file, &header, sizeof(header), path);
+        return file;
+    }
+
+    // Registers the records of one pack and returns the bytes they cover. Content is only
+    // verified for a pack that was still open, i.e. was being written when a crash hit.
+    std::uint64_t readPack(std::uint32_t id, const std::string& path, bool open, Pack& pack) {
+        auto mapping = std::make_shared<const MappedFile>(path, AccessPattern::Sequential);
+        PackFileHeader header;
+        if (mapping->size() < sizeof(header)) {
+            return 0;
+        }
+        std::memcpy(&header, mapping->data(), sizeof(header));
+        if (std::memcmp(header.magic, PackFormat::MAGIC, sizeof(header.magic)) != 0 ||
+            (header.version != PackFormat::VERSION &&
+             header.version != PackFormat::COMPRESSED_VERSION) ||
+            header.packId != id) {
+            return 0;
+        }
+
+        std::uint64_t offset = sizeof(header);
+        while (offset + sizeof(PackRecordHeader) <= mapping->size()) {
+            PackRecordHeader record;
+            std::memcpy(&record, mapping->data() + offset, sizeof(record));
+            std::uint64_t available = mapping->size() - offset;
+            bool compressed = (record.length & PackFormat::COMPRESSED) != 0;
+            std::uint64_t stored = record.length & ~PackFormat::COMPRESSED;
+            if (record.checksum != headerChecksum(record) || stored > available ||
+                recordBytes(stored) > available ||
+                (compressed && header.version != PackFormat::COMPRESSED_VERSION)) {
+                break;
+            }
+            const char* content = mapping->data() + offset + sizeof(record);
+            ContentKey key{record.keyHigh, record.keyLow};
+            std::uint64_t length = stored;
+            if (compressed) {
+                try {
+                    CompressedRecord blocks(content, static_cast<size_t>(stored));
+                    length = blocks.rawLength();
+                    if (open) {
+                        std::string raw(static_cast<size_t>(length), '\0');
+                        blocks.decodeAll(&raw[0]);
+                        if (ContentKey::of(raw) != key) {
+                            break;
+                        }
+                    }
+                } catch (const std::runtime_error&) {
+                    break;
+                }
+            } else if (open &&
+                       ContentKey::of(std::string_view(content, static_cast<size_t>(stored))) !=
+                           key) {
+                break;
+            }
+            auto [it, inserted] = entries.try_emplace(
+                key, Entry{id, offset + sizeof(record), stored, length, compressed, 0, false});
+            if (!inserted) {
+                pack.deadBytes += recordBytes(stored);
+            }
+            offset += recordBytes(stored);
+        }
+        if (offset == mapping->size()) {
+            pack.mapping = std::move(mapping);
+        }
+        return offset;
+    }
+
+    // Only a pack that was still open may have a torn tail; damage anywhere else means
+    // content was lost and the store cannot be trusted.
+    void scanPacks() {
+        std::vector<std::pair<std::uint32_t, std::filesystem::path>> found;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind(PackFormat::PREFIX, 0) != 0 ||
+                name.find(PackFormat::SUFFIX) == std::string::npos) {
+                continue;
+            }
+            size_t digits = std::strlen(PackFormat::PREFIX);
+            found.push_back({static_cast<std::uint32_t>(std::stoul(name.substr(digits))),
+                             entry.path()});
+        }
+        std::sort(found.begin(), found.end());
+
+        for (const auto& [id, path] : found) {
+            std::string name = path.filename().string();
+            bool open = name.size() > std::strlen(PackFormat::OPEN_SUFFIX) &&
+                        name.compare(name.size() - std::strlen(PackFormat::OPEN_SUFFIX),
+                                     std::string::npos, PackFormat::OPEN_SUFFIX) == 0;
+            std::uint64_t size = std::filesystem::file_size(path);
+            Pack pack{packPath(id, false), 0, 0, nullptr};
+            std::uint64_t valid = readPack(id, path.string(), open, pack);
+            if (valid < size && !open) {
+                throw std::runtime_error("Corrupt pack: " + path.string());
+            }
+            nextPackId = std::max(nextPackId, id + 1);
+            if (valid == 0) {
+                stats.truncatedBytes += size;
+                std::filesystem::remove(path);
+                continue;
+            }
+            if (valid < size) {
+                stats.truncatedBytes += size - valid;
+                std::filesystem::resize_file(path, valid);
+            }
+            if (open) {
+                FileSync::file(path.string());
+                std::filesystem::rename(path, pack.path);
+                FileSync::directory(directory.string());
+            }
+            pack.bytes = valid;
+            packs.emplace(id, std::move(pack));
+        }
+    }
+
+    // The caller holds `mutex` for all of the following.
+
+    void sealActive() {
+        if (!active) {
+            return;
+        }
+        Pack& pack = packs.at(activeId);
+        FileSync::flush(active);
+        std::fclose(active);
+        active = nullptr;
+        activeUnsynced = false;
+        std::string sealed = packPath(activeId, false);
+        std::filesystem::rename(pack.path, sealed);
+        pack.path = sealed;
+        FileSync::directory(directory.string());
+        scheduleCompaction(activeId);
+    }
+
+    void openActive(std::uint32_t version) {
+        sealActive();
+        std::uint32_t id = nextPackId++;
+        std::string path = packPath(id, true);
+        active = createPack(path, id, version);
+        activeId = id;
+        activeVersion = version;
+        packs.emplace(id, Pack{path, sizeof(PackFileHeader), 0, nullptr});
+        FileSync::directory(directory.string());
+    }
+
+    // Appends a record to the open pack and returns the offset of its content.
+    std::uint64_t append(const ContentKey& key, const char* data, std::uint64_t length,
+                         bool compressed) {
+        // Packs only get the compressed version when they may need it, so that stores
+        // without compression stay readable by older builds.
+        bool needsVersion = compressed && activeVersion != PackFormat::COMPRESSED_VERSION;
+        if (!active || packs.at(activeId).bytes >= options.packBytes || needsVersion) {
+            openActive(options.compression || compressed ? PackFormat::COMPRESSED_VERSION
+                                                         : PackFormat::VERSION);
+        }
+        Pack& pack = packs.at(activeId);
+        writeRecord(active, key, data, length, compressed, pack.path);
+        if (std::fflush(active) != 0) {
+            throw std::runtime_error("Cannot write pack: " + pack.path);
+        }
+        activeUnsynced = true;
+        std::uint64_t offset = pack.bytes + sizeof(PackRecordHeader);
+        pack.bytes += recordBytes(length);
+        stats.bytesWritten += recordBytes(length);
+        return offset;
+    }
+
+    // A mapping of pack `id` that covers its first `end` bytes. The open pack is mapped
+    // again whenever a read reaches past what the current mapping covers.
+    std::shared_ptr<const MappedFile> mappingFor(std::uint32_t id, std::uint64_t end) {
+        Pack& pack = packs.at(id);
+        if (!pack.mapping || pack.mapping->size() < end) {
+            pack.mapping = std::make_shared<const MappedFile>(pack.path);
+        }
+        return pack.mapping;
+    }
+
+    // True, and the content revived, if `key` is stored.
+    bool storedAlready(const ContentKey& key) {
+        auto found = entries.find(key);
+        if (found == entries.end()) {
+            return false;
+        }
+        revive(found->second);
+        ++stats.dedupHits;
+        return true;
+    }
+
+    Entry& entryFor(const ContentKey& key) {
+        auto found = entries.find(key);
+        if (found == entries.end()) {
+            throw std::runtime_error("Content not in pack store: " + key.toHex());
+        }
+        return found->second;
+    }
+
+    void markDead(Entry& entry) {
+        entry.dead = true;
+        packs.at(entry.pack).deadBytes += recordBytes(entry.stored);
+        scheduleCompaction(entry.pack);
+    }
+
+    void revive(Entry& entry) {
+        if (entry.dead) {
+            entry.dead = false;
+            packs.at(entry.pack).deadBytes -= recordBytes(entry.stored);
+        }
+    }
+
+    bool needsCompaction(std::uint32_t id) const {
+        if (id == activeId && active) {
+            return false;
+        }
+        const Pack& pack = packs.at(id);
+        std::uint64_t recordArea = pack.bytes - sizeof(PackFileHeader);
+        return pack.deadBytes > 0 &&
+               pack.deadBytes >= options.compactionThreshold * static_cast<double>(recordArea);
+    }
+
+    void scheduleCompaction(std::uint32_t id) {
+        if (!compactor || compactionQueued || !needsCompaction(id)) {
+            return;
+        }
+        compactionQueued = true;
+        compactor->submit([this]() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                compactionQueued = false;
+            }
+            try {
+                compact();
+            } catch (const std::exception&) {
+                // the pack stays as it is and is tried again on the next release
+            }
+        });
+    }
+
+    // Copies the live records of pack `id` into a new pack, then drops the old one.
+    // Only the bookkeeping at both ends runs under the store lock.
+    void compactPack(std::uint32_t id) {
+        std::vector<Record> live;
+        std::vector<ContentKey> dead;
+        std::shared_ptr<const MappedFile> mapping;
+        std::uint32_t newId = 0;
+        bool anyCompressed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!packs.count(id) || !needsCompaction(id)) {
+                return;
+            }
+            for (const auto& [key, entry] : entries) {
+                if (entry.pack == id) {
+                    if (entry.dead) {
+                        dead.push_back(key);
+                    } else {
+                        live.push_back({key, entry.offset, entry.stored, entry.compressed});
+                        anyCompressed = anyCompressed || entry.compressed;
+                    }
+                }
+            }
+            mapping = mappingFor(id, packs.at(id).bytes);
+            if (!live.empty()) {
+                newId = nextPackId++;
+            }
+        }
+
+        std::string oldPath;
+        std::string newPath = packPath(newId, false);
+        std::uint64_t newBytes = sizeof(PackFileHeader);
+        if (!live.empty()) {
+            std::string temporary = packPath(newId, true);
+            std::FILE* out = createPack(temporary, newId,
+                                        anyCompressed ? PackFormat::COMPRESSED_VERSION
+                                                      : PackFormat::VERSION);
+            try {
+                for (auto& record : live) {
+                    writeRecord(out, record.key, mapping->data() + record.offset, record.stored,
+                                record.compressed, temporary);
+                    record.offset = newBytes + sizeof(PackRecordHeader);
+                    newBytes += recordBytes(record.stored);
+                }
+                FileSync::flush(out);
+            } catch (...) {
+                std::fclose(out);
+                std::filesystem::remove(temporary);
+                throw;
+            }
+            std::fclose(out);
+            std::filesystem::rename(temporary, newPath);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Pack& old = packs.at(id);
+            if (!live.empty()) {
+                Pack moved{newPath, newBytes, 0, nullptr};
+                for (const auto& record : live) {
+                    Entry& entry = entries.at(record.key);
+                    entry.pack = newId;
+                    entry.offset = record.offset;
+                    if (entry.dead) {
+                        moved.deadBytes += recordBytes(entry.stored);
+                    }
+                }
+                packs.emplace(newId, std::move(moved));
+            }
+            for (const auto& key : dead) {
+                Entry& entry = entries.at(key);
+                if (entry.dead) {
+                    entries.erase(key);
+                } else {
+                    // Stored again while the copy ran: keep it, in the open pack.
+                    const char* content = mapping->data() + entry.offset;
+                    entry.offset = append(key, content, entry.stored, entry.compressed);
+                    entry.pack = activeId;
+                }
+            }
+            oldPath = old.path;
+            stats.bytesCompacted += newBytes - sizeof(PackFileHeader);
+            ++stats.packsCompacted;
+            packs.erase(id);
+        }
+        std::error_code ec;
+        std::filesystem::remove(oldPath, ec);
+        FileSync::directory(directory.string());
+    }
+
+  public:
+    explicit PackStore(const std::string& directory, PackStoreOptions options = {})
+        : directory(std::filesystem::absolute(directory)), options(options) {
+        std::filesystem::create_directories(this->directory);
+        scanPacks();
+        if (options.backgroundCompaction) {
+            compactor = std::make_unique<ThreadPool>(1);
+        }
+    }
+
+    PackStore(const PackStore&) = delete;
+    PackStore& operator=(const PackStore&) = delete;
+
+    ~PackStore() {
+        if (compactor) {
+            compactor->waitIdle();
+            compactor.reset();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        try {
+            sealActive();
+        } catch (const std::exception&) {
+            // left open; the next open verifies and seals it
+        }
+    }
+
+    std::string getDirectory() const { return directory.string(); }
+
+    // Stores `content` unless identical content is stored already; takes no reference.
+    // The record reaches the OS before this returns, and the disk once its pack is
+    // sealed or flush() or sync() is called.
+    ContentKey put(std::string_view content) {
+        ContentKey key = ContentKey::of(content);
+        if (!options.compression) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!storedAlready(key)) {
+                std::uint64_t offset = append(key, content.data(), content.size(), false);
+                entries.emplace(key, Entry{activeId, offset, content.size(), content.size(),
+                                           false, 0, false});
+            }
+            return key;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (storedAlready(key)) {
+                return key;
+            }
+        }
+        // Compressed without the lock; another put of the same content may win the race.
+        std::string record = CompressedRecord::encode(content, options.compressionBlockSize);
+        bool compressed = !record.empty();
+        std::string_view stored = compressed ? std::string_view(record) : content;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!storedAlready(key)) {
+            std::uint64_t offset = append(key, stored.data(), stored.size(), compressed);
+            entries.emplace(key, Entry{activeId, offset, stored.size(), content.size(),
+                                       compressed, 0, false});
+        }
+        return key;
+    }
+
+    bool contains(const ContentKey& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.count(key) > 0;
+    }
+
+    std::uint64_t sizeOf(const ContentKey& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entryFor(key).length;
+    }
+
+    // Zero-copy view of the content, valid for the lifetime of the handle. Compressed
+    // content is decoded into an owned buffer instead, on several threads when large.
+    MappedFile map(const ContentKey& key) {
+        Entry entry;
+        std::shared_ptr<const MappedFile> mapping;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entry = entryFor(key);
+            mapping = mappingFor(entry.pack, entry.offset + entry.stored);
+        }
+        if (!entry.compressed) {
+            return MappedFile(std::move(mapping), static_cast<size_t>(entry.offset),
+                              static_cast<size_t>(entry.length));
+        }
+        CompressedRecord blocks(mapping->data() + entry.offset,
+                                static_cast<size_t>(entry.stored));
+        std::vector<char> content(static_cast<size_t>(entry.length));
+        if (blocks.blockCount() >= CompressedRecord::PARALLEL_BLOCKS) {
+            std::call_once(decodersCreated,
+                           [this]() { decoders = std::make_unique<ThreadPool>(); });
+        }
+        blocks.decodeAll(content.data(), decoders.get());
+        return MappedFile(std::move(content));
+    }
+
+    // Copies up to `length` bytes of the content at `at`; returns how many there were.
+    // Of compressed content only the blocks in the range are decoded.
+    size_t read(const ContentKey& key, std::uint64_t at, char* destination, size_t length) {
+        Entry entry;
+        std::shared_ptr<const MappedFile> mapping;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entry = entryFor(key);
+            mapping = mappingFor(entry.pack, entry.offset + entry.stored);
+        }
+        const char* content = mapping->data() + entry.offset;
+        if (entry.compressed) {
+            return CompressedRecord(content, static_cast<size_t>(entry.stored))
+                .read(at, destination, length);
+        }
+        if (at >= entry.length) {
+            return 0;
+        }
+        length = static_cast<size_t>(std::min<std::uint64_t>(length, entry.length - at));
+        std::memcpy(destination, content + at, length);
+        return length;
+    }
+
+    void retain(const ContentKey& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = entryFor(key);
+        revive(entry);
+        ++entry.refs;
+    }
+
+    void release(const ContentKey& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = entryFor(key);
+        if (entry.refs > 0 && --entry.refs == 0) {
+            markDead(entry);
+        }
+    }
+
+    // Declares content nobody holds a reference to dead, such as content put() for a
+    // node that then could not be created.
+    void discard(const ContentKey& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Entry& entry = entryFor(key);
+        if (entry.refs == 0 && !entry.dead) {
+            markDead(entry);
+        }
+    }
+
+    // Declares every record nobody retained since the store was opened dead. Returns
+    // how many there were.
+    size_t dropUnclaimed() {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t dropped = 0;
+        for (auto& [key, entry] : entries) {
+            if (entry.refs == 0 && !entry.dead) {
+                markDead(entry);
+                ++dropped;
+            }
+        }
+        return dropped;
+    }
+
+    // Rewrites every sealed pack whose dead share reached the threshold, on the calling
+    // thread. Returns the number of packs rewritten.
+    size_t compact() {
+        std::lock_guard<std::mutex> compactionLock(compactionMutex);
+        std::vector<std::uint32_t> candidates;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& [id, pack] : packs) {
+                if (needsCompaction(id)) {
+                    candidates.push_back(id);
+                }
+            }
+        }
+        for (std::uint32_t id : candidates) {
+            compactPack(id);
+        }
+        return candidates.size();
+    }
+
+    // Pushes the records of the open pack to disk without sealing it, so that they can
+    // be referenced from a journal. Free when nothing was appended since the last call.
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (active && activeUnsynced) {
+            FileSync::flush(active);
+            activeUnsynced = false;
+        }
+    }
+
+    // Seals the open pack and pushes it to disk; the next put() starts a new pack.
+    void sync() {
+        std::lock_guard<std::mutex> lock(mutex);
+        sealActive();
+    }
+
+    // Waits for a background compaction that is queued or running.
+    void waitForCompaction() {
+        if (compactor) {
+            compactor->waitIdle();
+        }
+    }
+
+    PackStoreStats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        PackStoreStats result = stats;
+        result.packs = packs.size();
+        result.records = entries.size();
+        result.liveBytes = 0;
+        result.deadBytes = 0;
+        result.compressedRecords = 0;
+        result.bytesSaved = 0;
+        for (const auto& [key, entry] : entries) {
+            if (!entry.dead) {
+                result.liveBytes += entry.length;
+            }
+            if (entry.compressed) {
+                ++result.compressedRecords;
+                if (!entry.dead) {
+                    result.bytesSaved += entry.length - entry.stored;
+                }
+            }
+        }
+        for (const auto& [id, pack] : packs) {
+            result.deadBytes += pack.deadBytes;
+        }
+        return result;
+    }
+};
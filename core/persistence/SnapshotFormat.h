@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+
+// On-disk layout of a VFS snapshot. All fields are little-endian and naturally aligned,
+// sections start on 8-byte boundaries and refer to each other only by offsets relative
+// to their own start, so a mapped file is usable at any address.
+//
+//   SnapshotHeader
+//   SnapshotSection[sectionCount]
+//   section payloads
+struct SnapshotFormat {
+    static constexpr char MAGIC[8] = {'V', 'F', 'S', 'S', 'N', 'A', 'P', '\0'};
+    // Version 2 added lazy directories; version 1 files load unchanged.
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::uint32_t OLDEST_VERSION = 1;
+    static constexpr std::uint32_t NO_PARENT = 0xFFFFFFFF;
+    static constexpr std::uint32_t DIRECTORY_FLAG = 1;
+    // Archive directory or member; its path is the archive's.
+    static constexpr std::uint32_t ARCHIVE_FLAG = 2;
+    // File whose content is in the explorer's pack store; its path is the store's.
+    static constexpr std::uint32_t STORED_FLAG = 4;
+    // Stored file split into chunks; its key is the chunk recipe's.
+    static constexpr std::uint32_t CHUNKED_FLAG = 8;
+    // File that lived in memory; it is restored empty.
+    static constexpr std::uint32_t MEMORY_FLAG = 16;
+    // Directory mirrored lazily from the host; its path is the host directory.
+    static constexpr std::uint32_t LAZY_FLAG = 32;
+    static constexpr std::uint64_t ALIGNMENT = 8;
+};
+
+enum class SnapshotSectionKind : std::uint32_t {
+    Nodes = 1,           // SnapshotNode[nodeCount], preorder, root first
+    Strings = 2,         // deduplicated names and physical paths
+    NameMap = 3,         // optional FileHashMap image
+    NameTrie = 4,        // optional Trie image
+    ArchiveMembers = 5,  // SnapshotArchiveMember[] of the archive member files, in node order
+    StoredFiles = 6,     // SnapshotStoredFile[] of the stored and chunked files, in node order
+    LazyDirectories = 7, // SnapshotLazyDirectory[] of the lazy directories, in node order
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t sectionCount;
+    std::uint64_t nodeCount;
+    std::uint64_t journalSequence; // last journal record already reflected in the snapshot
+};
+
+struct SnapshotSection {
+    SnapshotSectionKind kind;
+    std::uint32_t reserved;
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint64_t checksum; // Hash64 of the payload
+};
+
+struct SnapshotNode {
+    std::uint64_t nameOffset;
+    std::uint64_t pathOffset;
+    std::uint64_t preLabel;
+    std::uint64_t postLabel;
+    std::int64_t createdAt;
+    std::uint32_t parent;
+    std::uint32_t nameLength;
+    std::uint32_t pathLength;
+    std::uint32_t flags;
+};
+
+// NameMap payload: SnapshotNameMapHeader, SnapshotNameMapEntry[entryCount], then
+// valueCount uint32 node indices.
+struct SnapshotNameMapHeader {
+    std::uint64_t bucketCount;
+    std::uint64_t entryCount;
+    std::uint64_t valueCount;
+};
+
+struct SnapshotNameMapEntry {
+    std::uint64_t keyOffset;
+    std::uint64_t firstValue;
+    std::uint64_t bucket;
+    std::uint32_t keyLength;
+    std::uint32_t valueCount;
+};
+
+// NameTrie payload: SnapshotTrieRecord[] in preorder, root first.
+struct SnapshotTrieRecord {
+    std::uint32_t count;
+    std::uint32_t childCount;
+    char ch;
+    char padding[3];
+};
+
+struct SnapshotArchiveMember {
+    std::uint64_t offset; // of the member's data within the archive
+    std::uint64_t size;
+    std::uint32_t node;
+    std::uint32_t reserved;
+};
+
+struct SnapshotStoredFile {
+    std::uint64_t keyHigh; // content key in the pack store
+    std::uint64_t keyLow;
+    std::uint32_t node;
+    std::uint32_t reserved;
+};
+
+// Mount options and state of a lazy directory. Only the children it had loaded are saved.
+struct SnapshotLazyDirectory {
+    std::int64_t revalidateAfterMs;
+    std::uint64_t prefetchSiblings;
+    std::uint32_t node;
+    std::uint32_t listed;
+};
+
+static_assert(sizeof(SnapshotHeader) == 32, "snapshot header layout");
+static_assert(sizeof(SnapshotSection) == 32, "snapshot section layout");
+static_assert(sizeof(SnapshotNode) == 56, "snapshot node layout");
+static_assert(sizeof(SnapshotNameMapEntry) == 32, "snapshot name map entry layout");
+static_assert(sizeof(SnapshotTrieRecord) == 12, "snapshot trie record layout");
+static_assert(sizeof(SnapshotArchiveMember) == 24, "snapshot archive member layout");
+static_assert(sizeof(SnapshotStoredFile) == 24, "snapshot stored file layout");
+static_assert(sizeof(SnapshotLazyDirectory) == 24, "snapshot lazy directory layout");
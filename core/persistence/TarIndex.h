@@ -0,0 +1,387 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../io/MappedFile.h"
+#include "../utils/Hash64.h"
+#include "ArchiveIndexFormat.h"
+
+struct TarMember {
+    std::string path;     // relative to the archive root, without "." or ".." components
+    std::uint64_t offset; // of the member's data within the archive
+    std::uint64_t size;
+    bool directory;
+};
+
+// Member table of a tar archive (ustar, GNU long names, pax path and size records). It
+// comes from one sequential pass over the headers, which seeks over member data, and is
+// persisted next to the archive so that later mounts only read the index back.
+class TarIndex {
+  private:
+    static constexpr size_t BLOCK = 512;
+    static constexpr size_t WINDOW_BYTES = 1 << 20;
+    static constexpr size_t SHORT_READ_BYTES = 4096;
+    static constexpr std::uint64_t SEEK_STRIDE = 64 << 10;
+    static constexpr std::uint64_t MAX_META_BYTES = 1 << 20; // long names and pax records
+
+    // Serves header blocks from a window read in one go, so the headers of small members
+    // come from a single sequential read. Once headers lie SEEK_STRIDE or more apart,
+    // only a short read is made at each, so the data of large members is seeked over.
+    class BlockReader {
+      private:
+        std::ifstream input;
+        std::uint64_t fileSize;
+        std::vector<char> window;
+        std::uint64_t windowStart = 0;
+        size_t windowSize = 0;
+        std::uint64_t lastOffset = 0;
+
+      public:
+        BlockReader(const std::string& path, std::uint64_t fileSize)
+            : input(path, std::ios::binary), fileSize(fileSize), window(WINDOW_BYTES) {
+            if (!input) {
+                throw std::runtime_error("Cannot open archive: " + path);
+            }
+        }
+
+        // The `length` bytes at `offset`, valid until the next call; nullptr past the end.
+        const char* at(std::uint64_t offset, size_t length) {
+            if (offset > fileSize || length > fileSize - offset) {
+                return nullptr;
+            }
+            bool farAhead = offset >= lastOffset + SEEK_STRIDE;
+            lastOffset = offset;
+            if (offset < windowStart || offset + length > windowStart + windowSize) {
+                input.clear();
+                input.seekg(static_cast<std::streamoff>(offset));
+                size_t batch = farAhead ? SHORT_READ_BYTES : WINDOW_BYTES;
+                size_t wanted = static_cast<size_t>(
+                    std::min<std::uint64_t>(std::max(length, batch), fileSize - offset));
+                window.resize(std::max(window.size(), wanted));
+                input.read(window.data(), static_cast<std::streamsize>(wanted));
+                windowStart = offset;
+                windowSize = static_cast<size_t>(input.gcount());
+                if (windowSize < length) {
+                    return nullptr;
+                }
+            }
+            return window.data() + (offset - windowStart);
+        }
+    };
+
+    static std::uint64_t paddedSize(std::uint64_t size) {
+        return (size + BLOCK - 1) / BLOCK * BLOCK;
+    }
+
+    static std::string field(const char* header, size_t offset, size_t width) {
+        const char* start = header + offset;
+        return std::string(start, std::find(start, start + width, '\0'));
+    }
+
+    // Octal, or base-256 when the high bit of the first byte is set (GNU, for sizes of
+    // 8 GiB and more).
+    static bool parseNumber(const char* field, size_t width, std::uint64_t& value) {
+        value = 0;
+        auto first = static_cast<unsigned char>(field[0]);
+        if (first & 0x80) {
+            value = first & 0x3F;
+            for (size_t i = 1; i < width; ++i) {
+                if (value >> 56) {
+                    return false;
+                }
+                value = value << 8 | static_cast<unsigned char>(field[i]);
+            }
+            return !(first & 0x40);
+        }
+        size_t i = 0;
+        while (i < width && (field[i] == ' ' || field[i] == '\0')) {
+            ++i;
+        }
+        for (; i < width && field[i] >= '0' && field[i] <= '7'; ++i) {
+            value = value << 3 | static_cast<std::uint64_t>(field[i] - '0');
+        }
+        return i == width || field[i] == ' ' || field[i] == '\0';
+    }
+
+    static bool isZeroBlock(const char* header) {
+        return std::all_of(header, header + BLOCK, [](char c) { return c == '\0'; });
+    }
+
+    // The stored sum is over the header with its own field read as spaces; some old
+    // writers summed signed chars.
+    static bool checksumMatches(const char* header) {
+        std::uint64_t stored;
+        if (!parseNumber(header + 148, 8, stored)) {
+            return false;
+        }
+        std::uint64_t sum = 0;
+        std::int64_t signedSum = 0;
+        for (size_t i = 0; i < BLOCK; ++i) {
+            char c = i >= 148 && i < 156 ? ' ' : header[i];
+            sum += static_cast<unsigned char>(c);
+            signedSum += static_cast<signed char>(c);
+        }
+        return stored == sum || static_cast<std::int64_t>(stored) == signedSum;
+    }
+
+    static bool parseDecimal(std::string_view text, std::uint64_t& value) {
+        value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            value = value * 10 + static_cast<std::uint64_t>(c - '0');
+        }
+        return !text.empty();
+    }
+
+    // Records are "<length> <key>=<value>\n".
+    static void parsePax(std::string_view records, std::string& path, std::uint64_t& size,
+                         bool& hasSize) {
+        while (!records.empty()) {
+            size_t space = records.find(' ');
+            if (space == std::string_view::npos) {
+                return;
+            }
+            std::uint64_t length;
+            if (!parseDecimal(records.substr(0, space), length) || length <= space + 1 ||
+                length > records.size()) {
+                return;
+            }
+            std::string_view record =
+                records.substr(space + 1, static_cast<size_t>(length) - space - 2);
+            size_t equals = record.find('=');
+            if (equals != std::string_view::npos) {
+                std::string_view key = record.substr(0, equals);
+                std::string_view value = record.substr(equals + 1);
+                if (key == "path") {
+                    path = std::string(value);
+                } else if (key == "size") {
+                    hasSize = parseDecimal(value, size);
+                }
+            }
+            records.remove_prefix(static_cast<size_t>(length));
+        }
+    }
+
+    // `raw` without "." and empty components; empty if it names the archive root or
+    // climbs out of it with "..", which no member is allowed to do.
+    static std::string normalizeMemberPath(const std::string& raw) {
+        std::string result;
+        size_t start = 0;
+        while (start <= raw.size()) {
+            size_t end = std::min(raw.find('/', start), raw.size());
+            std::string_view part(raw.data() + start, end - start);
+            if (part == "..") {
+                return "";
+            }
+            if (!part.empty() && part != ".") {
+                if (!result.empty()) {
+                    result += '/';
+                }
+                result += part;
+            }
+            start = end + 1;
+        }
+        return result;
+    }
+
+    static std::int64_t modificationStamp(const std::string& path) {
+        return static_cast<std::int64_t>(
+            std::filesystem::last_write_time(path).time_since_epoch().count());
+    }
+
+    static bool loadIndex(const std::string& indexPath, std::uint64_t archiveSize,
+                          std::int64_t archiveModified, std::vector<TarMember>& members) {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(indexPath, ec)) {
+            return false;
+        }
+        MappedFile file(indexPath, AccessPattern::Sequential);
+        ArchiveIndexHeader header;
+        if (file.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        std::uint64_t payload = file.size() - sizeof(header);
+        if (std::memcmp(header.magic, ArchiveIndexFormat::MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != ArchiveIndexFormat::VERSION || header.archiveSize != archiveSize ||
+            header.archiveModified != archiveModified ||
+            header.entryCount > payload / sizeof(ArchiveIndexEntry) ||
+            header.entryCount * sizeof(ArchiveIndexEntry) + header.pathBytes != payload ||
+            Hash64::compute(file.data() + sizeof(header), payload) != header.checksum) {
+            return false;
+        }
+
+        const char* entries = file.data() + sizeof(header);
+        std::string_view paths(entries + header.entryCount * sizeof(ArchiveIndexEntry),
+                               header.pathBytes);
+        members.reserve(header.entryCount);
+        for (std::uint64_t i = 0; i < header.entryCount; ++i) {
+            ArchiveIndexEntry entry;
+            std::memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+            if (entry.pathOffset > paths.size() ||
+                entry.pathLength > paths.size() - entry.pathOffset ||
+                entry.dataOffset > archiveSize || entry.size > archiveSize - entry.dataOffset) {
+                members.clear();
+                return false;
+            }
+            members.push_back({std::string(paths.substr(entry.pathOffset, entry.pathLength)),
+                               entry.dataOffset, entry.size,
+                               (entry.flags & ArchiveIndexFormat::DIRECTORY_FLAG) != 0});
+        }
+        return true;
+    }
+
+    // Written next to the target and renamed, so a reader never sees a torn index.
+    static void saveIndex(const std::string& indexPath, std::uint64_t archiveSize,
+                          std::int64_t archiveModified, const std::vector<TarMember>& members) {
+        std::string payload;
+        std::string paths;
+        payload.reserve(members.size() * sizeof(ArchiveIndexEntry));
+        for (const auto& member : members) {
+            ArchiveIndexEntry entry{paths.size(), member.offset, member.size,
+                                    static_cast<std::uint32_t>(member.path.size()),
+                                    member.directory ? ArchiveIndexFormat::DIRECTORY_FLAG : 0};
+            payload.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            paths += member.path;
+        }
+        payload += paths;
+
+        ArchiveIndexHeader header{};
+        std::memcpy(header.magic, ArchiveIndexFormat::MAGIC, sizeof(header.magic));
+        header.version = ArchiveIndexFormat::VERSION;
+        header.archiveSize = archiveSize;
+        header.archiveModified = archiveModified;
+        header.entryCount = members.size();
+        header.pathBytes = paths.size();
+        header.checksum = Hash64::compute(payload);
+
+        std::string temporary = indexPath + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+            if (!out.flush()) {
+                throw std::runtime_error("Cannot write archive index: " + indexPath);
+            }
+        }
+        std::filesystem::rename(temporary, indexPath);
+    }
+
+  public:
+    static std::string indexPath(const std::string& archivePath) {
+        return archivePath + ArchiveIndexFormat::SUFFIX;
+    }
+
+    // Reads every header of the archive. A member listed twice keeps its last entry,
+    // as when extracting; links and special files are left out.
+    static std::vector<TarMember> scan(const std::string& archivePath) {
+        std::uint64_t fileSize = std::filesystem::file_size(archivePath);
+        BlockReader reader(archivePath, fileSize);
+        std::vector<TarMember> members;
+        std::unordered_map<std::string, size_t> position;
+        std::string longName;
+        std::string paxPath;
+        std::uint64_t paxSize = 0;
+        bool hasPaxSize = false;
+
+        std::uint64_t offset = 0;
+        while (const char* header = reader.at(offset, BLOCK)) {
+            if (isZeroBlock(header)) {
+                break;
+            }
+            std::uint64_t size;
+            if (!checksumMatches(header) || !parseNumber(header + 124, 12, size)) {
+                throw std::runtime_error(offset == 0 ? "Not a tar archive: " + archivePath
+                                                     : "Corrupt tar archive: bad header at " +
+                                                           std::to_string(offset));
+            }
+            char type = header[156];
+            std::string name = field(header, 0, 100);
+            if (std::memcmp(header + 257, "ustar\0", 6) == 0 && header[345] != '\0') {
+                name = field(header, 345, 155) + "/" + name;
+            }
+            std::uint64_t data = offset + BLOCK;
+
+            if (type == 'L' || type == 'x') {
+                const char* content = size <= MAX_META_BYTES
+                                          ? reader.at(data, static_cast<size_t>(size))
+                                          : nullptr;
+                if (!content) {
+                    throw std::runtime_error("Corrupt tar archive: bad extended header at " +
+                                             std::to_string(offset));
+                }
+                std::string text(content, static_cast<size_t>(size));
+                if (type == 'L') {
+                    longName = text.substr(0, text.find('\0'));
+                } else {
+                    parsePax(text, paxPath, paxSize, hasPaxSize);
+                }
+            } else if (type != 'g' && type != 'K') {
+                if (hasPaxSize) {
+                    size = paxSize;
+                }
+                std::string raw = !paxPath.empty() ? paxPath : !longName.empty() ? longName : name;
+                bool regular = type == '0' || type == '\0' || type == '7';
+                bool directory = type == '5' || (regular && !raw.empty() && raw.back() == '/');
+                std::string path = normalizeMemberPath(raw);
+                if (data > fileSize || size > fileSize - data) {
+                    throw std::runtime_error("Corrupt tar archive: truncated member " + raw);
+                }
+                if ((regular || directory) && !path.empty()) {
+                    TarMember member{path, data, directory ? 0 : size, directory};
+                    auto [it, inserted] = position.try_emplace(path, members.size());
+                    if (inserted) {
+                        members.push_back(std::move(member));
+                    } else {
+                        members[it->second] = std::move(member);
+                    }
+                }
+                longName.clear();
+                paxPath.clear();
+                hasPaxSize = false;
+            }
+            // Any member type may claim a size; one past the end could wrap the offset.
+            if (data > fileSize || size > fileSize - data) {
+                throw std::runtime_error("Corrupt tar archive: truncated member at " +
+                                         std::to_string(offset));
+            }
+            std::uint64_t next = data + paddedSize(size);
+            if (next <= offset) {
+                throw std::runtime_error("Corrupt tar archive: bad header at " +
+                                         std::to_string(offset));
+            }
+            offset = next;
+        }
+        return members;
+    }
+
+    // Members from the persisted index while it matches the archive's size and
+    // modification time, from a scan otherwise, which then replaces the index. A
+    // directory that cannot take the index only costs the next mount another scan.
+    static std::vector<TarMember> load(const std::string& archivePath, bool& indexReused) {
+        std::uint64_t archiveSize = std::filesystem::file_size(archivePath);
+        std::int64_t archiveModified = modificationStamp(archivePath);
+        std::string index = indexPath(archivePath);
+        std::vector<TarMember> members;
+        indexReused = loadIndex(index, archiveSize, archiveModified, members);
+        if (indexReused) {
+            return members;
+        }
+        members = scan(archivePath);
+        try {
+            saveIndex(index, archiveSize, archiveModified, members);
+        } catch (const std::exception&) {
+        }
+        return members;
+    }
+};
@@ -0,0 +1,631 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../domain/VFSExplorer.h"
+#include "../io/MappedFile.h"
+#include "../search/BulkIndexBuilder.h"
+#include "../search/MappedNameIndex.h"
+#include "../utils/FileSync.h"
+#include "../utils/Hash64.h"
+#include "SnapshotFormat.h"
+
+struct SnapshotOptions {
+    bool includeIndexes = true;
+    bool verifyChecksums = true;
+    std::uint64_t journalSequence = 0; // stored by save()
+    std::string indexImagePath;        // written by save(), mapped by load() when current
+};
+
+struct SnapshotInfo {
+    std::uint64_t nodeCount;
+    std::uint64_t bytes;
+    bool indexesIncluded;
+    std::uint64_t journalSequence;
+    std::uint64_t treeVersion; // checksum of the node records, ties index images to a tree
+    bool indexImageMapped;
+};
+
+// Saves and restores the whole VFSExplorer state as one binary file (see SnapshotFormat).
+// Loading maps the file and rebuilds the tree in a single preorder pass: no text parsing,
+// no path resolution, no stat per file, and labels and descendant counts come from the
+// file instead of being recomputed. When the snapshot carries index images, the name map
+// and trie are restored structurally instead of re-inserting every name. With a separate
+// index image (SnapshotOptions::indexImagePath) they are not restored at all: lookups go
+// to the mapped image and only later changes land in the explorer's own indexes.
+class VFSSnapshot {
+  private:
+    static constexpr std::uint64_t MAX_BUCKETS_PER_NODE = 4;
+    static constexpr std::uint64_t MIN_BUCKET_ALLOWANCE = 64;
+
+    class StringPool {
+      private:
+        std::string data;
+        std::unordered_map<std::string, std::uint64_t> offsets;
+
+      public:
+        std::uint64_t intern(const std::string& text) {
+            auto [it, inserted] = offsets.try_emplace(text, data.size());
+            if (inserted) {
+                data += text;
+            }
+            return it->second;
+        }
+
+        const std::string& bytes() const { return data; }
+    };
+
+    struct PendingSection {
+        SnapshotSectionKind kind;
+        std::string payload;
+    };
+
+    template <typename T>
+    static void appendRaw(std::string& out, const T* values, size_t count) {
+        out.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+    }
+
+    static std::uint64_t alignUp(std::uint64_t offset) {
+        return (offset + SnapshotFormat::ALIGNMENT - 1) & ~(SnapshotFormat::ALIGNMENT - 1);
+    }
+
+    static std::uint32_t checkedLength(size_t length) {
+        if (length > 0xFFFFFFFFu) {
+            throw std::runtime_error("Snapshot entry too large");
+        }
+        return static_cast<std::uint32_t>(length);
+    }
+
+    // Returns the checksum of the first section, the node records.
+    static std::uint64_t writeFile(const std::string& path,
+                                   const std::vector<PendingSection>& sections,
+                                   std::uint64_t nodeCount, std::uint64_t journalSequence) {
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SnapshotFormat::MAGIC, sizeof(header.magic));
+        header.version = SnapshotFormat::VERSION;
+        header.sectionCount = static_cast<std::uint32_t>(sections.size());
+        header.nodeCount = nodeCount;
+        header.journalSequence = journalSequence;
+
+        std::vector<SnapshotSection> table;
+        std::uint64_t offset = alignUp(sizeof(header) + sections.size() * sizeof(SnapshotSection));
+        for (const auto& section : sections) {
+            table.push_back({section.kind, 0, offset, section.payload.size(),
+                             Hash64::compute(section.payload)});
+            offset = alignUp(offset + section.payload.size());
+        }
+
+        // Written next to the target and renamed, so a crash never leaves a torn snapshot.
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Cannot write snapshot: " + path);
+            }
+            std::string prefix;
+            appendRaw(prefix, &header, 1);
+            appendRaw(prefix, table.data(), table.size());
+            prefix.resize(table.empty() ? prefix.size() : table.front().offset, '\0');
+            out.write(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+            for (size_t i = 0; i < sections.size(); ++i) {
+                const std::string& payload = sections[i].payload;
+                out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                std::uint64_t end = table[i].offset + payload.size();
+                std::string padding(alignUp(end) - end, '\0');
+                out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            }
+            if (!out.flush()) {
+                throw std::runtime_error("Cannot write snapshot: " + path);
+            }
+        }
+        FileSync::file(temporary);
+        std::filesystem::rename(temporary, path);
+        std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        FileSync::directory(parent.empty() ? "." : parent.string());
+        return table.front().checksum;
+    }
+
+    struct MappedSections {
+        const SnapshotSection* nodes = nullptr;
+        const SnapshotSection* strings = nullptr;
+        const SnapshotSection* nameMap = nullptr;
+        const SnapshotSection* nameTrie = nullptr;
+        const SnapshotSection* archiveMembers = nullptr;
+        const SnapshotSection* storedFiles = nullptr;
+        const SnapshotSection* lazyDirectories = nullptr;
+    };
+
+    static MappedSections readTable(const MappedFile& file, const SnapshotHeader& header,
+                                    bool verifyChecksums) {
+        std::uint64_t tableEnd =
+            sizeof(SnapshotHeader) + std::uint64_t(header.sectionCount) * sizeof(SnapshotSection);
+        if (tableEnd > file.size()) {
+            throw std::runtime_error("Corrupt snapshot: truncated section table");
+        }
+
+        MappedSections found;
+        auto* table = reinterpret_cast<const SnapshotSection*>(file.data() + sizeof(header));
+        for (std::uint32_t i = 0; i < header.sectionCount; ++i) {
+            const SnapshotSection& section = table[i];
+            if (section.offset % SnapshotFormat::ALIGNMENT != 0 || section.offset > file.size() ||
+                section.size > file.size() - section.offset) {
+                throw std::runtime_error("Corrupt snapshot: section out of bounds");
+            }
+            if (verifyChecksums &&
+                Hash64::compute(file.data() + section.offset, section.size) != section.checksum) {
+                throw std::runtime_error("Corrupt snapshot: checksum mismatch");
+            }
+            switch (section.kind) {
+            case SnapshotSectionKind::Nodes:
+                found.nodes = &section;
+                break;
+            case SnapshotSectionKind::Strings:
+                found.strings = &section;
+                break;
+            case SnapshotSectionKind::NameMap:
+                found.nameMap = &section;
+                break;
+            case SnapshotSectionKind::NameTrie:
+                found.nameTrie = &section;
+                break;
+            case SnapshotSectionKind::ArchiveMembers:
+                found.archiveMembers = &section;
+                break;
+            case SnapshotSectionKind::StoredFiles:
+                found.storedFiles = &section;
+                break;
+            case SnapshotSectionKind::LazyDirectories:
+                found.lazyDirectories = &section;
+                break;
+            }
+        }
+        if (!found.nodes || !found.strings) {
+            throw std::runtime_error("Corrupt snapshot: missing node or string section");
+        }
+        return found;
+    }
+
+    // The array of T a section holds; empty when the snapshot has no such section.
+    template <typename T>
+    static std::pair<const T*, size_t> recordsOf(const MappedFile& file,
+                                                 const SnapshotSection* section,
+                                                 const char* what) {
+        if (!section) {
+            return {nullptr, 0};
+        }
+        if (section->size % sizeof(T) != 0) {
+            throw std::runtime_error(std::string("Corrupt snapshot: truncated ") + what);
+        }
+        return {reinterpret_cast<const T*>(file.data() + section->offset),
+                static_cast<size_t>(section->size / sizeof(T))};
+    }
+
+    // A table that outgrew the tree by this much (after mass deletions) is cheaper to
+    // rebuild than to restore bucket by bucket.
+    static bool plausibleNameMap(const MappedFile& file, const SnapshotSection& section,
+                                 std::uint64_t nodeCount) {
+        SnapshotNameMapHeader header;
+        if (section.size < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, file.data() + section.offset, sizeof(header));
+        return header.bucketCount <= MAX_BUCKETS_PER_NODE * nodeCount + MIN_BUCKET_ALLOWANCE;
+    }
+
+    static void restoreNameMap(const MappedFile& file, const SnapshotSection& section,
+                               std::string_view strings, const std::vector<VFSNode*>& nodes,
+                               FileHashMap& map) {
+        const char* base = file.data() + section.offset;
+        SnapshotNameMapHeader header;
+        if (section.size < sizeof(header)) {
+            throw std::runtime_error("Corrupt snapshot: truncated name map");
+        }
+        std::memcpy(&header, base, sizeof(header));
+        std::uint64_t needed = sizeof(header) + header.entryCount * sizeof(SnapshotNameMapEntry) +
+                               header.valueCount * sizeof(std::uint32_t);
+        if (header.entryCount > section.size || header.valueCount > section.size ||
+            needed > section.size || header.bucketCount == 0) {
+            throw std::runtime_error("Corrupt snapshot: truncated name map");
+        }
+
+        auto* entries = reinterpret_cast<const SnapshotNameMapEntry*>(base + sizeof(header));
+        auto* values = reinterpret_cast<const std::uint32_t*>(entries + header.entryCount);
+        map.resetBuckets(header.bucketCount);
+        for (std::uint64_t i = 0; i < header.entryCount; ++i) {
+            const SnapshotNameMapEntry& entry = entries[i];
+            if (entry.bucket >= header.bucketCount || entry.firstValue > header.valueCount ||
+                entry.valueCount > header.valueCount - entry.firstValue ||
+                entry.keyOffset > strings.size() ||
+                entry.keyLength > strings.size() - entry.keyOffset) {
+                throw std::runtime_error("Corrupt snapshot: bad name map entry");
+            }
+            std::vector<VFSNode*> targets;
+            targets.reserve(entry.valueCount);
+            for (std::uint32_t v = 0; v < entry.valueCount; ++v) {
+                std::uint32_t index = values[entry.firstValue + v];
+                if (index >= nodes.size()) {
+                    throw std::runtime_error("Corrupt snapshot: bad name map entry");
+                }
+                targets.push_back(nodes[index]);
+            }
+            map.restoreEntry(entry.bucket,
+                             std::string(strings.substr(entry.keyOffset, entry.keyLength)),
+                             std::move(targets));
+        }
+    }
+
+    static void restoreTrie(const MappedFile& file, const SnapshotSection& section,
+                            FileNameTrie& trie) {
+        if (section.size % sizeof(SnapshotTrieRecord) != 0) {
+            throw std::runtime_error("Corrupt snapshot: truncated trie");
+        }
+        auto* records = reinterpret_cast<const SnapshotTrieRecord*>(file.data() + section.offset);
+        size_t count = section.size / sizeof(SnapshotTrieRecord);
+        std::vector<Trie::FlatNode> flat;
+        flat.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            flat.push_back({records[i].ch, records[i].count, records[i].childCount});
+        }
+        trie.restore(flat);
+    }
+
+    // A missing, damaged or stale image is not an error: the indexes come from the
+    // snapshot instead.
+    static std::unique_ptr<MappedNameIndex> openImage(const SnapshotOptions& options,
+                                                      std::uint64_t treeVersion,
+                                                      std::uint64_t nodeCount) {
+        if (options.indexImagePath.empty() || !std::filesystem::exists(options.indexImagePath)) {
+            return nullptr;
+        }
+        try {
+            auto image =
+                std::make_unique<MappedNameIndex>(options.indexImagePath, options.verifyChecksums);
+            if (image->treeVersion() == treeVersion && image->nodeCount() == nodeCount) {
+                return image;
+            }
+        } catch (const std::runtime_error&) {
+        }
+        return nullptr;
+    }
+
+  public:
+    static SnapshotInfo save(const VFSExplorer& explorer, const std::string& path,
+                             const SnapshotOptions& options = {}) {
+        // Index sections mirror searchMap and trie, which hold only part of the names
+        // while an image is mapped.
+        bool withIndexes = options.includeIndexes && !explorer.nameImage;
+        bool withImage = !options.indexImagePath.empty();
+        StringPool strings;
+        std::vector<SnapshotNode> records;
+        std::unordered_map<const VFSNode*, std::uint32_t> indexOf;
+        std::unordered_map<std::string, std::vector<std::uint32_t>> imageNames;
+        std::vector<SnapshotArchiveMember> archiveMembers;
+        std::vector<SnapshotStoredFile> storedFiles;
+        std::vector<SnapshotLazyDirectory> lazyDirectories;
+
+        std::vector<std::pair<const VFSNode*, std::uint32_t>> stack{
+            {explorer.root.get(), SnapshotFormat::NO_PARENT}};
+        while (!stack.empty()) {
+            auto [node, parent] = stack.back();
+            stack.pop_back();
+
+            auto index = static_cast<std::uint32_t>(records.size());
+            if (records.size() >= SnapshotFormat::NO_PARENT) {
+                throw std::runtime_error("Too many nodes for a snapshot");
+            }
+            if (withIndexes) {
+                indexOf.emplace(node, index);
+            }
+            if (withImage && index > 0) {
+                imageNames[node->getName()].push_back(index);
+            }
+
+            SnapshotNode record{};
+            record.parent = parent;
+            record.nameOffset = strings.intern(node->getName());
+            record.nameLength = checkedLength(node->getName().size());
+            record.preLabel = node->getPreLabel();
+            record.postLabel = node->getPostLabel();
+            record.createdAt = static_cast<std::int64_t>(node->getCreationTime());
+
+            if (node->isDirectory()) {
+                record.flags = SnapshotFormat::DIRECTORY_FLAG;
+                if (auto* archive = dynamic_cast<const ArchiveDirectory*>(node)) {
+                    record.flags |= SnapshotFormat::ARCHIVE_FLAG;
+                    record.pathOffset = strings.intern(archive->getArchivePath());
+                    record.pathLength = checkedLength(archive->getArchivePath().size());
+                }
+                auto* dir = static_cast<const VFSDirectory*>(node);
+                if (const LazyListing* lazy = dir->getLazyListing()) {
+                    record.flags |= SnapshotFormat::LAZY_FLAG;
+                    record.pathOffset = strings.intern(lazy->hostPath);
+                    record.pathLength = checkedLength(lazy->hostPath.size());
+                    lazyDirectories.push_back({lazy->options.revalidateAfter.count(),
+                                               lazy->options.prefetchSiblings, index,
+                                               lazy->listed ? 1u : 0u});
+                }
+                // Saving a lazy mount must not list the parts of it nobody opened.
+                const auto& children = dir->getLoadedChildren();
+                for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                    stack.push_back({it->get(), index});
+                }
+            } else {
+                const std::string physicalPath =
+                    static_cast<const VFSFile*>(node)->getPhysicalPath();
+                record.pathOffset = strings.intern(physicalPath);
+                record.pathLength = checkedLength(physicalPath.size());
+                if (static_cast<const VFSFile*>(node)->isArchiveMember()) {
+                    auto* member = static_cast<const ArchiveMemberFile*>(node);
+                    record.flags = SnapshotFormat::ARCHIVE_FLAG;
+                    archiveMembers.push_back(
+                        {member->getArchiveOffset(), member->getSize(), index, 0});
+                } else if (auto* stored = dynamic_cast<const StoredFile*>(node)) {
+                    record.flags = SnapshotFormat::STORED_FLAG;
+                    const ContentKey& key = stored->getContentKey();
+                    storedFiles.push_back({key.high, key.low, index, 0});
+                } else if (auto* chunked = dynamic_cast<const ChunkedFile*>(node)) {
+                    record.flags = SnapshotFormat::STORED_FLAG | SnapshotFormat::CHUNKED_FLAG;
+                    const ContentKey& key = chunked->getRecipeKey();
+                    storedFiles.push_back({key.high, key.low, index, 0});
+                } else if (dynamic_cast<const MemoryFile*>(node)) {
+                    record.flags = SnapshotFormat::MEMORY_FLAG;
+                }
+            }
+            records.push_back(record);
+        }
+
+        std::vector<PendingSection> sections;
+        sections.push_back({SnapshotSectionKind::Nodes, {}});
+        appendRaw(sections.back().payload, records.data(), records.size());
+
+        if (withIndexes) {
+            SnapshotNameMapHeader header{explorer.searchMap.bucketCount(), 0, 0};
+            std::vector<SnapshotNameMapEntry> entries;
+            std::vector<std::uint32_t> values;
+            explorer.searchMap.forEachEntry([&](size_t bucket, const std::string& key,
+                                                const std::vector<VFSNode*>& nodes) {
+                entries.push_back({strings.intern(key), values.size(), bucket,
+                                   checkedLength(key.size()), checkedLength(nodes.size())});
+                for (VFSNode* node : nodes) {
+                    values.push_back(indexOf.at(node));
+                }
+            });
+            header.entryCount = entries.size();
+            header.valueCount = values.size();
+
+            sections.push_back({SnapshotSectionKind::NameMap, {}});
+            appendRaw(sections.back().payload, &header, 1);
+            appendRaw(sections.back().payload, entries.data(), entries.size());
+            appendRaw(sections.back().payload, values.data(), values.size());
+
+            std::vector<SnapshotTrieRecord> trieRecords;
+            for (const auto& flat : explorer.trie.flatten()) {
+                trieRecords.push_back({checkedLength(flat.count), checkedLength(flat.child_count),
+                                       flat.ch, {}});
+            }
+            sections.push_back({SnapshotSectionKind::NameTrie, {}});
+            appendRaw(sections.back().payload, trieRecords.data(), trieRecords.size());
+        }
+
+        if (!archiveMembers.empty()) {
+            sections.push_back({SnapshotSectionKind::ArchiveMembers, {}});
+            appendRaw(sections.back().payload, archiveMembers.data(), archiveMembers.size());
+        }
+        if (!storedFiles.empty()) {
+            sections.push_back({SnapshotSectionKind::StoredFiles, {}});
+            appendRaw(sections.back().payload, storedFiles.data(), storedFiles.size());
+        }
+        if (!lazyDirectories.empty()) {
+            sections.push_back({SnapshotSectionKind::LazyDirectories, {}});
+            appendRaw(sections.back().payload, lazyDirectories.data(), lazyDirectories.size());
+        }
+        sections.push_back({SnapshotSectionKind::Strings, strings.bytes()});
+        std::uint64_t treeVersion =
+            writeFile(path, sections, records.size(), options.journalSequence);
+        if (withImage) {
+            MappedNameIndex::write(options.indexImagePath, treeVersion, records.size(),
+                                   MappedNameIndex::Entries(imageNames.begin(), imageNames.end()));
+        }
+        return {records.size(), std::filesystem::file_size(path), withIndexes,
+                options.journalSequence, treeVersion, false};
+    }
+
+    // Replaces the explorer's whole state. The explorer is left untouched if the
+    // snapshot is unreadable or corrupt.
+    static SnapshotInfo load(VFSExplorer& explorer, const std::string& path,
+                             const SnapshotOptions& options = {}) {
+        MappedFile file(path, AccessPattern::Sequential);
+        SnapshotHeader header;
+        if (file.size() < sizeof(header)) {
+            throw std::runtime_error("Corrupt snapshot: truncated header");
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, SnapshotFormat::MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("Not a VFS snapshot: " + path);
+        }
+        if (header.version < SnapshotFormat::OLDEST_VERSION ||
+            header.version > SnapshotFormat::VERSION) {
+            throw std::runtime_error("Unsupported snapshot version " +
+                                     std::to_string(header.version));
+        }
+
+        MappedSections sections = readTable(file, header, options.verifyChecksums);
+        if (header.nodeCount == 0 || header.nodeCount > sections.nodes->size ||
+            sections.nodes->size != header.nodeCount * sizeof(SnapshotNode)) {
+            throw std::runtime_error("Corrupt snapshot: node count mismatch");
+        }
+        auto* records = reinterpret_cast<const SnapshotNode*>(file.data() + sections.nodes->offset);
+        std::string_view strings(file.data() + sections.strings->offset, sections.strings->size);
+        auto text = [&strings](std::uint64_t offset, std::uint32_t length) {
+            if (offset > strings.size() || length > strings.size() - offset) {
+                throw std::runtime_error("Corrupt snapshot: string out of bounds");
+            }
+            return std::string(strings.substr(offset, length));
+        };
+
+        std::unique_ptr<MappedNameIndex> image =
+            openImage(options, sections.nodes->checksum, header.nodeCount);
+        bool withIndexes = !image && options.includeIndexes && sections.nameMap &&
+                           sections.nameTrie &&
+                           plausibleNameMap(file, *sections.nameMap, header.nodeCount);
+        FileHashMap searchMap;
+        FileHashMap physicalMap;
+        FileNameTrie trie;
+        std::vector<VFSNode*> nodes(header.nodeCount);
+        auto [archiveMembers, archiveMemberCount] = recordsOf<SnapshotArchiveMember>(
+            file, sections.archiveMembers, "archive members");
+        size_t nextArchiveMember = 0;
+        auto [storedFiles, storedFileCount] =
+            recordsOf<SnapshotStoredFile>(file, sections.storedFiles, "stored files");
+        size_t nextStoredFile = 0;
+        auto [lazyDirectories, lazyDirectoryCount] = recordsOf<SnapshotLazyDirectory>(
+            file, sections.lazyDirectories, "lazy directories");
+        size_t nextLazyDirectory = 0;
+        bool prefetching = false;
+        if (storedFileCount > 0 && !explorer.packStore) {
+            throw std::runtime_error("Snapshot has stored files but no pack store is attached");
+        }
+
+        const SnapshotNode& rootRecord = records[0];
+        if (rootRecord.parent != SnapshotFormat::NO_PARENT ||
+            !(rootRecord.flags & SnapshotFormat::DIRECTORY_FLAG)) {
+            throw std::runtime_error("Corrupt snapshot: bad root");
+        }
+        auto root =
+            std::make_unique<VFSDirectory>(text(rootRecord.nameOffset, rootRecord.nameLength));
+        root->setLabels(rootRecord.preLabel, rootRecord.postLabel);
+        root->setCreationTime(static_cast<std::time_t>(rootRecord.createdAt));
+        nodes[0] = root.get();
+
+        // Directories stay detached until their last descendant is in, so add() never
+        // walks further than one parent to update descendant counts.
+        std::vector<std::pair<std::uint32_t, std::unique_ptr<VFSDirectory>>> open;
+        VFSDirectory* openTop = root.get();
+        std::uint32_t openTopIndex = 0;
+        auto closeTop = [&]() {
+            std::unique_ptr<VFSDirectory> finished = std::move(open.back().second);
+            open.pop_back();
+            openTop = open.empty() ? root.get() : open.back().second.get();
+            openTopIndex = open.empty() ? 0 : open.back().first;
+            openTop->add(std::move(finished));
+        };
+
+        for (std::uint64_t i = 1; i < header.nodeCount; ++i) {
+            const SnapshotNode& record = records[i];
+            while (openTopIndex != record.parent && !open.empty()) {
+                closeTop();
+            }
+            if (openTopIndex != record.parent) {
+                throw std::runtime_error("Corrupt snapshot: nodes out of preorder");
+            }
+
+            std::unique_ptr<VFSNode> node;
+            std::string name = text(record.nameOffset, record.nameLength);
+            bool archived = record.flags & SnapshotFormat::ARCHIVE_FLAG;
+            if (record.flags & SnapshotFormat::DIRECTORY_FLAG) {
+                if (archived) {
+                    node = std::make_unique<ArchiveDirectory>(
+                        std::move(name), text(record.pathOffset, record.pathLength));
+                } else if (record.flags & SnapshotFormat::LAZY_FLAG) {
+                    if (nextLazyDirectory >= lazyDirectoryCount ||
+                        lazyDirectories[nextLazyDirectory].node != i) {
+                        throw std::runtime_error("Corrupt snapshot: bad lazy directory");
+                    }
+                    const SnapshotLazyDirectory& saved = lazyDirectories[nextLazyDirectory++];
+                    LazyMountOptions lazyOptions;
+                    lazyOptions.prefetchSiblings = static_cast<size_t>(saved.prefetchSiblings);
+                    lazyOptions.revalidateAfter =
+                        std::chrono::milliseconds(saved.revalidateAfterMs);
+                    prefetching = prefetching || lazyOptions.prefetchSiblings > 0;
+                    auto dir = std::make_unique<VFSDirectory>(std::move(name));
+                    dir->makeLazy(&explorer, text(record.pathOffset, record.pathLength),
+                                  lazyOptions, saved.listed != 0);
+                    node = std::move(dir);
+                } else {
+                    node = std::make_unique<VFSDirectory>(std::move(name));
+                }
+            } else if (archived) {
+                if (nextArchiveMember >= archiveMemberCount ||
+                    archiveMembers[nextArchiveMember].node != i) {
+                    throw std::runtime_error("Corrupt snapshot: bad archive member");
+                }
+                const SnapshotArchiveMember& member = archiveMembers[nextArchiveMember++];
+                node = std::make_unique<ArchiveMemberFile>(
+                    std::move(name), text(record.pathOffset, record.pathLength), member.offset,
+                    member.size);
+            } else if (record.flags & SnapshotFormat::MEMORY_FLAG) {
+                node = std::make_unique<MemoryFile>(std::move(name), explorer.memoryPages);
+            } else if (record.flags & SnapshotFormat::STORED_FLAG) {
+                if (nextStoredFile >= storedFileCount || storedFiles[nextStoredFile].node != i) {
+                    throw std::runtime_error("Corrupt snapshot: bad stored file");
+                }
+                const SnapshotStoredFile& stored = storedFiles[nextStoredFile++];
+                ContentKey key{stored.keyHigh, stored.keyLow};
+                if (record.flags & SnapshotFormat::CHUNKED_FLAG) {
+                    node = std::make_unique<ChunkedFile>(std::move(name), *explorer.packStore, key);
+                } else {
+                    node = std::make_unique<StoredFile>(std::move(name), *explorer.packStore, key);
+                }
+            } else {
+                node = std::make_unique<VFSFile>(std::move(name),
+                                                 text(record.pathOffset, record.pathLength),
+                                                 VFSFile::TrustedPath{});
+            }
+            node->setLabels(record.preLabel, record.postLabel);
+            node->setCreationTime(static_cast<std::time_t>(record.createdAt));
+            VFSNode* raw = node.get();
+            nodes[i] = raw;
+
+            if (image) {
+                raw->setImageOrdinal(static_cast<std::uint32_t>(i));
+            }
+            if (raw->isDirectory()) {
+                auto* dir = static_cast<VFSDirectory*>(node.release());
+                open.push_back({static_cast<std::uint32_t>(i), std::unique_ptr<VFSDirectory>(dir)});
+                openTop = open.back().second.get();
+                openTopIndex = static_cast<std::uint32_t>(i);
+            } else {
+                if (VFSExplorer::hasOwnHostFile(raw)) {
+                    physicalMap.put(static_cast<VFSFile*>(raw)->getPhysicalPath(), raw);
+                }
+                openTop->add(std::move(node));
+            }
+        }
+        while (!open.empty()) {
+            closeTop();
+        }
+
+        if (withIndexes) {
+            restoreNameMap(file, *sections.nameMap, strings, nodes, searchMap);
+            restoreTrie(file, *sections.nameTrie, trie);
+        } else if (!image) {
+            BulkIndexBuilder::build(std::vector<VFSNode*>(nodes.begin() + 1, nodes.end()),
+                                    searchMap, trie);
+        }
+
+        SubtreeNameFilters::treeAssembled(root.get());
+        explorer.root = std::move(root);
+        explorer.searchMap = std::move(searchMap);
+        explorer.physicalMap = std::move(physicalMap);
+        explorer.trie = std::move(trie);
+        bool imageMapped = image != nullptr;
+        explorer.nameImage = std::move(image);
+        explorer.imageNodes = imageMapped ? std::move(nodes) : std::vector<VFSNode*>();
+        explorer.imageNamesRemoved.clear();
+        if (prefetching && !explorer.prefetcher) {
+            explorer.prefetcher = std::make_unique<HostListingPrefetcher>();
+        }
+        return {header.nodeCount, file.size(), withIndexes, header.journalSequence,
+                sections.nodes->checksum, imageMapped};
+    }
+};
@@ -0,0 +1,254 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../domain/VFSDirectory.h"
+#include "../domain/VFSNode.h"
+#include "FileHashMap.h"
+#include "FileNameTrie.h"
+#include "ParallelTraversal.h"
+
+// Builds the name map and the trie for a whole tree in one go instead of one put() and
+// one insert() per node: names are radix-sorted in parallel into the trie's char order,
+// and the sorted run then feeds both structures in a single pass, with the hash table
+// sized exactly once and the trie built from distinct names only.
+class BulkIndexBuilder {
+  private:
+    static constexpr size_t RADIX = 257; // 0 = name ended, 1..256 = next byte
+    static constexpr size_t KEY_BYTES = sizeof(std::uint64_t);
+    static constexpr size_t SMALL_RANGE = 48;
+    static constexpr size_t PARALLEL_MIN_NAMES = 1 << 16;
+
+    // The first KEY_BYTES bytes of the name are kept in `key`, so sorting and grouping
+    // names no longer than that never touch the nodes themselves. Bytes are flipped to
+    // sort in signed char order, the order the trie's std::map<char> children use.
+    struct NamedNode {
+        std::uint64_t key;
+        std::uint64_t preLabel;
+        VFSNode* node;
+        std::uint32_t length;
+
+        std::string_view name() const { return node->getName(); }
+    };
+
+    static NamedNode describe(VFSNode* node) {
+        const std::string& name = node->getName();
+        std::uint64_t key = 0;
+        for (size_t i = 0; i < KEY_BYTES; ++i) {
+            std::uint64_t byte =
+                i < name.size() ? static_cast<unsigned char>(name[i]) ^ 0x80u : 0;
+            key = (key << 8) | byte;
+        }
+        return {key, node->getPreLabel(), node, static_cast<std::uint32_t>(name.size())};
+    }
+
+    static size_t digit(const NamedNode& item, size_t depth) {
+        if (depth >= item.length) {
+            return 0;
+        }
+        if (depth < KEY_BYTES) {
+            return ((item.key >> (8 * (KEY_BYTES - 1 - depth))) & 0xff) + 1;
+        }
+        return (static_cast<unsigned char>(item.name()[depth]) ^ 0x80u) + 1;
+    }
+
+    // Padding in `key` compares like a 0x80 byte, so equal keys only settle equality
+    // together with the length, and only for names that fit in the key.
+    static bool sameName(const NamedNode& a, const NamedNode& b) {
+        return a.key == b.key && a.length == b.length &&
+               (a.length <= KEY_BYTES || a.name() == b.name());
+    }
+
+    static bool lessFrom(const NamedNode& a, const NamedNode& b, size_t depth) {
+        if (depth < KEY_BYTES && a.key != b.key) {
+            return a.key < b.key;
+        }
+        if (std::max(a.length, b.length) <= KEY_BYTES) {
+            return a.length < b.length;
+        }
+        std::string_view left = a.name().substr(std::min<size_t>(depth, a.length));
+        std::string_view right = b.name().substr(std::min<size_t>(depth, b.length));
+        return std::lexicographical_compare(left.begin(), left.end(), right.begin(),
+                                            right.end());
+    }
+
+    // Stable MSD radix sort of `count` items at `from` on bytes from `depth` on. Each pass
+    // scatters into the other buffer and the next level sorts from there, so the result
+    // lands in `to` when `intoTo` is set and back in `from` otherwise.
+    static void sortRange(NamedNode* from, NamedNode* to, size_t count, size_t depth,
+                          bool intoTo) {
+        while (count >= SMALL_RANGE) {
+            std::array<size_t, RADIX + 1> starts{};
+            for (size_t i = 0; i < count; ++i) {
+                ++starts[digit(from[i], depth) + 1];
+            }
+            // A byte every name shares (a common prefix, or a run of equal names) needs
+            // no scatter; move on to the next one.
+            size_t only = std::find(starts.begin() + 1, starts.end(), count) - starts.begin();
+            if (only == starts.size()) {
+                for (size_t d = 0; d < RADIX; ++d) {
+                    starts[d + 1] += starts[d];
+                }
+                std::array<size_t, RADIX> next{};
+                std::copy(starts.begin(), starts.end() - 1, next.begin());
+                for (size_t i = 0; i < count; ++i) {
+                    to[next[digit(from[i], depth)]++] = from[i];
+                }
+
+                // Bucket 0 holds names that end here; they are equal and already in order.
+                for (size_t d = 0; d < RADIX; ++d) {
+                    size_t begin = starts[d];
+                    size_t size = starts[d + 1] - begin;
+                    if (d > 0 && size > 1) {
+                        sortRange(to + begin, from + begin, size, depth + 1, !intoTo);
+                    } else if (!intoTo) {
+                        std::copy(to + begin, to + begin + size, from + begin);
+                    }
+                }
+                return;
+            }
+            if (only == 1) {
+                break;
+            }
+            ++depth;
+        }
+        if (count < SMALL_RANGE) {
+            std::stable_sort(from, from + count, [depth](const NamedNode& a, const NamedNode& b) {
+                return lessFrom(a, b, depth);
+            });
+        }
+        if (intoTo) {
+            std::copy(from, from + count, to);
+        }
+    }
+
+    // First pass split over threads (per-thread histograms, then a parallel scatter),
+    // after which the first-byte buckets are sorted concurrently.
+    static void parallelSort(std::vector<NamedNode>& items, size_t threadCount) {
+        std::vector<NamedNode> scratch(items.size());
+        if (threadCount <= 1 || items.size() < PARALLEL_MIN_NAMES) {
+            sortRange(items.data(), scratch.data(), items.size(), 0, false);
+            return;
+        }
+
+        size_t chunk = (items.size() + threadCount - 1) / threadCount;
+        std::vector<std::array<size_t, RADIX>> histograms(threadCount);
+        runParallel(threadCount, [&](size_t t) {
+            histograms[t].fill(0);
+            size_t end = std::min(items.size(), (t + 1) * chunk);
+            for (size_t i = t * chunk; i < end; ++i) {
+                ++histograms[t][digit(items[i], 0)];
+            }
+        });
+
+        std::array<size_t, RADIX + 1> starts{};
+        size_t offset = 0;
+        for (size_t d = 0; d < RADIX; ++d) {
+            starts[d] = offset;
+            for (size_t t = 0; t < threadCount; ++t) {
+                size_t countInChunk = histograms[t][d];
+                histograms[t][d] = offset;
+                offset += countInChunk;
+            }
+        }
+        starts[RADIX] = offset;
+
+        runParallel(threadCount, [&](size_t t) {
+            size_t end = std::min(items.size(), (t + 1) * chunk);
+            for (size_t i = t * chunk; i < end; ++i) {
+                scratch[histograms[t][digit(items[i], 0)]++] = items[i];
+            }
+        });
+        items.swap(scratch);
+
+        std::vector<size_t> buckets;
+        for (size_t d = 1; d < RADIX; ++d) {
+            if (starts[d + 1] - starts[d] > 1) {
+                buckets.push_back(d);
+            }
+        }
+        // Largest buckets first so one long tail does not end up on the last thread.
+        std::sort(buckets.begin(), buckets.end(), [&](size_t a, size_t b) {
+            return starts[a + 1] - starts[a] > starts[b + 1] - starts[b];
+        });
+        std::atomic<size_t> nextBucket{0};
+        runParallel(threadCount, [&](size_t) {
+            for (size_t i = nextBucket++; i < buckets.size(); i = nextBucket++) {
+                size_t d = buckets[i];
+                sortRange(items.data() + starts[d], scratch.data() + starts[d],
+                          starts[d + 1] - starts[d], 1, false);
+            }
+        });
+    }
+
+    template <typename Work>
+    static void runParallel(size_t threadCount, const Work& work) {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (size_t t = 1; t < threadCount; ++t) {
+            threads.emplace_back([&work, t]() { work(t); });
+        }
+        work(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+  public:
+    // Replaces the contents of `map` and `trie` with the names of `nodes`. Nodes sharing a
+    // name end up in preorder in the map.
+    static void build(const std::vector<VFSNode*>& nodes, FileHashMap& map, FileNameTrie& trie,
+                      size_t threadCount = ParallelTraversal::defaultThreadCount()) {
+        std::vector<NamedNode> items(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            items[i] = describe(nodes[i]);
+        }
+        parallelSort(items, threadCount);
+
+        std::vector<std::pair<size_t, size_t>> groups;
+        for (size_t begin = 0; begin < items.size();) {
+            size_t end = begin + 1;
+            while (end < items.size() && sameName(items[end], items[begin])) {
+                ++end;
+            }
+            groups.push_back({begin, end});
+            begin = end;
+        }
+
+        auto byPreorder = [](const NamedNode& a, const NamedNode& b) {
+            return a.preLabel < b.preLabel;
+        };
+        std::vector<std::pair<std::string_view, size_t>> names;
+        names.reserve(groups.size());
+        map.reserveExact(groups.size());
+        for (auto [begin, end] : groups) {
+            if (!std::is_sorted(items.begin() + begin, items.begin() + end, byPreorder)) {
+                std::sort(items.begin() + begin, items.begin() + end, byPreorder);
+            }
+            std::vector<VFSNode*> values(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                values[i - begin] = items[i].node;
+            }
+            names.push_back({items[begin].name(), end - begin});
+            map.insertNew(std::string(items[begin].name()), std::move(values));
+        }
+        trie.buildSorted(names);
+    }
+
+    // Same for every node below `root` (root excluded), collected in parallel.
+    static size_t build(VFSDirectory* root, FileHashMap& map, FileNameTrie& trie,
+                        size_t threadCount = ParallelTraversal::defaultThreadCount()) {
+        std::vector<VFSNode*> nodes = ParallelTraversal::collect(
+            root, threadCount, [root](const VFSNode* node) { return node != root; });
+        build(nodes, map, trie, threadCount);
+        return nodes.size();
+    }
+};
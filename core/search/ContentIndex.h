@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Token occurrences of a single document: token -> word positions in ascending order.
+using TokenPositions = std::unordered_map<std::string, std::vector<std::uint32_t>>;
+
+// Inverted index with varint-compressed postings. Each posting list is a byte stream of
+// (doc id delta, occurrence count, position deltas...) records in ascending doc order.
+// Re-indexing a document appends it under a fresh id; the old id becomes a tombstone
+// that is dropped by compact(). Modification times are in nanoseconds.
+class ContentIndex {
+  private:
+    struct Document {
+        std::string path;
+        std::int64_t modifiedAt;
+        std::uintmax_t size;
+        bool alive;
+    };
+
+    struct PostingList {
+        std::vector<std::uint8_t> bytes;
+        std::uint32_t lastDoc = 0;
+        std::uint32_t docCount = 0;
+    };
+
+    struct Posting {
+        std::uint32_t doc;
+        std::vector<std::uint32_t> positions;
+    };
+
+    std::vector<Document> documents;
+    std::unordered_map<std::string, std::uint32_t> docByPath;
+    std::unordered_map<std::string, PostingList> postings;
+    size_t deadDocuments = 0;
+
+    static void writeVarint(std::vector<std::uint8_t>& out, std::uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    static std::uint32_t readVarint(const std::vector<std::uint8_t>& in, size_t& pos) {
+        std::uint32_t value = 0;
+        int shift = 0;
+        while (in[pos] & 0x80) {
+            value |= static_cast<std::uint32_t>(in[pos++] & 0x7F) << shift;
+            shift += 7;
+        }
+        value |= static_cast<std::uint32_t>(in[pos++]) << shift;
+        return value;
+    }
+
+    static void append(PostingList& list, std::uint32_t doc,
+                       const std::vector<std::uint32_t>& positions) {
+        writeVarint(list.bytes, list.docCount == 0 ? doc : doc - list.lastDoc);
+        writeVarint(list.bytes, static_cast<std::uint32_t>(positions.size()));
+        std::uint32_t previous = 0;
+        for (std::uint32_t position : positions) {
+            writeVarint(list.bytes, position - previous);
+            previous = position;
+        }
+        list.lastDoc = doc;
+        ++list.docCount;
+    }
+
+    std::vector<Posting> decode(const PostingList& list) const {
+        std::vector<Posting> result;
+        result.reserve(list.docCount);
+
+        size_t pos = 0;
+        std::uint32_t doc = 0;
+        for (std::uint32_t i = 0; i < list.docCount; ++i) {
+            doc = (i == 0 ? 0 : doc) + readVarint(list.bytes, pos);
+            std::uint32_t count = readVarint(list.bytes, pos);
+
+            Posting posting{doc, {}};
+            posting.positions.reserve(count);
+            std::uint32_t position = 0;
+            for (std::uint32_t j = 0; j < count; ++j) {
+                position += readVarint(list.bytes, pos);
+                posting.positions.push_back(position);
+            }
+            if (documents[doc].alive) {
+                result.push_back(std::move(posting));
+            }
+        }
+        return result;
+    }
+
+  public:
+    // Modification time of a document that may have changed again unnoticed; such a
+    // document is never current.
+    static constexpr std::int64_t UNTRUSTED_TIME = -1;
+
+    static std::string normalize(const std::string& token) {
+        std::string result = token;
+        for (char& c : result) {
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+        return result;
+    }
+
+    static bool isTokenChar(char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               c == '_';
+    }
+
+    static std::vector<std::string> tokenize(const std::string& text) {
+        std::vector<std::string> tokens;
+        std::string current;
+        for (char c : text) {
+            if (isTokenChar(c)) {
+                current += c;
+            } else if (!current.empty()) {
+                tokens.push_back(normalize(current));
+                current.clear();
+            }
+        }
+        if (!current.empty()) {
+            tokens.push_back(normalize(current));
+        }
+        return tokens;
+    }
+
+    bool isCurrent(const std::string& path, std::int64_t modifiedAt, std::uintmax_t size) const {
+        auto it = docByPath.find(path);
+        if (it == docByPath.end()) {
+            return false;
+        }
+        const Document& doc = documents[it->second];
+        return doc.modifiedAt != UNTRUSTED_TIME && doc.modifiedAt == modifiedAt &&
+               doc.size == size;
+    }
+
+    void addDocument(const std::string& path, std::int64_t modifiedAt, std::uintmax_t size,
+                     const TokenPositions& tokens) {
+        removeDocument(path);
+
+        auto doc = static_cast<std::uint32_t>(documents.size());
+        documents.push_back({path, modifiedAt, size, true});
+        docByPath[path] = doc;
+
+        for (const auto& [token, positions] : tokens) {
+            append(postings[token], doc, positions);
+        }
+    }
+
+    bool removeDocument(const std::string& path) {
+        auto it = docByPath.find(path);
+        if (it == docByPath.end()) {
+            return false;
+        }
+        documents[it->second].alive = false;
+        docByPath.erase(it);
+        ++deadDocuments;
+        return true;
+    }
+
+    std::vector<std::string> documentPaths() const {
+        std::vector<std::string> paths;
+        paths.reserve(docByPath.size());
+        for (const auto& [path, doc] : docByPath) {
+            paths.push_back(path);
+        }
+        return paths;
+    }
+
+    std::vector<std::string> findTerm(const std::string& term) const {
+        std::vector<std::string> result;
+        auto it = postings.find(normalize(term));
+        if (it == postings.end()) {
+            return result;
+        }
+        for (const auto& posting : decode(it->second)) {
+            result.push_back(documents[posting.doc].path);
+        }
+        return result;
+    }
+
+    std::vector<std::string> findPhrase(const std::string& phrase) const {
+        std::vector<std::string> terms = tokenize(phrase);
+        std::vector<std::string> result;
+        if (terms.empty()) {
+            return result;
+        }
+
+        std::vector<std::vector<Posting>> lists;
+        for (const auto& term : terms) {
+            auto it = postings.find(term);
+            if (it == postings.end()) {
+                return result;
+            }
+            lists.push_back(decode(it->second));
+        }
+
+        std::vector<size_t> cursors(lists.size(), 0);
+        for (const auto& first : lists[0]) {
+            bool inAll = true;
+            for (size_t i = 1; i < lists.size() && inAll; ++i) {
+                while (cursors[i] < lists[i].size() && lists[i][cursors[i]].doc < first.doc) {
+                    ++cursors[i];
+                }
+                inAll = cursors[i] < lists[i].size() && lists[i][cursors[i]].doc == first.doc;
+            }
+            if (!inAll) {
+                continue;
+            }
+
+            for (std::uint32_t start : first.positions) {
+                bool matched = true;
+                for (size_t i = 1; i < lists.size() && matched; ++i) {
+                    const auto& positions = lists[i][cursors[i]].positions;
+                    matched = std::binary_search(positions.begin(), positions.end(),
+                                                 start + static_cast<std::uint32_t>(i));
+                }
+                if (matched) {
+                    result.push_back(documents[first.doc].path);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    // Drops tombstoned documents and renumbers the live ones densely, keeping their
+    // order, so posting lists stay sorted by doc id.
+    void compact() {
+        if (deadDocuments == 0) {
+            return;
+        }
+        std::vector<std::uint32_t> renumbered(documents.size());
+        std::vector<Document> live;
+        live.reserve(docByPath.size());
+        for (size_t doc = 0; doc < documents.size(); ++doc) {
+            if (documents[doc].alive) {
+                renumbered[doc] = static_cast<std::uint32_t>(live.size());
+                live.push_back(std::move(documents[doc]));
+            }
+        }
+        for (auto it = postings.begin(); it != postings.end();) {
+            std::vector<Posting> kept = decode(it->second);
+            if (kept.empty()) {
+                it = postings.erase(it);
+                continue;
+            }
+            PostingList rebuilt;
+            for (const auto& posting : kept) {
+                append(rebuilt, renumbered[posting.doc], posting.positions);
+            }
+            it->second = std::move(rebuilt);
+            ++it;
+        }
+        documents = std::move(live);
+        for (auto& [path, doc] : docByPath) {
+            doc = renumbered[doc];
+        }
+        deadDocuments = 0;
+    }
+
+    bool needsCompaction() const { return deadDocuments > docByPath.size(); }
+
+    size_t documentCount() const { return docByPath.size(); }
+
+    size_t termCount() const { return postings.size(); }
+
+    size_t postingBytes() const {
+        size_t total = 0;
+        for (const auto& [token, list] : postings) {
+            total += list.bytes.size();
+        }
+        return total;
+    }
+};
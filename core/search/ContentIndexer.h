@@ -0,0 +1,165 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../io/MappedFile.h"
+#include "../utils/ThreadPool.h"
+#include "ContentIndex.h"
+
+struct ContentIndexStats {
+    size_t documents;
+    size_t terms;
+    size_t postingBytes;
+    std::uintmax_t bytesIndexed;
+    long long indexingNanos;
+};
+
+// Optional full-text indexer for the physical files behind VFSFile nodes. Files are read
+// and tokenized on a background pool; only the final merge into the index takes the lock.
+class ContentIndexer {
+  private:
+    static constexpr size_t BINARY_PROBE = 4096;
+    static constexpr std::uintmax_t DEFAULT_MAX_FILE_BYTES = 64 * 1024 * 1024;
+
+    mutable std::mutex indexMutex;
+    ContentIndex index;
+    std::uintmax_t maxFileBytes;
+    std::atomic<std::uintmax_t> bytesIndexed{0};
+    std::atomic<long long> indexingNanos{0};
+    ThreadPool pool;
+
+    // File mtimes follow a coarse kernel clock, so a file indexed this soon after it was
+    // written may be written again within the same tick, at the same size.
+    static constexpr std::chrono::seconds RACY_WRITE_WINDOW{1};
+
+    static std::int64_t modificationTime(const std::filesystem::file_time_type& time) {
+        if (std::filesystem::file_time_type::clock::now() - time < RACY_WRITE_WINDOW) {
+            return ContentIndex::UNTRUSTED_TIME;
+        }
+        return static_cast<std::int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch())
+                .count());
+    }
+
+    // Returns false for files that look binary.
+    static bool tokenizeFile(const std::string& path, TokenPositions& tokens) {
+        MappedFile file(path, AccessPattern::Sequential);
+        std::string_view text = file.view();
+
+        std::string_view probe = text.substr(0, BINARY_PROBE);
+        if (probe.find('\0') != std::string_view::npos) {
+            return false;
+        }
+
+        std::string current;
+        std::uint32_t position = 0;
+        for (char c : text) {
+            if (ContentIndex::isTokenChar(c)) {
+                current += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            } else if (!current.empty()) {
+                tokens[current].push_back(position++);
+                current.clear();
+            }
+        }
+        if (!current.empty()) {
+            tokens[current].push_back(position);
+        }
+        return true;
+    }
+
+    void indexNow(const std::string& path) {
+        auto start = std::chrono::steady_clock::now();
+
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        auto writeTime = std::filesystem::last_write_time(path, ec);
+        if (ec || !std::filesystem::is_regular_file(path, ec)) {
+            std::lock_guard<std::mutex> lock(indexMutex);
+            index.removeDocument(path);
+            return;
+        }
+
+        std::int64_t modifiedAt = modificationTime(writeTime);
+        {
+            std::lock_guard<std::mutex> lock(indexMutex);
+            if (index.isCurrent(path, modifiedAt, size)) {
+                return;
+            }
+        }
+
+        TokenPositions tokens;
+        try {
+            if (size <= maxFileBytes && !tokenizeFile(path, tokens)) {
+                tokens.clear();
+            }
+        } catch (const std::exception&) {
+            tokens.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(indexMutex);
+            index.addDocument(path, modifiedAt, size, tokens);
+            if (index.needsCompaction()) {
+                index.compact();
+            }
+        }
+
+        bytesIndexed += tokens.empty() ? 0 : size;
+        indexingNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    }
+
+  public:
+    explicit ContentIndexer(size_t threadCount = ThreadPool::defaultThreadCount(),
+                            std::uintmax_t maxFileBytes = DEFAULT_MAX_FILE_BYTES)
+        : maxFileBytes(maxFileBytes), pool(threadCount) {}
+
+    // Schedules (re)indexing; unchanged files are skipped by size and mtime.
+    void indexFile(const std::string& physicalPath) {
+        pool.submit([this, physicalPath]() { indexNow(physicalPath); });
+    }
+
+    void indexFiles(const std::vector<std::string>& physicalPaths) {
+        for (const auto& path : physicalPaths) {
+            indexFile(path);
+        }
+    }
+
+    void removeFile(const std::string& physicalPath) {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        index.removeDocument(physicalPath);
+    }
+
+    // Re-checks every indexed file and re-indexes the ones that changed or vanished.
+    void refresh() {
+        std::vector<std::string> paths;
+        {
+            std::lock_guard<std::mutex> lock(indexMutex);
+            paths = index.documentPaths();
+        }
+        indexFiles(paths);
+    }
+
+    void waitIdle() { pool.waitIdle(); }
+
+    std::vector<std::string> findTerm(const std::string& term) const {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        return index.findTerm(term);
+    }
+
+    std::vector<std::string> findPhrase(const std::string& phrase) const {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        return index.findPhrase(phrase);
+    }
+
+    ContentIndexStats getStats() const {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        return {index.documentCount(), index.termCount(), index.postingBytes(),
+                bytesIndexed.load(), indexingNanos.load()};
+    }
+};
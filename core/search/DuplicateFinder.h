@@ -0,0 +1,298 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../domain/VFSExplorer.h"
+#include "../io/MappedFile.h"
+#include "../utils/Hash64.h"
+#include "../utils/ThreadPool.h"
+
+struct DuplicateGroup {
+    std::uintmax_t size;
+    std::uint64_t hash;
+    std::vector<std::string> physicalPaths;
+    std::vector<VFSFile*> files;
+};
+
+struct DedupStats {
+    size_t physicalFiles;
+    size_t partiallyHashed;
+    size_t fullyHashed;
+    size_t cacheHits;
+    std::uintmax_t bytesHashed;
+};
+
+// Finds VFSFile nodes with identical content. Candidates are narrowed by size, then by a
+// hash of the first and last block, and only files that still collide are hashed fully.
+// Hashes are cached per physical path and mtime, so repeated runs only read changed files.
+class DuplicateFinder {
+  private:
+    static constexpr size_t PARTIAL_BLOCK = 4096;
+    static constexpr std::uint32_t CACHE_MAGIC = 0x56464448;
+    static constexpr std::uint32_t CACHE_VERSION = 2;
+    static constexpr std::uint32_t HAS_PARTIAL = 1;
+    static constexpr std::uint32_t HAS_FULL = 2;
+
+    // Cache file: CacheFileHeader, then per entry the path length as uint64, the path
+    // and a CacheFileEntry. The checksum covers everything after the header.
+    struct CacheFileHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t count;
+        std::uint64_t bodyBytes;
+        std::uint64_t checksum;
+    };
+
+    struct CacheFileEntry {
+        std::int64_t modifiedAt;
+        std::uint64_t size;
+        std::uint64_t partial;
+        std::uint64_t full;
+        std::uint32_t flags;
+        std::uint32_t reserved;
+    };
+
+    struct CachedHash {
+        std::int64_t modifiedAt = 0;
+        std::uintmax_t size = 0;
+        bool hasPartial = false;
+        bool hasFull = false;
+        std::uint64_t partial = 0;
+        std::uint64_t full = 0;
+    };
+
+    struct Candidate {
+        std::string path;
+        std::uintmax_t size;
+        std::int64_t modifiedAt;
+    };
+
+    std::unordered_map<std::string, CachedHash> cache;
+    std::mutex cacheMutex;
+    ThreadPool pool;
+    DedupStats stats{};
+
+    static std::uint64_t partialHash(const std::string& path) {
+        MappedFile file(path, AccessPattern::Random);
+        Hash64 hasher;
+        size_t head = std::min(file.size(), PARTIAL_BLOCK);
+        hasher.update(file.data(), head);
+        if (file.size() > PARTIAL_BLOCK) {
+            size_t tail = std::min(file.size() - head, PARTIAL_BLOCK);
+            hasher.update(file.data() + file.size() - tail, tail);
+        }
+        return hasher.digest();
+    }
+
+    static std::uint64_t fullHash(const std::string& path) {
+        MappedFile file(path, AccessPattern::Sequential);
+        return Hash64::compute(file.data(), file.size());
+    }
+
+    // Returns the cached entry for the candidate, dropping it if the file changed.
+    CachedHash& entryFor(const Candidate& candidate) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        CachedHash& entry = cache[candidate.path];
+        if (entry.modifiedAt != candidate.modifiedAt || entry.size != candidate.size) {
+            entry = CachedHash{};
+            entry.modifiedAt = candidate.modifiedAt;
+            entry.size = candidate.size;
+        }
+        return entry;
+    }
+
+    // Hashes every candidate in parallel and regroups them by (key, hash). A candidate
+    // left alone in its bucket is only kept if `keepAlone` says so.
+    template <typename HashFn, typename KeepFn>
+    std::vector<std::vector<Candidate>> splitByHash(const std::vector<Candidate>& group,
+                                                    bool full, HashFn hashFn,
+                                                    KeepFn keepAlone) {
+        std::vector<std::future<std::uint64_t>> hashes;
+        for (const auto& candidate : group) {
+            CachedHash& entry = entryFor(candidate);
+            bool cached = full ? entry.hasFull : entry.hasPartial;
+            if (cached) {
+                ++stats.cacheHits;
+                std::promise<std::uint64_t> ready;
+                ready.set_value(full ? entry.full : entry.partial);
+                hashes.push_back(ready.get_future());
+                continue;
+            }
+
+            (full ? stats.fullyHashed : stats.partiallyHashed)++;
+            stats.bytesHashed += full ? candidate.size : std::min<std::uintmax_t>(
+                                                             candidate.size, 2 * PARTIAL_BLOCK);
+            hashes.push_back(pool.submit([this, candidate, full, hashFn]() {
+                std::uint64_t hash = hashFn(candidate.path);
+                CachedHash& slot = entryFor(candidate);
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                (full ? slot.full : slot.partial) = hash;
+                (full ? slot.hasFull : slot.hasPartial) = true;
+                return hash;
+            }));
+        }
+
+        std::map<std::uint64_t, std::vector<Candidate>> byHash;
+        for (size_t i = 0; i < group.size(); ++i) {
+            try {
+                byHash[hashes[i].get()].push_back(group[i]);
+            } catch (const std::exception&) {
+                // unreadable files cannot be proven equal to anything
+            }
+        }
+
+        std::vector<std::vector<Candidate>> result;
+        for (auto& [hash, candidates] : byHash) {
+            if (candidates.size() > 1 || keepAlone(candidates.front())) {
+                result.push_back(std::move(candidates));
+            }
+        }
+        return result;
+    }
+
+  public:
+    explicit DuplicateFinder(size_t threadCount = ThreadPool::defaultThreadCount())
+        : pool(threadCount) {}
+
+    std::vector<DuplicateGroup> findDuplicates(const VFSExplorer& explorer) {
+        stats = DedupStats{};
+        std::vector<DuplicateGroup> groups;
+
+        // Several nodes over one host file are duplicates without comparing anything.
+        auto shared = [&explorer](const Candidate& candidate) {
+            return explorer.findByPhysicalPath(candidate.path).size() > 1;
+        };
+        std::map<std::uintmax_t, std::vector<Candidate>> bySize;
+        for (const auto& path : explorer.collectPhysicalPaths()) {
+            std::error_code sizeError;
+            std::error_code timeError;
+            auto size = std::filesystem::file_size(path, sizeError);
+            auto writeTime = std::filesystem::last_write_time(path, timeError);
+            if (sizeError || timeError) {
+                continue;
+            }
+            ++stats.physicalFiles;
+            bySize[size].push_back({path, size, writeTime.time_since_epoch().count()});
+        }
+
+        for (auto& [size, sameSize] : bySize) {
+            std::vector<std::vector<Candidate>> collisions;
+            if (sameSize.size() > 1) {
+                for (auto& partialGroup : splitByHash(sameSize, false, partialHash, shared)) {
+                    bool wholeFileRead = size <= 2 * PARTIAL_BLOCK;
+                    if (wholeFileRead) {
+                        collisions.push_back(std::move(partialGroup));
+                        continue;
+                    }
+                    for (auto& fullGroup : splitByHash(partialGroup, true, fullHash, shared)) {
+                        collisions.push_back(std::move(fullGroup));
+                    }
+                }
+            } else if (shared(sameSize.front())) {
+                // hashed anyway, so the group reports the content's hash
+                collisions = splitByHash(sameSize, true, fullHash, shared);
+            }
+
+            for (auto& collision : collisions) {
+                DuplicateGroup group{size, 0, {}, {}};
+                for (const auto& candidate : collision) {
+                    group.physicalPaths.push_back(candidate.path);
+                    auto files = explorer.findByPhysicalPath(candidate.path);
+                    group.files.insert(group.files.end(), files.begin(), files.end());
+                }
+                if (group.files.size() > 1) {
+                    CachedHash& entry = entryFor(collision.front());
+                    group.hash = entry.hasFull ? entry.full : entry.partial;
+                    groups.push_back(std::move(group));
+                }
+            }
+        }
+        return groups;
+    }
+
+    const DedupStats& lastStats() const { return stats; }
+
+    bool saveCache(const std::string& cachePath) {
+        std::string body;
+        CacheFileHeader header{CACHE_MAGIC, CACHE_VERSION, 0, 0, 0};
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            header.count = cache.size();
+            for (const auto& [path, entry] : cache) {
+                std::uint64_t pathLength = path.size();
+                CacheFileEntry record{entry.modifiedAt, entry.size, entry.partial, entry.full,
+                                      (entry.hasPartial ? HAS_PARTIAL : 0) |
+                                          (entry.hasFull ? HAS_FULL : 0),
+                                      0};
+                body.append(reinterpret_cast<const char*>(&pathLength), sizeof(pathLength));
+                body += path;
+                body.append(reinterpret_cast<const char*>(&record), sizeof(record));
+            }
+        }
+        header.bodyBytes = body.size();
+        header.checksum = Hash64::compute(body);
+
+        std::ofstream out(cachePath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        return static_cast<bool>(out.flush());
+    }
+
+    // Merges a cache written by saveCache. A file of another version, or one that is
+    // truncated or corrupt, is ignored as a whole and false returned.
+    bool loadCache(const std::string& cachePath) {
+        std::ifstream in(cachePath, std::ios::binary);
+        CacheFileHeader header{};
+        std::error_code ec;
+        auto fileBytes = std::filesystem::file_size(cachePath, ec);
+        if (ec || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+            header.bodyBytes != fileBytes - sizeof(header)) {
+            return false;
+        }
+        std::string body(static_cast<size_t>(header.bodyBytes), '\0');
+        if (!in.read(&body[0], static_cast<std::streamsize>(body.size())) ||
+            Hash64::compute(body) != header.checksum) {
+            return false;
+        }
+
+        std::unordered_map<std::string, CachedHash> loaded;
+        size_t at = 0;
+        for (std::uint64_t i = 0; i < header.count; ++i) {
+            std::uint64_t pathLength = 0;
+            CacheFileEntry record{};
+            if (body.size() - at < sizeof(pathLength)) {
+                return false;
+            }
+            std::memcpy(&pathLength, body.data() + at, sizeof(pathLength));
+            at += sizeof(pathLength);
+            if (pathLength > body.size() - at || body.size() - at - pathLength < sizeof(record)) {
+                return false;
+            }
+            std::string path = body.substr(at, static_cast<size_t>(pathLength));
+            at += static_cast<size_t>(pathLength);
+            std::memcpy(&record, body.data() + at, sizeof(record));
+            at += sizeof(record);
+            loaded[path] = {record.modifiedAt, record.size, (record.flags & HAS_PARTIAL) != 0,
+                            (record.flags & HAS_FULL) != 0, record.partial, record.full};
+        }
+        if (at != body.size()) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (auto& [path, entry] : loaded) {
+            cache[path] = entry;
+        }
+        return true;
+    }
+};
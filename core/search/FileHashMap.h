@@ -3,6 +3,7 @@
 #include <vector>
 #include "domain/VFSNode.h"
 #include <list>
+#include <stdexcept>
 #include <utility>
 
 struct Entry {
@@ -33,7 +34,10 @@ private:
     }
 
     void resize() {
-        size_t newCapacity = buckets.size() * GROWTH_FACTOR;
+        rehash(buckets.size() * GROWTH_FACTOR);
+    }
+
+    void rehash(size_t newCapacity) {
         std::vector<std::list<Entry>> newBuckets(newCapacity);
 
         for (auto& bucket : buckets) {
@@ -85,6 +89,66 @@ public:
         return {}; 
     }
 
+    size_t bucketCount() const { return buckets.size(); }
+
+    // Visits entries bucket by bucket, in the order restoreEntry() expects them back.
+    template <typename Visitor>
+    void forEachEntry(Visitor visit) const {
+        for (size_t index = 0; index < buckets.size(); ++index) {
+            for (const auto& entry : buckets[index]) {
+                visit(index, entry.key, entry.values);
+            }
+        }
+    }
+
+    // Rebuilds a saved table without rehashing: reset to the saved bucket count, then
+    // hand back every entry with the bucket it was saved from.
+    void resetBuckets(size_t bucketCount) {
+        buckets.assign(bucketCount == 0 ? 1 : bucketCount, {});
+        countOfElements = 0;
+    }
+
+    // Throws if the entry cannot have come from that bucket, as lookups would miss it.
+    void restoreEntry(size_t bucket, std::string key, std::vector<VFSNode*> values) {
+        if (bucket >= buckets.size() || getBucketIndex(key) != bucket) {
+            throw std::runtime_error("Corrupt snapshot: name map entry in the wrong bucket");
+        }
+        buckets[bucket].push_back(Entry{std::move(key), std::move(values)});
+        countOfElements++;
+    }
+
+    // Sizes the table once for `distinctKeys` entries so that a bulk fill through
+    // insertNew() never rehashes.
+    void reserveExact(size_t distinctKeys) {
+        resetBuckets(static_cast<size_t>(distinctKeys / LOAD_FACTOR) + 1);
+    }
+
+    // Grows the table once so that `additionalKeys` more keys fit without a resize.
+    void reserve(size_t additionalKeys) {
+        size_t needed = static_cast<size_t>((countOfElements + additionalKeys) / LOAD_FACTOR) + 1;
+        if (needed > buckets.size()) {
+            rehash(needed);
+        }
+    }
+
+    // Adds an entry for a key the caller knows is not in the table yet.
+    void insertNew(std::string key, std::vector<VFSNode*> values) {
+        size_t index = getBucketIndex(key);
+        buckets[index].push_back(Entry{std::move(key), std::move(values)});
+        countOfElements++;
+    }
+
+    std::vector<std::string> keys() const {
+        std::vector<std::string> result;
+        result.reserve(countOfElements);
+        for (const auto& bucket : buckets) {
+            for (const auto& entry : bucket) {
+                result.push_back(entry.key);
+            }
+        }
+        return result;
+    }
+
     void remove(const std::string& key, VFSNode* node) {
         std::size_t index = getBucketIndex(key);
         auto& bucket = buckets[index];
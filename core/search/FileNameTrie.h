@@ -25,4 +25,16 @@ public:
         return trie->erase(fileName);
     }
 
+    std::vector<Trie::FlatNode> flatten() const {
+        return trie->flatten();
+    }
+
+    void restore(const std::vector<Trie::FlatNode>& nodes) {
+        trie->restore(nodes);
+    }
+
+    void buildSorted(const std::vector<std::pair<std::string_view, size_t>>& fileNames) {
+        trie->build_sorted(fileNames);
+    }
+
 };
\ No newline at end of file
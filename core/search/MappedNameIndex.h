@@ -0,0 +1,276 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../io/MappedFile.h"
+#include "../persistence/IndexImageFormat.h"
+#include "../utils/FileSync.h"
+#include "../utils/Hash64.h"
+
+// Read-only name index answered straight from a mapped IndexImageFormat file: exact
+// lookups probe the slot table, prefix queries walk the trie arrays. Nothing is
+// materialized on open, so a million-name image is usable after one checksum pass (or
+// none, when verification is off). Values are snapshot preorder indices; turning them into
+// nodes, and layering later changes on top, is up to the owner.
+class MappedNameIndex {
+  private:
+    MappedFile file;
+    IndexImageHeader header{};
+    const IndexImageSlot* slots = nullptr;
+    const std::uint32_t* values = nullptr;
+    const IndexImageTrieNode* trie = nullptr;
+    const char* strings = nullptr;
+
+    static std::uint64_t alignUp(std::uint64_t offset) {
+        return (offset + IndexImageFormat::ALIGNMENT - 1) & ~(IndexImageFormat::ALIGNMENT - 1);
+    }
+
+    // Same order as std::map<char>, which is what Trie::auto_complete emits.
+    static bool trieOrder(const std::string& a, const std::string& b) {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+    std::string_view key(const IndexImageSlot& slot) const {
+        if (slot.keyOffset > header.stringBytes ||
+            slot.keyLength > header.stringBytes - slot.keyOffset) {
+            throw std::runtime_error("Corrupt index image: key out of bounds");
+        }
+        return std::string_view(strings + slot.keyOffset, slot.keyLength);
+    }
+
+    // Children always follow their parent in breadth-first order, which also rules out
+    // cycles in a damaged image.
+    std::pair<const IndexImageTrieNode*, const IndexImageTrieNode*> children(
+        const IndexImageTrieNode& node) const {
+        if (node.childCount == 0) {
+            return {nullptr, nullptr};
+        }
+        std::uint64_t index = static_cast<std::uint64_t>(&node - trie);
+        if (node.firstChild <= index || node.firstChild > header.trieNodeCount ||
+            node.childCount > header.trieNodeCount - node.firstChild) {
+            throw std::runtime_error("Corrupt index image: trie child out of bounds");
+        }
+        return {trie + node.firstChild, trie + node.firstChild + node.childCount};
+    }
+
+    const IndexImageTrieNode* child(const IndexImageTrieNode& node, char ch) const {
+        auto [first, last] = children(node);
+        const IndexImageTrieNode* it = std::lower_bound(
+            first, last, ch, [](const IndexImageTrieNode& n, char c) { return n.ch < c; });
+        return it != last && it->ch == ch ? it : nullptr;
+    }
+
+    static std::vector<IndexImageTrieNode> buildTrie(
+        const std::vector<std::pair<std::string, std::vector<std::uint32_t>>>& entries,
+        std::vector<size_t>& order) {
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return trieOrder(entries[a].first, entries[b].first);
+        });
+
+        struct Range {
+            std::uint32_t node;
+            size_t begin;
+            size_t end;
+            size_t depth;
+        };
+        std::vector<IndexImageTrieNode> nodes{{0, 0, 0, '\0', {}}};
+        std::vector<Range> queue{{0, 0, order.size(), 0}};
+        for (size_t q = 0; q < queue.size(); ++q) {
+            Range range = queue[q];
+            IndexImageTrieNode& node = nodes[range.node];
+            size_t i = range.begin;
+            while (i < range.end && entries[order[i]].first.size() == range.depth) {
+                node.count += static_cast<std::uint32_t>(entries[order[i]].second.size());
+                ++i;
+            }
+            node.firstChild = static_cast<std::uint32_t>(nodes.size());
+            while (i < range.end) {
+                char ch = entries[order[i]].first[range.depth];
+                size_t runEnd = i;
+                while (runEnd < range.end && entries[order[runEnd]].first[range.depth] == ch) {
+                    ++runEnd;
+                }
+                queue.push_back({static_cast<std::uint32_t>(nodes.size()), i, runEnd,
+                                 range.depth + 1});
+                nodes.push_back({0, 0, 0, ch, {}});
+                ++nodes[range.node].childCount;
+                i = runEnd;
+            }
+        }
+        return nodes;
+    }
+
+    template <typename T>
+    static void appendArray(std::string& out, const T* data, size_t count) {
+        out.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+        out.resize(alignUp(out.size()), '\0');
+    }
+
+  public:
+    // Writes an image for `entries` (name, preorder indices of the nodes with that name).
+    using Entries = std::vector<std::pair<std::string, std::vector<std::uint32_t>>>;
+
+    static void write(const std::string& path, std::uint64_t treeVersion,
+                      std::uint64_t nodeCount, const Entries& entries) {
+        IndexImageHeader header{};
+        std::memcpy(header.magic, IndexImageFormat::MAGIC, sizeof(header.magic));
+        header.version = IndexImageFormat::VERSION;
+        header.treeVersion = treeVersion;
+        header.nodeCount = nodeCount;
+        header.slotCount = 8;
+        while (header.slotCount < entries.size() * 2) {
+            header.slotCount *= 2;
+        }
+
+        std::vector<IndexImageSlot> slotTable(header.slotCount);
+        std::vector<std::uint32_t> valueArray;
+        std::string stringData;
+        std::vector<size_t> order;
+        for (size_t e = 0; e < entries.size(); ++e) {
+            const auto& [name, nodes] = entries[e];
+            if (name.empty() || nodes.empty()) {
+                continue;
+            }
+            order.push_back(e);
+            IndexImageSlot slot{Hash64::compute(name), stringData.size(), valueArray.size(),
+                                static_cast<std::uint32_t>(name.size()),
+                                static_cast<std::uint32_t>(nodes.size())};
+            stringData += name;
+            valueArray.insert(valueArray.end(), nodes.begin(), nodes.end());
+            std::uint64_t i = slot.hash & (header.slotCount - 1);
+            while (slotTable[i].valueCount != 0) {
+                i = (i + 1) & (header.slotCount - 1);
+            }
+            slotTable[i] = slot;
+        }
+        std::vector<IndexImageTrieNode> trieNodes = buildTrie(entries, order);
+
+        header.valueCount = valueArray.size();
+        header.trieNodeCount = trieNodes.size();
+        header.stringBytes = stringData.size();
+
+        std::string payload;
+        appendArray(payload, slotTable.data(), slotTable.size());
+        appendArray(payload, valueArray.data(), valueArray.size());
+        appendArray(payload, trieNodes.data(), trieNodes.size());
+        appendArray(payload, stringData.data(), stringData.size());
+        header.checksum = Hash64::compute(payload);
+
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+            if (!out.flush()) {
+                throw std::runtime_error("Cannot write index image: " + path);
+            }
+        }
+        FileSync::file(temporary);
+        std::filesystem::rename(temporary, path);
+    }
+
+    explicit MappedNameIndex(const std::string& path, bool verifyChecksum = true)
+        : file(path, AccessPattern::Random) {
+        if (file.size() < sizeof(header)) {
+            throw std::runtime_error("Corrupt index image: truncated header");
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, IndexImageFormat::MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != IndexImageFormat::VERSION) {
+            throw std::runtime_error("Not a supported index image: " + path);
+        }
+
+        // Every count is bounded by the file size before it takes part in any product.
+        std::uint64_t available = file.size() - sizeof(header);
+        if (header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0 ||
+            header.slotCount > available || header.valueCount > available ||
+            header.trieNodeCount == 0 || header.trieNodeCount > available ||
+            header.stringBytes > available) {
+            throw std::runtime_error("Corrupt index image: bad counts");
+        }
+        std::uint64_t slotsAt = sizeof(header);
+        std::uint64_t valuesAt = alignUp(slotsAt + header.slotCount * sizeof(IndexImageSlot));
+        std::uint64_t trieAt = alignUp(valuesAt + header.valueCount * sizeof(std::uint32_t));
+        std::uint64_t stringsAt =
+            alignUp(trieAt + header.trieNodeCount * sizeof(IndexImageTrieNode));
+        if (alignUp(stringsAt + header.stringBytes) != file.size()) {
+            throw std::runtime_error("Corrupt index image: size mismatch");
+        }
+        if (verifyChecksum && Hash64::compute(file.data() + sizeof(header),
+                                              file.size() - sizeof(header)) != header.checksum) {
+            throw std::runtime_error("Corrupt index image: checksum mismatch");
+        }
+
+        slots = reinterpret_cast<const IndexImageSlot*>(file.data() + slotsAt);
+        values = reinterpret_cast<const std::uint32_t*>(file.data() + valuesAt);
+        trie = reinterpret_cast<const IndexImageTrieNode*>(file.data() + trieAt);
+        strings = file.data() + stringsAt;
+    }
+
+    std::uint64_t treeVersion() const { return header.treeVersion; }
+
+    std::uint64_t nodeCount() const { return header.nodeCount; }
+
+    // Preorder indices of the nodes named `name`, as a view into the image.
+    std::pair<const std::uint32_t*, size_t> find(const std::string& name) const {
+        std::uint64_t hash = Hash64::compute(name);
+        std::uint64_t mask = header.slotCount - 1;
+        for (std::uint64_t i = hash & mask, probes = 0; probes < header.slotCount;
+             i = (i + 1) & mask, ++probes) {
+            const IndexImageSlot& slot = slots[i];
+            if (slot.valueCount == 0) {
+                break;
+            }
+            if (slot.hash == hash && key(slot) == name) {
+                if (slot.firstValue > header.valueCount ||
+                    slot.valueCount > header.valueCount - slot.firstValue) {
+                    throw std::runtime_error("Corrupt index image: values out of bounds");
+                }
+                return {values + slot.firstValue, slot.valueCount};
+            }
+        }
+        return {nullptr, 0};
+    }
+
+    // Calls visit(name, count) for every name starting with `prefix`, in Trie order.
+    template <typename Visitor>
+    void forEachWithPrefix(const std::string& prefix, Visitor visit) const {
+        const IndexImageTrieNode* node = trie;
+        for (char ch : prefix) {
+            node = child(*node, ch);
+            if (!node) {
+                return;
+            }
+        }
+
+        std::string word = prefix;
+        std::vector<std::pair<const IndexImageTrieNode*, std::uint32_t>> stack{{node, 0}};
+        if (node->count > 0) {
+            visit(word, node->count);
+        }
+        while (!stack.empty()) {
+            auto& [parent, next] = stack.back();
+            if (next == parent->childCount) {
+                stack.pop_back();
+                if (!stack.empty()) {
+                    word.pop_back();
+                }
+                continue;
+            }
+            const IndexImageTrieNode* current = children(*parent).first + next++;
+            word.push_back(current->ch);
+            if (current->count > 0) {
+                visit(word, current->count);
+            }
+            stack.push_back({current, 0});
+        }
+    }
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../domain/VFSDirectory.h"
+#include "../domain/VFSNode.h"
+
+// Work-stealing tree walk. A task is one directory: its owner scans the children, keeps
+// matches in a private buffer and pushes subdirectories onto its own deque. Idle workers
+// steal the oldest (usually largest) directories from the front of other deques.
+class ParallelTraversal {
+  private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<const VFSDirectory*> tasks;
+    };
+
+    struct SharedState {
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+        std::atomic<size_t> pending{0};
+    };
+
+    static void push(SharedState& state, size_t worker, const VFSDirectory* dir) {
+        state.pending.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(state.queues[worker]->mutex);
+        state.queues[worker]->tasks.push_back(dir);
+    }
+
+    static const VFSDirectory* popOwn(SharedState& state, size_t worker) {
+        std::lock_guard<std::mutex> lock(state.queues[worker]->mutex);
+        auto& tasks = state.queues[worker]->tasks;
+        if (tasks.empty()) {
+            return nullptr;
+        }
+        const VFSDirectory* dir = tasks.back();
+        tasks.pop_back();
+        return dir;
+    }
+
+    static const VFSDirectory* steal(SharedState& state, size_t thief) {
+        size_t count = state.queues.size();
+        for (size_t offset = 1; offset < count; ++offset) {
+            auto& victim = *state.queues[(thief + offset) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                const VFSDirectory* dir = victim.tasks.front();
+                victim.tasks.pop_front();
+                return dir;
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename Match, typename Descend>
+    static void work(SharedState& state, size_t worker, const Match& match,
+                     const Descend& shouldDescend, std::vector<VFSNode*>& results) {
+        while (state.pending.load(std::memory_order_acquire) > 0) {
+            const VFSDirectory* dir = popOwn(state, worker);
+            if (!dir) {
+                dir = steal(state, worker);
+            }
+            if (!dir) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (const auto& child : dir->getLoadedChildren()) {
+                if (match(child.get())) {
+                    results.push_back(child.get());
+                }
+                if (child->isDirectory()) {
+                    auto* childDir = static_cast<const VFSDirectory*>(child.get());
+                    if (shouldDescend(childDir)) {
+                        push(state, worker, childDir);
+                    }
+                }
+            }
+            state.pending.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+  public:
+    static size_t defaultThreadCount() {
+        size_t count = std::thread::hardware_concurrency();
+        return count == 0 ? 1 : count;
+    }
+
+    // Collects every node below `root` (root included) for which `match` holds.
+    // Subtrees of directories rejected by `shouldDescend` are skipped. Lazy directories
+    // contribute what they have loaded; nothing is listed from the worker threads.
+    template <typename Match, typename Descend>
+    static std::vector<VFSNode*> collect(VFSNode* root, size_t threadCount, Match match,
+                                         Descend shouldDescend) {
+        std::vector<VFSNode*> results;
+        if (!root) {
+            return results;
+        }
+        if (match(root)) {
+            results.push_back(root);
+        }
+        if (!root->isDirectory() || !shouldDescend(static_cast<const VFSDirectory*>(root))) {
+            return results;
+        }
+
+        size_t workers = threadCount == 0 ? 1 : threadCount;
+        SharedState state;
+        for (size_t i = 0; i < workers; ++i) {
+            state.queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        push(state, 0, static_cast<const VFSDirectory*>(root));
+
+        std::vector<std::vector<VFSNode*>> buffers(workers);
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (size_t i = 1; i < workers; ++i) {
+            threads.emplace_back([&, i]() { work(state, i, match, shouldDescend, buffers[i]); });
+        }
+        work(state, 0, match, shouldDescend, buffers[0]);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (auto& buffer : buffers) {
+            results.insert(results.end(), buffer.begin(), buffer.end());
+        }
+        return results;
+    }
+
+    template <typename Match>
+    static std::vector<VFSNode*> collect(VFSNode* root, size_t threadCount, Match match) {
+        return collect(root, threadCount, match, [](const VFSDirectory*) { return true; });
+    }
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Blocked Bloom filter over the names of a directory subtree: each name touches a single
+// 512-bit block, so a lookup costs one cache line.
+class SubtreeBloomFilter {
+  private:
+    static constexpr size_t BLOCK_WORDS = 8;
+    static constexpr size_t BLOCK_BITS = BLOCK_WORDS * 64;
+    static constexpr size_t BITS_PER_NAME = 12;
+    static constexpr size_t PROBES = 6;
+    static constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    static constexpr std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+    std::vector<std::uint64_t> words;
+    size_t blockCount;
+    size_t capacity;
+    size_t insertedCount;
+    size_t staleCount;
+
+    static std::uint64_t mix(std::uint64_t value) {
+        value ^= value >> 30;
+        value *= 0xBF58476D1CE4E5B9ULL;
+        value ^= value >> 27;
+        value *= 0x94D049BB133111EBULL;
+        value ^= value >> 31;
+        return value;
+    }
+
+    static std::uint64_t hashFunction(const std::string& name) {
+        std::uint64_t hash = FNV_OFFSET;
+        for (char c : name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= FNV_PRIME;
+        }
+        return mix(hash);
+    }
+
+    size_t blockIndex(std::uint64_t hash) const {
+        return static_cast<size_t>(((hash >> 32) * blockCount) >> 32);
+    }
+
+  public:
+    explicit SubtreeBloomFilter(size_t expectedNames)
+        : blockCount((expectedNames * BITS_PER_NAME + BLOCK_BITS - 1) / BLOCK_BITS),
+          capacity(expectedNames), insertedCount(0), staleCount(0) {
+        if (blockCount == 0) {
+            blockCount = 1;
+        }
+        words.assign(blockCount * BLOCK_WORDS, 0);
+    }
+
+    void insert(const std::string& name) {
+        std::uint64_t hash = hashFunction(name);
+        std::uint64_t* block = &words[blockIndex(hash) * BLOCK_WORDS];
+        std::uint64_t bits = mix(hash);
+        for (size_t i = 0; i < PROBES; ++i) {
+            size_t bit = bits & (BLOCK_BITS - 1);
+            block[bit / 64] |= std::uint64_t(1) << (bit % 64);
+            bits >>= 9;
+        }
+        ++insertedCount;
+    }
+
+    bool mayContain(const std::string& name) const {
+        std::uint64_t hash = hashFunction(name);
+        const std::uint64_t* block = &words[blockIndex(hash) * BLOCK_WORDS];
+        std::uint64_t bits = mix(hash);
+        for (size_t i = 0; i < PROBES; ++i) {
+            size_t bit = bits & (BLOCK_BITS - 1);
+            if (!(block[bit / 64] & (std::uint64_t(1) << (bit % 64)))) {
+                return false;
+            }
+            bits >>= 9;
+        }
+        return true;
+    }
+
+    // Bloom filters cannot delete; removed names only degrade precision until a rebuild.
+    void markStale(size_t count) { staleCount += count; }
+
+    bool needsRebuild() const { return insertedCount > capacity || staleCount * 4 > insertedCount; }
+
+    size_t memoryUsage() const { return sizeof(*this) + words.size() * sizeof(std::uint64_t); }
+};
+
+struct SubtreeNameSummary {
+    size_t descendantCount = 0;
+    size_t unlistedDirectories = 0; // lazy directories not read yet, this one included
+    std::unique_ptr<SubtreeBloomFilter> filter;
+    bool rebuildPending = false;
+    bool pendingBelow = false;
+};
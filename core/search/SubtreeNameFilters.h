@@ -0,0 +1,190 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "../domain/VFSDirectory.h"
+#include "../domain/VFSNode.h"
+#include "SubtreeBloomFilter.h"
+
+// Keeps the per-directory Bloom summaries in sync with the tree. Inserts are applied to
+// every ancestor filter right away; deletes and overflowing filters only schedule a
+// rebuild that runs on the next refresh().
+class SubtreeNameFilters {
+  private:
+    static constexpr size_t MIN_FILTERED_DESCENDANTS = 64;
+    static constexpr size_t CAPACITY_HEADROOM = 2;
+
+    static void collectNames(const VFSNode* node, std::vector<std::string>& names) {
+        names.push_back(node->getName());
+        if (node->isDirectory()) {
+            for (const auto& child : static_cast<const VFSDirectory*>(node)->getLoadedChildren()) {
+                collectNames(child.get(), names);
+            }
+        }
+    }
+
+    static void insertDescendants(const VFSDirectory* dir, SubtreeBloomFilter& filter) {
+        for (const auto& child : dir->getLoadedChildren()) {
+            filter.insert(child->getName());
+            if (child->isDirectory()) {
+                insertDescendants(static_cast<const VFSDirectory*>(child.get()), filter);
+            }
+        }
+    }
+
+    static void markPending(VFSDirectory* dir) {
+        dir->getNameSummary().rebuildPending = true;
+        markPendingAbove(dir);
+    }
+
+    // Leads refresh() from the root down to `node`.
+    static void markPendingAbove(VFSNode* node) {
+        for (VFSNode* current = node->getParent(); current; current = current->getParent()) {
+            auto& summary = static_cast<VFSDirectory*>(current)->getNameSummary();
+            if (summary.pendingBelow) {
+                break;
+            }
+            summary.pendingBelow = true;
+        }
+    }
+
+    static void rebuild(VFSDirectory* dir) {
+        auto& summary = dir->getNameSummary();
+        summary.rebuildPending = false;
+
+        if (summary.descendantCount < MIN_FILTERED_DESCENDANTS) {
+            summary.filter.reset();
+            return;
+        }
+
+        summary.filter =
+            std::make_unique<SubtreeBloomFilter>(summary.descendantCount * CAPACITY_HEADROOM);
+        insertDescendants(dir, *summary.filter);
+    }
+
+  public:
+    // Called once `node` has been attached to its parent.
+    static void subtreeAttached(VFSNode* node) {
+        // A moved subtree brings rebuilds scheduled under its old parent.
+        if (node->isDirectory()) {
+            const auto& summary = static_cast<VFSDirectory*>(node)->getNameSummary();
+            if (summary.rebuildPending || summary.pendingBelow) {
+                markPendingAbove(node);
+            }
+        }
+
+        std::vector<std::string> names;
+        collectNames(node, names);
+
+        for (VFSNode* current = node->getParent(); current; current = current->getParent()) {
+            auto* dir = static_cast<VFSDirectory*>(current);
+            auto& summary = dir->getNameSummary();
+            if (!summary.filter) {
+                if (summary.descendantCount >= MIN_FILTERED_DESCENDANTS) {
+                    markPending(dir);
+                }
+                continue;
+            }
+
+            for (const auto& name : names) {
+                summary.filter->insert(name);
+            }
+            if (summary.filter->needsRebuild()) {
+                markPending(dir);
+            }
+        }
+    }
+
+    // Called after attaching a subtree that was assembled without the per-node hooks, so
+    // that its own large directories get filters as well (see treeAssembled).
+    static void subtreeAssembled(VFSNode* node) {
+        if (!node->isDirectory()) {
+            return;
+        }
+        auto* dir = static_cast<VFSDirectory*>(node);
+        treeAssembled(dir);
+        if (dir->getNameSummary().rebuildPending) {
+            markPending(dir);
+        }
+    }
+
+    // Called while `node` is still attached, right before it leaves its parent.
+    static void subtreeDetaching(VFSNode* node) {
+        size_t count = 1;
+        if (node->isDirectory()) {
+            count += static_cast<VFSDirectory*>(node)->getDescendantCount();
+        }
+
+        for (VFSNode* current = node->getParent(); current; current = current->getParent()) {
+            auto* dir = static_cast<VFSDirectory*>(current);
+            auto& summary = dir->getNameSummary();
+            if (summary.filter) {
+                summary.filter->markStale(count);
+                if (summary.filter->needsRebuild()) {
+                    markPending(dir);
+                }
+            }
+        }
+    }
+
+    // Called after `node` got its new name.
+    static void nameReplaced(VFSNode* node) {
+        for (VFSNode* current = node->getParent(); current; current = current->getParent()) {
+            auto* dir = static_cast<VFSDirectory*>(current);
+            auto& summary = dir->getNameSummary();
+            if (summary.filter) {
+                summary.filter->markStale(1);
+                summary.filter->insert(node->getName());
+                if (summary.filter->needsRebuild()) {
+                    markPending(dir);
+                }
+            }
+        }
+    }
+
+    // Schedules filters for every large directory of a tree assembled without the
+    // per-node hooks, e.g. restored from a snapshot.
+    static void treeAssembled(VFSDirectory* dir) {
+        auto& summary = dir->getNameSummary();
+        if (summary.descendantCount < MIN_FILTERED_DESCENDANTS) {
+            return;
+        }
+        summary.rebuildPending = true;
+        summary.pendingBelow = true;
+        for (const auto& child : dir->getLoadedChildren()) {
+            if (child->isDirectory()) {
+                treeAssembled(static_cast<VFSDirectory*>(child.get()));
+            }
+        }
+    }
+
+    // Rebuilds every scheduled filter under `dir`. Must run before a traversal that
+    // reads the filters from several threads, and by one thread at a time.
+    static void refresh(VFSDirectory* dir) {
+        auto& summary = dir->getNameSummary();
+        if (!summary.pendingBelow && !summary.rebuildPending) {
+            return;
+        }
+
+        if (summary.pendingBelow) {
+            summary.pendingBelow = false;
+            for (const auto& child : dir->getLoadedChildren()) {
+                if (child->isDirectory()) {
+                    refresh(static_cast<VFSDirectory*>(child.get()));
+                }
+            }
+        }
+
+        if (summary.rebuildPending) {
+            rebuild(dir);
+        }
+    }
+
+    // Filters only know names that were listed, so a subtree with unlisted lazy
+    // directories may contain anything.
+    static bool mayContain(const VFSDirectory* dir, const std::string& name) {
+        const auto& summary = dir->getNameSummary();
+        return summary.unlistedDirectories > 0 || !summary.filter ||
+               summary.filter->mayContain(name);
+    }
+};
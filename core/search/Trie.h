@@ -2,8 +2,11 @@
 
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <utility>
 
 struct TrieNode {
   std::map<char, std::unique_ptr<TrieNode>> children;
@@ -89,8 +92,82 @@ private:
   }
 
 public:
+  // Flattened node for saving and restoring the trie without re-inserting words.
+  struct FlatNode {
+    char ch;
+    std::size_t count;
+    std::size_t child_count;
+  };
+
   explicit Trie() : root(std::make_unique<TrieNode>()) {}
 
+  // Preorder listing; the root comes first with ch == '\0'.
+  std::vector<FlatNode> flatten() const {
+    std::vector<FlatNode> nodes;
+    std::vector<std::pair<char, const TrieNode*>> stack{{'\0', root.get()}};
+    while (!stack.empty()) {
+      auto [ch, node] = stack.back();
+      stack.pop_back();
+      nodes.push_back({ch, node->count, node->children.size()});
+      for (auto it = node->children.rbegin(); it != node->children.rend(); ++it) {
+        stack.push_back({it->first, it->second.get()});
+      }
+    }
+    return nodes;
+  }
+
+  // Inverse of flatten(). Children arrive in key order, so every insert is a hint hit.
+  void restore(const std::vector<FlatNode>& nodes) {
+    root = std::make_unique<TrieNode>(nodes.empty() ? 0 : nodes.front().count);
+    std::vector<std::pair<TrieNode*, std::size_t>> open;
+    if (!nodes.empty() && nodes.front().child_count > 0) {
+      open.push_back({root.get(), nodes.front().child_count});
+    }
+    for (std::size_t i = 1; i < nodes.size() && !open.empty(); ++i) {
+      TrieNode* parent = open.back().first;
+      if (--open.back().second == 0) {
+        open.pop_back();
+      }
+      auto child = std::make_unique<TrieNode>(nodes[i].count);
+      TrieNode* child_ptr = child.get();
+      auto it = parent->children.emplace_hint(parent->children.end(), nodes[i].ch,
+                                              std::move(child));
+      if (it->second.get() != child_ptr) {
+        throw std::runtime_error("Corrupt trie image: duplicate child");
+      }
+      if (nodes[i].child_count > 0) {
+        open.push_back({child_ptr, nodes[i].child_count});
+      }
+    }
+  }
+
+  // Replaces the contents with `words`, each given once with its count and sorted in the
+  // trie's own char order (the order std::map<char> keeps children in). Each word reuses
+  // the path it shares with its predecessor and appends the rest at the end of the child
+  // maps, so the whole build is one pass over the characters.
+  void build_sorted(const std::vector<std::pair<std::string_view, std::size_t>>& words) {
+    root = std::make_unique<TrieNode>();
+    std::vector<TrieNode*> path{root.get()};
+    std::string_view previous;
+    for (const auto& [word, count] : words) {
+      if (word.empty()) continue;
+      std::size_t common = 0;
+      while (common < previous.size() && common < word.size() &&
+             previous[common] == word[common]) {
+        ++common;
+      }
+      path.resize(common + 1);
+      for (std::size_t i = common; i < word.size(); ++i) {
+        TrieNode* parent = path.back();
+        auto it = parent->children.emplace_hint(parent->children.end(), word[i],
+                                                std::make_unique<TrieNode>());
+        path.push_back(it->second.get());
+      }
+      path.back()->count += count;
+      previous = word;
+    }
+  }
+
   bool search(const std::string& word) const {
     if (word.empty()) return false;
     return search_recursive(root.get(), word, 0);
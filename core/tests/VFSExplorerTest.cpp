@@ -1,9 +1,15 @@
+#include "../domain/HostFileWatcher.h"
 #include "../domain/VFSExplorer.h"
+#include "../persistence/Journal.h"
+#include "../persistence/VFSSnapshot.h"
+#include "../search/DuplicateFinder.h"
 #include "../utils/PathUtils.h"
 #include "../utils/ScriptLoader.h"
 #include <cassert>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <set>
 #include <sstream>
 
 class TestRunner {
@@ -383,6 +389,1462 @@ int main() {
                    "Physical path should contain file name");
     });
 
+    // ==================== Subtree Scope Tests ====================
+    runner.runTest("Test 51: Scoped search by index keeps only nodes under scope", [&]() {
+        auto inProjects = explorer.searchByIndex("Tiger.cpp", "/home/projects");
+        auto inPictures = explorer.searchByIndex("Tiger.cpp", "/home/pictures");
+        assertTrue(!inProjects.empty(), "Tiger.cpp should be found under /home/projects");
+        assertTrue(inPictures.empty(), "Tiger.cpp should not be found under /home/pictures");
+    });
+
+    runner.runTest("Test 52: Ancestor labels survive relabeling of wide directories", [&]() {
+        VFSDirectory* wide = explorer.createDirectory("/home", "wide");
+        VFSDirectory* last = nullptr;
+        for (int i = 0; i < 2000; ++i) {
+            last = explorer.createDirectory("/home/wide", "sub_" + std::to_string(i));
+        }
+        VFSDirectory* nested = explorer.createDirectory("/home/wide/sub_7", "nested");
+        assertTrue(wide->isAncestorOf(last), "wide should contain its last child");
+        assertTrue(explorer.getRoot()->isAncestorOf(nested), "Root should contain nested");
+        assertFalse(last->isAncestorOf(nested), "Siblings must not contain each other");
+        assertFalse(nested->isAncestorOf(wide), "Descendant is not an ancestor");
+    });
+
+    runner.runTest("Test 53: Move directory into its own descendant throws exception", [&]() {
+        VFSDirectory* wide = explorer.navigateToDirectory("/home/wide");
+        VFSDirectory* nested = explorer.navigateToDirectory("/home/wide/sub_7/nested");
+        assertThrows([&]() { explorer.moveNode(wide, nested); }, "own child");
+        explorer.moveNode(nested, explorer.navigateToDirectory("/home"));
+        assertTrue(explorer.navigateToDirectory("/home")->isAncestorOf(nested),
+                   "Moved node should be labeled under its new parent");
+        assertFalse(wide->isAncestorOf(nested), "Moved node should leave the old subtree");
+    });
+
+    // ==================== Parallel Traversal Tests ====================
+    runner.runTest("Test 54: Parallel traversal matches sequential traversal", [&]() {
+        for (size_t threads : {1, 2, 4}) {
+            auto sequential = explorer.searchByTraversal("nested");
+            auto parallel = explorer.searchByParallelTraversal("nested", threads);
+            std::sort(sequential.begin(), sequential.end());
+            std::sort(parallel.begin(), parallel.end());
+            assertTrue(sequential == parallel, "Result sets should be equal");
+        }
+    });
+
+    runner.runTest("Test 55: Search mode dispatches to every engine", [&]() {
+        for (SearchMode mode :
+             {SearchMode::Index, SearchMode::Traversal, SearchMode::ParallelTraversal}) {
+            auto results = explorer.search("Tiger.cpp", mode);
+            assertTrue(results.size() == 1, "Each mode should find exactly one Tiger.cpp");
+        }
+    });
+
+    // ==================== Bloom Filter Tests ====================
+    runner.runTest("Test 56: Filtered traversal stays exact after renames and deletes", [&]() {
+        explorer.createDirectory("/home", "bloom");
+        for (int i = 0; i < 300; ++i) {
+            explorer.createDirectory("/home/bloom", "entry_" + std::to_string(i));
+        }
+        assertTrue(explorer.searchByTraversal("entry_42").size() == 1, "entry_42 before rename");
+        explorer.renameNode("/home/bloom/entry_42", "renamed_42");
+        explorer.deleteNode("/home/bloom/entry_43");
+        assertTrue(explorer.searchByTraversal("entry_42").empty(), "Old name should be gone");
+        assertTrue(explorer.searchByTraversal("entry_43").empty(), "Deleted node should be gone");
+        assertTrue(explorer.searchByTraversal("renamed_42").size() == 1, "New name found");
+        assertTrue(explorer.searchByParallelTraversal("renamed_42", 2).size() == 1,
+                   "Parallel traversal should see the new name too");
+        assertTrue(explorer.getRoot()->getNameSummary().filter != nullptr,
+                   "Large subtrees should get a filter");
+    });
+
+    runner.runTest("Test 57: Scoped traversal keeps only nodes under scope", [&]() {
+        auto inBloom = explorer.searchByTraversal("entry_7", "/home/bloom");
+        auto inPictures = explorer.searchByTraversal("entry_7", "/home/pictures");
+        assertTrue(inBloom.size() == 1, "entry_7 should be found under /home/bloom");
+        assertTrue(inPictures.empty(), "entry_7 should not be found under /home/pictures");
+    });
+
+    runner.runTest("Test 58: Descendant counts follow moves and deletes", [&]() {
+        VFSDirectory* bloom = explorer.navigateToDirectory("/home/bloom");
+        size_t before = bloom->getDescendantCount();
+        explorer.moveNode(explorer.navigateToDirectory("/home/bloom/entry_1"),
+                          explorer.navigateToDirectory("/home/pictures"));
+        assertTrue(bloom->getDescendantCount() == before - 1, "Move should decrement count");
+        assertTrue(explorer.searchByTraversal("entry_1", "/home/pictures").size() == 1,
+                   "Moved node should be found at its new place");
+        explorer.copyNode(bloom, "/home/pictures", false, "bloom_copy");
+        assertTrue(explorer.searchByTraversal("entry_7", "/home/pictures").size() == 1,
+                   "Copied nodes should be found under the copy");
+        assertTrue(explorer.navigateToDirectory("/home/pictures/bloom_copy")
+                           ->getNameSummary()
+                           .filter != nullptr,
+                   "A copied subtree should get filters of its own");
+    });
+
+    // ==================== Content Search Tests ====================
+    runner.runTest("Test 59: Content search answers term and phrase queries", [&]() {
+        ContentIndexer indexer(2);
+        indexer.indexFiles(explorer.collectPhysicalPaths());
+        indexer.waitIdle();
+        auto byTerm = explorer.searchByContent(indexer, "IntervalLabeler");
+        auto byPhrase = explorer.searchByContent(indexer, "class VFSExplorer");
+        auto reversed = explorer.searchByContent(indexer, "VFSExplorer class");
+        assertTrue(!byTerm.empty(), "VFSExplorer.cpp mentions IntervalLabeler");
+        assertTrue(byPhrase.size() == 1, "Only VFSExplorer.cpp declares class VFSExplorer");
+        assertEquals("VFSExplorer.cpp", byPhrase.front()->getName(), "Phrase hit should match");
+        assertTrue(reversed.empty(), "Word order matters for phrases");
+    });
+
+    runner.runTest("Test 60: Content index picks up changed files on refresh", [&]() {
+        std::string path = (std::filesystem::temp_directory_path() / "content_test.txt").string();
+        std::ofstream(path) << "alpha beta";
+        ContentIndexer indexer(1);
+        indexer.indexFile(path);
+        indexer.waitIdle();
+        assertTrue(indexer.findTerm("alpha").size() == 1, "alpha should be indexed");
+
+        std::ofstream(path) << "delta zeta";
+        indexer.refresh();
+        indexer.waitIdle();
+        assertTrue(indexer.findTerm("alpha").empty(), "Stale term should disappear");
+        assertTrue(indexer.findTerm("zeta").size() == 1,
+                   "A rewrite of the same size right away should be picked up");
+
+        std::ofstream(path) << "gamma delta epsilon";
+        indexer.refresh();
+        indexer.waitIdle();
+        assertTrue(indexer.findTerm("zeta").empty() &&
+                       indexer.findPhrase("delta epsilon").size() == 1,
+                   "New phrase found once compaction renumbered the documents");
+        std::filesystem::remove(path);
+    });
+
+    // ==================== Duplicate Detection Tests ====================
+    runner.runTest("Test 61: Duplicate finder groups identical physical files", [&]() {
+        auto tmp = std::filesystem::temp_directory_path();
+        std::string first = (tmp / "dedup_first.bin").string();
+        std::string second = (tmp / "dedup_second.bin").string();
+        std::string payload(20000, 'x');
+        std::ofstream(first, std::ios::binary) << payload;
+        std::ofstream(second, std::ios::binary) << payload;
+        explorer.createDirectory("/home", "dedup");
+        explorer.addFile("/home/dedup", "first.bin", first);
+        explorer.addFile("/home/dedup", "second.bin", second);
+
+        DuplicateFinder finder(2);
+        auto groups = finder.findDuplicates(explorer);
+        bool found = false;
+        for (const auto& group : groups) {
+            if (group.size == payload.size()) {
+                found = group.physicalPaths.size() == 2 && group.files.size() == 2;
+            }
+        }
+        assertTrue(found, "Both copies should form one duplicate group");
+        assertTrue(finder.lastStats().fullyHashed == 2, "Only colliding files are fully hashed");
+
+        finder.findDuplicates(explorer);
+        assertTrue(finder.lastStats().fullyHashed == 0, "Second run should hit the hash cache");
+        assertTrue(finder.lastStats().cacheHits >= 2, "Cached hashes should be reused");
+
+        std::string lone = (tmp / "dedup_lone.bin").string();
+        std::string loneContent(12345, 'y');
+        std::ofstream(lone, std::ios::binary) << loneContent;
+        explorer.addFile("/home/dedup", "lone.bin", lone);
+        explorer.addFile("/home/dedup", "lone_again.bin", lone);
+        bool loneHashed = false;
+        for (const auto& group : finder.findDuplicates(explorer)) {
+            if (group.size == loneContent.size()) {
+                loneHashed = group.hash == Hash64::compute(loneContent);
+            }
+        }
+        assertTrue(loneHashed, "Nodes sharing one host file are reported with its real hash");
+
+        std::string other = (tmp / "dedup_other.bin").string();
+        std::ofstream(other, std::ios::binary) << std::string(loneContent.size(), 'z');
+        explorer.addFile("/home/dedup", "other.bin", other);
+        bool stillShared = false;
+        for (const auto& group : finder.findDuplicates(explorer)) {
+            if (group.size == loneContent.size()) {
+                stillShared = group.physicalPaths == std::vector<std::string>{lone} &&
+                              group.files.size() == 2;
+            }
+        }
+        assertTrue(stillShared, "A shared host file stays reported beside same-size files");
+
+        std::string cachePath = (tmp / "dedup_cache.bin").string();
+        assertTrue(finder.saveCache(cachePath), "Hash cache should be saved");
+        DuplicateFinder reloaded(2);
+        assertTrue(reloaded.loadCache(cachePath), "Saved hash cache should load");
+        reloaded.findDuplicates(explorer);
+        assertTrue(reloaded.lastStats().fullyHashed == 0, "Loaded cache spares the hashing");
+        std::fstream corrupt(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+        corrupt.seekp(40);
+        corrupt.put('!');
+        corrupt.close();
+        assertFalse(DuplicateFinder(1).loadCache(cachePath), "Corrupt cache is rejected");
+
+        explorer.deleteNode("/home/dedup");
+        std::filesystem::remove(first);
+        std::filesystem::remove(second);
+        std::filesystem::remove(lone);
+        std::filesystem::remove(other);
+        std::filesystem::remove(cachePath);
+    });
+
+    runner.runTest("Test 62: Hash64 matches the XXH64 reference values", [&]() {
+        assertTrue(Hash64::compute(std::string()) == 0xEF46DB3751D8E999ULL, "Empty input");
+        assertTrue(Hash64::compute(std::string("abc")) == 0x44BC2CF5AD770999ULL, "Short input");
+        std::string longText(1000, 'a');
+        Hash64 streaming;
+        streaming.update(longText.data(), 7);
+        streaming.update(longText.data() + 7, longText.size() - 7);
+        assertTrue(streaming.digest() == Hash64::compute(longText), "Streaming equals one-shot");
+    });
+
+    // ==================== Mapped Read Tests ====================
+    runner.runTest("Test 63: Mapped read returns the same bytes as the stream", [&]() {
+        VFSFile* file = explorer.navigateToFile("/home/pictures/Leopard.jpg");
+        auto stream = file->openReadStream();
+        std::string streamed((std::istreambuf_iterator<char>(*stream)),
+                             std::istreambuf_iterator<char>());
+        MappedFile mapped = file->mapReadOnly(AccessPattern::Random);
+        assertTrue(mapped.size() == file->getSize(), "Mapped size should match file size");
+        assertTrue(mapped.view() == streamed, "Mapped bytes should match streamed bytes");
+    });
+
+    runner.runTest("Test 64: Special files fall back to buffered reads", [&]() {
+        if (!std::filesystem::exists("/proc/self/status")) {
+            return;
+        }
+        MappedFile special("/proc/self/status");
+        assertFalse(special.isMapped(), "procfs entries cannot be mapped by size");
+        assertTrue(special.view().find("Name:") != std::string_view::npos,
+                   "Fallback should still read the content");
+    });
+
+    // ==================== Async I/O Tests ====================
+    runner.runTest("Test 65: Async reads match synchronous reads on every backend", [&]() {
+        VFSFile* file = explorer.navigateToFile("/home/pictures/Leopard.jpg");
+        MappedFile mapped = file->mapReadOnly();
+        for (AsyncBackend backend : {AsyncBackend::Auto, AsyncBackend::ThreadPool}) {
+            AsyncFileIO io(4, backend);
+            AsyncStatResult stat = file->statAsync(io).get();
+            assertTrue(stat.error == 0 && stat.size == file->getSize(), "Stat should report size");
+
+            AsyncReadResult whole = file->readAsync(io, 0, mapped.size() + 100).get();
+            assertTrue(whole.error == 0, "Read should succeed");
+            assertTrue(std::string_view(whole.data.data(), whole.data.size()) == mapped.view(),
+                       "Read past the end should return exactly the file");
+
+            AsyncReadResult slice = file->readAsync(io, 10, 5).get();
+            assertTrue(std::string_view(slice.data.data(), slice.data.size()) ==
+                           mapped.view().substr(10, 5),
+                       "Offset reads should return the requested range");
+        }
+    });
+
+    runner.runTest("Test 66: Async batch completes every request and reports errors", [&]() {
+        VFSFile* file = explorer.navigateToFile("/home/pictures/Leopard.jpg");
+        AsyncFileIO io(2);
+        std::atomic<int> completed{0};
+        std::atomic<int> failed{0};
+        for (int i = 0; i < 50; ++i) {
+            file->readAsync(io, 0, 16, [&](AsyncReadResult result) {
+                ++completed;
+                failed += result.error != 0;
+            });
+        }
+        io.read("/nonexistent/async/file", 0, 16, [&](AsyncReadResult result) {
+            ++completed;
+            failed += result.error == ENOENT;
+        });
+        io.waitIdle();
+        assertTrue(completed == 51, "Every request should complete");
+        assertTrue(failed == 1, "Only the missing file should fail, with ENOENT");
+    });
+
+    // ==================== Block Cache Tests ====================
+    runner.runTest("Test 67: Cached stream and map return the file content", [&]() {
+        VFSFile* file = explorer.navigateToFile("/home/pictures/Leopard.jpg");
+        MappedFile direct = file->mapReadOnly();
+        BlockCache cache(8 * 1024 * 1024, 4096, 4);
+
+        auto stream = file->openReadStream(cache);
+        std::string streamed((std::istreambuf_iterator<char>(*stream)),
+                             std::istreambuf_iterator<char>());
+        assertTrue(streamed == direct.view(), "Cached stream should match the file");
+
+        stream->clear();
+        stream->seekg(-7, std::ios::end);
+        char tail[7];
+        stream->read(tail, sizeof(tail));
+        assertTrue(std::string_view(tail, sizeof(tail)) == direct.view().substr(direct.size() - 7),
+                   "Seeking from the end should land on the last bytes");
+
+        BlockCacheStats cold = cache.getStats();
+        MappedFile cached = file->mapReadOnly(cache);
+        BlockCacheStats warm = cache.getStats();
+        assertTrue(cached.view() == direct.view(), "Cached map should match the file");
+        assertTrue(warm.misses == cold.misses && warm.hits > cold.hits,
+                   "Second read should be served from the cache");
+        assertTrue(warm.hitRatio() > 0.0 && warm.cachedBytes <= warm.byteBudget,
+                   "Metrics should reflect hits within the budget");
+    });
+
+    runner.runTest("Test 68: Block cache keeps the hot set through a scan", [&]() {
+        std::string path = (std::filesystem::temp_directory_path() / "block_cache_scan.bin").string();
+        std::ofstream(path, std::ios::binary) << std::string(400 * 4096, 'x');
+        FileVersion version = BlockCache::versionOf(path);
+        BlockCache cache(64 * 4096, 4096, 1);
+
+        for (int round = 0; round < 2; ++round) {
+            for (std::uint64_t block = 0; block < 16; ++block) {
+                cache.getBlock(path, version, block);
+            }
+        }
+        for (std::uint64_t block = 100; block < 400; ++block) {
+            cache.getBlock(path, version, block);
+        }
+        std::uint64_t missesBefore = cache.getStats().misses;
+        for (std::uint64_t block = 0; block < 16; ++block) {
+            cache.getBlock(path, version, block);
+        }
+        BlockCacheStats stats = cache.getStats();
+        assertTrue(stats.misses == missesBefore, "Hot blocks should survive the scan");
+        assertTrue(stats.evictions > 0 && stats.cachedBytes <= 64 * 4096,
+                   "Scan blocks should be evicted to stay within budget");
+
+        BlockCache chunked(64 * 4096, 4096, 1);
+        char chunk[512];
+        for (std::uint64_t offset = 0; offset < 4 * 4096; offset += sizeof(chunk)) {
+            chunked.read(path, version, offset, chunk, sizeof(chunk));
+        }
+        for (std::uint64_t block = 100; block < 400; ++block) {
+            chunked.getBlock(path, version, block);
+        }
+        missesBefore = chunked.getStats().misses;
+        chunked.read(path, version, 0, chunk, sizeof(chunk));
+        std::filesystem::remove(path);
+        assertTrue(chunked.getStats().misses == missesBefore + 1,
+                   "Small reads through a block in one pass should not make it hot");
+    });
+
+    // ==================== Descriptor Cache Tests ====================
+    runner.runTest("Test 69: Descriptor cache serves repeated and concurrent reads", [&]() {
+        VFSFile* file = explorer.navigateToFile("/home/pictures/Leopard.jpg");
+        MappedFile direct = file->mapReadOnly();
+        FileDescriptorCache descriptors(4);
+
+        auto stream = file->openReadStream(descriptors);
+        std::string streamed((std::istreambuf_iterator<char>(*stream)),
+                             std::istreambuf_iterator<char>());
+        assertTrue(streamed == direct.view(), "Descriptor stream should match the file");
+
+        std::vector<std::thread> readers;
+        std::atomic<int> mismatches{0};
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&, t]() {
+                char chunk[256];
+                for (std::uint64_t offset = t * 1000; offset < 200000; offset += 4096) {
+                    size_t count = file->readAt(descriptors, offset, chunk, sizeof(chunk));
+                    mismatches +=
+                        std::string_view(chunk, count) != direct.view().substr(offset, 256);
+                }
+            });
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        DescriptorCacheStats stats = descriptors.getStats();
+        assertTrue(mismatches == 0, "Positional reads should not interfere");
+        assertTrue(stats.opens == 1 && stats.opensAvoided > 0, "File should be opened once");
+    });
+
+    runner.runTest("Test 70: Descriptor cache drops renamed and deleted files", [&]() {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string path = (dir / "descriptor_cache_a.txt").string();
+        std::string moved = (dir / "descriptor_cache_b.txt").string();
+        std::ofstream(path) << "first";
+        FileDescriptorCache descriptors(4, std::chrono::milliseconds(0));
+        char text[16];
+
+        size_t count = descriptors.readAt(path, 0, text, sizeof(text));
+        assertTrue(std::string(text, count) == "first", "Initial read");
+
+        std::filesystem::rename(path, moved);
+        std::ofstream(path) << "second";
+        count = descriptors.readAt(path, 0, text, sizeof(text));
+        assertTrue(std::string(text, count) == "second", "Replaced path should be reopened");
+
+        auto held = descriptors.acquire(moved);
+        std::filesystem::remove(moved);
+        assertFalse(held->stillValid(false), "Unlinked file should be detected without a lookup");
+        assertThrows([&]() { descriptors.acquire(moved); }, "Cannot open file");
+        assertTrue(descriptors.getStats().invalidations == 2, "Both stale entries dropped");
+        std::filesystem::remove(path);
+    });
+
+    // ==================== Readahead Tests ====================
+    runner.runTest("Test 71: Readahead stream matches the file across seeks", [&]() {
+        VFSFile* file = explorer.navigateToFile("/home/pictures/Leopard.jpg");
+        MappedFile direct = file->mapReadOnly();
+
+        auto stream = file->openSequentialStream();
+        std::string streamed((std::istreambuf_iterator<char>(*stream)),
+                             std::istreambuf_iterator<char>());
+        assertTrue(streamed == direct.view(), "Sequential read should match the file");
+        ReadaheadStats sequential = static_cast<ReadaheadStream&>(*stream).getStats();
+        assertTrue(sequential.bytesPrefetched == direct.size(), "Every byte prefetched once");
+
+        ReadaheadStream seeking(file->getPhysicalPath());
+        char chunk[100];
+        for (std::uint64_t offset : {1500000, 20, 900000, 2000000}) {
+            seeking.seekg(static_cast<std::streamoff>(offset));
+            seeking.read(chunk, sizeof(chunk));
+            assertTrue(std::string_view(chunk, sizeof(chunk)) == direct.view().substr(offset, 100),
+                       "Read after seek should return the right bytes");
+        }
+        ReadaheadStats random = seeking.getStats();
+        assertTrue(random.restarts == 4 && random.window <= 2 * ReadaheadStreambuf::MIN_WINDOW,
+                   "Seeks should restart readahead from the minimum window");
+    });
+
+    // ==================== Snapshot Tests ====================
+    runner.runTest("Test 72: Snapshot round trip restores tree and indexes", [&]() {
+        std::string path = (std::filesystem::temp_directory_path() / "vfs_test.snapshot").string();
+        for (bool includeIndexes : {true, false}) {
+            SnapshotOptions options;
+            options.includeIndexes = includeIndexes;
+            SnapshotInfo saved = VFSSnapshot::save(explorer, path, options);
+
+            VFSExplorer restored;
+            SnapshotInfo loaded = VFSSnapshot::load(restored, path);
+            assertTrue(loaded.nodeCount == saved.nodeCount, "Node count should round trip");
+            assertTrue(loaded.indexesIncluded == includeIndexes, "Index images as requested");
+
+            VFSFile* original = explorer.navigateToFile("/home/pictures/Leopard.jpg");
+            VFSFile* copy = restored.navigateToFile("/home/pictures/Leopard.jpg");
+            assertEquals(original->getPhysicalPath(), copy->getPhysicalPath(), "Physical path");
+            assertTrue(copy->getPreLabel() == original->getPreLabel() &&
+                           copy->getCreationTime() == original->getCreationTime(),
+                       "Labels and timestamps should round trip");
+            assertTrue(restored.getRoot()->getDescendantCount() ==
+                           explorer.getRoot()->getDescendantCount(),
+                       "Descendant counts should round trip");
+            assertTrue(restored.searchByIndex("Leopard.jpg").size() ==
+                           explorer.searchByIndex("Leopard.jpg").size(),
+                       "Name index should answer like the original");
+            assertTrue(restored.searchByIndex("pictures", "/home").size() == 1,
+                       "Scoped search should work on restored labels");
+            assertTrue(restored.getSuggestions("T") == explorer.getSuggestions("T"),
+                       "Trie should answer like the original");
+            assertTrue(restored.searchByTraversal("Leopard.jpg").size() ==
+                           explorer.searchByTraversal("Leopard.jpg").size(),
+                       "Traversal should see the same tree");
+            assertTrue(restored.findByPhysicalPath(copy->getPhysicalPath()).size() ==
+                           explorer.findByPhysicalPath(original->getPhysicalPath()).size(),
+                       "Physical path index should be rebuilt");
+
+            restored.createDirectory("/home", "after_restore");
+            assertTrue(restored.searchByIndex("after_restore").size() == 1,
+                       "Restored explorer should accept new nodes");
+        }
+        std::filesystem::remove(path);
+    });
+
+    runner.runTest("Test 73: Corrupt snapshot is rejected without side effects", [&]() {
+        std::string path =
+            (std::filesystem::temp_directory_path() / "vfs_corrupt.snapshot").string();
+        VFSSnapshot::save(explorer, path);
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(sizeof(SnapshotHeader) + 4 * sizeof(SnapshotSection) + 8);
+            file.put('\x7f');
+        }
+
+        VFSExplorer target;
+        target.createDirectory("/", "kept");
+        assertThrows([&]() { VFSSnapshot::load(target, path); }, "checksum mismatch");
+        assertTrue(target.searchByIndex("kept").size() == 1, "Failed load must not modify state");
+
+        std::ofstream(path, std::ios::binary) << "not a snapshot at all, just text";
+        assertThrows([&]() { VFSSnapshot::load(target, path); }, "Not a VFS snapshot");
+        std::filesystem::remove(path);
+
+        FileHashMap map;
+        map.resetBuckets(8);
+        int accepted = 0;
+        for (size_t bucket = 0; bucket < 8; ++bucket) {
+            try {
+                map.restoreEntry(bucket, "Leopard.jpg", {});
+                ++accepted;
+            } catch (const std::runtime_error&) {
+            }
+        }
+        assertTrue(accepted == 1, "A name map entry is only accepted in its own bucket");
+        assertThrows([&]() { map.restoreEntry(8, "Leopard.jpg", {}); }, "Corrupt snapshot");
+    });
+
+    // ==================== Journal Tests ====================
+    runner.runTest("Test 74: Journal replays every mutation after the last checkpoint", [&]() {
+        auto dir = std::filesystem::temp_directory_path() / "vfs_test_journal";
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        std::string physical = (dir / "payload.txt").string();
+        std::string snapshot = (dir / "tree.snapshot").string();
+        std::ofstream(physical) << "journal payload";
+
+        JournalOptions options;
+        options.sync = JournalSync::EveryCommit;
+        {
+            VFSExplorer live;
+            Journal journal((dir / "log").string(), options);
+            journal.recover(live, snapshot);
+            live.setMutationLog(&journal);
+
+            live.createDirectory("/", "docs");
+            live.createDirectory("/", "archive");
+            live.addFile("/docs", "a.txt", physical);
+            journal.checkpoint(live, snapshot);
+
+            live.addFile("/docs", "b.txt", physical);
+            live.renameNode("/docs/a.txt", "renamed.txt");
+            live.copyNode(live.navigateToNode("/docs"), "/archive");
+            live.copyNode(live.navigateToNode("/docs"), "/archive");
+            live.moveNode(live.navigateToNode("/docs/b.txt"), live.navigateToDirectory("/archive"));
+            live.cutNode(live.navigateToNode("/archive/docs_copy1"), "/", false, "moved");
+            live.deleteNode("/archive/docs/renamed.txt");
+            assertTrue(journal.lastSequence() == 10, "Every mutation should get one record");
+        }
+        std::filesystem::remove(physical);
+
+        VFSExplorer restored;
+        Journal journal((dir / "log").string(), options);
+        JournalRecovery recovery = journal.recover(restored, snapshot);
+        assertTrue(recovery.snapshotLoaded && recovery.snapshotSequence == 3 &&
+                       recovery.replayed == 7 && recovery.lastSequence == 10,
+                   "Only records after the checkpoint should be replayed");
+        assertTrue(journal.segmentCount() == 1, "Checkpoint should compact older segments");
+        assertTrue(restored.searchByIndex("renamed.txt").size() == 2 &&
+                       restored.navigateToNode("/archive/b.txt") &&
+                       restored.navigateToNode("/moved/renamed.txt") &&
+                       !restored.navigateToDirectory("/archive/docs")->getChild("renamed.txt"),
+                   "Replay should reproduce the tree");
+
+        restored.setMutationLog(&journal);
+        restored.createDirectory("/", "after");
+        assertTrue(journal.lastSequence() == 11, "Numbering should continue after recovery");
+        restored.setMutationLog(nullptr);
+        std::filesystem::remove_all(dir);
+    });
+
+    runner.runTest("Test 75: Torn journal tail is dropped on open", [&]() {
+        auto dir = std::filesystem::temp_directory_path() / "vfs_torn_journal";
+        std::filesystem::remove_all(dir);
+        {
+            VFSExplorer live;
+            Journal journal(dir.string());
+            live.setMutationLog(&journal);
+            live.createDirectory("/", "one");
+            live.createDirectory("/", "two");
+            journal.sync();
+        }
+        auto segment = std::filesystem::directory_iterator(dir)->path();
+        auto size = std::filesystem::file_size(segment);
+        std::filesystem::resize_file(segment, size - 3);
+
+        VFSExplorer restored;
+        Journal journal(dir.string());
+        JournalRecovery recovery = journal.recover(restored);
+        assertTrue(recovery.replayed == 1 && recovery.truncatedBytes > 0,
+                   "Only the intact record should be replayed");
+        assertTrue(restored.navigateToNode("/one") && restored.searchByIndex("two").empty(),
+                   "The torn record must not be applied");
+        std::filesystem::remove_all(dir);
+
+        std::string snapshot =
+            (std::filesystem::temp_directory_path() / "vfs_ahead.snapshot").string();
+        {
+            VFSExplorer live;
+            Journal journal(dir.string());
+            live.setMutationLog(&journal);
+            live.createDirectory("/", "logged");
+            journal.sync();
+            SnapshotOptions snapshotOptions;
+            snapshotOptions.journalSequence = 5;
+            VFSSnapshot::save(live, snapshot, snapshotOptions);
+        }
+        {
+            VFSExplorer ahead;
+            Journal journal(dir.string());
+            assertTrue(journal.recover(ahead, snapshot).lastSequence == 5,
+                       "A snapshot ahead of the log should set the sequence");
+            ahead.setMutationLog(&journal);
+            ahead.createDirectory("/", "after");
+            journal.sync();
+            ahead.setMutationLog(nullptr);
+        }
+        VFSExplorer reopened;
+        Journal journal2(dir.string());
+        JournalRecovery ahead = journal2.recover(reopened, snapshot);
+        assertTrue(ahead.replayed == 1 && ahead.lastSequence == 6 &&
+                       reopened.navigateToNode("/after") && journal2.segmentCount() == 1,
+                   "Segments behind the snapshot should be gone after recovery");
+        std::filesystem::remove(snapshot);
+        std::filesystem::remove_all(dir);
+    });
+
+    // ==================== Index Image Tests ====================
+    runner.runTest("Test 76: Mapped index image answers searches with an overlay", [&]() {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string snapshot = (dir / "vfs_image_test.snapshot").string();
+        SnapshotOptions options;
+        options.indexImagePath = (dir / "vfs_image_test.index").string();
+        SnapshotInfo saved = VFSSnapshot::save(explorer, snapshot, options);
+
+        VFSExplorer restored;
+        SnapshotInfo loaded = VFSSnapshot::load(restored, snapshot, options);
+        assertTrue(loaded.indexImageMapped && loaded.treeVersion == saved.treeVersion,
+                   "Image built for this tree should be mapped");
+        assertTrue(restored.searchByIndex("Leopard.jpg").size() ==
+                       explorer.searchByIndex("Leopard.jpg").size(),
+                   "Lookups should be answered from the image");
+        assertTrue(restored.getSuggestions("") == explorer.getSuggestions(""),
+                   "Suggestions should match the original trie");
+
+        VFSNode* leopard = restored.navigateToNode("/home/pictures/Leopard.jpg");
+        size_t leopards = restored.searchByIndex("Leopard.jpg").size();
+        restored.renameNode("/home/pictures/Leopard.jpg", "Lynx.jpg");
+        restored.createDirectory("/home", "Leopard.jpg");
+        restored.deleteNode("/home/pictures");
+        std::vector<VFSNode*> hits = restored.searchByIndex("Leopard.jpg");
+        assertTrue(hits.size() == leopards &&
+                       std::find(hits.begin(), hits.end(), leopard) == hits.end(),
+                   "Renamed and deleted nodes should leave the image, new ones join the overlay");
+        assertTrue(restored.searchByIndex("Lynx.jpg").empty(),
+                   "Deleted subtree should be gone from the overlay too");
+
+        std::vector<std::string> suggestions = restored.getSuggestions("");
+        auto trieOrder = [](const std::string& a, const std::string& b) {
+            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+        };
+        assertTrue(std::is_sorted(suggestions.begin(), suggestions.end(), trieOrder) &&
+                       std::adjacent_find(suggestions.begin(), suggestions.end()) ==
+                           suggestions.end(),
+                   "Merged suggestions should stay ordered and unique");
+        std::filesystem::remove(snapshot);
+        std::filesystem::remove(options.indexImagePath);
+    });
+
+    runner.runTest("Test 77: Stale or damaged index image falls back to the snapshot", [&]() {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string snapshot = (dir / "vfs_stale_test.snapshot").string();
+        SnapshotOptions options;
+        options.indexImagePath = (dir / "vfs_stale_test.index").string();
+        VFSSnapshot::save(explorer, snapshot, options);
+
+        VFSExplorer changed;
+        VFSSnapshot::load(changed, snapshot);
+        changed.createDirectory("/", "only_in_new_tree");
+        VFSSnapshot::save(changed, snapshot);
+
+        VFSExplorer restored;
+        SnapshotInfo loaded = VFSSnapshot::load(restored, snapshot, options);
+        assertTrue(!loaded.indexImageMapped, "Image of another tree version must be ignored");
+        assertTrue(restored.searchByIndex("only_in_new_tree").size() == 1,
+                   "Indexes should come from the snapshot instead");
+
+        VFSSnapshot::save(changed, snapshot, options);
+        {
+            std::fstream file(options.indexImagePath,
+                              std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(sizeof(IndexImageHeader) + 4);
+            file.put('\x5a');
+        }
+        VFSExplorer fallback;
+        assertTrue(!VFSSnapshot::load(fallback, snapshot, options).indexImageMapped &&
+                       fallback.searchByIndex("only_in_new_tree").size() == 1,
+                   "Damaged image should be ignored");
+        std::filesystem::remove(snapshot);
+        std::filesystem::remove(options.indexImagePath);
+    });
+
+    runner.runTest("Test 78: Bulk index build matches incremental indexing", [&]() {
+        std::string physical =
+            std::filesystem::absolute(std::filesystem::temp_directory_path() / "vfs_bulk.txt")
+                .string();
+        std::ofstream(physical) << "bulk";
+
+        // Enough names for the parallel sort path, with duplicates, shared prefixes and
+        // non-ASCII names that sort before ASCII in the trie.
+        VFSExplorer tree;
+        std::vector<std::string> names;
+        for (size_t d = 0; d < 700; ++d) {
+            std::string dir = d % 7 == 0 ? "папка" + std::to_string(d) : "dir" + std::to_string(d);
+            tree.createDirectory("/", dir);
+            names.push_back(dir);
+            for (size_t f = 0; f < 100; ++f) {
+                std::string name = f % 10 == 0 ? "файл" + std::to_string(f)
+                                               : "f" + std::to_string((d * 100 + f) % 3000);
+                tree.addFile("/" + dir, name, physical, VFSFile::TrustedPath{});
+                names.push_back(name);
+            }
+        }
+
+        auto sorted = [](std::vector<VFSNode*> nodes) {
+            std::sort(nodes.begin(), nodes.end());
+            return nodes;
+        };
+        std::vector<std::string> prefixes{"", "f", "f1", "f29", "d", "dir69", "п", "фа", "zzz"};
+        std::vector<std::vector<VFSNode*>> incrementalHits;
+        std::vector<std::vector<std::string>> incrementalSuggestions;
+        for (const auto& name : names) {
+            incrementalHits.push_back(sorted(tree.searchByIndex(name)));
+        }
+        for (const auto& prefix : prefixes) {
+            incrementalSuggestions.push_back(tree.getSuggestions(prefix));
+        }
+
+        assertTrue(tree.rebuildIndexes(4) == names.size(), "Every node should be indexed");
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (sorted(tree.searchByIndex(names[i])) != incrementalHits[i]) {
+                throw std::runtime_error("Bulk index differs for " + names[i]);
+            }
+        }
+        for (size_t i = 0; i < prefixes.size(); ++i) {
+            assertTrue(tree.getSuggestions(prefixes[i]) == incrementalSuggestions[i],
+                       "Suggestions should match for prefix '" + prefixes[i] + "'");
+        }
+
+        tree.createDirectory("/", "after_rebuild");
+        tree.deleteNode("/dir1");
+        assertTrue(tree.searchByIndex("after_rebuild").size() == 1 &&
+                       tree.searchByIndex("dir1").empty(),
+                   "Rebuilt indexes should keep tracking mutations");
+        std::filesystem::remove(physical);
+    });
+
+    runner.runTest("Test 79: Fast script load matches load and creates parents", [&]() {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string physical = std::filesystem::absolute(dir / "vfs_fast_payload.txt").string();
+        std::string script = (dir / "vfs_fast_script.txt").string();
+        std::ofstream(physical) << "fast";
+        {
+            std::ofstream out(script, std::ios::binary);
+            out << "# comment\n\nmkdir /a\r\nmkdir /a/b\n  mkdir\t/a/c  \n"
+                << "mkfile /a/b/one.txt " << physical << "\n"
+                << "mkfile /a/c/two.txt " << physical << "\n"
+                << "mkfile /a/b/one.txt " << physical << "\n"
+                << "mkfile /missing/x.txt " << physical << "\n"
+                << "mkfile /a/b/gone.txt /no/such/file\n"
+                << "mkdir /a\n";
+        }
+
+        VFSExplorer slow;
+        std::ostream::iostate outState = std::cout.rdstate();
+        std::streambuf* errBuffer = std::cerr.rdbuf(nullptr);
+        std::cout.setstate(std::ios::failbit);
+        ScriptLoader::load(slow, script.c_str());
+        std::cout.clear(outState);
+        std::cerr.rdbuf(errBuffer);
+
+        VFSExplorer fast;
+        ScriptLoadOptions quiet;
+        quiet.logSummary = false;
+        ScriptLoadStats stats = ScriptLoader::loadFast(fast, script, quiet);
+        assertTrue(stats.lines == 11 && stats.directories == 3 && stats.files == 2 &&
+                       stats.failures == 4,
+                   "Lines, entries and failures should be counted");
+        assertTrue(fast.getSuggestions("") == slow.getSuggestions(""),
+                   "Fast load should index the same names as load");
+        assertTrue(fast.findByPhysicalPath(physical).size() == 2,
+                   "Files should be registered by physical path");
+        assertTrue(fast.getRoot()->getDescendantCount() == slow.getRoot()->getDescendantCount(),
+                   "Fast load should build the same tree");
+
+        {
+            std::ofstream out(script, std::ios::binary);
+            out << "mkdir -p /deep/er/est\nmkdir -p /deep/er\n"
+                << "mkfile /deep/er/est/f.txt " << physical;
+        }
+        stats = ScriptLoader::loadFast(fast, script, quiet);
+        assertTrue(stats.failures == 0 && stats.directories == 3 && stats.files == 1,
+                   "mkdir -p should create missing parents and accept existing ones");
+        assertTrue(fast.searchByIndex("est").size() == 1 &&
+                       fast.searchByIndex("f.txt").size() == 1 &&
+                       fast.searchByIndex("one.txt").size() == 1,
+                   "Later loads should add to the existing indexes");
+        std::filesystem::remove(script);
+        std::filesystem::remove(physical);
+    });
+
+    runner.runTest("Test 80: Host directory mounts with its whole tree", [&]() {
+        auto host = std::filesystem::temp_directory_path() / "vfs_mount_host";
+        std::filesystem::remove_all(host);
+        for (int d = 0; d < 20; ++d) {
+            auto dir = host / ("dir" + std::to_string(d)) / "nested";
+            std::filesystem::create_directories(dir);
+            for (int f = 0; f < 10; ++f) {
+                std::ofstream(dir / ("file" + std::to_string(f) + ".txt")) << f;
+            }
+        }
+        std::ofstream(host / "top.txt") << "top";
+        std::filesystem::create_symlink(host / "dir0", host / "link");
+
+        VFSExplorer mounted;
+        mounted.createDirectory("/", "mnt");
+        MountStats stats = mounted.mountHostDirectory(host.string(), "/mnt/host", 4);
+        assertTrue(stats.directories == 40 && stats.files == 201 && stats.skipped == 1,
+                   "Every directory and regular file should be counted, symlinks skipped");
+        assertTrue(mounted.getRoot()->getDescendantCount() == 1 + 1 + 40 + 201,
+                   "Mounted subtree should be attached under /mnt");
+        assertTrue(mounted.searchByIndex("file3.txt").size() == 20 &&
+                       mounted.searchByIndex("nested").size() == 20 &&
+                       mounted.searchByIndex("host").size() == 1,
+                   "Mounted names should be indexed");
+        std::string top = (host / "top.txt").string();
+        assertTrue(mounted.findByPhysicalPath(top).size() == 1,
+                   "Mounted files should point at their host files");
+        auto suggestions = mounted.getSuggestions("dir1");
+        assertTrue(suggestions.size() == 11, "Mounted names should be suggested");
+
+        bool threw = false;
+        try {
+            mounted.mountHostDirectory(host.string(), "/mnt/host");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assertTrue(threw, "Mounting over an existing name should fail");
+        threw = false;
+        try {
+            mounted.mountHostDirectory((host / "missing").string(), "/mnt/other");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assertTrue(threw && mounted.searchByIndex("other").empty(),
+                   "Missing host directory should fail");
+        std::filesystem::remove_all(host);
+    });
+
+    runner.runTest("Test 81: Lazy mount lists directories on first access", [&]() {
+        auto host = std::filesystem::temp_directory_path() / "vfs_lazy_host";
+        std::filesystem::remove_all(host);
+        for (int d = 0; d < 10; ++d) {
+            auto dir = host / ("dir" + std::to_string(d)) / "nested";
+            std::filesystem::create_directories(dir);
+            for (int f = 0; f < 5; ++f) {
+                std::ofstream(dir / ("file" + std::to_string(f) + ".txt")) << f;
+            }
+        }
+        std::ofstream(host / "top.txt") << "top";
+
+        VFSExplorer lazy;
+        lazy.createDirectory("/", "mnt");
+        LazyMountOptions options;
+        options.prefetchSiblings = 3;
+        VFSDirectory* mount = lazy.mountLazy(host.string(), "/mnt/host", options);
+        assertTrue(lazy.getRoot()->getDescendantCount() == 2 &&
+                       lazy.searchByIndex("top.txt").empty(),
+                   "Mounting should not read the host tree");
+
+        auto* dir3 = static_cast<VFSDirectory*>(mount->getChild("dir3"));
+        assertTrue(dir3 && lazy.getRoot()->getDescendantCount() == 2 + 11,
+                   "Accessing the mount should list its top level only");
+        assertTrue(dir3->getChildren().size() == 1 && mount->getChild("dir4") &&
+                       lazy.searchByIndex("nested").size() == 1,
+                   "Listed entries should be indexed as they appear");
+
+        assertTrue(lazy.searchByTraversal("file2.txt").size() == 10 &&
+                       lazy.searchByIndex("file2.txt").size() == 10,
+                   "A traversal should list everything it descends into");
+        assertTrue(lazy.getRoot()->getDescendantCount() == 2 + 11 + 10 + 50,
+                   "Whole host tree should be listed after the traversal");
+
+        VFSExplorer copied;
+        copied.createDirectory("/", "mnt");
+        VFSDirectory* other = copied.mountLazy(host.string(), "/mnt/host");
+        other->getChildren();
+        copied.copyNode(other->getChild("dir5"), "/");
+        assertTrue(copied.searchByParallelTraversal("file4.txt", 2).size() == 11,
+                   "Copies of unlisted directories should stay lazy and list on their own");
+
+        VFSExplorer watched;
+        options.revalidateAfter = std::chrono::milliseconds(1);
+        VFSDirectory* live = watched.mountLazy(host.string(), "/host", options);
+        assertTrue(live->getChild("top.txt") != nullptr, "Host file should be listed");
+        watched.createDirectory("/host", "virtual");
+        std::filesystem::remove(host / "top.txt");
+        std::ofstream(host / "new.txt") << "new";
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        assertTrue(!live->getChild("top.txt") && live->getChild("new.txt") &&
+                       live->getChild("virtual"),
+                   "Stale listing should pick up host changes and keep VFS entries");
+        assertTrue(watched.searchByIndex("top.txt").empty() &&
+                       watched.searchByIndex("new.txt").size() == 1,
+                   "Revalidation should keep the index in sync");
+
+        std::string snapshot = (host.parent_path() / "vfs_lazy.snapshot").string();
+        VFSExplorer saved;
+        VFSDirectory* savedMount = saved.mountLazy(host.string(), "/host", options);
+        savedMount->getChild("dir7");
+        size_t listedCount = saved.getRoot()->getDescendantCount();
+        VFSSnapshot::save(saved, snapshot);
+        assertTrue(saved.getRoot()->getDescendantCount() == listedCount,
+                   "Saving should not list unopened directories");
+        VFSExplorer restored;
+        VFSSnapshot::load(restored, snapshot);
+        auto* restoredMount = static_cast<VFSDirectory*>(restored.getRoot()->getChild("host"));
+        auto* restoredDir = static_cast<VFSDirectory*>(restoredMount->getLoadedChild("dir7"));
+        assertTrue(restoredMount->getLazyListing() && restoredMount->isListed() &&
+                       restoredDir && !restoredDir->isListed() &&
+                       restoredDir->getLazyListing()->options.revalidateAfter ==
+                           options.revalidateAfter,
+                   "Lazy state should round trip through a snapshot");
+        std::filesystem::remove(snapshot);
+
+        VFSExplorer shared;
+        shared.mountLazy(host.string(), "/host");
+        std::atomic<int> wrong{0};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&]() {
+                wrong += shared.searchByTraversal("file3.txt").size() != 10;
+                wrong += shared.navigateToDirectory("/host/dir2/nested")->getChildren().size() != 5;
+                wrong += shared.getSuggestions("file").size() != 5;
+            });
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        assertTrue(wrong == 0, "Concurrent readers should list a mount once and agree");
+
+        bool threw = false;
+        try {
+            watched.mountLazy((host / "missing").string(), "/other");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assertTrue(threw, "Missing host directory should fail");
+        std::filesystem::remove_all(host);
+    });
+
+    runner.runTest("Test 82: Watcher applies host changes to mounted files", [&]() {
+        auto host = std::filesystem::temp_directory_path() / "vfs_watch_host";
+        std::filesystem::remove_all(host);
+        std::filesystem::create_directories(host / "sub");
+        std::ofstream(host / "a.txt") << "abc";
+        std::ofstream(host / "b.txt") << "12345";
+        std::ofstream(host / "sub" / "c.txt") << "x";
+
+        VFSExplorer explorer;
+        explorer.mountHostDirectory(host.string(), "/host");
+        auto* mount = static_cast<VFSDirectory*>(explorer.getRoot()->getChild("host"));
+        {
+            HostFileWatcher watcher(explorer);
+            assertTrue(watcher.watch("/host") == 2, "Both host directories should be watched");
+            auto waitFor = [&](const std::function<bool()>& condition) {
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                while (std::chrono::steady_clock::now() < deadline) {
+                    auto lock = watcher.lockTree();
+                    if (condition()) {
+                        return true;
+                    }
+                    lock.unlock();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                return false;
+            };
+            {
+                auto lock = watcher.lockTree();
+                assertTrue(mount->getSize() == 9 && mount->getCachedSize() == 9,
+                           "Directory total should be cached once every file is watched");
+            }
+
+            std::ofstream(host / "a.txt", std::ios::app) << "defg";
+            assertTrue(waitFor([&]() { return mount->getSize() == 13; }),
+                       "Appended bytes should reach the cached totals");
+
+            std::filesystem::remove(host / "b.txt");
+            assertTrue(waitFor([&]() {
+                           return explorer.searchByIndex("b.txt").empty() && mount->getSize() == 8;
+                       }),
+                       "Deleted host file should leave the tree and the index");
+            WatchStats stats = watcher.getStats();
+            assertTrue(stats.events >= 2 && stats.batches >= 2 && stats.removals == 1 &&
+                           stats.overflows == 0,
+                       "Stats should count events, batches and removals");
+        }
+        assertTrue(mount->getCachedSize() == VFSNode::NO_CACHED_SIZE && mount->getSize() == 8,
+                   "Cached sizes should be dropped with the watcher");
+        std::filesystem::remove_all(host);
+    });
+
+    runner.runTest("Test 83: Tar archive mounts read-only and reuses its index", [&]() {
+        auto work = std::filesystem::temp_directory_path() / "vfs_archive_test";
+        std::filesystem::remove_all(work);
+        std::filesystem::create_directories(work);
+        std::string archive = (work / "data.tar").string();
+        std::string longName = "deep/" + std::string(120, 'n') + ".txt";
+        auto header = [](const std::string& name, std::uint64_t size, char type) {
+            std::string block(512, '\0');
+            name.copy(&block[0], 100);
+            std::snprintf(&block[100], 8, "%07o", 0644);
+            if (size < (1ull << 33)) {
+                std::snprintf(&block[124], 12, "%011llo", static_cast<unsigned long long>(size));
+            } else {
+                block[124] = '\x80'; // base-256
+                for (int i = 0; i < 8; ++i) {
+                    block[135 - i] = static_cast<char>(size >> (8 * i));
+                }
+            }
+            block[156] = type;
+            std::memcpy(&block[257], "ustar\0" "00", 8);
+            std::fill(block.begin() + 148, block.begin() + 156, ' ');
+            unsigned sum = 0;
+            for (char c : block) {
+                sum += static_cast<unsigned char>(c);
+            }
+            std::snprintf(&block[148], 7, "%06o", sum);
+            return block;
+        };
+        {
+            std::ofstream out(archive, std::ios::binary);
+            auto member = [&](const std::string& name, const std::string& content, char type) {
+                out << header(name, content.size(), type) << content
+                    << std::string((512 - content.size() % 512) % 512, '\0');
+            };
+            member("docs/", "", '5');
+            member("./docs/readme.txt", "hello archive", '0');
+            member("src/main.cpp", "int main() {}", '0');
+            member("././@LongLink", longName + '\0', 'L');
+            member(longName.substr(0, 100), "long", '0');
+            member("../escape.txt", "no", '0');
+            out << std::string(1024, '\0');
+        }
+
+        VFSExplorer explorer;
+        ArchiveMountStats stats = explorer.mountArchive(archive, "/arc");
+        assertTrue(stats.files == 3 && stats.directories == 3 && !stats.indexReused,
+                   "First mount should scan the headers and skip escaping members");
+        assertTrue(std::filesystem::exists(archive + ".vfsidx"), "Index should be persisted");
+
+        auto* arc = static_cast<VFSDirectory*>(explorer.getRoot()->getChild("arc"));
+        auto* docs = static_cast<VFSDirectory*>(arc->getChild("docs"));
+        auto* readme = static_cast<VFSFile*>(docs->getChild("readme.txt"));
+        MappedFile mapped = readme->mapReadOnly();
+        assertTrue(readme->getSize() == 13 && mapped.view() == "hello archive",
+                   "Member should map exactly its range of the archive");
+        std::string streamed;
+        std::getline(*readme->openReadStream(), streamed);
+        assertTrue(streamed == "hello archive", "Member should stream its own bytes");
+        auto* deep = static_cast<VFSDirectory*>(arc->getChild("deep"));
+        assertTrue(deep->getChild(longName.substr(5)) != nullptr &&
+                       explorer.searchByIndex("main.cpp").size() == 1 && arc->getSize() == 30,
+                   "GNU long names, implicit directories and the index should be covered");
+
+        bool refused = false;
+        try {
+            explorer.createDirectory("/arc/docs", "new");
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        try {
+            explorer.deleteNode("/arc/docs/readme.txt");
+            refused = false;
+        } catch (const std::runtime_error&) {
+        }
+        assertTrue(refused && docs->getChild("readme.txt") == readme,
+                   "Archive directories should be read-only");
+
+        explorer.copyNode(readme, "/");
+        auto* copy = static_cast<VFSFile*>(explorer.getRoot()->getChild("readme.txt"));
+        assertTrue(copy->mapReadOnly().view() == "hello archive",
+                   "A copy outside the archive should still read the member");
+        explorer.deleteNode("/readme.txt");
+
+        std::string snapshot = (work / "tree.snap").string();
+        VFSSnapshot::save(explorer, snapshot);
+        VFSExplorer restored;
+        VFSSnapshot::load(restored, snapshot);
+        VFSNode* restoredReadme = restored.searchByIndex("readme.txt").front();
+        assertTrue(static_cast<VFSFile*>(restoredReadme)->mapReadOnly().view() == "hello archive",
+                   "Snapshots should keep members as archive ranges");
+
+        VFSExplorer again;
+        assertTrue(again.mountArchive(archive, "/arc").indexReused &&
+                       again.searchByIndex("main.cpp").size() == 1,
+                   "Second mount should reuse the persisted index");
+
+        // A size that wraps the scan offset back onto the same header must not loop.
+        std::string crafted = (work / "crafted.tar").string();
+        std::ofstream(crafted, std::ios::binary)
+            << header("pax_global_header", ~0ull - 511, 'g') << std::string(512, '\0');
+        VFSExplorer hostile;
+        assertThrows([&]() { hostile.mountArchive(crafted, "/arc"); }, "Corrupt tar archive");
+        std::filesystem::remove_all(work);
+    });
+
+    runner.runTest("Test 84: Stored files share deduplicated content in pack files", [&]() {
+        auto work = std::filesystem::temp_directory_path() / "vfs_pack_test";
+        std::filesystem::remove_all(work);
+        std::string packs = (work / "packs").string();
+        std::string snapshot = (work / "tree.snap").string();
+        PackStoreOptions options;
+        options.packBytes = 2048;
+        options.backgroundCompaction = false;
+        std::string large(3000, 'x');
+        {
+            PackStore store(packs, options);
+            VFSExplorer explorer;
+            explorer.setPackStore(&store);
+            explorer.createDirectory("/", "docs");
+            VFSFile* a = explorer.createStoredFile("/docs", "a.txt", "same bytes");
+            explorer.createStoredFile("/docs", "b.txt", "same bytes");
+            explorer.createStoredFile("/docs", "c.bin", large);
+            explorer.createStoredFile("/docs", "d.bin", large + "!");
+            PackStoreStats stats = store.getStats();
+            assertTrue(stats.records == 3 && stats.dedupHits == 1 && stats.packs == 2,
+                       "Identical contents should be stored once");
+            assertTrue(a->mapReadOnly().view() == "same bytes" && a->getSize() == 10 &&
+                           explorer.searchByIndex("b.txt").size() == 1,
+                       "Stored files should read back their content and be indexed");
+
+            explorer.copyNode(a, "/");
+            explorer.deleteNode("/docs/a.txt");
+            explorer.deleteNode("/docs/b.txt");
+            assertTrue(store.getStats().deadBytes == 0, "Content still referenced stays live");
+            explorer.deleteNode("/a.txt");
+            explorer.deleteNode("/docs/c.bin");
+            store.sync();
+            assertTrue(store.getStats().deadBytes > 0 && store.compact() == 1,
+                       "The pack that lost its contents should be compacted");
+            stats = store.getStats();
+            assertTrue(stats.deadBytes == 0 && stats.records == 1,
+                       "Compaction should reclaim every dead record");
+            auto* d = static_cast<VFSFile*>(explorer.searchByIndex("d.bin").front());
+            assertTrue(d->mapReadOnly().view() == large + "!",
+                       "Live content should survive compaction");
+            VFSSnapshot::save(explorer, snapshot);
+        }
+
+        PackStore reopened(packs, options);
+        VFSExplorer restored;
+        restored.setPackStore(&reopened);
+        VFSSnapshot::load(restored, snapshot);
+        auto* d = static_cast<VFSFile*>(restored.searchByIndex("d.bin").front());
+        assertTrue(d->mapReadOnly().view() == large + "!" && reopened.dropUnclaimed() == 0,
+                   "A reopened store should serve the files of a snapshot");
+        std::filesystem::remove_all(work);
+    });
+
+    runner.runTest("Test 85: Chunked files share the chunks of near-duplicates", [&]() {
+        auto work = std::filesystem::temp_directory_path() / "vfs_chunk_test";
+        std::filesystem::remove_all(work);
+        std::string snapshot = (work / "tree.snap").string();
+        PackStoreOptions options;
+        options.backgroundCompaction = false;
+        std::string original;
+        for (int line = 0; original.size() < 64 * 1024; ++line) {
+            original += "    int value" + std::to_string(line) + " = compute(" +
+                        std::to_string(line * 7919 % 1000) + ");\n";
+        }
+        std::string edited = original;
+        edited.insert(edited.size() / 2, "    // a line added in the middle\n");
+        {
+            PackStore store((work / "packs").string(), options);
+            VFSExplorer explorer;
+            explorer.setPackStore(&store);
+            explorer.createChunkedFile("/", "v1.cpp", original);
+            std::uint64_t firstVersion = store.getStats().liveBytes;
+            auto* v2 = static_cast<ChunkedFile*>(explorer.createChunkedFile("/", "v2.cpp", edited));
+            assertTrue(v2->getChunkCount() > 4 &&
+                           store.getStats().liveBytes - firstVersion < original.size() / 4,
+                       "A small edit should only store the chunks around it");
+            assertTrue(v2->mapReadOnly().view() == edited && v2->getSize() == edited.size(),
+                       "Chunked content should be reassembled exactly");
+
+            FileDescriptorCache descriptors;
+            std::string middle(5000, '\0');
+            v2->readAt(descriptors, 30000, &middle[0], middle.size());
+            auto stream = v2->openReadStream();
+            stream->seekg(30000);
+            std::string streamed(5000, '\0');
+            stream->read(&streamed[0], streamed.size());
+            assertTrue(middle == edited.substr(30000, 5000) && streamed == middle,
+                       "Ranges spanning chunks should read through the chunk index");
+
+            explorer.deleteNode("/v1.cpp");
+            store.sync();
+            store.compact();
+            assertTrue(v2->mapReadOnly().view() == edited,
+                       "Deleting a version should keep the chunks the other one uses");
+            VFSSnapshot::save(explorer, snapshot);
+        }
+        PackStore reopened((work / "packs").string(), options);
+        VFSExplorer restored;
+        restored.setPackStore(&reopened);
+        VFSSnapshot::load(restored, snapshot);
+        auto* v2 = static_cast<VFSFile*>(restored.searchByIndex("v2.cpp").front());
+        assertTrue(v2->mapReadOnly().view() == edited,
+                   "Snapshots should restore chunked files from their recipe");
+        std::filesystem::remove_all(work);
+    });
+
+    runner.runTest("Test 86: Memory files keep their content in arena pages", [&]() {
+        VFSExplorer explorer;
+        explorer.createDirectory("/", "scratch");
+        VFSNode* scratch = explorer.navigateToNode("/scratch");
+        assertTrue(scratch->getSize() == 0, "Empty directory should total zero");
+
+        MemoryFile* file = explorer.createMemoryFile("/scratch", "buffer.txt");
+        std::string block(5000, 'b');
+        file->write(0, "hello");
+        file->append(block);
+        assertTrue(file->getSize() == 5005 && scratch->getSize() == 5005,
+                   "Writes should update the file and directory sizes");
+        assertTrue(file->mapReadOnly().view() == "hello" + block,
+                   "Content should read back across page boundaries");
+
+        file->write(4090, "XYZ");
+        char middle[5] = {};
+        file->read(4089, middle, 5);
+        assertTrue(std::string(middle, 5) == "bXYZb", "Overwrites should span pages");
+
+        file->truncate(3);
+        file->truncate(6);
+        assertTrue(file->mapReadOnly().view() == std::string("hel\0\0\0", 6) &&
+                       scratch->getSize() == 6,
+                   "Truncate should drop content and grow with zeros");
+
+        explorer.copyNode(file, "/");
+        auto* copy = static_cast<MemoryFile*>(explorer.getRoot()->getChild("buffer.txt"));
+        copy->append("!");
+        assertTrue(file->getSize() == 6 && copy->getSize() == 7 &&
+                       explorer.searchByIndex("buffer.txt").size() == 2,
+                   "Copies should be indexed and independent");
+
+        explorer.deleteNode("/buffer.txt");
+        explorer.deleteNode("/scratch/buffer.txt");
+        assertTrue(explorer.getMemoryPageStats().pagesInUse == 0,
+                   "Deleted memory files should return their pages");
+    });
+
+    runner.runTest("Test 87: Write streams coalesce writes and update cached sizes", [&]() {
+        auto host = std::filesystem::temp_directory_path() / "vfs_write_stream";
+        std::filesystem::remove_all(host);
+        std::filesystem::create_directories(host);
+        std::string path = (host / "log.txt").string();
+
+        VFSExplorer explorer;
+        explorer.createDirectory("/", "docs");
+        explorer.createFile("/docs", "log.txt", path);
+        auto* log = static_cast<VFSFile*>(explorer.navigateToNode("/docs/log.txt"));
+        VFSNode* docs = explorer.navigateToNode("/docs");
+        log->updateCachedSize(0); // as a watcher would
+        assertTrue(docs->getSize() == 0 && docs->getCachedSize() == 0,
+                   "Directory total should be cached");
+
+        std::string expected;
+        auto stream = log->openWriteStream(WriteMode::Append);
+        for (int i = 0; i < 1000; ++i) {
+            *stream << "line " << i << '\n';
+            expected += "line " + std::to_string(i) + "\n";
+        }
+        assertTrue(std::filesystem::file_size(path) == 0 &&
+                       stream->bufferedBytes() == expected.size(),
+                   "Small writes should stay in the buffer");
+        stream->write(0, "LINE");
+        expected.replace(0, 4, "LINE");
+        stream->close();
+        WriteBackStats stats = stream->getStats();
+        assertTrue(stats.flushes == 1 && stats.targetWrites == 1,
+                   "Buffered writes should reach the host file as one write");
+        std::ifstream written(path, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(written)), {});
+        assertTrue(content == expected, "Host file should hold every write in order");
+        assertTrue(log->getSize() == expected.size() &&
+                       docs->getCachedSize() == static_cast<std::int64_t>(expected.size()),
+                   "Closing should update the cached sizes");
+
+        log->write(expected.size() + 2, "end");
+        assertTrue(docs->getSize() == expected.size() + 5,
+                   "Writes past the end should grow the file");
+        log->openWriteStream(WriteMode::Truncate)->close();
+        assertTrue(std::filesystem::file_size(path) == 0 && docs->getSize() == 0,
+                   "Truncating should empty the file and the totals");
+
+        MemoryFile* scratch = explorer.createMemoryFile("/docs", "scratch.txt");
+        auto memoryStream = scratch->openWriteStream();
+        *memoryStream << "in memory";
+        memoryStream->close();
+        assertTrue(scratch->mapReadOnly().view() == "in memory" && docs->getSize() == 9,
+                   "Memory files should take streamed writes");
+
+        PackStore store((host / "packs").string());
+        explorer.setPackStore(&store);
+        VFSFile* stored = explorer.createStoredFile("/docs", "stored.txt", "shared");
+        bool threw = false;
+        try {
+            stored->write(0, "x");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assertTrue(threw, "Files without a host file of their own should refuse writes");
+        std::filesystem::remove_all(host);
+    });
+
+    runner.runTest("Test 88: Deep copies get host files of their own", [&]() {
+        auto host = std::filesystem::temp_directory_path() / "vfs_deep_copy";
+        std::filesystem::remove_all(host);
+        for (int d = 0; d < 4; ++d) {
+            std::filesystem::create_directories(host / ("dir" + std::to_string(d)));
+            for (int f = 0; f < 5; ++f) {
+                auto path = host / ("dir" + std::to_string(d)) / ("f" + std::to_string(f) + ".txt");
+                std::ofstream(path) << std::string(1000 * (f + 1), char('a' + d));
+            }
+        }
+
+        VFSExplorer explorer;
+        explorer.mountHostDirectory(host.string(), "/src", 2);
+        explorer.createDirectory("/", "dst");
+        explorer.createMemoryFile("/src/dir0", "scratch.txt")->write(0, "memory");
+        DeepCopyStats stats =
+            explorer.deepCopyNode(explorer.navigateToNode("/src"), "/dst", false, "", 4);
+        assertTrue(stats.files == 20 && stats.bytes == 4 * 15000 &&
+                       stats.reflinked + stats.kernelCopied + stats.userspaceCopied == 20,
+                   "Every host file should be copied once");
+#if VFS_HAS_COPY_FILE_RANGE
+        assertTrue(stats.userspaceBytes == 0, "Copies should not pass through userspace");
+#endif
+
+        auto* original = static_cast<VFSFile*>(explorer.navigateToNode("/src/dir1/f2.txt"));
+        auto* copy = static_cast<VFSFile*>(explorer.navigateToNode("/dst/src/dir1/f2.txt"));
+        assertTrue(copy->getPhysicalPath() == (host / "dir1" / "f2_copy1.txt").string() &&
+                       copy->mapReadOnly().view() == std::string(3000, 'b'),
+                   "Copies should sit next to their originals with the same content");
+        copy->write(0, "changed");
+        assertTrue(original->mapReadOnly().view() == std::string(3000, 'b'),
+                   "Writing a copy should leave the original alone");
+        assertTrue(explorer.findByPhysicalPath(copy->getPhysicalPath()).size() == 1,
+                   "Copies should be indexed by their own physical path");
+        assertTrue(static_cast<MemoryFile*>(explorer.navigateToNode("/dst/src/dir0/scratch.txt"))
+                           ->mapReadOnly()
+                           .view() == "memory",
+                   "Memory files should be copied with their content");
+
+        explorer.deepCopyNode(original, "/dst");
+        assertTrue(static_cast<VFSFile*>(explorer.navigateToNode("/dst/f2.txt"))
+                           ->getPhysicalPath() == (host / "dir1" / "f2_copy2.txt").string(),
+                   "A second copy should take the next free host name");
+
+        std::string copied;
+        {
+            VFSExplorer live;
+            Journal journal((host / "log").string());
+            live.setMutationLog(&journal);
+            live.createDirectory("/", "docs");
+            live.addFile("/docs", "f0.txt", (host / "dir3" / "f0.txt").string());
+            live.deepCopyNode(live.navigateToNode("/docs"), "/", false, "backup");
+            auto* backup = static_cast<VFSFile*>(live.navigateToNode("/backup/f0.txt"));
+            copied = backup->getPhysicalPath();
+            journal.sync();
+        }
+        VFSExplorer restored;
+        Journal journal((host / "log").string());
+        journal.recover(restored);
+        assertTrue(static_cast<VFSFile*>(restored.navigateToNode("/backup/f0.txt"))
+                               ->getPhysicalPath() == copied &&
+                       !std::filesystem::exists(host / "dir3" / "f0_copy3.txt"),
+                   "Replay should link the copies made before instead of copying again");
+        std::filesystem::remove_all(host);
+    });
+
+    runner.runTest("Test 89: Compressed pack records read back like raw ones", [&]() {
+        auto work = std::filesystem::temp_directory_path() / "vfs_compressed_pack_test";
+        std::filesystem::remove_all(work);
+        PackStoreOptions options;
+        options.compression = true;
+        options.compressionBlockSize = 4096;
+        options.packBytes = 40000;
+        options.backgroundCompaction = false;
+        std::string text;
+        for (int i = 0; text.size() < 200000; ++i) {
+            text += "line " + std::to_string(i % 97) + ": the quick brown fox\n";
+        }
+        std::string noise(50000, '\0');
+        std::uint32_t state = 12345;
+        for (char& byte : noise) {
+            state = state * 1664525u + 1013904223u;
+            byte = static_cast<char>(state >> 24);
+        }
+        ContentKey textKey;
+        ContentKey noiseKey;
+        {
+            PackStore store((work / "packs").string(), options);
+            textKey = store.put(text);
+            noiseKey = store.put(noise);
+            store.retain(textKey);
+            store.retain(noiseKey);
+            PackStoreStats stats = store.getStats();
+            assertTrue(stats.compressedRecords == 1 && stats.bytesSaved > text.size() / 2 &&
+                           stats.liveBytes == text.size() + noise.size(),
+                       "Only the compressible content should be stored compressed");
+            assertTrue(store.sizeOf(textKey) == text.size() &&
+                           store.map(textKey).view() == text && store.map(noiseKey).view() == noise,
+                       "Compressed content should map back to the original bytes");
+            std::string range(10000, '\0');
+            size_t count = store.read(textKey, 4000, &range[0], range.size());
+            assertTrue(count == range.size() && range == text.substr(4000, 10000),
+                       "A read spanning several blocks should decode just those");
+            count = store.read(textKey, text.size() - 10, &range[0], range.size());
+            assertTrue(count == 10 && range.compare(0, 10, text, text.size() - 10) == 0,
+                       "A read past the end should stop at the content's end");
+
+            VFSExplorer explorer;
+            explorer.setPackStore(&store);
+            explorer.createStoredFile("/", "a.txt", text + "tail");
+            auto* file = static_cast<VFSFile*>(explorer.navigateToNode("/a.txt"));
+            assertTrue(file->getSize() == text.size() + 4 &&
+                           file->mapReadOnly().view() == text + "tail",
+                       "Stored files should read compressed content transparently");
+            explorer.deleteNode("/a.txt");
+            store.release(noiseKey);
+            store.sync();
+            assertTrue(store.compact() == 2 && store.map(textKey).view() == text,
+                       "Compaction should carry compressed records over as they are");
+        }
+
+        PackStore reopened((work / "packs").string(), options);
+        reopened.retain(textKey);
+        PackStoreStats stats = reopened.getStats();
+        assertTrue(stats.records == 1 && stats.compressedRecords == 1 &&
+                       reopened.map(textKey).view() == text && reopened.dropUnclaimed() == 0,
+                   "A reopened store should recognise its compressed records");
+
+        auto packVersions = [](const std::filesystem::path& directory) {
+            std::set<std::uint32_t> versions;
+            for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+                PackFileHeader header{};
+                std::ifstream(entry.path(), std::ios::binary)
+                    .read(reinterpret_cast<char*>(&header), sizeof(header));
+                versions.insert(header.version);
+            }
+            return versions;
+        };
+        options.compression = false;
+        {
+            PackStore plain((work / "plain").string(), options);
+            plain.put(text);
+            plain.sync();
+        }
+        assertTrue(packVersions(work / "packs") ==
+                           std::set<std::uint32_t>{PackFormat::COMPRESSED_VERSION} &&
+                       packVersions(work / "plain") ==
+                           std::set<std::uint32_t>{PackFormat::VERSION},
+                   "Only packs that may hold compressed records should get the new version");
+        std::filesystem::remove_all(work);
+    });
+
     runner.printSummary();
 
     return runner.passedTests == runner.totalTests ? 0 : 1;
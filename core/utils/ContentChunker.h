@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+struct ChunkerOptions {
+    size_t minSize = 512;
+    size_t averageSize = 2048; // a power of two
+    size_t maxSize = 16384;
+};
+
+// Content-defined chunking following FastCDC: a gear hash rolls over the bytes and a
+// chunk ends where its top bits are zero, so boundaries follow the content and an edit
+// only changes the chunks around it. The first minSize bytes of a chunk are skipped, and
+// the mask is stricter before averageSize than after (normalized chunking), which keeps
+// chunk sizes close to the average.
+class ContentChunker {
+  private:
+    std::uint64_t strictMask;
+    std::uint64_t looseMask;
+    ChunkerOptions options;
+
+    static constexpr std::uint64_t splitMix(std::uint64_t& state) {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr std::array<std::uint64_t, 256> gearTable() {
+        std::array<std::uint64_t, 256> table{};
+        std::uint64_t state = 0x5EED;
+        for (auto& value : table) {
+            value = splitMix(state);
+        }
+        return table;
+    }
+
+    static const std::array<std::uint64_t, 256> GEAR;
+
+    // `bits` ones at the top of the word; with the hash shifted left each round, those
+    // bits depend on the last 64 bytes.
+    static std::uint64_t topMask(int bits) { return ~std::uint64_t(0) << (64 - bits); }
+
+  public:
+    explicit ContentChunker(ChunkerOptions options = {}) : options(options) {
+        if (options.averageSize < 64 || (options.averageSize & (options.averageSize - 1)) ||
+            options.minSize >= options.averageSize || options.maxSize <= options.averageSize) {
+            throw std::runtime_error("Invalid chunker options");
+        }
+        int bits = 0;
+        while ((size_t(1) << bits) < options.averageSize) {
+            ++bits;
+        }
+        strictMask = topMask(bits + 2);
+        looseMask = topMask(bits - 2);
+    }
+
+    // Length of the chunk that starts at `data`.
+    size_t cut(const char* data, size_t length) const {
+        if (length <= options.minSize) {
+            return length;
+        }
+        size_t end = length < options.maxSize ? length : options.maxSize;
+        size_t normal = end < options.averageSize ? end : options.averageSize;
+        auto* bytes = reinterpret_cast<const unsigned char*>(data);
+        std::uint64_t hash = 0;
+        size_t i = options.minSize;
+        for (; i < normal; ++i) {
+            hash = (hash << 1) + GEAR[bytes[i]];
+            if (!(hash & strictMask)) {
+                return i + 1;
+            }
+        }
+        for (; i < end; ++i) {
+            hash = (hash << 1) + GEAR[bytes[i]];
+            if (!(hash & looseMask)) {
+                return i + 1;
+            }
+        }
+        return end;
+    }
+
+    // Calls `visit` with each chunk of `content`, in order.
+    template <typename Visit>
+    void split(std::string_view content, Visit visit) const {
+        size_t offset = 0;
+        while (offset < content.size()) {
+            size_t length = cut(content.data() + offset, content.size() - offset);
+            visit(content.substr(offset, length));
+            offset += length;
+        }
+    }
+};
+
+inline const std::array<std::uint64_t, 256> ContentChunker::GEAR = ContentChunker::gearTable();
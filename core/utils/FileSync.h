@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdio>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Pushes written data down to the storage device. Without POSIX these only flush the
+// stdio buffers, which is as much as the portable library offers.
+class FileSync {
+  public:
+    static void flush(std::FILE* file) {
+        std::fflush(file);
+#if defined(__linux__)
+        ::fdatasync(fileno(file));
+#elif defined(__unix__) || defined(__APPLE__)
+        ::fsync(fileno(file));
+#endif
+    }
+
+    static void file(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+#else
+        (void)path;
+#endif
+    }
+
+    // Makes a rename or an unlink inside `path` durable.
+    static void directory(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+#else
+        (void)path;
+#endif
+    }
+};
@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Streaming 64-bit hash following the XXH64 algorithm.
+class Hash64 {
+  private:
+    static constexpr std::uint64_t PRIME1 = 11400714785074694791ULL;
+    static constexpr std::uint64_t PRIME2 = 14029467366897019727ULL;
+    static constexpr std::uint64_t PRIME3 = 1609587929392839161ULL;
+    static constexpr std::uint64_t PRIME4 = 9650029242287828579ULL;
+    static constexpr std::uint64_t PRIME5 = 2870177450012600261ULL;
+    static constexpr size_t STRIPE = 32;
+
+    std::uint64_t lanes[4];
+    std::uint8_t pending[STRIPE];
+    size_t pendingSize;
+    std::uint64_t totalLength;
+    std::uint64_t seed;
+
+    static std::uint64_t rotl(std::uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static std::uint64_t read64(const std::uint8_t* p) {
+        std::uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static std::uint32_t read32(const std::uint8_t* p) {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+        acc += input * PRIME2;
+        acc = rotl(acc, 31);
+        return acc * PRIME1;
+    }
+
+    static std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t lane) {
+        acc ^= round(0, lane);
+        return acc * PRIME1 + PRIME4;
+    }
+
+    void consumeStripe(const std::uint8_t* p) {
+        for (int i = 0; i < 4; ++i) {
+            lanes[i] = round(lanes[i], read64(p + i * 8));
+        }
+    }
+
+  public:
+    explicit Hash64(std::uint64_t seed = 0) : pendingSize(0), totalLength(0), seed(seed) {
+        lanes[0] = seed + PRIME1 + PRIME2;
+        lanes[1] = seed + PRIME2;
+        lanes[2] = seed;
+        lanes[3] = seed - PRIME1;
+    }
+
+    void update(const void* data, size_t length) {
+        auto* p = static_cast<const std::uint8_t*>(data);
+        totalLength += length;
+
+        if (pendingSize + length < STRIPE) {
+            std::memcpy(pending + pendingSize, p, length);
+            pendingSize += length;
+            return;
+        }
+
+        if (pendingSize > 0) {
+            size_t fill = STRIPE - pendingSize;
+            std::memcpy(pending + pendingSize, p, fill);
+            consumeStripe(pending);
+            p += fill;
+            length -= fill;
+            pendingSize = 0;
+        }
+
+        while (length >= STRIPE) {
+            consumeStripe(p);
+            p += STRIPE;
+            length -= STRIPE;
+        }
+
+        std::memcpy(pending, p, length);
+        pendingSize = length;
+    }
+
+    std::uint64_t digest() const {
+        std::uint64_t hash;
+        if (totalLength >= STRIPE) {
+            hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+            for (std::uint64_t lane : lanes) {
+                hash = mergeRound(hash, lane);
+            }
+        } else {
+            hash = seed + PRIME5;
+        }
+        hash += totalLength;
+
+        const std::uint8_t* p = pending;
+        const std::uint8_t* end = pending + pendingSize;
+        while (p + 8 <= end) {
+            hash ^= round(0, read64(p));
+            hash = rotl(hash, 27) * PRIME1 + PRIME4;
+            p += 8;
+        }
+        if (p + 4 <= end) {
+            hash ^= static_cast<std::uint64_t>(read32(p)) * PRIME1;
+            hash = rotl(hash, 23) * PRIME2 + PRIME3;
+            p += 4;
+        }
+        while (p < end) {
+            hash ^= (*p) * PRIME5;
+            hash = rotl(hash, 11) * PRIME1;
+            ++p;
+        }
+
+        hash ^= hash >> 33;
+        hash *= PRIME2;
+        hash ^= hash >> 29;
+        hash *= PRIME3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    static std::uint64_t compute(const void* data, size_t length, std::uint64_t seed = 0) {
+        Hash64 hasher(seed);
+        hasher.update(data, length);
+        return hasher.digest();
+    }
+
+    static std::uint64_t compute(const std::string& text, std::uint64_t seed = 0) {
+        return compute(text.data(), text.size(), seed);
+    }
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// Byte-oriented LZ77 codec in the style of LZ4's block format: fast to compress with
+// one hash probe per position, and much faster to decompress. A block is a series of
+// sequences, each a token (literal count in the high nibble, match length - MIN_MATCH
+// in the low one, 15 meaning more length bytes follow), the literals, then a 2-byte
+// little-endian match offset. The last sequence has literals only.
+class LzCodec {
+  private:
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t MAX_OFFSET = 65535;
+    static constexpr int HASH_BITS = 14;
+    // No match starts within the last bytes, so the final literals are never empty
+    // and a match never runs past the input.
+    static constexpr size_t LAST_LITERALS = 5;
+    static constexpr size_t MATCH_LIMIT = 12;
+    // After this many misses in a row the search steps over more bytes at a time, so
+    // incompressible input is rejected quickly.
+    static constexpr unsigned SKIP_TRIGGER = 6;
+    static constexpr size_t WILD_COPY = 16;
+
+    static std::uint32_t read32(const unsigned char* at) {
+        std::uint32_t value;
+        std::memcpy(&value, at, sizeof(value));
+        return value;
+    }
+
+    static std::uint32_t hash(std::uint32_t sequence, int bits) {
+        return (sequence * 2654435761u) >> (32 - bits);
+    }
+
+    // Appends `length` in the 255-continued form after a saturated nibble.
+    static bool putLength(unsigned char*& out, const unsigned char* end, size_t length) {
+        while (length >= 255) {
+            if (out == end) {
+                return false;
+            }
+            *out++ = 255;
+            length -= 255;
+        }
+        if (out == end) {
+            return false;
+        }
+        *out++ = static_cast<unsigned char>(length);
+        return true;
+    }
+
+    static bool putSequence(unsigned char*& out, const unsigned char* end,
+                            const unsigned char* literals, size_t literalCount,
+                            size_t offset, size_t matchLength) {
+        if (out == end) {
+            return false;
+        }
+        unsigned char* token = out++;
+        *token = static_cast<unsigned char>((literalCount < 15 ? literalCount : 15) << 4);
+        if (literalCount >= 15 && !putLength(out, end, literalCount - 15)) {
+            return false;
+        }
+        if (static_cast<size_t>(end - out) < literalCount) {
+            return false;
+        }
+        std::memcpy(out, literals, literalCount);
+        out += literalCount;
+        if (matchLength == 0) {
+            return true;
+        }
+        if (end - out < 2) {
+            return false;
+        }
+        *out++ = static_cast<unsigned char>(offset);
+        *out++ = static_cast<unsigned char>(offset >> 8);
+        size_t extra = matchLength - MIN_MATCH;
+        *token |= static_cast<unsigned char>(extra < 15 ? extra : 15);
+        return extra < 15 || putLength(out, end, extra - 15);
+    }
+
+    static size_t getLength(const unsigned char*& in, const unsigned char* end) {
+        size_t length = 0;
+        unsigned char byte;
+        do {
+            if (in == end) {
+                throw std::runtime_error("Corrupt compressed block");
+            }
+            byte = *in++;
+            length += byte;
+        } while (byte == 255);
+        return length;
+    }
+
+  public:
+    // Compresses `length` bytes into `destination`, which has room for `capacity`.
+    // Returns the compressed size, or 0 when it would not fit: pass capacity length - 1
+    // to keep only blocks that shrink.
+    static size_t compress(const char* source, size_t length, char* destination,
+                           size_t capacity) {
+        auto* in = reinterpret_cast<const unsigned char*>(source);
+        auto* out = reinterpret_cast<unsigned char*>(destination);
+        const unsigned char* outEnd = out + capacity;
+        const unsigned char* anchor = in;
+        if (length >= MATCH_LIMIT) {
+            // A table of about four slots per input byte, so small inputs clear little.
+            int bits = HASH_BITS;
+            while (bits > 8 && (size_t(1) << (bits - 2)) > length) {
+                --bits;
+            }
+            std::vector<std::uint32_t> table(size_t(1) << bits, 0);
+            const unsigned char* matchEnd = in + length - LAST_LITERALS;
+            const unsigned char* searchEnd = in + length - MATCH_LIMIT;
+            const unsigned char* at = in + 1;
+            unsigned misses = 0;
+            while (at <= searchEnd) {
+                std::uint32_t sequence = read32(at);
+                std::uint32_t& slot = table[hash(sequence, bits)];
+                const unsigned char* candidate = in + slot;
+                slot = static_cast<std::uint32_t>(at - in);
+                if (candidate >= at || static_cast<size_t>(at - candidate) > MAX_OFFSET ||
+                    read32(candidate) != sequence) {
+                    at += 1 + (misses++ >> SKIP_TRIGGER);
+                    continue;
+                }
+                misses = 0;
+                while (at > anchor && candidate > in && at[-1] == candidate[-1]) {
+                    --at;
+                    --candidate;
+                }
+                size_t matchLength = MIN_MATCH;
+                while (at + matchLength < matchEnd &&
+                       at[matchLength] == candidate[matchLength]) {
+                    ++matchLength;
+                }
+                if (!putSequence(out, outEnd, anchor, static_cast<size_t>(at - anchor),
+                                 static_cast<size_t>(at - candidate), matchLength)) {
+                    return 0;
+                }
+                at += matchLength;
+                anchor = at;
+                if (at <= searchEnd) {
+                    auto previous = static_cast<std::uint32_t>(at - 2 - in);
+                    table[hash(read32(at - 2), bits)] = previous;
+                }
+            }
+        }
+        if (!putSequence(out, outEnd, anchor, static_cast<size_t>(in + length - anchor), 0,
+                         0)) {
+            return 0;
+        }
+        return static_cast<size_t>(out - reinterpret_cast<unsigned char*>(destination));
+    }
+
+    // Decompresses a block into exactly `length` bytes at `destination`. Every read and
+    // write is bounds-checked, so corrupt input throws instead of overrunning.
+    static void decompress(const char* source, size_t sourceLength, char* destination,
+                           size_t length) {
+        auto* in = reinterpret_cast<const unsigned char*>(source);
+        const unsigned char* inEnd = in + sourceLength;
+        auto* out = reinterpret_cast<unsigned char*>(destination);
+        auto* begin = out;
+        const unsigned char* outEnd = out + length;
+        while (true) {
+            if (in == inEnd) {
+                throw std::runtime_error("Corrupt compressed block");
+            }
+            unsigned token = *in++;
+            size_t literals = token >> 4;
+            if (literals == 15) {
+                literals += getLength(in, inEnd);
+            }
+            if (static_cast<size_t>(inEnd - in) < literals ||
+                static_cast<size_t>(outEnd - out) < literals) {
+                throw std::runtime_error("Corrupt compressed block");
+            }
+            if (literals <= WILD_COPY && static_cast<size_t>(inEnd - in) >= WILD_COPY &&
+                static_cast<size_t>(outEnd - out) >= WILD_COPY) {
+                std::memcpy(out, in, WILD_COPY); // fixed size: one unaligned load and store
+            } else {
+                std::memcpy(out, in, literals);
+            }
+            in += literals;
+            out += literals;
+            if (in == inEnd) {
+                break;
+            }
+            if (inEnd - in < 2) {
+                throw std::runtime_error("Corrupt compressed block");
+            }
+            size_t offset = in[0] | (size_t(in[1]) << 8);
+            in += 2;
+            size_t matchLength = token & 15;
+            if (matchLength == 15) {
+                matchLength += getLength(in, inEnd);
+            }
+            matchLength += MIN_MATCH;
+            if (offset == 0 || static_cast<size_t>(out - begin) < offset ||
+                static_cast<size_t>(outEnd - out) < matchLength) {
+                throw std::runtime_error("Corrupt compressed block");
+            }
+            const unsigned char* match = out - offset;
+            if (offset >= 8 && static_cast<size_t>(outEnd - out) >= matchLength + 8) {
+                // Each step reads only bytes written before it, even when the match
+                // overlaps its own output.
+                for (size_t i = 0; i < matchLength; i += 8) {
+                    std::memcpy(out + i, match + i, 8);
+                }
+                out += matchLength;
+            } else {
+                for (size_t i = 0; i < matchLength; ++i) {
+                    *out++ = *match++;
+                }
+            }
+        }
+        if (out != outEnd) {
+            throw std::runtime_error("Corrupt compressed block");
+        }
+    }
+};
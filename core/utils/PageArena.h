@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+struct PageArenaStats {
+    size_t pageSize;
+    size_t pagesInUse;
+    size_t pagesFree; // released and waiting for reuse
+    size_t bytesReserved;
+};
+
+// Fixed-size pages carved from large slabs. Released pages are handed out again before
+// a new slab is carved; slabs go back to the system only with the arena, so content of
+// any size costs whole pages and no per-allocation heap call.
+class PageArena {
+  private:
+    static constexpr size_t PAGES_PER_SLAB = 256;
+
+    size_t pageSize;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<char[]>> slabs;
+    std::vector<char*> freePages;
+    size_t carved = PAGES_PER_SLAB; // pages taken from the newest slab
+    size_t inUse = 0;
+
+  public:
+    static constexpr size_t DEFAULT_PAGE_SIZE = 4096;
+
+    explicit PageArena(size_t pageSize = DEFAULT_PAGE_SIZE) : pageSize(pageSize) {
+        if (pageSize == 0) {
+            throw std::runtime_error("Page size must not be zero");
+        }
+    }
+
+    PageArena(const PageArena&) = delete;
+    PageArena& operator=(const PageArena&) = delete;
+
+    size_t getPageSize() const { return pageSize; }
+
+    // An uninitialized page.
+    char* allocate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++inUse;
+        if (!freePages.empty()) {
+            char* page = freePages.back();
+            freePages.pop_back();
+            return page;
+        }
+        if (carved == PAGES_PER_SLAB) {
+            slabs.emplace_back(new char[pageSize * PAGES_PER_SLAB]); // left uninitialized
+            carved = 0;
+        }
+        return slabs.back().get() + pageSize * carved++;
+    }
+
+    void release(char* page) {
+        std::lock_guard<std::mutex> lock(mutex);
+        --inUse;
+        freePages.push_back(page);
+    }
+
+    PageArenaStats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return {pageSize, inUse, freePages.size(), slabs.size() * PAGES_PER_SLAB * pageSize};
+    }
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+class PageCache {
+  public:
+    // Asks the kernel to drop the files from the page cache so the next read is cold.
+    // Dirty pages are flushed first, otherwise DONTNEED leaves them resident.
+    static void evict(const std::vector<std::string>& paths) {
+#if defined(__unix__) || defined(__APPLE__)
+        for (const auto& path : paths) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                continue;
+            }
+            ::fsync(fd);
+#if defined(POSIX_FADV_DONTNEED)
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+            ::close(fd);
+        }
+#else
+        (void)paths;
+#endif
+    }
+};
@@ -1,7 +1,27 @@
 #pragma once
 
 #include "../domain/VFSExplorer.h"
+#include "../io/MappedFile.h"
+#include <chrono>
+#include <filesystem>
 #include <iostream>
+#include <string_view>
+#include <vector>
+
+struct ScriptLoadOptions {
+    bool logEntries = false;    // one line per created entry, as load() prints
+    bool logSummary = true;
+    bool createParents = false; // `mkdir -p` semantics for every command
+};
+
+struct ScriptLoadStats {
+    size_t lines = 0;
+    size_t directories = 0;
+    size_t files = 0;
+    size_t failures = 0;
+    double seconds = 0;
+    double linesPerSecond = 0;
+};
 
 class ScriptLoader {
 private:
@@ -32,8 +52,234 @@ private:
             std::cerr << "Failed to create file " << vPath << ": " << e.what() << std::endl;
         }
     }
+
+    // State of one loadFast() run. `dirs` is the directory chain the previous path
+    // resolved to (dirs[0] is root, names[i] leads to dirs[i + 1]); the names are views
+    // into the mapped script, which outlives the run.
+    struct FastLoad {
+        VFSExplorer& explorer;
+        ScriptLoadOptions options;
+        std::vector<VFSDirectory*> dirs;
+        std::vector<std::string_view> names;
+        std::vector<VFSNode*> added;
+        std::string lastPhysical;
+        std::string lastAbsolute;
+        ScriptLoadStats stats;
+    };
+
+    static std::string_view nextToken(std::string_view& line) {
+        constexpr const char* SPACES = " \t\r\v\f";
+        size_t begin = line.find_first_not_of(SPACES);
+        if (begin == std::string_view::npos) {
+            line = {};
+            return {};
+        }
+        size_t end = std::min(line.find_first_of(SPACES, begin), line.size());
+        std::string_view token = line.substr(begin, end - begin);
+        line.remove_prefix(end);
+        return token;
+    }
+
+    static std::string_view parentOf(std::string_view path) {
+        size_t slash = path.find_last_of('/');
+        if (slash == std::string_view::npos || path.find_first_not_of('/') >= slash) {
+            return "/";
+        }
+        return path.substr(0, slash);
+    }
+
+    static std::string_view nameOf(std::string_view path) {
+        size_t slash = path.find_last_of('/');
+        return slash == std::string_view::npos ? path : path.substr(slash + 1);
+    }
+
+    // Attaches without touching the name indexes; loadFast() indexes everything at the end.
+    static VFSNode* attach(FastLoad& load, VFSDirectory* parent, std::unique_ptr<VFSNode> node) {
+        load.explorer.requireWritable(parent);
+        VFSNode* attached = load.explorer.attachNode(parent, std::move(node));
+        load.added.push_back(attached);
+        ++(attached->isDirectory() ? load.stats.directories : load.stats.files);
+        return attached;
+    }
+
+    // Walks the directory components of `path`, reusing the prefix it shares with the
+    // previous chain, so a sorted script resolves most parents without a single lookup.
+    // Missing directories are created when `createMissing` is set; otherwise, or when a
+    // component is a file, the result is nullptr.
+    static VFSDirectory* resolve(FastLoad& load, std::string_view path, bool createMissing) {
+        size_t depth = 0;
+        for (size_t pos = 0; pos < path.size();) {
+            size_t slash = std::min(path.find('/', pos), path.size());
+            std::string_view part = path.substr(pos, slash - pos);
+            size_t partStart = pos;
+            pos = slash + 1;
+            if (part.empty()) {
+                continue;
+            }
+            if (depth < load.names.size() && load.names[depth] == part) {
+                ++depth;
+                continue;
+            }
+
+            load.names.resize(depth);
+            load.dirs.resize(depth + 1);
+            VFSDirectory* parent = load.dirs.back();
+            VFSNode* child = parent->getChild(std::string(part));
+            if (!child) {
+                if (!createMissing) {
+                    return nullptr;
+                }
+                child = attach(load, parent, std::make_unique<VFSDirectory>(std::string(part)));
+                std::string_view created = path.substr(0, partStart + part.size());
+                load.explorer.logMutation(MutationOp::CreateDirectory, {parentOf(created), part});
+            } else if (!child->isDirectory()) {
+                return nullptr;
+            }
+            load.names.push_back(part);
+            load.dirs.push_back(static_cast<VFSDirectory*>(child));
+            ++depth;
+        }
+        load.names.resize(depth);
+        load.dirs.resize(depth + 1);
+        return load.dirs.back();
+    }
+
+    // Scripts usually point many entries at the same host file, so the last validated
+    // path is kept instead of checking the file system again.
+    static const std::string& absolutePhysicalPath(FastLoad& load, std::string_view path) {
+        if (path != load.lastPhysical) {
+            std::string physical(path);
+            if (!std::filesystem::exists(physical)) {
+                throw std::runtime_error("Physical file does not exist: " + physical);
+            }
+            load.lastAbsolute = std::filesystem::absolute(physical).string();
+            load.lastPhysical = std::move(physical);
+        }
+        return load.lastAbsolute;
+    }
+
+    static void fastMkdir(FastLoad& load, std::string_view path, bool createParents) {
+        std::string_view parentPath = parentOf(path);
+        std::string_view name = nameOf(path);
+        if (name.empty()) {
+            throw std::runtime_error("Invalid directory path");
+        }
+        VFSDirectory* parent = resolve(load, parentPath, createParents);
+        if (!parent) {
+            throw std::runtime_error("Directory does not exist at path: " +
+                                     std::string(parentPath));
+        }
+
+        VFSNode* existing = parent->getChild(std::string(name));
+        if (existing && !(createParents && existing->isDirectory())) {
+            throw std::runtime_error("Directory or file with the same name already exists");
+        }
+        if (!existing) {
+            existing = attach(load, parent, std::make_unique<VFSDirectory>(std::string(name)));
+            load.explorer.logMutation(MutationOp::CreateDirectory, {parentPath, name});
+            if (load.options.logEntries) {
+                std::cout << "Directory created: " << path << '\n';
+            }
+        }
+        load.names.push_back(name);
+        load.dirs.push_back(static_cast<VFSDirectory*>(existing));
+    }
+
+    static void fastMkfile(FastLoad& load, std::string_view vPath, std::string_view rPath) {
+        std::string_view parentPath = parentOf(vPath);
+        std::string name(nameOf(vPath));
+        VFSDirectory* parent = resolve(load, parentPath, load.options.createParents);
+        if (!parent) {
+            throw std::runtime_error("Directory does not exist at path: " +
+                                     std::string(parentPath));
+        }
+        if (name.empty()) {
+            throw std::runtime_error("Invalid file path");
+        }
+        if (parent->getChild(name)) {
+            throw std::runtime_error("Directory or file with the same name already exists");
+        }
+
+        const std::string& physical = absolutePhysicalPath(load, rPath);
+        attach(load, parent,
+               std::make_unique<VFSFile>(std::move(name), physical, VFSFile::TrustedPath{}));
+        load.explorer.logMutation(MutationOp::AddFile,
+                                  {parentPath, nameOf(vPath), std::string_view(physical)});
+        if (load.options.logEntries) {
+            std::cout << "File created: " << vPath << '\n';
+        }
+    }
+
 public:
 
+    // Same commands as load(), for large scripts: the script is mapped and scanned in
+    // place, parents come from the previous line's directory chain instead of a walk from
+    // root, `mkdir -p` creates missing ancestors, and the name indexes are updated once
+    // after the last line. Per-entry logging is off unless asked for.
+    static ScriptLoadStats loadFast(VFSExplorer& explorer, const std::string& scriptPath,
+                                    ScriptLoadOptions options = {}) {
+        auto start = std::chrono::steady_clock::now();
+        MappedFile script(scriptPath, AccessPattern::Sequential);
+        FastLoad load{explorer, options, {explorer.root.get()}, {}, {}, {}, {}, {}};
+
+        std::string_view rest = script.view();
+        while (!rest.empty()) {
+            size_t end = std::min(rest.find('\n'), rest.size());
+            std::string_view line = rest.substr(0, end);
+            rest.remove_prefix(std::min(end + 1, rest.size()));
+            ++load.stats.lines;
+
+            std::string_view command = nextToken(line);
+            if (command.empty() || command.front() == '#') {
+                continue;
+            }
+            std::string_view first = nextToken(line);
+            std::string_view second = nextToken(line);
+            try {
+                if (command == MKDIR_CMD) {
+                    bool createParents = options.createParents;
+                    if (first == "-p") {
+                        createParents = true;
+                        first = second;
+                    }
+                    if (!first.empty()) {
+                        fastMkdir(load, first, createParents);
+                    }
+                } else if (command == MKFILE_CMD) {
+                    if (!first.empty() && !second.empty()) {
+                        fastMkfile(load, first, second);
+                    }
+                } else {
+                    ++load.stats.failures;
+                    if (options.logEntries) {
+                        std::cerr << "[Warning] Unknown command at line " << load.stats.lines
+                                  << ": " << command << '\n';
+                    }
+                }
+            } catch (const std::exception& e) {
+                ++load.stats.failures;
+                if (options.logEntries) {
+                    std::cerr << "Failed at line " << load.stats.lines << " (" << command << ' '
+                              << first << "): " << e.what() << '\n';
+                }
+            }
+        }
+        explorer.indexAttached(load.added);
+
+        load.stats.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        load.stats.linesPerSecond =
+            load.stats.seconds > 0 ? load.stats.lines / load.stats.seconds : 0;
+        if (options.logSummary) {
+            std::cout << "[Info] Script loaded: " << load.stats.lines << " lines in "
+                      << load.stats.seconds << " s (" << load.stats.linesPerSecond
+                      << " lines/s), " << load.stats.directories << " directories, "
+                      << load.stats.files << " files, " << load.stats.failures << " failed"
+                      << std::endl;
+        }
+        return load.stats;
+    }
+
     static void load(VFSExplorer& explorer, const char* scriptPath = PATH_TO_SCRIPT) {
         std::ifstream file(scriptPath);
         if (!file.is_open()) {